@@ -0,0 +1,322 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :appq.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :通讯者和应用进程之间的消息队列.POSIX消息队列每条消息都要进入内核拷贝两次，
+//                 并唤醒等待的一方；共享内存环只在用户态拷贝，只有消费者读空后才通过门铃唤醒，
+//                 连续的消息不产生系统调用.两种方式对上层提供相同的收发接口，由配置选择
+// Interface      :无
+// Others         :共享内存环由通讯者在启动时建立并清空，应用进程需要在通讯者启动之后映射.
+//                 环的格式和应用使用的接口见shmring.h
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <mqueue.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "glog4c.h"
+#include "appq.h"
+#include "shmring.h"
+
+#define APPQ_RING_MAX (1U << 30)
+
+static int     m_kind = APPQ_MQUEUE;
+static int     m_open = 0;
+static char    m_a2q_name[128];
+static char    m_q2a_name[128];
+static mqd_t   m_a2q_mq = (mqd_t)-1;
+static mqd_t   m_q2a_mq = (mqd_t)-1;
+static size_t  m_a2q_size = 0;       // 应用到通讯者方向的消息尺寸
+static size_t  m_q2a_size = 0;       // 通讯者到应用方向的消息尺寸
+static shmring m_a2q_ring;           // 通讯者是消费者
+static shmring m_q2a_ring;           // 通讯者是生产者，发送时持m_send_lock
+static pthread_mutex_t m_send_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int appq_kind_parse(const char *name)
+{
+    if (NULL == name) {
+        return APPQ_ER_PARAM;
+    }
+    if (strcasecmp(name, "mqueue") == 0) {
+        return APPQ_MQUEUE;
+    }
+    if (strcasecmp(name, "shm") == 0) {
+        return APPQ_SHM;
+    }
+    return APPQ_ER_PARAM;
+}
+
+//------------------------------------------------------------------------------
+// Function       :appq_ring_create
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :建立或重建一个共享内存环和它的门铃FIFO，环头清零后再写入魔数，最后按应用
+//                 相同的方式映射.消费者初始处于停车状态，第一条消息就会按响门铃
+// Input          :name:共享内存名称
+//                :size:数据区尺寸，2的幂
+// Output         :rb:环句柄
+// Return         :成功返回APPQ_OK，失败返回APPQ_ER_OPEN
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static int appq_ring_create(const char *name, uint32_t size, shmring *rb)
+{
+    char path[128];
+
+    if (shmring_bell_path(name, path, sizeof(path)) != SHMRING_OK) {
+        return APPQ_ER_OPEN;
+    }
+    unlink(path); // 上次异常退出时可能残留
+    if (mkfifo(path, 0666) < 0) {
+        glog4c_err("create ring bell error:");
+        glog4c_err(strerror(errno));
+        return APPQ_ER_OPEN;
+    }
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0666);
+    if (fd < 0) {
+        glog4c_err("create ring error:");
+        glog4c_err(strerror(errno));
+        return APPQ_ER_OPEN;
+    }
+    size_t total = sizeof(shmring_head) + size;
+    if (ftruncate(fd, total) < 0) {
+        glog4c_err("resize ring error:");
+        glog4c_err(strerror(errno));
+        close(fd);
+        return APPQ_ER_OPEN;
+    }
+    shmring_head *ring = (shmring_head *)mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)ring) {
+        glog4c_err("map ring error:");
+        glog4c_err(strerror(errno));
+        return APPQ_ER_OPEN;
+    }
+    memset(ring, 0, sizeof(shmring_head));
+    ring->version = SHMRING_VERSION;
+    ring->size    = size;
+    ring->maxmsg  = size / 8; // 满的环至少能容纳多条最长的消息
+    ring->parked  = 1;
+    __atomic_store_n(&ring->magic, SHMRING_MAGIC, __ATOMIC_RELEASE);
+    munmap(ring, total);
+
+    if (shmring_open(name, rb) != SHMRING_OK) {
+        glog4c_err("open ring error!\n");
+        return APPQ_ER_OPEN;
+    }
+    return APPQ_OK;
+}
+
+// 删除共享内存环和门铃
+static void appq_ring_unlink(const char *name)
+{
+    char path[128];
+
+    shm_unlink(name);
+    if (shmring_bell_path(name, path, sizeof(path)) == SHMRING_OK) {
+        unlink(path);
+    }
+}
+
+// 打开两个方向的POSIX消息队列并读取消息尺寸
+static int appq_mq_open(const char *a2q, const char *q2a)
+{
+    struct mq_attr attr;
+
+    m_a2q_mq = mq_open(a2q, O_RDONLY | O_CREAT | O_NONBLOCK, 0666, NULL);
+    if (m_a2q_mq < 0) {
+        glog4c_err("open app2queue queue error:");
+        glog4c_err(strerror(errno));
+        return APPQ_ER_OPEN;
+    }
+    m_q2a_mq = mq_open(q2a, O_RDWR | O_CREAT | O_NONBLOCK, 0666, NULL);
+    if (m_q2a_mq < 0 && EEXIST == errno) {
+        m_q2a_mq = mq_open(q2a, O_RDWR | O_NONBLOCK, 0666, NULL);
+    }
+    if (m_q2a_mq < 0) {
+        glog4c_err("open queue2app queue error:");
+        glog4c_err(strerror(errno));
+        mq_close(m_a2q_mq);
+        return APPQ_ER_OPEN;
+    }
+    if (mq_getattr(m_a2q_mq, &attr) < 0) {
+        glog4c_err("get mqueue attr error:");
+        glog4c_err(strerror(errno));
+        goto fail;
+    }
+    m_a2q_size = attr.mq_msgsize;
+    if (mq_getattr(m_q2a_mq, &attr) < 0) {
+        glog4c_err("get mqueue attr error:");
+        glog4c_err(strerror(errno));
+        goto fail;
+    }
+    m_q2a_size = attr.mq_msgsize;
+    return APPQ_OK;
+fail:
+    mq_close(m_a2q_mq);
+    mq_close(m_q2a_mq);
+    return APPQ_ER_OPEN;
+}
+
+/******************************************************************************
+* Description    : 建立两个方向的队列.共享内存方式下环尺寸按2的幂向上取整，单条消息最大为
+*                  环尺寸的1/8
+* Input          : kind - APPQ_MQUEUE或APPQ_SHM
+*                : a2q - 应用到通讯者的队列名称
+*                : q2a - 通讯者到应用的队列名称
+*                : ring_size - 共享内存环尺寸，0使用APPQ_RING_SIZE
+* Output         : None
+* Return         : 返回值参考头文件定义
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+******************************************************************************/
+int appq_open(int kind, const char *a2q, const char *q2a, uint32_t ring_size)
+{
+    int ret;
+
+    if (m_open || NULL == a2q || NULL == q2a
+        || strlen(a2q) >= sizeof(m_a2q_name) || strlen(q2a) >= sizeof(m_q2a_name)) {
+        return APPQ_ER_PARAM;
+    }
+    strcpy(m_a2q_name, a2q);
+    strcpy(m_q2a_name, q2a);
+    m_kind = kind;
+    if (APPQ_MQUEUE == kind) {
+        ret = appq_mq_open(a2q, q2a);
+    } else if (APPQ_SHM == kind) {
+        uint32_t size = APPQ_RING_MIN;
+        if (0 == ring_size) {
+            ring_size = APPQ_RING_SIZE;
+        }
+        while (size < ring_size && size < APPQ_RING_MAX) {
+            size <<= 1;
+        }
+        ret = appq_ring_create(a2q, size, &m_a2q_ring);
+        if (APPQ_OK == ret) {
+            ret = appq_ring_create(q2a, size, &m_q2a_ring);
+            if (APPQ_OK != ret) {
+                shmring_close(&m_a2q_ring);
+                appq_ring_unlink(a2q);
+            }
+        }
+        m_a2q_size = size / 8;
+        m_q2a_size = size / 8;
+    } else {
+        return APPQ_ER_PARAM;
+    }
+    if (APPQ_OK == ret) {
+        m_open = 1;
+        glog4c_info("application queue: %s, message size %u/%u\n",
+            APPQ_SHM == kind ? "shm" : "mqueue", (unsigned)m_a2q_size, (unsigned)m_q2a_size);
+    }
+    return ret;
+}
+
+int appq_fd(void)
+{
+    return (APPQ_SHM == m_kind) ? shmring_fd(&m_a2q_ring) : (int)m_a2q_mq;
+}
+
+int appq_recv(void *buf, size_t size)
+{
+    if (APPQ_SHM == m_kind) {
+        int ret = shmring_recv(&m_a2q_ring, buf, size > UINT32_MAX ? UINT32_MAX : (uint32_t)size);
+        if (ret >= 0) {
+            return ret;
+        }
+        if (SHMRING_ER_CORRUPT == ret) {
+            glog4c_err("app2queue ring is corrupted\n");
+            return APPQ_ER_IO;
+        }
+        return (SHMRING_ER_AGAIN == ret) ? APPQ_ER_AGAIN : APPQ_ER_SIZE;
+    }
+    for (;;) {
+        ssize_t qsize = mq_receive(m_a2q_mq, buf, size, NULL);
+        if (qsize >= 0) {
+            return (int)qsize;
+        }
+        if (EINTR == errno) {
+            continue;
+        }
+        if (EAGAIN == errno) {
+            return APPQ_ER_AGAIN;
+        }
+        glog4c_err("receive message failed:");
+        glog4c_err(strerror(errno));
+        return APPQ_ER_IO;
+    }
+}
+
+int appq_send(const void *buf, size_t len)
+{
+    if (APPQ_SHM == m_kind) {
+        if (len > m_q2a_size) {
+            return APPQ_ER_SIZE;
+        }
+        pthread_mutex_lock(&m_send_lock);
+        int ret = shmring_send(&m_q2a_ring, buf, (uint32_t)len);
+        pthread_mutex_unlock(&m_send_lock);
+        if (SHMRING_OK == ret) {
+            return APPQ_OK;
+        }
+        return (SHMRING_ER_AGAIN == ret) ? APPQ_ER_AGAIN : APPQ_ER_SIZE;
+    }
+    for (;;) {
+        if (mq_send(m_q2a_mq, buf, len, 0) == 0) {
+            return APPQ_OK;
+        }
+        if (EINTR == errno) {
+            continue;
+        }
+        if (EAGAIN == errno) {
+            return APPQ_ER_AGAIN;
+        }
+        if (EMSGSIZE == errno) {
+            return APPQ_ER_SIZE;
+        }
+        return APPQ_ER_IO;
+    }
+}
+
+size_t appq_msgsize(void)
+{
+    return m_a2q_size;
+}
+
+size_t appq_sendsize(void)
+{
+    return m_q2a_size;
+}
+
+void appq_close(void)
+{
+    if (!m_open) {
+        return;
+    }
+    if (APPQ_SHM == m_kind) {
+        shmring_close(&m_a2q_ring);
+        shmring_close(&m_q2a_ring);
+        appq_ring_unlink(m_a2q_name);
+        appq_ring_unlink(m_q2a_name);
+    } else {
+        mq_close(m_a2q_mq);
+        mq_close(m_q2a_mq);
+        mq_unlink(m_a2q_name);
+        mq_unlink(m_q2a_name);
+    }
+    m_open = 0;
+}
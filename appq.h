@@ -0,0 +1,44 @@
+#ifndef APPQ_H_
+#define APPQ_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 通讯者和应用进程之间的消息队列，每个方向一个，传输方式由配置选择:
+//   APPQ_MQUEUE  POSIX消息队列，兼容原有的应用
+//   APPQ_SHM     共享内存单生产者单消费者环(shmring.h)，收发不进入内核，只在对方读空等待时
+//                按一次门铃.应用进程使用shmring.h中的shmring_open映射同名的两个环
+// 应用到通讯者的方向只由主线程接收；通讯者到应用的方向由主线程和通信线程共同发送，
+// 共享内存方式下发送者之间用互斥锁串行，保证环只有一个生产者
+
+#define APPQ_MQUEUE 0
+#define APPQ_SHM    1
+
+#define APPQ_OK         0
+#define APPQ_ER_PARAM  -1 // 参数错误
+#define APPQ_ER_OPEN   -2 // 队列或共享内存建立失败
+#define APPQ_ER_AGAIN  -3 // 接收时队列为空，发送时队列已满
+#define APPQ_ER_SIZE   -4 // 消息超过最大尺寸
+#define APPQ_ER_IO     -5 // 其他收发错误
+
+#define APPQ_RING_SIZE 65536 // 默认的环尺寸，单位B
+#define APPQ_RING_MIN  4096
+
+// 传输方式名称转换为APPQ_MQUEUE或APPQ_SHM，无法识别时返回APPQ_ER_PARAM
+int appq_kind_parse(const char *name);
+// 建立两个方向的队列，a2q为应用到通讯者，q2a为通讯者到应用，ring_size为共享内存环尺寸
+int appq_open(int kind, const char *a2q, const char *q2a, uint32_t ring_size);
+// 应用到通讯者方向的可读句柄，可以交给epoll等待
+int appq_fd(void);
+// 接收一条应用消息，成功返回消息长度，队列为空时返回APPQ_ER_AGAIN
+int appq_recv(void *buf, size_t size);
+// 发送一条消息到应用，可以在任意线程调用，队列满时返回APPQ_ER_AGAIN
+int appq_send(const void *buf, size_t len);
+// 应用到通讯者方向单条消息的最大尺寸
+size_t appq_msgsize(void);
+// 通讯者到应用方向单条消息的最大尺寸
+size_t appq_sendsize(void);
+// 关闭并删除两个方向的队列
+void appq_close(void);
+
+#endif
@@ -0,0 +1,411 @@
+//------------------------------------------------------------------------------
+// Protability:       gunc99.
+// Design Pattern:    None.
+// Base Classes:      None.
+// MultiThread Safe:  Writes through asyncomm_write.
+// Exception Safe:    No Creation, No process
+// Library/package:   None.
+// Source files:      asy_serial.c
+// Related Document:  None.
+// Organize:          
+// Email:             llemmx@gmail.com
+//------------------------------------------------------------------------------
+// Release Note:
+//     串口通道。串口以非阻塞方式打开并注册到异步通信线程，可读时一次readv把内核
+//     缓存的数据全部读入环形缓冲区，再按帧间隔或字节数成帧后转发给应用。
+//     非阻塞模式下内核不处理VMIN/VTIME，这里用帧间隔定时器模拟相同的语义。
+//------------------------------------------------------------------------------
+// Version    Date          Author    Note
+//------------------------------------------------------------------------------
+// 1.0.0      2026-10-17    llemmx    -Original
+// 1.1.0      2026-10-17    llemmx    -Frame gap on the reactor timer wheel
+//------------------------------------------------------------------------------
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GLOG4C_MODULE GLOG4C_MOD_ASYNCOMM
+#include "glog4c.h"
+#include "ringbuf.h"
+#include "asyncomm.h"
+
+#define SERIAL_RX_SIZE 4096 // 接收缓冲区尺寸
+#define SERIAL_TX_SIZE 4096 // 发送缓冲区尺寸
+
+// 串口通道
+typedef struct asyserial {
+    int              fd;      // 串口句柄
+    asytimer         gap;     // 帧间隔定时器，与串口属于同一个通信线程
+    int              port;    // 端口编号
+    asyserial_cfg    cfg;     // 串口参数
+    ringbuf          rx;      // 接收缓冲区，只在通信线程中访问
+    ringbuf          tx;      // 发送缓冲区，受txlock保护
+    pthread_mutex_t  txlock;  // 发送锁，应用线程和通信线程都会发送
+    uint8_t         *frame;   // 数据跨越缓冲区尾部时用于拼接成完整的帧
+    asytxn          *txn;     // 请求/应答事务表，NULL表示收到的数据直接转发
+}asyserial;
+
+static int  serial_write(void *ctx, const void *buf, size_t size);
+static void serial_close(void *ctx);
+
+static const asyport_ops m_serial_ops = {serial_write, serial_close};
+
+// 波特率转换表
+static const struct {
+    uint32_t baud;
+    speed_t  speed;
+}m_bauds[] = {
+    {1200, B1200}, {2400, B2400}, {4800, B4800}, {9600, B9600}, {19200, B19200},
+    {38400, B38400}, {57600, B57600}, {115200, B115200}, {230400, B230400},
+    {460800, B460800}, {921600, B921600},
+};
+
+/******************************************************************************
+* Description    : 按配置设置串口参数，串口工作在原始模式.
+* Input          : fd - 串口句柄
+*                : cfg - 串口参数
+* Output         : None
+* Return         : 返回值参考头文件定义
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int serial_setup(int fd, const asyserial_cfg *cfg)
+{
+    struct termios tio;
+    speed_t speed = 0;
+
+    for (size_t idx = 0; idx < sizeof(m_bauds) / sizeof(m_bauds[0]); ++idx) {
+        if (m_bauds[idx].baud == cfg->baud) {
+            speed = m_bauds[idx].speed;
+            break;
+        }
+    }
+    if (0 == speed) {
+        glog4c_warn("Unsupported baud rate %u\n", cfg->baud);
+        return ASY_ER_PARAM;
+    }
+    if (tcgetattr(fd, &tio) < 0) {
+        glog4c_err(strerror(errno));
+        return ASY_ER_PARAM;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+    tio.c_cflag |= CLOCAL | CREAD;
+    switch (cfg->databits) {
+    case 5: tio.c_cflag |= CS5; break;
+    case 6: tio.c_cflag |= CS6; break;
+    case 7: tio.c_cflag |= CS7; break;
+    default: tio.c_cflag |= CS8; break;
+    }
+    if (2 == cfg->stopbits) {
+        tio.c_cflag |= CSTOPB;
+    }
+    if ('E' == cfg->parity || 'e' == cfg->parity) {
+        tio.c_cflag |= PARENB;
+        tio.c_iflag |= INPCK;
+    } else if ('O' == cfg->parity || 'o' == cfg->parity) {
+        tio.c_cflag |= PARENB | PARODD;
+        tio.c_iflag |= INPCK;
+    }
+    // 非阻塞模式下内核不使用这两个参数，这里仍然写入，便于外部工具查看串口设置
+    tio.c_cc[VMIN]  = cfg->vmin;
+    tio.c_cc[VTIME] = cfg->vtime;
+
+    if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+        glog4c_err(strerror(errno));
+        return ASY_ER_PARAM;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return ASY_OK;
+}
+
+// 一帧数据交给事务表匹配请求，没有启用事务时直接转发
+static int serial_deliver(asyserial *chn, const void *buf, size_t len)
+{
+    if (NULL != chn->txn) {
+        return asytxn_input(chn->txn, buf, len);
+    }
+    return asyncomm_forward(chn->port, buf, len);
+}
+
+// 将接收缓冲区中的数据作为一帧转发给应用，数据跨越缓冲区尾部时先拼接，返回转发结果
+static int serial_emit(asyserial *chn)
+{
+    struct iovec iov[2];
+    int cnt = ringbuf_data_vec(&chn->rx, iov);
+    int ret = ASY_OK;
+
+    if (1 == cnt) {
+        ret = serial_deliver(chn, iov[0].iov_base, iov[0].iov_len);
+        ringbuf_consume(&chn->rx, iov[0].iov_len);
+    } else if (2 == cnt) {
+        uint32_t len = ringbuf_read(&chn->rx, chn->frame, chn->rx.size);
+        ret = serial_deliver(chn, chn->frame, len);
+    }
+    return ret;
+}
+
+// 启动帧间隔定时器，每次收到数据都重新计时
+static void serial_arm_gap(asyserial *chn)
+{
+    asyncomm_timer_set(&chn->gap, (uint32_t)chn->cfg.vtime * 100);
+}
+
+// 把发送缓冲区中的数据写出，调用者需持有txlock
+static void serial_flush_tx(asyserial *chn)
+{
+    struct iovec iov[2];
+    int cnt;
+    ssize_t wsize;
+
+    while ((cnt = ringbuf_data_vec(&chn->tx, iov)) > 0) {
+        wsize = writev(chn->fd, iov, cnt);
+        if (wsize > 0) {
+            ringbuf_consume(&chn->tx, wsize);
+            continue;
+        }
+        if (wsize < 0 && EINTR == errno) {
+            continue;
+        }
+        if (wsize < 0 && EAGAIN != errno) {
+            glog4c_err(strerror(errno));
+        }
+        break;
+    }
+}
+
+/******************************************************************************
+* Description    : 串口事件回调.可读时把内核缓存的数据全部读入环形缓冲区，一次readv
+*                  可以同时填满缓冲区尾部和头部的空闲区域.
+* Input          : fd - 串口句柄
+*                : events - epoll事件
+*                : arg - 串口通道
+* Output         : None
+* Return         : 串口不会主动关闭，总是返回ASY_OK
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int serial_on_event(int fd, uint32_t events, void *arg)
+{
+    asyserial *chn = (asyserial *)arg;
+    struct iovec iov[2];
+    ssize_t rsize;
+    int cnt;
+
+    if (events & EPOLLOUT) {
+        pthread_mutex_lock(&chn->txlock);
+        serial_flush_tx(chn);
+        pthread_mutex_unlock(&chn->txlock);
+    }
+    if (0 == (events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+        return ASY_OK;
+    }
+
+    for (;;) {
+        cnt = ringbuf_space_vec(&chn->rx, iov);
+        if (0 == cnt) { // 缓冲区满，先把已有数据作为一帧转发
+            if (ASY_ER_BUSY == serial_emit(chn)) {
+                return ASY_OK; // 积压达到高水位，已经停止读取
+            }
+            continue;
+        }
+        rsize = readv(fd, iov, cnt);
+        if (rsize > 0) {
+            ringbuf_produce(&chn->rx, rsize);
+            continue;
+        }
+        if (rsize < 0 && EINTR == errno) {
+            continue;
+        }
+        if (rsize < 0 && EAGAIN != errno) {
+            // 例如USB串口被拔出时返回EIO，边沿触发模式下不会重复通知，不会空转
+            glog4c_err(strerror(errno));
+        }
+        break;
+    }
+
+    if (0 == ringbuf_used(&chn->rx)) {
+        return ASY_OK;
+    }
+    if (chn->cfg.vmin > 0 && ringbuf_used(&chn->rx) >= chn->cfg.vmin) {
+        serial_emit(chn);
+    } else if (chn->cfg.vtime > 0) {
+        serial_arm_gap(chn);
+    } else if (0 == chn->cfg.vmin) {
+        serial_emit(chn);
+    }
+    return ASY_OK;
+}
+
+// 帧间隔到期，缓存的数据作为一帧转发
+static void serial_on_gap(void *arg)
+{
+    asyserial *chn = (asyserial *)arg;
+
+    if (ringbuf_used(&chn->rx) > 0) {
+        serial_emit(chn);
+    }
+}
+
+// 释放串口通道，由通信线程在通道不再被引用时调用
+static void serial_release(void *arg)
+{
+    asyserial *chn = (asyserial *)arg;
+
+    // 先删除端口，等待正在发送的线程退出
+    asyncomm_port_del(chn->port);
+    asytxn_free(chn->txn);
+    asyncomm_timer_cancel(&chn->gap);
+    close(chn->fd);
+    ringbuf_free(&chn->rx);
+    ringbuf_free(&chn->tx);
+    pthread_mutex_destroy(&chn->txlock);
+    free(chn->frame);
+    free(chn);
+}
+
+/******************************************************************************
+* Description    : 打开串口并注册到通信线程.
+* Input          : dev - 串口设备路径
+*                : cfg - 串口参数
+* Output         : None
+* Return         : 成功返回端口编号，失败返回头文件中定义的错误码
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 帧间隔定时器改为时间轮中的定时器
+******************************************************************************/
+int asyncomm_open_serial(const char *dev, const asyserial_cfg *cfg)
+{
+    int ret;
+
+    if (NULL == dev || NULL == cfg) {
+        return ASY_ER_PARAM;
+    }
+    int fd = open(dev, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        glog4c_err(strerror(errno));
+        glog4c_warn("Can't open serial %s\n", dev);
+        return ASY_ER_PARAM;
+    }
+    ret = serial_setup(fd, cfg);
+    if (ret != ASY_OK) {
+        close(fd);
+        return ret;
+    }
+
+    asyserial *chn = (asyserial *)calloc(1, sizeof(asyserial));
+    if (NULL == chn) {
+        close(fd);
+        return ASY_ER_FMEM;
+    }
+    chn->fd  = fd;
+    chn->cfg = *cfg;
+    chn->frame = (uint8_t *)malloc(SERIAL_RX_SIZE);
+    pthread_mutex_init(&chn->txlock, NULL);
+    if (NULL == chn->frame
+        || ringbuf_init(&chn->rx, SERIAL_RX_SIZE) != RINGBUF_OK
+        || ringbuf_init(&chn->tx, SERIAL_TX_SIZE) != RINGBUF_OK) {
+        ret = ASY_ER_FMEM;
+        goto EXIT_OS;
+    }
+
+    // 端口号要先于注册分配，收到的数据以端口号标识来源
+    chn->port = asyncomm_port_add(chn, &m_serial_ops);
+    if (chn->port < 0) {
+        ret = chn->port;
+        goto EXIT_OS;
+    }
+    asyncomm_port_flow(chn->port, cfg->flow);
+    // 串口是半双工的，一次只能有一个请求在途，应答按帧间隔成帧.事务表要先于注册建立
+    if (cfg->txn.window > 0) {
+        asytxn_cfg tcfg = cfg->txn;
+        tcfg.window = 1;
+        chn->txn = asytxn_new(chn->port, &tcfg, serial_write, chn, -1);
+        if (NULL == chn->txn) {
+            glog4c_warn("serial port=%d transaction disabled\n", chn->port);
+        } else {
+            asyncomm_port_txn(chn->port, chn->txn);
+        }
+    }
+    // 定时器与串口在同一个通信线程，接收缓冲区不需要加锁.定时器先于注册初始化，
+    // 注册后串口立即可能收到数据
+    ret = asyncomm_timer_init(&chn->gap, -1, serial_on_gap, chn);
+    if (ret == ASY_OK) {
+        ret = asyncomm_attach_at(fd, asyncomm_timer_reactor(&chn->gap), EPOLLIN | EPOLLOUT, serial_on_event, chn);
+    }
+    if (ret != ASY_OK) {
+        asyncomm_port_del(chn->port);
+        asytxn_free(chn->txn);
+        goto EXIT_OS;
+    }
+    asyncomm_set_release(fd, serial_release);
+    asyncomm_set_port(fd, chn->port);
+
+    glog4c_info("Open serial %s fd=%d port=%d baud=%u\n", dev, fd, chn->port, cfg->baud);
+    return chn->port;
+
+EXIT_OS:
+    ringbuf_free(&chn->rx);
+    ringbuf_free(&chn->tx);
+    pthread_mutex_destroy(&chn->txlock);
+    free(chn->frame);
+    free(chn);
+    close(fd);
+    return ret;
+}
+
+/******************************************************************************
+* Description    : 向串口发送数据.发送缓冲区为空时直接写串口，写不完的部分放入发送缓冲区，
+*                  由通信线程在串口可写时继续发送.
+* Input          : ctx - 串口通道
+*                : buf - 数据
+*                : size - 数据长度
+* Output         : None
+* Return         : 成功返回接收的字节数，发送缓冲区满时返回ASY_ER_AGAIN
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int serial_write(void *ctx, const void *buf, size_t size)
+{
+    asyserial *chn = (asyserial *)ctx;
+    const uint8_t *pos = (const uint8_t *)buf;
+    size_t done = 0;
+
+    pthread_mutex_lock(&chn->txlock);
+    if (0 == ringbuf_used(&chn->tx)) {
+        while (done < size) {
+            ssize_t wsize = write(chn->fd, pos + done, size - done);
+            if (wsize > 0) {
+                done += wsize;
+            } else if (wsize < 0 && EINTR == errno) {
+                continue;
+            } else {
+                break;
+            }
+        }
+    }
+    done += ringbuf_write(&chn->tx, pos + done, size - done);
+    pthread_mutex_unlock(&chn->txlock);
+
+    return (0 == done && size > 0) ? ASY_ER_AGAIN : (int)done;
+}
+
+// 关闭串口，通道由通信线程在当前批次事件处理完后释放
+static void serial_close(void *ctx)
+{
+    asyserial *chn = (asyserial *)ctx;
+
+    asyncomm_remove(chn->fd);
+}
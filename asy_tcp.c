@@ -0,0 +1,882 @@
+//------------------------------------------------------------------------------
+// Protability:       gunc99.
+// Design Pattern:    None.
+// Base Classes:      None.
+// MultiThread Safe:  Writes through asyncomm_write.
+// Exception Safe:    No Creation, No process
+// Library/package:   None.
+// Source files:      asy_tcp.c
+// Related Document:  None.
+// Organize:
+// Email:             llemmx@gmail.com
+//------------------------------------------------------------------------------
+// Release Note:
+//     TCP通道。服务端在每个通信线程上各自创建一个SO_REUSEPORT监听句柄，由内核把
+//     新连接分散到各个线程；客户端非阻塞连接，断开后按指数退避时间自动重连。
+//     发送数据先挂到发送队列，再用sendmsg一次写出多个缓冲区；大块数据在内核支持
+//     时使用MSG_ZEROCOPY，缓冲区在内核发回完成通知后才释放。
+//------------------------------------------------------------------------------
+// Version    Date          Author    Note
+//------------------------------------------------------------------------------
+// 1.0.0      2026-10-17    llemmx    -Original
+//------------------------------------------------------------------------------
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // accept4需要GNU扩展
+#endif
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#define TCP_HAS_ZC 1 // 内核头文件支持零拷贝发送
+#else
+#define TCP_HAS_ZC 0
+#endif
+
+#define GLOG4C_MODULE GLOG4C_MOD_ASYNCOMM
+#include "glog4c.h"
+#include "asyncomm.h"
+#include "metric.h"
+
+#define TCP_ROLE_CLIENT 0 // 主动连接的客户端
+#define TCP_ROLE_CONN   1 // 服务端接受的连接
+
+#define TCP_IOV_MAX     64          // 单次sendmsg最多合并的缓冲区数量
+#define TCP_ZC_MIN      (16 << 10)  // 达到这个尺寸的数据才使用零拷贝发送
+#define TCP_TX_MAX      (1 << 20)   // 单个连接最多缓存的待发送字节数
+#define TCP_BACKOFF_MIN 100         // 重连退避时间下限，单位ms
+#define TCP_BACKOFF_MAX 30000       // 重连退避时间上限，单位ms
+#define TCP_BACKLOG     128         // 监听队列长度
+
+// 发送缓冲区
+typedef struct asybuf {
+    struct asybuf *next;
+    uint32_t len;    // 数据长度
+    uint32_t off;    // 已经发送的长度
+    uint32_t zc_seq; // 最后一次零拷贝发送的序号
+    int      zc;     // 是否有数据以零拷贝方式发送过
+    uint8_t  data[];
+}asybuf;
+
+// TCP连接，客户端在重连过程中保持不变，句柄随每次连接变化
+typedef struct asytcp {
+    int              role;       // 连接类型
+    int              fd;         // 当前连接句柄，未连接时为-1
+    int              tfd;        // 重连定时器，仅客户端使用
+    int              port;       // 端口编号
+    int              connected;  // 是否已经建立连接
+    int              closing;    // 是否正在关闭
+    uint32_t         backoff;    // 下一次重连的等待时间，单位ms
+    struct sockaddr_storage addr; // 对端地址
+    socklen_t        alen;
+    pthread_mutex_t  txlock;     // 保护发送队列和fd，应用线程与通信线程都会发送
+    asybuf          *txhead;     // 待发送队列
+    asybuf          *txtail;
+    uint32_t         txbytes;    // 待发送字节数
+    asybuf          *zchead;     // 等待零拷贝完成通知的缓冲区
+    asybuf          *zctail;
+    uint32_t         zc_next;    // 下一次零拷贝发送的序号
+    int              zc;         // 当前连接是否使用零拷贝
+    asytxn          *txn;        // 请求/应答事务表，仅客户端使用，NULL表示收到的数据直接转发
+}asytcp;
+
+// TCP服务端，每个通信线程一个监听句柄
+typedef struct asytcps {
+    int  port;    // 端口编号
+    int  nlfd;    // 监听句柄数量
+    int  alive;   // 尚未释放的监听句柄数量
+    int  flow;    // 接入连接的积压处理方式
+    int  lfds[];  // 监听句柄
+}asytcps;
+
+static int  tcp_write(void *ctx, const void *buf, size_t size);
+static void tcp_close(void *ctx);
+static void tcps_close(void *ctx);
+static void tcpc_connect(asytcp *tcp);
+
+static const asyport_ops m_tcp_ops  = {tcp_write, tcp_close};
+static const asyport_ops m_tcps_ops = {NULL, tcps_close};
+
+// 释放缓冲区链表
+static void tcp_free_bufs(asybuf *buf)
+{
+    while (NULL != buf) {
+        asybuf *next = buf->next;
+        free(buf);
+        buf = next;
+    }
+}
+
+// 已经发送完的缓冲区，做过零拷贝发送的需要等待完成通知，调用者需持有txlock
+static void tcp_retire(asytcp *tcp, asybuf *buf)
+{
+    if (!buf->zc) {
+        free(buf);
+        return;
+    }
+    buf->next = NULL;
+    if (NULL == tcp->zctail) {
+        tcp->zchead = buf;
+    } else {
+        tcp->zctail->next = buf;
+    }
+    tcp->zctail = buf;
+}
+
+// 弹出发送队列头部
+static asybuf *tcp_pop(asytcp *tcp)
+{
+    asybuf *buf = tcp->txhead;
+
+    tcp->txhead = buf->next;
+    if (NULL == tcp->txhead) {
+        tcp->txtail = NULL;
+    }
+    tcp->txbytes -= buf->len - buf->off;
+    return buf;
+}
+
+/******************************************************************************
+* Description    : 发送队列中的数据.普通数据合并成iovec一次sendmsg写出，大块数据在连接支持
+*                  时使用MSG_ZEROCOPY单独发送.调用者需持有txlock.
+* Input          : tcp - TCP连接
+* Output         : None
+* Return         : 0正常，写满时也返回0；-1表示连接出错
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int tcp_flush(asytcp *tcp)
+{
+    struct iovec iov[TCP_IOV_MAX];
+    struct msghdr msg;
+    ssize_t wsize;
+
+    while (NULL != tcp->txhead) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+#if TCP_HAS_ZC
+        asybuf *head = tcp->txhead;
+        if (tcp->zc && head->len - head->off >= TCP_ZC_MIN) {
+            iov[0].iov_base = head->data + head->off;
+            iov[0].iov_len  = head->len - head->off;
+            msg.msg_iovlen  = 1;
+            wsize = sendmsg(tcp->fd, &msg, MSG_ZEROCOPY | MSG_NOSIGNAL);
+            if (wsize > 0) {
+                // 每次成功的零拷贝调用对应一个完成序号
+                head->off     += wsize;
+                head->zc_seq   = tcp->zc_next++;
+                head->zc       = 1;
+                tcp->txbytes  -= wsize;
+                if (head->off == head->len) {
+                    tcp_retire(tcp, tcp_pop(tcp));
+                }
+                continue;
+            }
+            if (wsize < 0 && EINTR == errno) {
+                continue;
+            }
+            if (wsize < 0 && EAGAIN == errno) {
+                return 0;
+            }
+            if (wsize < 0 && ENOBUFS != errno) {
+                return -1;
+            }
+            // ENOBUFS表示超出了零拷贝可以锁定的内存，本次退回到普通发送
+        }
+#endif
+        int cnt = 0;
+        for (asybuf *buf = tcp->txhead; NULL != buf && cnt < TCP_IOV_MAX; buf = buf->next) {
+            iov[cnt].iov_base = buf->data + buf->off;
+            iov[cnt].iov_len  = buf->len - buf->off;
+            ++cnt;
+        }
+        msg.msg_iovlen = cnt;
+        wsize = sendmsg(tcp->fd, &msg, MSG_NOSIGNAL);
+        if (wsize < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return (EAGAIN == errno) ? 0 : -1;
+        }
+        // 按写出的字节数释放缓冲区
+        while (wsize > 0) {
+            asybuf *buf = tcp->txhead;
+            uint32_t left = buf->len - buf->off;
+            if ((size_t)wsize < left) {
+                buf->off     += wsize;
+                tcp->txbytes -= wsize;
+                break;
+            }
+            wsize -= left;
+            tcp_retire(tcp, tcp_pop(tcp));
+        }
+    }
+    return 0;
+}
+
+#if TCP_HAS_ZC
+// 读取错误队列中的零拷贝完成通知，释放内核已经不再引用的缓冲区
+static void tcp_zc_complete(asytcp *tcp)
+{
+    char ctrl[128];
+    struct msghdr msg;
+
+    for (;;) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        if (recvmsg(tcp->fd, &msg, MSG_ERRQUEUE) < 0) {
+            break;
+        }
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); NULL != cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            struct sock_extended_err *serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if (0 != serr->ee_errno || SO_EE_ORIGIN_ZEROCOPY != serr->ee_origin) {
+                continue;
+            }
+            pthread_mutex_lock(&tcp->txlock);
+            while (NULL != tcp->zchead && (int32_t)(tcp->zchead->zc_seq - serr->ee_data) <= 0) {
+                asybuf *buf = tcp->zchead;
+                tcp->zchead = buf->next;
+                free(buf);
+            }
+            if (NULL == tcp->zchead) {
+                tcp->zctail = NULL;
+            }
+            // 内核实际做了拷贝(例如回环地址)，零拷贝只会增加开销，后续关闭
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                tcp->zc = 0;
+            }
+            pthread_mutex_unlock(&tcp->txlock);
+        }
+    }
+}
+#endif
+
+// 新连接建立后的套接字设置
+static void tcp_setup(asytcp *tcp)
+{
+    int one = 1;
+
+    setsockopt(tcp->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    tcp->zc = 0;
+#if TCP_HAS_ZC
+    if (0 == setsockopt(tcp->fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one))) {
+        tcp->zc = 1;
+    }
+#endif
+}
+
+/******************************************************************************
+* Description    : TCP连接事件回调.处理连接完成、零拷贝完成通知、可写和可读事件，读到的
+*                  数据转发给应用.
+* Input          : fd - 连接句柄
+*                : events - epoll事件
+*                : arg - TCP连接
+* Output         : None
+* Return         : ASY_OK继续监听，ASY_CLOSE表示连接已经断开
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int tcp_on_event(int fd, uint32_t events, void *arg)
+{
+    asytcp *tcp = (asytcp *)arg;
+    char *rxbuf = asyncomm_rxbuf();
+    size_t rxsize = asyncomm_rxsize();
+    ssize_t rsize;
+    int err = 0;
+
+    if (!tcp->connected) {
+        // 非阻塞连接完成或失败时句柄变为可写
+        socklen_t len = sizeof(err);
+        if (0 == (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            return ASY_OK;
+        }
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || 0 != err) {
+            glog4c_warn("tcp connect port=%d failed: %s\n", tcp->port, strerror(err));
+            return ASY_CLOSE;
+        }
+        pthread_mutex_lock(&tcp->txlock);
+        tcp->connected = 1;
+        tcp->backoff   = TCP_BACKOFF_MIN;
+        pthread_mutex_unlock(&tcp->txlock);
+        glog4c_info("tcp port=%d connected\n", tcp->port);
+        events |= EPOLLOUT;
+    }
+#if TCP_HAS_ZC
+    if (events & EPOLLERR) {
+        tcp_zc_complete(tcp);
+    }
+#endif
+    if (events & EPOLLOUT) {
+        pthread_mutex_lock(&tcp->txlock);
+        err = tcp_flush(tcp);
+        pthread_mutex_unlock(&tcp->txlock);
+        if (err < 0) {
+            return ASY_CLOSE;
+        }
+    }
+
+    for (;;) {
+        rsize = recv(fd, rxbuf, rxsize, 0);
+        if (rsize > 0) {
+            int fret = (NULL != tcp->txn) ? asytxn_input(tcp->txn, rxbuf, rsize)
+                : asyncomm_forward(tcp->port, rxbuf, rsize);
+            if (ASY_ER_BUSY == fret) {
+                return ASY_OK; // 积压达到高水位，已经停止读取，恢复时重新通知
+            }
+            continue;
+        }
+        if (0 == rsize) {
+            return ASY_CLOSE;
+        }
+        if (EINTR == errno) {
+            continue;
+        }
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            break;
+        }
+        return ASY_CLOSE;
+    }
+    if (events & (EPOLLRDHUP | EPOLLHUP)) {
+        return ASY_CLOSE;
+    }
+    return ASY_OK;
+}
+
+// 释放TCP连接的全部资源
+static void tcp_destroy(asytcp *tcp)
+{
+    asyncomm_port_del(tcp->port);
+    asytxn_free(tcp->txn);
+    tcp_free_bufs(tcp->txhead);
+    tcp_free_bufs(tcp->zchead);
+    pthread_mutex_destroy(&tcp->txlock);
+    free(tcp);
+}
+
+/******************************************************************************
+* Description    : 连接句柄释放回调.服务端连接直接释放，客户端关闭句柄后启动重连定时器.
+* Input          : arg - TCP连接
+* Output         : None
+* Return         : None
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+// 按退避时间启动重连定时器，每次失败后退避时间加倍
+static void tcpc_backoff(asytcp *tcp)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec  = tcp->backoff / 1000;
+    its.it_value.tv_nsec = (long)(tcp->backoff % 1000) * 1000000L;
+    timerfd_settime(tcp->tfd, 0, &its, NULL);
+    glog4c_info("tcp port=%d reconnect after %u ms\n", tcp->port, tcp->backoff);
+    tcp->backoff = (tcp->backoff << 1) > TCP_BACKOFF_MAX ? TCP_BACKOFF_MAX : (tcp->backoff << 1);
+}
+
+static void tcp_conn_release(void *arg)
+{
+    asytcp *tcp = (asytcp *)arg;
+
+    // 先在锁内摘除句柄，避免应用线程向已经关闭的句柄发送
+    pthread_mutex_lock(&tcp->txlock);
+    int fd = tcp->fd;
+    tcp->fd        = -1;
+    tcp->connected = 0;
+    // 已经关闭的连接收不到零拷贝完成通知，这些缓冲区直接释放
+    tcp_free_bufs(tcp->zchead);
+    tcp->zchead = NULL;
+    tcp->zctail = NULL;
+    pthread_mutex_unlock(&tcp->txlock);
+    close(fd);
+
+    if (TCP_ROLE_CONN == tcp->role || tcp->closing) {
+        glog4c_info("tcp port=%d closed\n", tcp->port);
+        tcp_destroy(tcp);
+        return;
+    }
+
+    // 客户端按退避时间重连，待发送的数据保留到重连成功后发送，在途请求超时后重发
+    if (NULL != tcp->txn) {
+        asytxn_link(tcp->txn);
+    }
+    tcpc_backoff(tcp);
+}
+
+// 重连定时器到期
+static int tcpc_on_timer(int fd, uint32_t events, void *arg)
+{
+    asytcp *tcp = (asytcp *)arg;
+    uint64_t expired;
+    ssize_t rret = read(fd, &expired, sizeof(expired));
+
+    (void)rret;
+    if (!tcp->closing && tcp->fd < 0) {
+        tcpc_connect(tcp);
+    }
+    return ASY_OK;
+}
+
+// 重连定时器释放回调，连接句柄还在时由连接句柄的释放回调回收
+static void tcpc_timer_release(void *arg)
+{
+    asytcp *tcp = (asytcp *)arg;
+
+    tcp->closing = 1;
+    close(tcp->tfd);
+    if (tcp->fd >= 0) {
+        asyncomm_remove(tcp->fd);
+        return;
+    }
+    tcp_destroy(tcp);
+}
+
+/******************************************************************************
+* Description    : 发起非阻塞连接，失败时启动重连定时器.在打开客户端时和重连定时器回调中调用.
+* Input          : tcp - TCP客户端
+* Output         : None
+* Return         : None
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static void tcpc_connect(asytcp *tcp)
+{
+    int fd = socket(tcp->addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        glog4c_err(strerror(errno));
+        tcpc_backoff(tcp);
+        return;
+    }
+    int ret = connect(fd, (struct sockaddr *)&tcp->addr, tcp->alen);
+    if (ret < 0 && EINPROGRESS != errno) {
+        // 立即失败时错误已经由connect返回，SO_ERROR中不会再有，这里直接进入重连
+        glog4c_warn("tcp connect port=%d failed: %s\n", tcp->port, strerror(errno));
+        close(fd);
+        tcpc_backoff(tcp);
+        return;
+    }
+
+    pthread_mutex_lock(&tcp->txlock);
+    tcp->fd        = fd;
+    tcp->connected = 0;
+    tcp_setup(tcp);
+    pthread_mutex_unlock(&tcp->txlock);
+
+    // 连接句柄与重连定时器在同一个通信线程，状态切换不需要额外同步
+    if (asyncomm_attach(fd, tcp->tfd, EPOLLIN | EPOLLOUT | EPOLLRDHUP, tcp_on_event, tcp) != ASY_OK) {
+        pthread_mutex_lock(&tcp->txlock);
+        tcp->fd = -1;
+        pthread_mutex_unlock(&tcp->txlock);
+        close(fd);
+        tcpc_backoff(tcp);
+        return;
+    }
+    asyncomm_set_release(fd, tcp_conn_release);
+    asyncomm_set_port(fd, tcp->port);
+}
+
+// 解析地址，host为NULL或空字符串时使用通配地址
+static int tcp_resolve(const char *host, uint16_t port, int passive, struct sockaddr_storage *addr, socklen_t *alen)
+{
+    struct addrinfo hints, *res = NULL;
+    char service[8];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = passive ? AI_PASSIVE : 0;
+    snprintf(service, sizeof(service), "%u", port);
+    if (NULL != host && '\0' == host[0]) {
+        host = NULL;
+    }
+    int ret = getaddrinfo(host, service, &hints, &res);
+    if (0 != ret || NULL == res) {
+        glog4c_warn("resolve %s:%u failed: %s\n", NULL == host ? "*" : host, port, gai_strerror(ret));
+        return ASY_ER_PARAM;
+    }
+    memcpy(addr, res->ai_addr, res->ai_addrlen);
+    *alen = res->ai_addrlen;
+    freeaddrinfo(res);
+    return ASY_OK;
+}
+
+// 创建TCP连接对象
+static asytcp *tcp_new(int role)
+{
+    asytcp *tcp = (asytcp *)calloc(1, sizeof(asytcp));
+
+    if (NULL == tcp) {
+        return NULL;
+    }
+    tcp->role    = role;
+    tcp->fd      = -1;
+    tcp->tfd     = -1;
+    tcp->backoff = TCP_BACKOFF_MIN;
+    pthread_mutex_init(&tcp->txlock, NULL);
+    return tcp;
+}
+
+/******************************************************************************
+* Description    : 打开TCP客户端.连接过程完全由通信线程驱动，断开后自动重连.
+* Input          : host - 服务端地址
+*                : port - 服务端端口
+*                : flow - 应用队列拥塞时的积压处理方式，ASY_FLOW_xxx.ASY_FLOW_LATEST需要
+*                         启用事务并配置长度字段
+*                : txn - 事务参数，NULL或window为0时不启用，没有长度字段时window按1处理
+* Output         : None
+* Return         : 成功返回端口编号，失败返回头文件中定义的错误码
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 增加积压处理方式
+*                : 2026-10-17 : 1.2.0 : 增加请求/应答事务
+*                : 2026-10-17 : 1.2.1 : 没有长度字段时拒绝ASY_FLOW_LATEST
+*                : 2026-10-17 : 1.2.2 : 没有长度字段时事务窗口限制为1
+******************************************************************************/
+int asyncomm_open_tcpc(const char *host, uint16_t port, int flow, const asytxn_cfg *txn)
+{
+    int ret;
+
+    if (NULL == host) {
+        return ASY_ER_PARAM;
+    }
+    // 字节流没有成帧时一次读取不是完整的消息，latest合并会留下被截断的尾部
+    if (ASY_FLOW_LATEST == flow && (NULL == txn || 0 == txn->window || txn->len_off < 0)) {
+        glog4c_err("tcp client flow latest needs length framed transactions\n");
+        return ASY_ER_PARAM;
+    }
+    asytcp *tcp = tcp_new(TCP_ROLE_CLIENT);
+    if (NULL == tcp) {
+        return ASY_ER_FMEM;
+    }
+    ret = tcp_resolve(host, port, 0, &tcp->addr, &tcp->alen);
+    if (ret != ASY_OK) {
+        goto EXIT_TC;
+    }
+    tcp->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tcp->tfd < 0) {
+        ret = ASY_ER_EPOLL;
+        goto EXIT_TC;
+    }
+    tcp->port = asyncomm_port_add(tcp, &m_tcp_ops);
+    if (tcp->port < 0) {
+        ret = tcp->port;
+        goto EXIT_TC;
+    }
+    asyncomm_port_flow(tcp->port, flow);
+    ret = asyncomm_attach(tcp->tfd, -1, EPOLLIN, tcpc_on_timer, tcp);
+    if (ret != ASY_OK) {
+        asyncomm_port_del(tcp->port);
+        goto EXIT_TC;
+    }
+    asyncomm_set_release(tcp->tfd, tcpc_timer_release);
+    // 设备支持时多个请求以流水线方式同时在途，超时定时器与重连定时器在同一个通信线程
+    if (NULL != txn && txn->window > 0) {
+        asytxn_cfg tcfg = *txn;
+        // 字节流没有长度字段时只能把一次读取当作一个应答，一个报文段中的多个应答无法拆开，
+        // 只能一次一个请求在途
+        if (tcfg.window > 1 && tcfg.len_off < 0) {
+            glog4c_warn("tcp port=%d txn window %u needs a length field, use 1\n", tcp->port, tcfg.window);
+            tcfg.window = 1;
+        }
+        tcp->txn = asytxn_new(tcp->port, &tcfg, tcp_write, tcp, tcp->tfd);
+        if (NULL == tcp->txn) {
+            glog4c_warn("tcp port=%d transaction disabled\n", tcp->port);
+            if (ASY_FLOW_LATEST == flow) {
+                glog4c_warn("tcp port=%d flow falls back to oldest\n", tcp->port);
+                asyncomm_port_flow(tcp->port, ASY_FLOW_OLDEST);
+            }
+        } else {
+            asyncomm_port_txn(tcp->port, tcp->txn);
+        }
+    }
+    // 第一次连接也放到通信线程中发起，与重连走相同的路径
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_nsec = 1;
+    timerfd_settime(tcp->tfd, 0, &its, NULL);
+
+    glog4c_info("Open tcp client %s:%u port=%d\n", host, port, tcp->port);
+    return tcp->port;
+
+EXIT_TC:
+    if (tcp->tfd >= 0) {
+        close(tcp->tfd);
+    }
+    pthread_mutex_destroy(&tcp->txlock);
+    free(tcp);
+    return ret;
+}
+
+/******************************************************************************
+* Description    : 发送数据.连接空闲时先直接发送，剩余部分拷贝到发送队列，由通信线程在
+*                  可写时继续发送；客户端未连接时数据缓存到重连成功后发送.
+* Input          : ctx - TCP连接
+*                : buf - 数据
+*                : size - 数据长度
+* Output         : None
+* Return         : 成功返回接收的字节数，发送队列满时返回ASY_ER_AGAIN
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int tcp_write(void *ctx, const void *buf, size_t size)
+{
+    asytcp *tcp = (asytcp *)ctx;
+    const uint8_t *pos = (const uint8_t *)buf;
+    size_t done = 0;
+    int ret = ASY_OK;
+
+    pthread_mutex_lock(&tcp->txlock);
+    if (tcp->txbytes + size > TCP_TX_MAX) {
+        pthread_mutex_unlock(&tcp->txlock);
+        return ASY_ER_AGAIN;
+    }
+    // 小块数据在队列为空时直接发送，省去一次拷贝和内存申请
+    if (tcp->connected && NULL == tcp->txhead && size < TCP_ZC_MIN) {
+        ssize_t wsize = send(tcp->fd, pos, size, MSG_NOSIGNAL);
+        if (wsize > 0) {
+            done = wsize;
+        }
+    }
+    if (done < size) {
+        asybuf *node = (asybuf *)malloc(sizeof(asybuf) + size - done);
+        if (NULL == node) {
+            pthread_mutex_unlock(&tcp->txlock);
+            return (0 == done) ? ASY_ER_FMEM : (int)done;
+        }
+        metric_add(METRIC_ALLOC, 1);
+        node->next = NULL;
+        node->len  = size - done;
+        node->off  = 0;
+        node->zc   = 0;
+        memcpy(node->data, pos + done, node->len);
+        if (NULL == tcp->txtail) {
+            tcp->txhead = node;
+        } else {
+            tcp->txtail->next = node;
+        }
+        tcp->txtail   = node;
+        tcp->txbytes += node->len;
+        if (tcp->connected) {
+            ret = tcp_flush(tcp);
+        }
+    }
+    pthread_mutex_unlock(&tcp->txlock);
+    // 出错的连接由通信线程在收到EPOLLERR/EPOLLHUP时关闭
+    (void)ret;
+    return (int)size;
+}
+
+// 关闭TCP连接，客户端通过注销重连定时器关闭，资源在释放回调中回收
+static void tcp_close(void *ctx)
+{
+    asytcp *tcp = (asytcp *)ctx;
+
+    if (TCP_ROLE_CLIENT == tcp->role) {
+        asyncomm_remove(tcp->tfd);
+    } else {
+        asyncomm_remove(tcp->fd);
+    }
+}
+
+/******************************************************************************
+* Description    : 监听句柄事件回调，循环accept4直到EAGAIN，新连接注册到监听句柄所在的线程.
+* Input          : fd - 监听句柄
+*                : events - epoll事件
+*                : arg - TCP服务端
+* Output         : None
+* Return         : 总是返回ASY_OK
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int tcps_on_accept(int fd, uint32_t events, void *arg)
+{
+    asytcps *srv = (asytcps *)arg;
+
+    for (;;) {
+        struct sockaddr_storage addr;
+        socklen_t alen = sizeof(addr);
+        int cfd = accept4(fd, (struct sockaddr *)&addr, &alen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd < 0) {
+            if (EINTR == errno || ECONNABORTED == errno) {
+                continue;
+            }
+            if (EAGAIN != errno && EWOULDBLOCK != errno) {
+                // 文件句柄耗尽等错误，等待下一次连接事件再处理
+                glog4c_err(strerror(errno));
+            }
+            break;
+        }
+        asytcp *tcp = tcp_new(TCP_ROLE_CONN);
+        if (NULL == tcp) {
+            close(cfd);
+            continue;
+        }
+        tcp->fd        = cfd;
+        tcp->connected = 1;
+        tcp->addr      = addr;
+        tcp->alen      = alen;
+        tcp_setup(tcp);
+        tcp->port = asyncomm_port_add(tcp, &m_tcp_ops);
+        if (tcp->port < 0) {
+            close(cfd);
+            pthread_mutex_destroy(&tcp->txlock);
+            free(tcp);
+            continue;
+        }
+        asyncomm_port_flow(tcp->port, srv->flow);
+        if (asyncomm_attach(cfd, fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP, tcp_on_event, tcp) != ASY_OK) {
+            close(cfd);
+            tcp_destroy(tcp);
+            continue;
+        }
+        asyncomm_set_release(cfd, tcp_conn_release);
+        asyncomm_set_port(cfd, tcp->port);
+        glog4c_info("tcp server port=%d accept port=%d\n", srv->port, tcp->port);
+    }
+    return ASY_OK;
+}
+
+// 监听句柄释放回调，最后一个监听句柄释放时回收服务端
+static void tcps_release(void *arg)
+{
+    asytcps *srv = (asytcps *)arg;
+
+    if (0 == __atomic_sub_fetch(&srv->alive, 1, __ATOMIC_ACQ_REL)) {
+        asyncomm_port_del(srv->port);
+        for (int idx = 0; idx < srv->nlfd; ++idx) {
+            close(srv->lfds[idx]);
+        }
+        free(srv);
+    }
+}
+
+// 关闭服务端，只停止监听，已经建立的连接通过各自的端口关闭
+static void tcps_close(void *ctx)
+{
+    asytcps *srv = (asytcps *)ctx;
+
+    for (int idx = 0; idx < srv->nlfd; ++idx) {
+        asyncomm_remove(srv->lfds[idx]);
+    }
+}
+
+// 创建一个SO_REUSEPORT监听句柄
+static int tcps_listen(const struct sockaddr_storage *addr, socklen_t alen)
+{
+    int one = 1;
+    int fd = socket(addr->ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0
+        || bind(fd, (const struct sockaddr *)addr, alen) < 0
+        || listen(fd, TCP_BACKLOG) < 0) {
+        glog4c_err(strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/******************************************************************************
+* Description    : 打开TCP服务端.每个通信线程各自监听一个SO_REUSEPORT句柄，内核按连接把
+*                  负载分散到各个线程，接受的连接与监听句柄在同一个线程处理.
+* Input          : host - 监听地址，NULL或空字符串表示所有地址
+*                : port - 监听端口
+*                : flow - 接入连接在应用队列拥塞时的积压处理方式，ASY_FLOW_xxx，接入连接
+*                         是字节流，不支持ASY_FLOW_LATEST
+* Output         : None
+* Return         : 成功返回端口编号，失败返回头文件中定义的错误码
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 增加积压处理方式
+*                : 2026-10-17 : 1.1.1 : 拒绝ASY_FLOW_LATEST，注册全部失败时返回错误
+******************************************************************************/
+int asyncomm_open_tcps(const char *host, uint16_t port, int flow)
+{
+    struct sockaddr_storage addr;
+    socklen_t alen;
+    int nrt = asyncomm_nreactor();
+    int ret;
+
+    if (nrt <= 0) {
+        return ASY_ER_PARAM;
+    }
+    if (ASY_FLOW_LATEST == flow) {
+        glog4c_err("tcp server does not support flow latest\n");
+        return ASY_ER_PARAM;
+    }
+    ret = tcp_resolve(host, port, 1, &addr, &alen);
+    if (ret != ASY_OK) {
+        return ret;
+    }
+    asytcps *srv = (asytcps *)calloc(1, sizeof(asytcps) + sizeof(int) * nrt);
+    if (NULL == srv) {
+        return ASY_ER_FMEM;
+    }
+    srv->flow = flow;
+    for (srv->nlfd = 0; srv->nlfd < nrt; ++srv->nlfd) {
+        int fd = tcps_listen(&addr, alen);
+        if (fd < 0) {
+            ret = ASY_ER_PARAM;
+            goto EXIT_TS;
+        }
+        srv->lfds[srv->nlfd] = fd;
+    }
+    srv->port = asyncomm_port_add(srv, &m_tcps_ops);
+    if (srv->port < 0) {
+        ret = srv->port;
+        goto EXIT_TS;
+    }
+    // 释放计数在注册前设置好，注册后释放回调随时可能被调用.注册失败的句柄直接减少计数，
+    // 全部失败时最后一次减少会释放srv并删除端口，之后不能再访问srv
+    int sport = srv->port;
+    int nlfd = srv->nlfd;
+    int nok = 0;
+    srv->alive = nlfd;
+    for (int idx = 0; idx < nlfd; ++idx) {
+        int fd = srv->lfds[idx];
+        ret = asyncomm_attach_at(fd, idx, EPOLLIN, tcps_on_accept, srv);
+        if (ret != ASY_OK) {
+            glog4c_err("register tcp listener error.\n");
+            tcps_release(srv);
+            continue;
+        }
+        asyncomm_set_release(fd, tcps_release);
+        ++nok;
+    }
+    if (0 == nok) {
+        return ret;
+    }
+
+    glog4c_info("Open tcp server %s:%u port=%d listeners=%d/%d\n", NULL == host ? "*" : host, port, sport, nok, nlfd);
+    return sport;
+
+EXIT_TS:
+    for (int idx = 0; idx < srv->nlfd; ++idx) {
+        close(srv->lfds[idx]);
+    }
+    free(srv);
+    return ret;
+}
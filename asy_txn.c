@@ -0,0 +1,509 @@
+//------------------------------------------------------------------------------
+// Protability:       gunc99.
+// Design Pattern:    None.
+// Base Classes:      None.
+// MultiThread Safe:  asytxn_request/asyncomm_request.
+// Exception Safe:    No Creation, No process
+// Library/package:   None.
+// Source files:      asy_txn.c
+// Related Document:  None.
+// Organize:
+// Email:             llemmx@gmail.com
+//------------------------------------------------------------------------------
+// Release Note:
+//     请求/应答事务。应用以CODEC_CMD_REQ发送带标签的请求，每个端口的事务表记录
+//     在途的请求，设备的应答按序号或发送顺序匹配后以CODEC_CMD_RESP带回标签返回。
+//     支持流水线的链路最多同时发出window个请求，半双工串口一次只发一个；超出的
+//     请求在等待队列中排队，应答或超时后依次发出。超时由通信线程时间轮中的定时器
+//     驱动，定时器只在最早的截止时间提前时重新设置，超时后按次数重发。
+//------------------------------------------------------------------------------
+// Version    Date          Author    Note
+//------------------------------------------------------------------------------
+// 1.0.0      2026-10-17    llemmx    -Original
+// 1.1.0      2026-10-17    llemmx    -Timeouts on the reactor timer wheel
+//------------------------------------------------------------------------------
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GLOG4C_MODULE GLOG4C_MOD_ASYNCOMM
+#include "glog4c.h"
+#include "db_in_mem.h"
+#include "ringbuf.h"
+#include "codec.h"
+#include "asyncomm.h"
+#include "metric.h"
+#include "appq.h"
+
+#define TXN_QUEUE_SIZE (16 << 10) // 等待队列尺寸，记录格式为 标签4B | 长度2B | 请求
+#define TXN_RESP_HEAD  5          // 应答条目值的头部，标签4B | 状态1B
+#define TXN_RETRY_NS   1000000ULL // 应用队列满时重发应答帧的间隔
+
+// 在途请求
+typedef struct {
+    int      used;     // 是否在途
+    uint32_t tag;      // 应用指定的标签
+    uint32_t order;    // 发送顺序，按顺序匹配时应答属于最早的请求
+    uint16_t seq;      // 写入请求的序号
+    uint16_t tries;    // 已经发送的次数
+    uint64_t deadline; // 应答截止时间，单调时钟ns
+    uint64_t start;    // 第一次发送的采样时间
+    uint32_t len;      // 请求长度
+    uint32_t cap;      // 请求缓冲区容量，只增不减，稳定后不再申请内存
+    uint8_t *buf;      // 请求内容，重发时使用
+}txnslot;
+
+// 端口的事务表，通信线程和应用线程都会访问，除rx外受lock保护
+struct asytxn {
+    int              port;    // 端口编号
+    asytxn_cfg       cfg;     // 事务参数
+    int            (*write)(void *, const void *, size_t); // 通道的发送操作
+    void            *ctx;     // 通道私有数据，通道释放后为NULL
+    asytimer         timer;   // 超时定时器
+    pthread_mutex_t  lock;
+    txnslot         *slots;   // window个在途请求
+    int              nused;   // 在途请求数量
+    uint32_t         order;   // 下一个发送顺序
+    uint16_t         seq;     // 下一个序号
+    uint64_t         armed;   // 定时器设置的到期时间，0表示未设置
+    ringbuf          queue;   // 等待队列
+    uint8_t         *rx;      // 按长度字段拼接应答，只在所属通信线程中访问
+    uint32_t         rxlen;
+    uint32_t         rxcap;
+    char            *txbuf;   // 应答帧缓冲区，尺寸与应用队列消息尺寸一致
+    codec_writer     resp;    // 正在组帧的应答
+    int              pending; // 应答帧因为应用队列满而未发出
+};
+
+static inline uint16_t txn_rd16(const uint8_t *pos)
+{
+    return (uint16_t)((pos[0] << 8) | pos[1]);
+}
+
+static inline void txn_wr16(uint8_t *pos, uint16_t val)
+{
+    pos[0] = (uint8_t)(val >> 8);
+    pos[1] = (uint8_t)val;
+}
+
+// 发送已经组好的应答帧，应用队列满时保留，由定时器重发
+static void txn_flush(asytxn *txn)
+{
+    if (0 == txn->resp.count) {
+        return;
+    }
+    uint16_t count = txn->resp.count;
+    int ret = appq_send(txn->txbuf, codec_end(&txn->resp));
+    if (APPQ_ER_AGAIN == ret) {
+        txn->pending = 1;
+        return;
+    }
+    if (APPQ_OK != ret) {
+        glog4c_err("send response to app failed!\n");
+        metric_add(METRIC_ASY_DROP, count);
+    }
+    txn->pending = 0;
+    codec_begin(&txn->resp, txn->txbuf, asyncomm_msgsize(), CODEC_CMD_RESP, DB_BLOB, 0);
+}
+
+// 追加一条应答，值在帧中原地组装.帧空间不足时先发送，应用队列满时丢弃这条应答
+static void txn_emit(asytxn *txn, uint32_t tag, uint8_t status, const void *data, uint32_t len)
+{
+    size_t max = asyncomm_msgsize() - CODEC_HEAD_SIZE - 4 - TXN_RESP_HEAD;
+
+    if (len > max) {
+        len = (uint32_t)max;
+    }
+    size_t need = codec_item_size(DB_BLOB, (uint16_t)(TXN_RESP_HEAD + len));
+    if (txn->resp.cap - txn->resp.len < need || 0xFFFF == txn->resp.count) {
+        txn_flush(txn);
+        if (txn->pending) {
+            metric_add(METRIC_ASY_DROP, 1);
+            return;
+        }
+    }
+    uint8_t *val = txn->resp.buf + txn->resp.len + 4; // 条目头之后
+    memcpy(val, &tag, sizeof(tag));
+    val[4] = status;
+    if (len > 0) {
+        memcpy(val + TXN_RESP_HEAD, data, len);
+    }
+    codec_put(&txn->resp, (uint16_t)txn->port, val, (uint16_t)(TXN_RESP_HEAD + len));
+}
+
+// 设置超时定时器，只在新的截止时间早于已经设置的时间时重新启动
+static void txn_arm(asytxn *txn, uint64_t now)
+{
+    uint64_t next = txn->pending ? now + TXN_RETRY_NS : 0;
+
+    for (int idx = 0; idx < txn->cfg.window; ++idx) {
+        if (txn->slots[idx].used && (0 == next || txn->slots[idx].deadline < next)) {
+            next = txn->slots[idx].deadline;
+        }
+    }
+    // 定时器提前到期时重新计算，不需要跟随每次应答推迟
+    if (0 == next || (0 != txn->armed && txn->armed <= next)) {
+        return;
+    }
+    asyncomm_timer_at(&txn->timer, next);
+    txn->armed = next;
+}
+
+// 发送在途请求，写入失败或只写入一部分时等待超时重发
+static void txn_send(asytxn *txn, txnslot *slot, uint64_t now)
+{
+    ++slot->tries;
+    slot->deadline = now + (uint64_t)txn->cfg.timeout * 1000000ULL;
+    if (NULL == txn->ctx) {
+        return;
+    }
+    int ret = txn->write(txn->ctx, slot->buf, slot->len);
+    if (ret < 0 || (uint32_t)ret < slot->len) {
+        glog4c_debug("txn port=%d write %d/%u, wait for retry\n", txn->port, ret, slot->len);
+    }
+}
+
+// 占用一个空闲的在途位置并发送请求，调用者保证有空闲位置
+static int txn_start(asytxn *txn, uint32_t tag, const void *buf, uint32_t len, uint64_t now)
+{
+    txnslot *slot = txn->slots;
+
+    while (slot->used) {
+        ++slot;
+    }
+    if (slot->cap < len) {
+        uint8_t *tmp = (uint8_t *)realloc(slot->buf, len);
+        if (NULL == tmp) {
+            return ASY_ER_FMEM;
+        }
+        metric_add(METRIC_ALLOC, 1);
+        slot->buf = tmp;
+        slot->cap = len;
+    }
+    memcpy(slot->buf, buf, len);
+    slot->used  = 1;
+    slot->tag   = tag;
+    slot->order = txn->order++;
+    slot->seq   = txn->seq++;
+    slot->tries = 0;
+    slot->len   = len;
+    slot->start = metric_begin(METRIC_H_TXN_RTT);
+    if (txn->cfg.seq_off >= 0 && len >= (uint32_t)txn->cfg.seq_off + 2) {
+        txn_wr16(slot->buf + txn->cfg.seq_off, slot->seq);
+    }
+    ++txn->nused;
+    metric_add(METRIC_TXN_REQ, 1);
+    txn_send(txn, slot, now);
+    return ASY_OK;
+}
+
+// 等待队列中的请求依次占用空闲的在途位置
+static void txn_dequeue(asytxn *txn, uint64_t now)
+{
+    uint32_t tag;
+    uint16_t len;
+
+    while (txn->nused < txn->cfg.window && ringbuf_used(&txn->queue) > 0) {
+        ringbuf_read(&txn->queue, &tag, sizeof(tag));
+        ringbuf_read(&txn->queue, &len, sizeof(len));
+        ringbuf_read(&txn->queue, txn->rx + txn->rxcap, len); // rx之后的暂存区
+        if (txn_start(txn, tag, txn->rx + txn->rxcap, len, now) != ASY_OK) {
+            txn_emit(txn, tag, ASY_TXN_BUSY, NULL, 0);
+        }
+    }
+}
+
+// 结束一个在途请求
+static void txn_done(asytxn *txn, txnslot *slot, uint8_t status, const void *data, uint32_t len)
+{
+    txn_emit(txn, slot->tag, status, data, len);
+    slot->used = 0;
+    --txn->nused;
+}
+
+/******************************************************************************
+* Description    : 为一个完整的应答查找在途请求.配置了序号位置时按序号匹配，否则属于最早
+*                  发出的请求.没有匹配的请求时作为普通数据转发给应用
+* Input          : txn - 事务表，调用者持有lock
+*                : data - 应答
+*                : len - 应答长度
+* Output         : None
+* Return         : 转发普通数据时返回asyncomm_forward的结果
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int txn_match(asytxn *txn, const uint8_t *data, uint32_t len)
+{
+    txnslot *hit = NULL;
+
+    for (int idx = 0; idx < txn->cfg.window; ++idx) {
+        txnslot *slot = &txn->slots[idx];
+        if (!slot->used) {
+            continue;
+        }
+        if (txn->cfg.seq_off >= 0) {
+            if (len >= (uint32_t)txn->cfg.seq_off + 2 && txn_rd16(data + txn->cfg.seq_off) == slot->seq) {
+                hit = slot;
+                break;
+            }
+        } else if (NULL == hit || (int32_t)(slot->order - hit->order) < 0) {
+            hit = slot;
+        }
+    }
+    if (NULL == hit) {
+        return asyncomm_forward(txn->port, data, len);
+    }
+    metric_port(txn->port, 1, len);
+    metric_end(METRIC_H_TXN_RTT, hit->start);
+    metric_add(METRIC_TXN_RESP, 1);
+    txn_done(txn, hit, ASY_TXN_OK, data, len);
+    return ASY_OK;
+}
+
+// 保留第一次出现的ASY_ER_BUSY，之后的结果不能覆盖停止读取的要求
+static inline int txn_keep_busy(int ret, int next)
+{
+    return (ASY_ER_BUSY == ret) ? ret : next;
+}
+
+// 按长度字段从拼接缓冲区中取出完整的应答，长度不合理时整体作为普通数据转发并重新同步
+static int txn_frame(asytxn *txn)
+{
+    uint32_t head = (uint32_t)txn->cfg.len_off + 2;
+    int ret = ASY_OK;
+
+    while (txn->rxlen >= head) {
+        int32_t flen = (int32_t)head + txn_rd16(txn->rx + txn->cfg.len_off) + txn->cfg.len_adj;
+        if (flen <= 0 || (uint32_t)flen > txn->rxcap) {
+            ret = txn_keep_busy(ret, asyncomm_forward(txn->port, txn->rx, txn->rxlen));
+            txn->rxlen = 0;
+            break;
+        }
+        if (txn->rxlen < (uint32_t)flen) {
+            break;
+        }
+        ret = txn_keep_busy(ret, txn_match(txn, txn->rx, (uint32_t)flen));
+        txn->rxlen -= (uint32_t)flen;
+        memmove(txn->rx, txn->rx + flen, txn->rxlen);
+    }
+    return ret;
+}
+
+/******************************************************************************
+* Description    : 通道收到的数据.没有配置长度字段时每次收到的数据是一个应答，否则先拼接
+*                  成完整的应答再匹配；匹配的应答和请求完成后，等待队列中的请求接着发出
+* Input          : txn - 事务表
+*                : buf - 数据
+*                : size - 数据长度
+* Output         : None
+* Return         : 数据转发时返回asyncomm_forward的结果，ASY_ER_BUSY表示应当停止读取
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+int asytxn_input(asytxn *txn, const void *buf, size_t size)
+{
+    const uint8_t *pos = (const uint8_t *)buf;
+    int ret = ASY_OK;
+
+    pthread_mutex_lock(&txn->lock);
+    if (txn->cfg.len_off < 0) {
+        ret = txn_match(txn, pos, (uint32_t)size);
+    } else {
+        while (size > 0) {
+            uint32_t len = txn->rxcap - txn->rxlen;
+            if (len > size) {
+                len = (uint32_t)size;
+            }
+            memcpy(txn->rx + txn->rxlen, pos, len);
+            txn->rxlen += len;
+            pos  += len;
+            size -= len;
+            ret = txn_keep_busy(ret, txn_frame(txn));
+        }
+    }
+    uint64_t now = metric_now();
+    txn_dequeue(txn, now);
+    txn_flush(txn);
+    txn_arm(txn, now);
+    pthread_mutex_unlock(&txn->lock);
+    return ret;
+}
+
+/******************************************************************************
+* Description    : 发送请求.有空闲的在途位置并且没有排队的请求时立即发送，否则进入等待
+*                  队列，保持请求的顺序
+* Input          : txn - 事务表
+*                : tag - 应用指定的标签，随应答返回
+*                : buf - 请求
+*                : size - 请求长度
+* Output         : None
+* Return         : 等待队列已满返回ASY_ER_AGAIN，端口已经关闭返回ASY_ER_PARAM
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+int asytxn_request(asytxn *txn, uint32_t tag, const void *buf, size_t size)
+{
+    uint16_t len = (uint16_t)size;
+    int ret = ASY_OK;
+
+    if (NULL == buf || 0 == size || size > txn->rxcap) {
+        return ASY_ER_PARAM;
+    }
+    pthread_mutex_lock(&txn->lock);
+    uint64_t now = metric_now();
+    if (NULL == txn->ctx) {
+        ret = ASY_ER_PARAM;
+    } else if (txn->nused < txn->cfg.window && 0 == ringbuf_used(&txn->queue)) {
+        ret = txn_start(txn, tag, buf, len, now);
+        txn_arm(txn, now);
+    } else if (ringbuf_space(&txn->queue) >= sizeof(tag) + sizeof(len) + len) {
+        ringbuf_write(&txn->queue, &tag, sizeof(tag));
+        ringbuf_write(&txn->queue, &len, sizeof(len));
+        ringbuf_write(&txn->queue, buf, len);
+    } else {
+        ret = ASY_ER_AGAIN;
+    }
+    pthread_mutex_unlock(&txn->lock);
+    return ret;
+}
+
+// 超时定时器，重发或结束超时的请求，重发应答帧
+static void txn_on_timer(void *arg)
+{
+    asytxn *txn = (asytxn *)arg;
+
+    pthread_mutex_lock(&txn->lock);
+    uint64_t now = metric_now();
+    txn->armed = 0;
+    if (txn->pending) {
+        txn_flush(txn);
+    }
+    for (int idx = 0; NULL != txn->ctx && idx < txn->cfg.window; ++idx) {
+        txnslot *slot = &txn->slots[idx];
+        if (!slot->used || slot->deadline > now) {
+            continue;
+        }
+        if (slot->tries <= txn->cfg.retry) {
+            metric_add(METRIC_TXN_RETRY, 1);
+            txn_send(txn, slot, now);
+        } else {
+            glog4c_debug("txn port=%d tag=%u timeout\n", txn->port, slot->tag);
+            metric_add(METRIC_TXN_TIMEOUT, 1);
+            txn_done(txn, slot, ASY_TXN_TIMEOUT, NULL, 0);
+        }
+    }
+    if (NULL != txn->ctx) {
+        txn_dequeue(txn, now);
+    }
+    txn_flush(txn);
+    txn_arm(txn, now);
+    pthread_mutex_unlock(&txn->lock);
+}
+
+// 回收事务表
+static void txn_destroy(asytxn *txn)
+{
+    for (int idx = 0; NULL != txn->slots && idx < txn->cfg.window; ++idx) {
+        free(txn->slots[idx].buf);
+    }
+    free(txn->slots);
+    ringbuf_free(&txn->queue);
+    free(txn->rx);
+    free(txn->txbuf);
+    pthread_mutex_destroy(&txn->lock);
+    free(txn);
+}
+
+/******************************************************************************
+* Description    : 建立端口的事务表和超时定时器.
+* Input          : port - 端口编号
+*                : cfg - 事务参数，window为0时不建立
+*                : write - 通道的发送操作，可以在任意线程调用
+*                : ctx - 发送操作的参数
+*                : near_fd - 通道句柄，定时器属于同一个通信线程，-1表示不指定
+* Output         : None
+* Return         : 成功返回事务表，失败返回NULL
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 超时定时器改为时间轮中的定时器
+******************************************************************************/
+asytxn *asytxn_new(int port, const asytxn_cfg *cfg, int (*write)(void *, const void *, size_t),
+    void *ctx, int near_fd)
+{
+    if (NULL == cfg || 0 == cfg->window || NULL == write || 0 == asyncomm_msgsize()) {
+        return NULL;
+    }
+    asytxn *txn = (asytxn *)calloc(1, sizeof(asytxn));
+    if (NULL == txn) {
+        return NULL;
+    }
+    txn->port  = port;
+    txn->cfg   = *cfg;
+    txn->write = write;
+    txn->ctx   = ctx;
+    if (0 == txn->cfg.timeout) {
+        txn->cfg.timeout = 1000;
+    }
+    if (txn->cfg.window > 1 && txn->cfg.seq_off < 0) {
+        glog4c_warn("txn port=%d pipelines without sequence, a lost reply shifts later replies\n", port);
+    }
+    pthread_mutex_init(&txn->lock, NULL);
+    // 应答和请求都不超过一个条目，rx后面再留一个请求的暂存区
+    txn->rxcap = (uint32_t)asyncomm_rxsize();
+    txn->rx    = (uint8_t *)malloc((size_t)txn->rxcap * 2);
+    txn->txbuf = (char *)malloc(asyncomm_msgsize());
+    txn->slots = (txnslot *)calloc(txn->cfg.window, sizeof(txnslot));
+    if (NULL == txn->rx || NULL == txn->txbuf || NULL == txn->slots
+        || ringbuf_init(&txn->queue, TXN_QUEUE_SIZE) != RINGBUF_OK
+        || asyncomm_timer_init(&txn->timer, near_fd, txn_on_timer, txn) != ASY_OK) {
+        txn_destroy(txn);
+        return NULL;
+    }
+    codec_begin(&txn->resp, txn->txbuf, asyncomm_msgsize(), CODEC_CMD_RESP, DB_BLOB, 0);
+    glog4c_info("txn port=%d window=%u timeout=%ums retry=%u\n",
+        port, txn->cfg.window, txn->cfg.timeout, txn->cfg.retry);
+    return txn;
+}
+
+// 连接重建，丢弃拼接到一半的应答
+void asytxn_link(asytxn *txn)
+{
+    pthread_mutex_lock(&txn->lock);
+    txn->rxlen = 0;
+    pthread_mutex_unlock(&txn->lock);
+}
+
+// 通道关闭，在途和排队的请求以ASY_TXN_CLOSED结束，停止定时器后回收
+void asytxn_free(asytxn *txn)
+{
+    uint32_t tag;
+    uint16_t len;
+
+    if (NULL == txn) {
+        return;
+    }
+    pthread_mutex_lock(&txn->lock);
+    txn->ctx = NULL;
+    for (int idx = 0; idx < txn->cfg.window; ++idx) {
+        if (txn->slots[idx].used) {
+            txn_done(txn, &txn->slots[idx], ASY_TXN_CLOSED, NULL, 0);
+        }
+    }
+    while (ringbuf_used(&txn->queue) > 0) {
+        ringbuf_read(&txn->queue, &tag, sizeof(tag));
+        ringbuf_read(&txn->queue, &len, sizeof(len));
+        ringbuf_consume(&txn->queue, len);
+        txn_emit(txn, tag, ASY_TXN_CLOSED, NULL, 0);
+    }
+    txn_flush(txn);
+    if (txn->pending) {
+        metric_add(METRIC_ASY_DROP, txn->resp.count);
+    }
+    pthread_mutex_unlock(&txn->lock);
+    // 定时器可能属于其他通信线程，停止时等待正在执行的回调结束
+    asyncomm_timer_cancel(&txn->timer);
+    txn_destroy(txn);
+}
@@ -1,8 +1,8 @@
 //------------------------------------------------------------------------------
 // Protability:       gunc99.
-// Design Pattern:    None.
+// Design Pattern:    Reactor.
 // Base Classes:      None.
-// MultiThread Safe:  None.
+// MultiThread Safe:  asyncomm_register/asyncomm_remove/asyncomm_exit.
 // Exception Safe:    No Creation, No process
 // Library/package:   None.
 // Source files:      asyncomm.c
@@ -12,18 +12,30 @@
 //------------------------------------------------------------------------------
 // Release Note:
 //     负责异步通信的模块，所有的网络，串口均在这个线程进行管理。
+//     所有文件句柄以边沿触发方式注册到epoll中，由通信线程回调对应的处理函数。
+//     注销和退出请求通过eventfd唤醒通信线程，由通信线程在安全的时机释放资源。
+//     每个通信线程的定时器由一个分层时间轮管理，共用一个timerfd，只在最早的到期时间
+//     提前时重新设置。
 //------------------------------------------------------------------------------
 // Version    Date          Author    Note
 //------------------------------------------------------------------------------
 // 1.0.0      2019-01-20    llemmx    -Original
+// 1.1.0      2026-10-17    llemmx    -Implement epoll reactor
+// 1.2.0      2026-10-17    llemmx    -Timer wheel
 //------------------------------------------------------------------------------
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // CPU亲和性设置需要GNU扩展
+#endif
 #include <pthread.h>
+#include <sched.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <netinet/in.h>
 #include <net/if.h>
 #include <unistd.h>
@@ -31,142 +43,1423 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
-#include <mqueue.h>
+#include <strings.h>
 
+#define GLOG4C_MODULE GLOG4C_MOD_ASYNCOMM
 #include "glog4c.h"
+#include "db_in_mem.h"
 #include "asyncomm.h"
+#include "metric.h"
+#include "appq.h"
+#include "ringbuf.h"
 
 #define PT_EXIT 0
 #define PT_RUN  1
 
-pthread_t m_thread;      // 通信线程句柄
-struct epoll_event m_ev; // epoll handle for module
-int m_ephandel; // epoll 句柄
+#define ASY_MAX_EVENTS  64  // 单次epoll_wait最多处理的事件数量
+#define ASY_FD_STEP     64  // 句柄表每次扩展的步长
+#define ASY_MAX_THREADS 32  // 最多支持的通信线程数量
+#define ASY_RETRY_US    500 // 应用队列满时重试发送的间隔，单位us
+#define ASY_FLOW_HIGH   (64 << 10) // 默认的积压高水位，单位B
+#define ASY_FLOW_LOW    (16 << 10) // 默认的积压低水位，单位B
+
+struct asyreactor;
+struct asyflow;
+
+// 通信通道，每个注册的文件句柄对应一个
+typedef struct asychn {
+    int                fd;    // 文件句柄，注销后置为-1
+    asyncomm_cb        cb;    // 事件回调
+    void              *arg;   // 回调参数
+    asyncomm_rel       rel;   // 释放回调，通道释放时调用
+    struct asyreactor *rt;    // 所属的通信线程
+    struct asychn     *next;  // 注销后挂接到待释放链表
+    uint32_t           events; // 注册的epoll事件
+    int                port;  // 句柄读到的数据所属的端口，-1表示不是数据通道
+}asychn;
+
+// 端口的积压数据，应用队列满时转发的数据按端口保存在这里，由所属通信线程独占
+// 记录格式为 长度2B | 数据
+typedef struct asyflow {
+    int             port;   // 端口编号
+    int             policy; // ASY_FLOW_*
+    ringbuf         buf;    // 积压缓冲区，第一次积压时申请
+    uint32_t        nrec;   // 积压的记录数量
+    asychn         *src;    // 数据来源通道，ASY_FLOW_BLOCK时停止它的读取
+    int             paused; // 已经停止读取
+    int             queued; // 已经在积压链表中
+    struct asyflow *next;   // 积压链表
+}asyflow;
+
+// 通信线程(reactor)，每个线程拥有独立的epoll、唤醒句柄和接收缓冲区
+typedef struct asyreactor {
+    pthread_t thread;     // 线程句柄
+    int       idx;        // 线程编号，同时决定绑定的CPU
+    int       epfd;       // epoll 句柄
+    int       wakefd;     // 唤醒线程的eventfd
+    int       nfds;       // 当前管理的句柄数量，用于负载均衡
+    char     *txbuf;      // 发送到应用队列的组帧缓冲区，尺寸与队列消息尺寸一致
+    char     *rxbuf;      // 接收缓冲区，位于txbuf帧头之后，读到的数据可以原地组帧
+    char     *pendbuf;    // 合并转发的缓冲区，尺寸与队列消息尺寸一致
+    codec_writer pend;    // 正在合并的数据帧
+    uint64_t  pend_start; // 合并帧第一条数据的采样时间
+    int       tmfd;       // 定时器句柄，data.ptr为所属reactor
+    uint64_t  fast_due;   // 合并帧等待或拥塞重试的截止时间，单调时钟ns，0表示未启动
+    pthread_mutex_t tmlock; // 保护时间轮、到期链表和tm_due，其他线程也可以启动和停止定时器
+    tmwheel   wheel;      // 定时器时间轮，tick为ASY_TICK_NS
+    tmnode    fired;      // 已经到期等待回调的定时器
+    asytimer *running;    // 正在执行回调的定时器
+    uint64_t  tm_due;     // timerfd设置的到期时间，0表示未设置
+    int       congested;  // 应用队列已满，新数据进入积压缓冲区
+    asychn   *cur;        // 正在执行回调的通道
+    asyflow **flows;      // 按端口编号索引的积压状态
+    int       nflow;      // flows容量
+    asyflow  *flow_none;  // 不属于任何端口的数据的积压状态
+    asyflow  *backlog;    // 有积压数据的端口，按轮转顺序发送
+    asyflow  *backlog_tail;
+    asychn   *zombie;     // 已注销等待释放的通道，受m_lock保护
+}asyreactor;
+
 volatile int m_pexit_flag = PT_RUN; // 线程退出标志，这里申请需要注意是非易挥发行变量
 
+static long   m_rxsize = 0;         // 接收缓冲区尺寸
+static uint32_t m_fwd_delay = 0;    // 转发数据合并的最长等待时间，单位us，0表示每次唤醒结束时发送
+static uint32_t m_flow_high = ASY_FLOW_HIGH; // 积压高水位，超过后按端口策略丢弃或停止读取
+static uint32_t m_flow_low  = ASY_FLOW_LOW;  // 积压低水位，停止读取的端口降到这里后恢复
+
+static asyreactor *m_reactors = NULL; // 通信线程数组
+static int         m_rtcap = 0;       // 通信线程数组容量
+static int         m_nreactor = 0;    // 已经启动的通信线程数量
+static __thread asyreactor *m_cur = NULL; // 当前线程对应的reactor，非通信线程为NULL
+static uint32_t    m_tm_rr = 0;       // 不指定线程的定时器轮流分配
+
+// 通道端口，串口、TCP连接等都以端口编号对外提供统一的发送和关闭接口
+typedef struct {
+    void              *ctx;  // 通道私有数据，为NULL表示端口空闲
+    const asyport_ops *ops;  // 通道操作
+    int                flow; // 应用队列满时的处理策略，ASY_FLOW_*
+    asytxn            *txn;  // 请求/应答事务表，NULL表示没有启用
+}asyport;
+
+static pthread_rwlock_t m_port_lock = PTHREAD_RWLOCK_INITIALIZER; // 发送时持读锁，增删端口持写锁
+static asyport *m_ports = NULL;     // 端口表
+static int      m_port_cap = 0;     // 端口表容量
+
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER; // 保护句柄表与待释放链表
+static asychn **m_chns = NULL;      // 按文件句柄索引的通道表
+static int      m_chn_cap = 0;      // 通道表容量
+
+static void asyflow_unlink(asyreactor *rt, asychn *chn);
+
+// 唤醒通信线程
+static void asyncomm_wakeup(asyreactor *rt)
+{
+    uint64_t one = 1;
+    ssize_t wret = write(rt->wakefd, &one, sizeof(one));
+    (void)wret;
+}
+
+// 释放已注销的通道，只能在通信线程处理完一批事件后调用.释放回调中可能继续注销同一线程的
+// 其他句柄，所以循环到待释放链表为空为止
+static void asyncomm_reap(asyreactor *rt)
+{
+    for (;;) {
+        pthread_mutex_lock(&m_lock);
+        asychn *chn = rt->zombie;
+        rt->zombie = NULL;
+        pthread_mutex_unlock(&m_lock);
+        if (NULL == chn) {
+            break;
+        }
+
+        while (NULL != chn) {
+            asychn *next = chn->next;
+            if (NULL != chn->rel) {
+                chn->rel(chn->arg);
+            }
+            asyflow_unlink(rt, chn);
+            free(chn);
+            chn = next;
+        }
+    }
+}
+
+// 将通道从句柄表和epoll中摘除并挂到所属线程的待释放链表，调用者需持有m_lock
+static asychn *asyncomm_detach(int fd)
+{
+    if (fd < 0 || fd >= m_chn_cap || NULL == m_chns[fd]) {
+        return NULL;
+    }
+    asychn *chn = m_chns[fd];
+    asyreactor *rt = chn->rt;
+    m_chns[fd] = NULL;
+    epoll_ctl(rt->epfd, EPOLL_CTL_DEL, fd, NULL);
+    --rt->nfds;
+    chn->fd    = -1;
+    chn->next  = rt->zombie;
+    rt->zombie = chn;
+    return chn;
+}
+
+// 选择负载最小的通信线程，负载相同时按句柄散列，避免总是集中到第一个线程
+static asyreactor *asyncomm_pick(int fd)
+{
+    asyreactor *best = &m_reactors[fd % m_nreactor];
+
+    for (int idx = 0; idx < m_nreactor; ++idx) {
+        if (m_reactors[idx].nfds < best->nfds) {
+            best = &m_reactors[idx];
+        }
+    }
+    return best;
+}
+
+// 按截止时间设置timerfd，调用者持有tmlock.已经设置的时间不晚于due时不改动，多出来的
+// 唤醒由事件循环重新计算
+static void asyncomm_program(asyreactor *rt, uint64_t due)
+{
+    struct itimerspec its;
+
+    if (0 != rt->tm_due && rt->tm_due <= due) {
+        return;
+    }
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec  = (time_t)(due / 1000000000ULL);
+    its.it_value.tv_nsec = (long)(due % 1000000000ULL);
+    timerfd_settime(rt->tmfd, TFD_TIMER_ABSTIME, &its, NULL);
+    rt->tm_due = due;
+}
+
+// 启动合并等待或拥塞重试定时器，已经启动时不重复设置，到期后由事件循环统一处理
+static void asyncomm_arm(asyreactor *rt, uint32_t us)
+{
+    if (0 != rt->fast_due) {
+        return;
+    }
+    rt->fast_due = metric_now() + (uint64_t)us * 1000ULL;
+    pthread_mutex_lock(&rt->tmlock);
+    asyncomm_program(rt, rt->fast_due);
+    pthread_mutex_unlock(&rt->tmlock);
+}
+
+// 时间轮推进到now，调用者持有tmlock.有定时器到期时立即唤醒通信线程
+static void asyncomm_wheel_sync(asyreactor *rt, uint64_t now)
+{
+    tmwheel_advance(&rt->wheel, now / ASY_TICK_NS, &rt->fired);
+    if (rt->fired.next != &rt->fired) {
+        asyncomm_program(rt, now);
+    }
+}
+
 /******************************************************************************
-* Description    : 异步通信数据获取函数.
-* Input          : arg - 队列句柄，用于跨进程/线程传递通信数据
+* Description    : 处理到期的定时器.时间轮推进到当前时间，到期的定时器逐个取出后释放锁
+*                  执行回调，回调中可以重新启动或停止任何定时器.最后按合并帧等待和时间轮
+*                  中最早的时间重新设置timerfd
+* Input          : rt - 通信线程
+*                : now - 当前时间，单调时钟ns
 * Output         : None
-* Return         : 返回值参考头文件定义
+* Return         : None
 *------------------------------------------------------------------------------
-* 2020-01-30     : 1.0.0 : llemmx
+* 2026-10-17     : 1.0.0 : llemmx
 * Modification   :
 ******************************************************************************/
-static void *asyncomm_get_msg(void *arg)
+static void asyncomm_timer_run(asyreactor *rt, uint64_t now)
 {
-    mqd_t *m_queue2app = (mqd_t *)arg; // 队列句柄
+    uint64_t fired = 0;
+    tmnode *node;
 
-    if (NULL == arg) {
-        glog4c_err("pointer value is NULL.");
-        glog4c_info("Beacuse parameter is NULL. So end of thread.");
+    pthread_mutex_lock(&rt->tmlock);
+    tmwheel_advance(&rt->wheel, now / ASY_TICK_NS, &rt->fired);
+    while (NULL != (node = tmwheel_pop(&rt->fired))) {
+        asytimer *tm = (asytimer *)node;
+        rt->running = tm;
+        pthread_mutex_unlock(&rt->tmlock);
+        tm->cb(tm->arg);
+        pthread_mutex_lock(&rt->tmlock);
+        rt->running = NULL;
+        ++fired;
+    }
+    uint64_t next = tmwheel_next(&rt->wheel);
+    if (TMW_NEVER != next) {
+        asyncomm_program(rt, next * ASY_TICK_NS);
+    }
+    if (0 != rt->fast_due) {
+        asyncomm_program(rt, rt->fast_due);
+    }
+    pthread_mutex_unlock(&rt->tmlock);
+    metric_add(METRIC_TIMER_FIRE, fired);
+}
+
+// 端口的积压状态，create为0时不存在返回NULL
+static asyflow *asyflow_get(asyreactor *rt, int port, int create)
+{
+    asyflow **slot = &rt->flow_none;
+
+    if (CODEC_PORT_NONE != port) {
+        if (port < 0) {
+            return NULL;
+        }
+        if (port >= rt->nflow) {
+            if (!create) {
+                return NULL;
+            }
+            int cap = (port / ASY_FD_STEP + 1) * ASY_FD_STEP;
+            asyflow **tmp = (asyflow **)realloc(rt->flows, sizeof(asyflow *) * cap);
+            if (NULL == tmp) {
+                return NULL;
+            }
+            memset(tmp + rt->nflow, 0, sizeof(asyflow *) * (cap - rt->nflow));
+            rt->flows = tmp;
+            rt->nflow = cap;
+        }
+        slot = &rt->flows[port];
+    }
+    if (NULL != *slot || !create) {
+        return *slot;
+    }
+    asyflow *flow = (asyflow *)calloc(1, sizeof(asyflow));
+    if (NULL == flow) {
         return NULL;
     }
+    flow->port   = port;
+    flow->policy = ASY_FLOW_OLDEST;
+    pthread_rwlock_rdlock(&m_port_lock);
+    if (port >= 0 && port < m_port_cap && NULL != m_ports[port].ctx) {
+        flow->policy = m_ports[port].flow;
+    }
+    pthread_rwlock_unlock(&m_port_lock);
+    *slot = flow;
+    return flow;
+}
 
-    for (;m_pexit_flag != PT_EXIT;) {
-        usleep(1000);
+// 修改来源通道关注的读事件，BLOCK策略用它停止和恢复读取
+static void asyflow_read(asyreactor *rt, asyflow *flow, int on)
+{
+    struct epoll_event ev;
+    asychn *chn = flow->src;
+
+    if (NULL == chn || chn->fd < 0) {
+        return;
+    }
+    ev.events   = (on ? chn->events : (chn->events & ~(EPOLLIN | EPOLLRDHUP))) | EPOLLET;
+    ev.data.ptr = chn;
+    // 边沿触发时重新加入EPOLLIN会立即检查一次，停止期间到达的数据不会丢失
+    if (epoll_ctl(rt->epfd, EPOLL_CTL_MOD, chn->fd, &ev) < 0) {
+        glog4c_warn("flow control fd=%d failed: %s\n", chn->fd, strerror(errno));
+        return;
+    }
+    flow->paused = !on;
+    metric_add(on ? METRIC_FLOW_RESUME : METRIC_FLOW_PAUSE, 1);
+}
+
+// 丢弃最早的一条积压记录
+static void asyflow_drop(asyflow *flow)
+{
+    uint16_t len = 0;
+
+    ringbuf_read(&flow->buf, &len, sizeof(len));
+    ringbuf_consume(&flow->buf, len);
+    --flow->nrec;
+}
+
+/******************************************************************************
+* Description    : 把一条数据放入端口的积压缓冲区，按端口策略限制积压的字节数:
+*                  ASY_FLOW_OLDEST 超过高水位时丢弃最早的记录
+*                  ASY_FLOW_LATEST 只保留最新的一条消息，旧记录被合并掉.一条消息超过
+*                                  一个记录时后续的记录追加在第一条之后，不参与合并
+*                  ASY_FLOW_BLOCK  超过高水位时停止来源通道的读取，降到低水位后恢复，
+*                                  没有可以停止的通道或缓冲区已满时退化为丢弃最早的记录
+* Input          : rt - 通信线程
+*                : port - 端口编号
+*                : data - 数据，不超过一条消息能容纳的长度
+*                : len - 数据长度
+*                : first - 是否为一条消息的第一个记录
+* Output         : None
+* Return         : 来源通道已经停止读取时返回ASY_ER_BUSY
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : latest按消息合并，不拆开超过一个记录的消息
+******************************************************************************/
+static int asyflow_push(asyreactor *rt, int port, const void *data, uint16_t len, int first)
+{
+    asyflow *flow = asyflow_get(rt, port, 1);
+    uint32_t need = sizeof(uint16_t) + len;
+
+    if (NULL == flow) {
+        metric_add(METRIC_ASY_DROP, 1);
+        return ASY_ER_FMEM;
+    }
+    if (NULL == flow->buf.buf
+        && ringbuf_init(&flow->buf, m_flow_high + sizeof(uint16_t) + (uint32_t)m_rxsize) != RINGBUF_OK) {
+        metric_add(METRIC_ASY_DROP, 1);
+        return ASY_ER_FMEM;
+    }
+    if (NULL != rt->cur && rt->cur->port == port) {
+        flow->src = rt->cur;
+    }
+    if (ASY_FLOW_LATEST == flow->policy && first) {
+        metric_add(METRIC_FLOW_CONFLATE, flow->nrec);
+        ringbuf_consume(&flow->buf, ringbuf_used(&flow->buf));
+        flow->nrec = 0;
+    } else {
+        // latest的后续记录只受缓冲区尺寸限制，保持消息完整
+        uint32_t limit = ((ASY_FLOW_BLOCK == flow->policy && NULL != flow->src) || ASY_FLOW_LATEST == flow->policy)
+            ? flow->buf.size : m_flow_high;
+        while (flow->nrec > 0 && ringbuf_used(&flow->buf) + need > limit) {
+            asyflow_drop(flow);
+            metric_add(METRIC_ASY_DROP, 1);
+        }
+    }
+    ringbuf_write(&flow->buf, &len, sizeof(len));
+    ringbuf_write(&flow->buf, data, len);
+    ++flow->nrec;
+    metric_add(METRIC_FLOW_QUEUED, 1);
+    if (!flow->queued) {
+        flow->queued = 1;
+        flow->next   = NULL;
+        if (NULL == rt->backlog) {
+            rt->backlog = flow;
+        } else {
+            rt->backlog_tail->next = flow;
+        }
+        rt->backlog_tail = flow;
+    }
+    if (ASY_FLOW_BLOCK == flow->policy && !flow->paused && ringbuf_used(&flow->buf) >= m_flow_high) {
+        asyflow_read(rt, flow, 0);
+    }
+    return flow->paused ? ASY_ER_BUSY : ASY_OK;
+}
+
+// 释放端口的积压状态，未发送的记录计为丢弃
+static void asyflow_free(asyreactor *rt, asyflow *flow)
+{
+    if (flow->queued) {
+        asyflow **pos = &rt->backlog;
+        rt->backlog_tail = NULL;
+        while (NULL != *pos) {
+            if (*pos == flow) {
+                *pos = flow->next;
+                continue;
+            }
+            rt->backlog_tail = *pos;
+            pos = &(*pos)->next;
+        }
     }
+    metric_add(METRIC_ASY_DROP, flow->nrec);
+    if (CODEC_PORT_NONE == flow->port) {
+        rt->flow_none = NULL;
+    } else if (flow->port >= 0 && flow->port < rt->nflow) {
+        rt->flows[flow->port] = NULL;
+    }
+    ringbuf_free(&flow->buf);
+    free(flow);
+}
+
+// 通道释放时解除与积压状态的关联，端口已经删除时丢弃它的积压数据
+static void asyflow_unlink(asyreactor *rt, asychn *chn)
+{
+    int alive = 0;
 
-    glog4c_info("Communication thread exited.\n");
+    if (chn->port < 0) {
+        return;
+    }
+    asyflow *flow = asyflow_get(rt, chn->port, 0);
+    if (NULL == flow) {
+        return;
+    }
+    if (flow->src == chn) {
+        flow->src    = NULL;
+        flow->paused = 0;
+    }
+    if (CODEC_PORT_NONE != chn->port) {
+        pthread_rwlock_rdlock(&m_port_lock);
+        alive = chn->port < m_port_cap && NULL != m_ports[chn->port].ctx;
+        pthread_rwlock_unlock(&m_port_lock);
+    }
+    if (!alive && NULL == flow->src) {
+        asyflow_free(rt, flow);
+    }
 }
 
 /******************************************************************************
-* Description    : 异步通信初始化函数.当前只考虑支持1个线程，后期跟进实际情况可以考虑支持多
-* 个接收线程的支持
-* Input          : value - 队列句柄，用于跨进程/线程传递通信数据
+* Description    : 发送正在合并的数据帧并开始新帧.队列已满时保留这一帧，进入拥塞状态并
+*                  启动重试定时器，此后转发的数据进入各端口的积压缓冲区
+* Input          : rt - 通信线程
+* Output         : None
+* Return         : 队列已满时返回ASY_ER_AGAIN
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 队列满时不再丢弃
+******************************************************************************/
+static int asyncomm_flush(asyreactor *rt)
+{
+    if (0 == rt->pend.count) {
+        return ASY_OK;
+    }
+    uint16_t count = rt->pend.count;
+    size_t flen = codec_end(&rt->pend);
+    int sret = appq_send(rt->pendbuf, flen);
+    if (APPQ_ER_AGAIN == sret) {
+        if (!rt->congested) {
+            rt->congested = 1;
+            metric_add(METRIC_FLOW_CONGEST, 1);
+        }
+        asyncomm_arm(rt, ASY_RETRY_US);
+        return ASY_ER_AGAIN;
+    }
+    metric_end(METRIC_H_FWD_DELAY, rt->pend_start);
+    if (APPQ_OK == sret) {
+        metric_add(METRIC_FWD_FRAMES, 1);
+        metric_add(METRIC_FWD_RECORDS, count);
+    } else {
+        glog4c_err("forward to app failed!\n");
+        metric_add(METRIC_ASY_DROP, count);
+    }
+    codec_begin(&rt->pend, rt->pendbuf, m_rxsize, CODEC_CMD_DATA, DB_BLOB, 0);
+    return (APPQ_OK == sret) ? ASY_OK : ASY_ER_UNKNOW;
+}
+
+// 追加一条记录到合并帧，第一条记录开始计时
+static void asyncomm_pend_put(asyreactor *rt, int port, const void *data, uint16_t len)
+{
+    codec_put(&rt->pend, (uint16_t)port, data, len);
+    if (1 == rt->pend.count) {
+        rt->pend_start = metric_begin(METRIC_H_FWD_DELAY);
+        if (m_fwd_delay > 0) {
+            asyncomm_arm(rt, m_fwd_delay);
+        }
+    }
+}
+
+// 读取最早一条积压记录的长度，不移动读出位置
+static uint16_t asyflow_peek(const asyflow *flow)
+{
+    struct iovec iov[2];
+    uint8_t hdr[sizeof(uint16_t)];
+    uint16_t len;
+
+    int cnt = ringbuf_data_vec(&flow->buf, iov);
+    size_t first = iov[0].iov_len < sizeof(hdr) ? iov[0].iov_len : sizeof(hdr);
+    memcpy(hdr, iov[0].iov_base, first);
+    if (first < sizeof(hdr) && cnt > 1) {
+        memcpy(hdr + first, iov[1].iov_base, sizeof(hdr) - first);
+    }
+    memcpy(&len, hdr, sizeof(len));
+    return len;
+}
+
+/******************************************************************************
+* Description    : 拥塞时由重试定时器调用.先重发保留的帧，再按端口轮转，每次从一个端口取
+*                  一条积压记录放入合并帧，帧满时发送，队列再次满时停止等待下一次重试.
+*                  积压全部发送后解除拥塞，停止读取的通道降到低水位时恢复读取.记录经过
+*                  rxbuf拼接，只能在回调之外调用
+* Input          : rt - 通信线程
+* Output         : None
+* Return         : None
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+static void asyncomm_resume(asyreactor *rt)
+{
+    if (asyncomm_flush(rt) != ASY_OK) {
+        return;
+    }
+    while (NULL != rt->backlog) {
+        asyflow *flow = rt->backlog;
+        uint16_t len = asyflow_peek(flow);
+        if (0xFFFF == rt->pend.count || rt->pend.len + codec_item_size(DB_BLOB, len) > rt->pend.cap) {
+            if (asyncomm_flush(rt) != ASY_OK) {
+                return;
+            }
+        }
+        ringbuf_consume(&flow->buf, sizeof(len));
+        ringbuf_read(&flow->buf, rt->rxbuf, len);
+        --flow->nrec;
+        asyncomm_pend_put(rt, flow->port, rt->rxbuf, len);
+        if (flow->paused && ringbuf_used(&flow->buf) <= m_flow_low) {
+            asyflow_read(rt, flow, 1);
+        }
+        // 移到链表尾部，各端口轮流发送
+        rt->backlog = flow->next;
+        flow->next  = NULL;
+        if (0 == flow->nrec) {
+            flow->queued = 0;
+            if (NULL == rt->backlog) {
+                rt->backlog_tail = NULL;
+            }
+        } else if (NULL == rt->backlog) {
+            rt->backlog = flow;
+        } else {
+            rt->backlog_tail->next = flow;
+            rt->backlog_tail = flow;
+        }
+    }
+    if (asyncomm_flush(rt) == ASY_OK) {
+        rt->congested = 0;
+    }
+}
+
+/******************************************************************************
+* Description    : 默认的读取回调，读到EAGAIN为止，每次读取的数据直接转发给应用.
+* Input          : fd - 文件句柄
+*                : events - epoll事件
+*                : arg - 未使用
+* Output         : None
+* Return         : ASY_OK继续监听，ASY_CLOSE表示对端已关闭
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.1.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int asyncomm_read_forward(int fd, uint32_t events, void *arg)
+{
+    ssize_t rsize;
+    char *rxbuf = m_cur->rxbuf; // 回调只在通信线程中执行，使用线程私有的缓冲区
+
+    for (;;) {
+        rsize = read(fd, rxbuf, m_rxsize - ASY_FWD_HEAD);
+        if (rsize > 0) {
+            if (ASY_ER_BUSY == asyncomm_forward(CODEC_PORT_NONE, rxbuf, rsize)) {
+                return ASY_OK; // 积压超过高水位，已经停止读取
+            }
+            continue;
+        }
+        if (0 == rsize) {
+            return ASY_CLOSE;
+        }
+        if (EINTR == errno) {
+            continue;
+        }
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            break;
+        }
+        glog4c_err(strerror(errno));
+        return ASY_CLOSE;
+    }
+    if (events & (EPOLLHUP | EPOLLERR)) {
+        return ASY_CLOSE;
+    }
+    return ASY_OK;
+}
+
+/******************************************************************************
+* Description    : 异步通信数据获取函数.
+* Input          : arg - 线程对应的reactor
 * Output         : None
 * Return         : 返回值参考头文件定义
 *------------------------------------------------------------------------------
 * 2020-01-30     : 1.0.0 : llemmx
-* Modification   :
+* Modification   : 2026-10-17 : 1.1.0 : 实现边沿触发的epoll事件循环
+*                : 2026-10-17 : 1.2.0 : 每个通信线程独立运行一个事件循环
+*                : 2026-10-17 : 1.3.0 : 转发数据合并发送
+*                : 2026-10-17 : 1.4.0 : 应用队列拥塞时定时重试发送积压数据
+*                : 2026-10-17 : 1.5.0 : 处理时间轮中到期的定时器
 ******************************************************************************/
-int asyncomm_init(mqd_t *value)
+static void *asyncomm_get_msg(void *arg)
+{
+    struct epoll_event evs[ASY_MAX_EVENTS];
+    asyreactor *rt = (asyreactor *)arg;
+
+    if (NULL == arg) {
+        glog4c_err("pointer value is NULL.");
+        glog4c_warn("Beacuse parameter is NULL. So end of thread.");
+        return NULL;
+    }
+    m_cur = rt;
+
+    for (;m_pexit_flag != PT_EXIT;) {
+        int nev = epoll_wait(rt->epfd, evs, ASY_MAX_EVENTS, -1);
+        if (nev < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            glog4c_err(strerror(errno));
+            break;
+        }
+        metric_add(METRIC_ASY_WAKE, 1);
+
+        for (int idx = 0; idx < nev; ++idx) {
+            asychn *chn = (asychn *)evs[idx].data.ptr;
+            if (NULL == chn) { // 唤醒事件，清除计数即可，注销和退出在循环中处理
+                uint64_t cnt;
+                ssize_t rret = read(rt->wakefd, &cnt, sizeof(cnt));
+                (void)rret;
+                continue;
+            }
+            if ((void *)rt == (void *)chn) { // 合并等待超时、拥塞重试或时间轮中的定时器到期
+                uint64_t cnt;
+                ssize_t rret = read(rt->tmfd, &cnt, sizeof(cnt));
+                (void)rret;
+                metric_add(METRIC_TIMER_WAKE, 1);
+                pthread_mutex_lock(&rt->tmlock);
+                rt->tm_due = 0;
+                pthread_mutex_unlock(&rt->tmlock);
+                uint64_t now = metric_now();
+                if (0 != rt->fast_due && rt->fast_due <= now) {
+                    rt->fast_due = 0;
+                    if (rt->congested) {
+                        asyncomm_resume(rt);
+                    } else {
+                        asyncomm_flush(rt);
+                    }
+                }
+                asyncomm_timer_run(rt, now);
+                continue;
+            }
+            // 同一批事件中可能已经被其他回调注销
+            if (chn->fd < 0) {
+                continue;
+            }
+            rt->cur = chn;
+            int cret = chn->cb(chn->fd, evs[idx].events, chn->arg);
+            rt->cur = NULL;
+            if (ASY_CLOSE == cret) {
+                int fd = chn->fd;
+                pthread_mutex_lock(&m_lock);
+                asyncomm_detach(fd);
+                pthread_mutex_unlock(&m_lock);
+                // 设置了释放回调的通道由释放回调负责关闭句柄
+                if (NULL == chn->rel) {
+                    close(fd);
+                }
+            }
+        }
+        // 本批事件处理完毕后，不会再有指向已注销通道的指针，此时释放是安全的
+        asyncomm_reap(rt);
+        // 未设置等待时间时，本次唤醒中所有端口转发的数据合并后一次发送，拥塞时等待重试
+        if (0 == m_fwd_delay && !rt->congested) {
+            asyncomm_flush(rt);
+        }
+    }
+    asyncomm_resume(rt);
+
+    glog4c_info("Communication thread %d exited.\n", rt->idx);
+    return NULL;
+}
+
+// 创建单个通信线程，线程绑定到编号对应的CPU上
+static int asyncomm_start(asyreactor *rt, int idx)
 {
     int ret;
-    //pthread_attr_t attr;
+    struct epoll_event ev;
+    pthread_attr_t attr;
+    cpu_set_t cpus;
 
-    if (NULL == value) {
-        return ASY_ER_PARAM;
+    rt->idx    = idx;
+    rt->nfds   = 0;
+    rt->zombie = NULL;
+    rt->txbuf  = (char *)malloc(m_rxsize);
+    rt->pendbuf = (char *)malloc(m_rxsize);
+    if (NULL == rt->txbuf || NULL == rt->pendbuf) {
+        return ASY_ER_FMEM;
     }
+    rt->rxbuf  = rt->txbuf + ASY_FWD_HEAD;
+    codec_begin(&rt->pend, rt->pendbuf, m_rxsize, CODEC_CMD_DATA, DB_BLOB, 0);
 
     // 创建EPOLL
-    m_ephandel = epoll_create(EPOLL_CLOEXEC); // 在多进程环境下，退出时会关闭对应的文件描述符
-    if (m_ephandel < 0) {
+    rt->epfd = epoll_create1(EPOLL_CLOEXEC); // 在多进程环境下，退出时会关闭对应的文件描述符
+    if (rt->epfd < 0) {
         // 如果申请失败，这里要直接终止程序
         glog4c_err(strerror(errno));
         return ASY_ER_EPOLL;
     }
+    // 唤醒句柄的data.ptr为NULL，用于和通道事件区分
+    rt->wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (rt->wakefd < 0) {
+        glog4c_err(strerror(errno));
+        return ASY_ER_EPOLL;
+    }
+    ev.events   = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(rt->epfd, EPOLL_CTL_ADD, rt->wakefd, &ev) < 0) {
+        glog4c_err(strerror(errno));
+        return ASY_ER_EPOLL;
+    }
+    // 定时器句柄的data.ptr为reactor本身
+    tmwheel_init(&rt->wheel, metric_now() / ASY_TICK_NS);
+    tmnode_init(&rt->fired);
+    rt->tmfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (rt->tmfd < 0) {
+        glog4c_err(strerror(errno));
+        return ASY_ER_EPOLL;
+    }
+    ev.events   = EPOLLIN;
+    ev.data.ptr = rt;
+    if (epoll_ctl(rt->epfd, EPOLL_CTL_ADD, rt->tmfd, &ev) < 0) {
+        glog4c_err(strerror(errno));
+        return ASY_ER_EPOLL;
+    }
 
-    // 如果将来需要扩展线程堆栈尺寸或调整参数就需要使用这个功能
-    //ret = pthread_attr_init(&attr);
-    ret = pthread_create(&m_thread, NULL, asyncomm_get_msg, (void *)value);
+    // 将线程绑定到CPU，减少线程迁移带来的缓存失效
+    pthread_attr_init(&attr);
+    CPU_ZERO(&cpus);
+    CPU_SET(idx % sysconf(_SC_NPROCESSORS_ONLN), &cpus);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    ret = pthread_create(&rt->thread, &attr, asyncomm_get_msg, (void *)rt);
+    pthread_attr_destroy(&attr);
     if (ret != 0) {
         glog4c_err("Create pthread is error.\n");
         return ASY_ER_THREAD;
     }
+    return ASY_OK;
+}
+
+// 设置端口积压的高低水位，低水位不小于高水位时取高水位的1/4
+void asyncomm_set_watermark(uint32_t high, uint32_t low)
+{
+    m_flow_high = (0 == high) ? ASY_FLOW_HIGH : high;
+    m_flow_low  = (0 == low) ? ASY_FLOW_LOW : low;
+    if (m_flow_low >= m_flow_high) {
+        m_flow_low = m_flow_high / 4;
+    }
+}
+
+int asyncomm_flow_parse(const char *name)
+{
+    if (NULL == name) {
+        return ASY_ER_PARAM;
+    }
+    if (strcasecmp(name, "oldest") == 0) {
+        return ASY_FLOW_OLDEST;
+    }
+    if (strcasecmp(name, "latest") == 0) {
+        return ASY_FLOW_LATEST;
+    }
+    if (strcasecmp(name, "block") == 0) {
+        return ASY_FLOW_BLOCK;
+    }
+    return ASY_ER_PARAM;
+}
+
+/******************************************************************************
+* Description    : 异步通信初始化函数.创建nthread个通信线程，每个线程运行独立的epoll事件
+*                  循环，注册的文件句柄按负载分配到各个线程.
+* Input          : nthread - 通信线程数量，小于1时按1个处理
+*                : fwd_delay - 转发数据合并的最长等待时间，单位us，0表示只合并同一次唤醒中的数据
+* Output         : None
+* Return         : 返回值参考头文件定义
+*------------------------------------------------------------------------------
+* 2020-01-30     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 注册唤醒eventfd，保持epoll句柄有效
+*                : 2026-10-17 : 1.2.0 : 支持多个通信线程
+*                : 2026-10-17 : 1.3.0 : 通过appq发送，消息尺寸由应用队列决定
+*                : 2026-10-17 : 1.4.0 : 增加转发数据合并等待时间
+******************************************************************************/
+int asyncomm_init(int nthread, uint32_t fwd_delay)
+{
+    int ret;
+
+    if (appq_sendsize() <= ASY_FWD_HEAD) { // 消息尺寸至少要能容纳帧头
+        return ASY_ER_PARAM;
+    }
+    if (nthread < 1) {
+        nthread = 1;
+    } else if (nthread > ASY_MAX_THREADS) {
+        nthread = ASY_MAX_THREADS;
+    }
+    m_rxsize    = (long)appq_sendsize();
+    if (m_rxsize > 0xFFFF + ASY_FWD_HEAD) { // 条目长度只有2字节
+        m_rxsize = 0xFFFF + ASY_FWD_HEAD;
+    }
+    m_fwd_delay = fwd_delay;
 
-    close(m_ephandel);
+    m_reactors = (asyreactor *)calloc(nthread, sizeof(asyreactor));
+    if (NULL == m_reactors) {
+        return ASY_ER_FMEM;
+    }
+    m_rtcap = nthread;
+    for (int idx = 0; idx < nthread; ++idx) {
+        m_reactors[idx].epfd   = -1;
+        m_reactors[idx].wakefd = -1;
+        m_reactors[idx].tmfd   = -1;
+        pthread_mutex_init(&m_reactors[idx].tmlock, NULL);
+    }
+    m_pexit_flag = PT_RUN;
+    for (int idx = 0; idx < nthread; ++idx) {
+        ret = asyncomm_start(&m_reactors[idx], idx);
+        if (ret != ASY_OK) {
+            // 已经创建的线程需要正常退出
+            asyncomm_exit();
+            return ret;
+        }
+        ++m_nreactor;
+    }
+    glog4c_info("Communication threads = %d\n", m_nreactor);
 
     return ASY_OK;
 }
 
-int asyncomm_register(int nfd)
+/******************************************************************************
+* Description    : 注册文件句柄.句柄分配给指定的通信线程、负载最小的通信线程，或者与near_fd
+*                  所在的线程相同，这样相关的句柄(例如串口和它的帧间隔定时器)由同一个线程
+*                  处理，无需加锁.
+*                  epoll_ctl本身是线程安全的，注册完成后句柄就绪时epoll_wait会被直接唤醒，
+*                  所以注册不需要额外唤醒线程.
+* Input          : nfd - 非阻塞的文件句柄
+*                : near_fd - 已注册的句柄，小于0时按负载分配
+*                : rt_idx - 通信线程编号，小于0时不指定
+*                : events - 关注的epoll事件，内部总是附加EPOLLET
+*                : cb - 事件回调，为NULL时使用默认的读取转发处理
+*                : arg - 回调参数
+* Output         : None
+* Return         : 返回值参考头文件定义
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.2.0 : llemmx
+* Modification   :
+******************************************************************************/
+static int asyncomm_attach_to(int nfd, int near_fd, int rt_idx, uint32_t events, asyncomm_cb cb, void *arg)
 {
     int ret = ASY_OK;
+    struct epoll_event ev;
 
-    if (nfd <= 0) {
+    if (nfd <= 0 || m_nreactor <= 0) {
         return ASY_ER_PARAM;
     }
 
-    struct epoll_event ev;
+    asychn *chn = (asychn *)malloc(sizeof(asychn));
+    if (NULL == chn) {
+        return ASY_ER_FMEM;
+    }
+    chn->fd   = nfd;
+    chn->cb   = (NULL == cb) ? asyncomm_read_forward : cb;
+    chn->arg  = arg;
+    chn->rel  = NULL;
+    chn->next = NULL;
+    chn->events = events;
+    chn->port = (NULL == cb) ? CODEC_PORT_NONE : -1; // 默认处理转发的数据不属于任何端口
+
+    pthread_mutex_lock(&m_lock);
+    if (nfd >= m_chn_cap) {
+        int cap = (nfd / ASY_FD_STEP + 1) * ASY_FD_STEP;
+        asychn **tmp = (asychn **)realloc(m_chns, sizeof(asychn *) * cap);
+        if (NULL == tmp) {
+            pthread_mutex_unlock(&m_lock);
+            free(chn);
+            return ASY_ER_FMEM;
+        }
+        memset(tmp + m_chn_cap, 0, sizeof(asychn *) * (cap - m_chn_cap));
+        m_chns    = tmp;
+        m_chn_cap = cap;
+    }
+    if (NULL != m_chns[nfd]) {
+        pthread_mutex_unlock(&m_lock);
+        free(chn);
+        glog4c_debug("Repeat registration\n");
+        return ASY_OK;
+    }
 
-    ev.events  =EPOLLIN | EPOLLET;
-    ev.data.fd =nfd;
+    if (rt_idx >= 0 && rt_idx < m_nreactor) {
+        chn->rt = &m_reactors[rt_idx];
+    } else if (near_fd >= 0 && near_fd < m_chn_cap && NULL != m_chns[near_fd]) {
+        chn->rt = m_chns[near_fd]->rt;
+    } else {
+        chn->rt = asyncomm_pick(nfd);
+    }
+    ev.events   = events | EPOLLET;
+    ev.data.ptr = chn;
     // 注册可通行的文件句柄
-    int epret = epoll_ctl(m_ephandel, EPOLL_CTL_ADD, nfd, &ev);
-    if (EPERM == epret) {
-        ret = ASY_ER_UNEPFILE;
-        glog4c_hit("The target file fd does not support epoll.");
-    } else if (EEXIST == epret) {
+    if (epoll_ctl(chn->rt->epfd, EPOLL_CTL_ADD, nfd, &ev) < 0) {
+        if (EPERM == errno) {
+            ret = ASY_ER_UNEPFILE;
+            glog4c_warn("The target file fd does not support epoll.\n");
+        } else if (EEXIST == errno) {
+            ret = ASY_OK;
+            glog4c_debug("Repeat registration\n");
+        } else {
+            ret = ASY_ER_UNKNOW;
+            glog4c_err(strerror(errno));
+        }
+        pthread_mutex_unlock(&m_lock);
+        free(chn);
+        return ret;
+    }
+    ++chn->rt->nfds;
+    m_chns[nfd] = chn;
+    pthread_mutex_unlock(&m_lock);
+
+    return ret;
+}
+
+int asyncomm_attach(int nfd, int near_fd, uint32_t events, asyncomm_cb cb, void *arg)
+{
+    return asyncomm_attach_to(nfd, near_fd, -1, events, cb, arg);
+}
+
+// 注册到指定编号的通信线程，用于每个线程各自监听一个SO_REUSEPORT端口，或者与定时器在同一个线程
+int asyncomm_attach_at(int nfd, int idx, uint32_t events, asyncomm_cb cb, void *arg)
+{
+    if (idx < 0 || idx >= m_nreactor) {
+        return ASY_ER_PARAM;
+    }
+    return asyncomm_attach_to(nfd, -1, idx, events, cb, arg);
+}
+
+/******************************************************************************
+* Description    : 注册文件句柄，只关注可读事件.句柄分配给负载最小的通信线程.
+* Input          : nfd - 非阻塞的文件句柄
+*                : cb - 事件回调，为NULL时使用默认的读取转发处理
+*                : arg - 回调参数
+* Output         : None
+* Return         : 返回值参考头文件定义
+*------------------------------------------------------------------------------
+* 2020-01-30     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 增加回调，修正epoll_ctl返回值判断
+*                : 2026-10-17 : 1.2.0 : 按负载分配通信线程
+******************************************************************************/
+int asyncomm_register(int nfd, asyncomm_cb cb, void *arg)
+{
+    return asyncomm_attach(nfd, -1, EPOLLIN | EPOLLRDHUP, cb, arg);
+}
+
+/******************************************************************************
+* Description    : 设置通道释放回调.通道被注销后，所属通信线程在不再引用回调参数时调用它，
+*                  调用者可以在其中安全地释放回调参数并关闭句柄.
+* Input          : fd - 已注册的文件句柄
+*                : rel - 释放回调
+* Output         : None
+* Return         : 返回值参考头文件定义
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.2.0 : llemmx
+* Modification   :
+******************************************************************************/
+int asyncomm_set_release(int fd, asyncomm_rel rel)
+{
+    int ret = ASY_ER_PARAM;
+
+    pthread_mutex_lock(&m_lock);
+    if (fd >= 0 && fd < m_chn_cap && NULL != m_chns[fd]) {
+        m_chns[fd]->rel = rel;
         ret = ASY_OK;
-        glog4c_hit("Repeat registration");
-    } else {
-        ret = ASY_ER_UNKNOW;
-        glog4c_err("Unknow error!");
     }
+    pthread_mutex_unlock(&m_lock);
+    return ret;
+}
 
+// 登记句柄读到的数据所属的端口，ASY_FLOW_BLOCK的端口积压时停止读取这个句柄
+int asyncomm_set_port(int fd, int port)
+{
+    int ret = ASY_ER_PARAM;
+
+    pthread_mutex_lock(&m_lock);
+    if (fd >= 0 && fd < m_chn_cap && NULL != m_chns[fd] && port >= 0) {
+        m_chns[fd]->port = port;
+        ret = ASY_OK;
+    }
+    pthread_mutex_unlock(&m_lock);
     return ret;
 }
 
+/******************************************************************************
+* Description    : 注销文件句柄.通道内存由所属通信线程在当前批次事件处理完后释放.
+* Input          : ofd - 已注册的文件句柄
+* Output         : None
+* Return         : 返回值参考头文件定义
+*------------------------------------------------------------------------------
+* 2020-01-30     : 1.0.0 : llemmx
+* Modification   : 2026-10-17 : 1.1.0 : 延迟释放通道
+******************************************************************************/
 int asyncomm_remove(int ofd)
 {
-    struct epoll_event ev;
-
-    int epret = epoll_ctl(m_ephandel, EPOLL_CTL_DEL, ofd, &ev);
+    pthread_mutex_lock(&m_lock);
+    asychn *chn = asyncomm_detach(ofd);
+    asyreactor *rt = (NULL == chn) ? NULL : chn->rt;
+    pthread_mutex_unlock(&m_lock);
 
-    if (ENOENT == epret) {
-        glog4c_hit("fd is not registered with this epoll instance.");
+    if (NULL == rt) {
+        glog4c_warn("fd is not registered with this epoll instance.\n");
+        return ASY_OK;
+    }
+    if (m_cur != rt) {
+        asyncomm_wakeup(rt);
     }
     return ASY_OK;
 }
 
-int asyncomm_exit(void)
+/******************************************************************************
+* Description    : 转发数据到应用队列，数据封装为CODEC_CMD_DATA帧，超过队列消息尺寸的数据
+*                  会被拆分成多帧.小块数据追加到当前通信线程的合并帧中，每条数据是一个以
+*                  端口号为编号的条目，帧满、等待超时或本次唤醒结束时一次发送；超过半帧的
+*                  数据先发送合并帧再单独成帧，在txbuf中组帧，数据本身位于rxbuf时只需要在
+*                  前面填写帧头，不再拷贝.应用队列满时数据进入端口的积压缓冲区，由重试定时器
+*                  按顺序发送；端口已有积压时新数据也排在后面，保持同一端口数据的顺序.
+*                  ASY_FLOW_LATEST把一次调用的数据当作一条消息合并
+* Input          : port - 数据来源端口，CODEC_PORT_NONE表示不属于任何端口
+*                : buf - 数据
+*                : size - 数据长度
+* Output         : None
+* Return         : 端口按ASY_FLOW_BLOCK停止读取时返回ASY_ER_BUSY，回调应当停止读取并返回
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.1.0 : llemmx
+* Modification   : 2026-10-17 按消息格式封装数据
+*                : 2026-10-17 小块数据合并发送
+*                : 2026-10-17 队列满时按端口积压，不再直接丢弃
+*                : 2026-10-17 latest按消息合并
+******************************************************************************/
+int asyncomm_forward(int port, const void *buf, size_t size)
 {
-    m_pexit_flag = PT_EXIT;
+    const char *pos = (const char *)buf;
+    size_t chunk = (size_t)m_rxsize - ASY_FWD_HEAD;
+    asyreactor *rt = m_cur;
+    codec_writer wr;
+    int ret = ASY_OK;
+    int first = 1; // 超过一个记录的数据拆成多个记录，只有第一个参与latest合并
+
+    if (NULL == buf || 0 == m_rxsize || NULL == rt) {
+        return ASY_ER_PARAM;
+    }
+    metric_port(port, 1, size);
+    while (size > 0) {
+        size_t len = size > chunk ? chunk : size;
+        asyflow *flow = asyflow_get(rt, port, 0);
+        if (rt->congested || (NULL != flow && flow->nrec > 0)) {
+            ret = asyflow_push(rt, port, pos, (uint16_t)len, first);
+        } else if (codec_item_size(DB_BLOB, (uint16_t)len) > (size_t)m_rxsize / 2) {
+            // 先发送合并帧，保持同一端口数据的顺序
+            if (asyncomm_flush(rt) != ASY_OK) {
+                ret = asyflow_push(rt, port, pos, (uint16_t)len, first);
+            } else {
+                codec_begin(&wr, rt->txbuf, m_rxsize, CODEC_CMD_DATA, DB_BLOB, 0);
+                codec_put(&wr, (uint16_t)port, pos, (uint16_t)len); // 同一个缓冲区中时为重叠拷贝
+                int sret = appq_send(rt->txbuf, codec_end(&wr));
+                if (APPQ_OK == sret) {
+                    metric_add(METRIC_FWD_FRAMES, 1);
+                    metric_add(METRIC_FWD_RECORDS, 1);
+                } else if (APPQ_ER_AGAIN == sret) {
+                    // 组帧时数据已经移到txbuf的条目中
+                    ret = asyflow_push(rt, port, rt->txbuf + ASY_FWD_HEAD, (uint16_t)len, first);
+                    rt->congested = 1;
+                    metric_add(METRIC_FLOW_CONGEST, 1);
+                    asyncomm_arm(rt, ASY_RETRY_US);
+                } else {
+                    glog4c_err("forward to app failed!\n");
+                    metric_add(METRIC_ASY_DROP, 1);
+                }
+            }
+        } else if (codec_put(&rt->pend, (uint16_t)port, pos, (uint16_t)len) == CODEC_OK) {
+            if (1 == rt->pend.count) {
+                rt->pend_start = metric_begin(METRIC_H_FWD_DELAY);
+                if (m_fwd_delay > 0) {
+                    asyncomm_arm(rt, m_fwd_delay);
+                }
+            }
+        } else if (asyncomm_flush(rt) == ASY_OK) {
+            // 合并帧空间或条目数量不足时先发送，新帧一定能容纳不超过半帧的数据
+            asyncomm_pend_put(rt, port, pos, (uint16_t)len);
+        } else {
+            ret = asyflow_push(rt, port, pos, (uint16_t)len, first);
+        }
+        pos  += len;
+        size -= len;
+        first = 0;
+    }
+    return ret;
 }
 
-int asyncomm_open_serial()
+size_t asyncomm_msgsize(void)
 {
-    return ASY_OK;
+    return (size_t)m_rxsize;
 }
 
-int asyncomm_open_tcpc()
+// 当前通信线程的接收缓冲区，尺寸为asyncomm_msgsize()，只能在事件回调中使用
+char *asyncomm_rxbuf(void)
 {
-    return ASY_OK;
+    return (NULL == m_cur) ? NULL : m_cur->rxbuf;
 }
 
-int asyncomm_open_tcps()
+size_t asyncomm_rxsize(void)
 {
+    return (size_t)m_rxsize - ASY_FWD_HEAD;
+}
+
+int asyncomm_nreactor(void)
+{
+    return m_nreactor;
+}
+
+int asyncomm_timer_init(asytimer *tm, int near_fd, asytimer_cb cb, void *arg)
+{
+    asyreactor *rt = NULL;
+
+    if (NULL == tm || NULL == cb || m_nreactor <= 0) {
+        return ASY_ER_PARAM;
+    }
+    if (near_fd >= 0) {
+        pthread_mutex_lock(&m_lock);
+        if (near_fd < m_chn_cap && NULL != m_chns[near_fd]) {
+            rt = m_chns[near_fd]->rt;
+        }
+        pthread_mutex_unlock(&m_lock);
+    }
+    if (NULL == rt) {
+        rt = (NULL != m_cur) ? m_cur
+            : asyncomm_pick((int)(__atomic_fetch_add(&m_tm_rr, 1, __ATOMIC_RELAXED) & 0x7FFFFFFF));
+    }
+    tmnode_init(&tm->node);
+    tm->cb  = cb;
+    tm->arg = arg;
+    tm->rt  = rt;
     return ASY_OK;
 }
 
+int asyncomm_timer_reactor(const asytimer *tm)
+{
+    return ((const asyreactor *)tm->rt)->idx;
+}
+
+/******************************************************************************
+* Description    : 启动定时器.到期时间向上取整到tick，不会提前到期.插入前时间轮先推进到
+*                  当前时间，定时器放在尽量低的层，只有比timerfd已经设置的时间更早时才
+*                  重新设置timerfd
+* Input          : tm - 已经初始化的定时器
+*                : deadline - 单调时钟的绝对时间，单位ns
+* Output         : None
+* Return         : None
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+void asyncomm_timer_at(asytimer *tm, uint64_t deadline)
+{
+    asyreactor *rt = (asyreactor *)tm->rt;
+    uint64_t now = metric_now();
+
+    pthread_mutex_lock(&rt->tmlock);
+    asyncomm_wheel_sync(rt, now);
+    tmwheel_add(&rt->wheel, &tm->node, (deadline + ASY_TICK_NS - 1) / ASY_TICK_NS);
+    asyncomm_program(rt, tm->node.expire * ASY_TICK_NS);
+    pthread_mutex_unlock(&rt->tmlock);
+}
+
+void asyncomm_timer_set(asytimer *tm, uint32_t ms)
+{
+    asyncomm_timer_at(tm, metric_now() + (uint64_t)ms * 1000000ULL);
+}
+
+void asyncomm_timer_cancel(asytimer *tm)
+{
+    asyreactor *rt = (asyreactor *)tm->rt;
+
+    if (NULL == rt) {
+        return;
+    }
+    pthread_mutex_lock(&rt->tmlock);
+    tmwheel_del(&rt->wheel, &tm->node);
+    // 其他线程停止时等待回调结束，回调中可能重新启动了定时器，需要再删除一次
+    while (rt->running == tm && m_cur != rt) {
+        pthread_mutex_unlock(&rt->tmlock);
+        sched_yield();
+        pthread_mutex_lock(&rt->tmlock);
+        tmwheel_del(&rt->wheel, &tm->node);
+    }
+    pthread_mutex_unlock(&rt->tmlock);
+}
+
+/******************************************************************************
+* Description    : 登记通道端口，返回的端口编号用于发送数据和关闭通道.
+* Input          : ctx - 通道私有数据
+*                : ops - 通道操作
+* Output         : None
+* Return         : 成功返回端口编号，失败返回头文件中定义的错误码
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.3.0 : llemmx
+* Modification   :
+******************************************************************************/
+int asyncomm_port_add(void *ctx, const asyport_ops *ops)
+{
+    int port;
+
+    if (NULL == ctx || NULL == ops) {
+        return ASY_ER_PARAM;
+    }
+    pthread_rwlock_wrlock(&m_port_lock);
+    for (port = 0; port < m_port_cap; ++port) {
+        if (NULL == m_ports[port].ctx) {
+            break;
+        }
+    }
+    if (port == m_port_cap) {
+        int cap = m_port_cap + ASY_FD_STEP;
+        asyport *tmp = (asyport *)realloc(m_ports, sizeof(asyport) * cap);
+        if (NULL == tmp) {
+            pthread_rwlock_unlock(&m_port_lock);
+            return ASY_ER_FMEM;
+        }
+        memset(tmp + m_port_cap, 0, sizeof(asyport) * (cap - m_port_cap));
+        m_ports    = tmp;
+        m_port_cap = cap;
+    }
+    m_ports[port].ctx  = ctx;
+    m_ports[port].ops  = ops;
+    m_ports[port].flow = ASY_FLOW_OLDEST;
+    m_ports[port].txn  = NULL;
+    pthread_rwlock_unlock(&m_port_lock);
+    return port;
+}
+
+// 登记端口的事务表，端口删除后不再通过端口访问它
+int asyncomm_port_txn(int port, asytxn *txn)
+{
+    int ret = ASY_ER_PARAM;
+
+    pthread_rwlock_wrlock(&m_port_lock);
+    if (port >= 0 && port < m_port_cap && NULL != m_ports[port].ctx) {
+        m_ports[port].txn = txn;
+        ret = ASY_OK;
+    }
+    pthread_rwlock_unlock(&m_port_lock);
+    return ret;
+}
+
+// 向启用事务的端口发送请求，持读锁期间端口不会被删除，事务表不会被释放
+int asyncomm_request(int port, uint32_t tag, const void *buf, size_t size)
+{
+    int ret = ASY_ER_PARAM;
+
+    pthread_rwlock_rdlock(&m_port_lock);
+    if (port >= 0 && port < m_port_cap && NULL != m_ports[port].txn) {
+        ret = asytxn_request(m_ports[port].txn, tag, buf, size);
+    }
+    pthread_rwlock_unlock(&m_port_lock);
+    return ret;
+}
+
+// 设置端口的积压处理方式，通信线程第一次积压该端口的数据时读取
+int asyncomm_port_flow(int port, int policy)
+{
+    int ret = ASY_ER_PARAM;
+
+    if (policy < ASY_FLOW_OLDEST || policy > ASY_FLOW_BLOCK) {
+        return ASY_ER_PARAM;
+    }
+    pthread_rwlock_wrlock(&m_port_lock);
+    if (port >= 0 && port < m_port_cap && NULL != m_ports[port].ctx) {
+        m_ports[port].flow = policy;
+        ret = ASY_OK;
+    }
+    pthread_rwlock_unlock(&m_port_lock);
+    return ret;
+}
+
+// 删除通道端口，返回后不会再有线程通过该端口访问通道私有数据
+void asyncomm_port_del(int port)
+{
+    pthread_rwlock_wrlock(&m_port_lock);
+    if (port >= 0 && port < m_port_cap) {
+        m_ports[port].ctx = NULL;
+        m_ports[port].ops = NULL;
+        m_ports[port].txn = NULL;
+    }
+    pthread_rwlock_unlock(&m_port_lock);
+}
+
+/******************************************************************************
+* Description    : 向通道端口发送数据，可以在任意线程调用.
+* Input          : port - 端口编号
+*                : buf - 数据
+*                : size - 数据长度
+* Output         : None
+* Return         : 成功返回接收的字节数，失败返回头文件中定义的错误码
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.3.0 : llemmx
+* Modification   :
+******************************************************************************/
+int asyncomm_write(int port, const void *buf, size_t size)
+{
+    int ret = ASY_ER_PARAM;
+
+    if (NULL == buf) {
+        return ASY_ER_PARAM;
+    }
+    pthread_rwlock_rdlock(&m_port_lock);
+    if (port >= 0 && port < m_port_cap && NULL != m_ports[port].ctx && NULL != m_ports[port].ops->write) {
+        ret = m_ports[port].ops->write(m_ports[port].ctx, buf, size);
+    }
+    pthread_rwlock_unlock(&m_port_lock);
+    if (ret > 0) {
+        metric_port(port, 0, (uint64_t)ret);
+    }
+    return ret;
+}
+
+// 关闭通道端口，通道资源由通信线程在安全的时机释放
+int asyncomm_close(int port)
+{
+    int ret = ASY_ER_PARAM;
+
+    // 持有读锁保证关闭期间通道私有数据不会被释放回调回收
+    pthread_rwlock_rdlock(&m_port_lock);
+    if (port >= 0 && port < m_port_cap && NULL != m_ports[port].ctx && NULL != m_ports[port].ops->close) {
+        m_ports[port].ops->close(m_ports[port].ctx);
+        ret = ASY_OK;
+    }
+    pthread_rwlock_unlock(&m_port_lock);
+    return ret;
+}
+
+int asyncomm_exit(void)
+{
+    if (NULL == m_reactors) {
+        return ASY_OK;
+    }
+    m_pexit_flag = PT_EXIT;
+    for (int idx = 0; idx < m_nreactor; ++idx) {
+        asyncomm_wakeup(&m_reactors[idx]);
+    }
+    for (int idx = 0; idx < m_nreactor; ++idx) {
+        pthread_join(m_reactors[idx].thread, NULL);
+    }
+
+    // 线程退出后释放所有通道，文件句柄由各自的打开者或释放回调关闭
+    pthread_mutex_lock(&m_lock);
+    for (int fd = 0; fd < m_chn_cap; ++fd) {
+        asyncomm_detach(fd);
+    }
+    pthread_mutex_unlock(&m_lock);
+
+    // 初始化失败时可能有线程未创建，只释放已经申请的资源
+    for (int idx = 0; idx < m_rtcap; ++idx) {
+        asyncomm_reap(&m_reactors[idx]);
+    }
+    for (int idx = 0; idx < m_rtcap; ++idx) {
+        asyreactor *rt = &m_reactors[idx];
+        if (rt->wakefd >= 0) {
+            close(rt->wakefd);
+        }
+        if (rt->tmfd >= 0) {
+            close(rt->tmfd);
+        }
+        for (int port = 0; port < rt->nflow; ++port) {
+            if (NULL != rt->flows[port]) {
+                asyflow_free(rt, rt->flows[port]);
+            }
+        }
+        if (NULL != rt->flow_none) {
+            asyflow_free(rt, rt->flow_none);
+        }
+        free(rt->flows);
+        if (rt->epfd >= 0) {
+            close(rt->epfd);
+        }
+        free(rt->txbuf);
+        free(rt->pendbuf);
+        pthread_mutex_destroy(&rt->tmlock);
+    }
+    free(m_reactors);
+    m_reactors = NULL;
+    m_rtcap    = 0;
+    m_nreactor = 0;
+
+    pthread_mutex_lock(&m_lock);
+    free(m_chns);
+    m_chns    = NULL;
+    m_chn_cap = 0;
+    pthread_mutex_unlock(&m_lock);
+
+    // 释放回调中已经删除了各自的端口，这里只回收端口表
+    pthread_rwlock_wrlock(&m_port_lock);
+    free(m_ports);
+    m_ports    = NULL;
+    m_port_cap = 0;
+    pthread_rwlock_unlock(&m_port_lock);
+    return ASY_OK;
+}
@@ -1,16 +1,172 @@
 #ifndef ASYNCOMM_H_
 #define ASYNCOMM_H_
 
-#include <mqueue.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "codec.h"
+#include "tmwheel.h"
 
 #define ASY_OK 0 // 操作成果
+#define ASY_CLOSE 1 // 事件回调返回该值时，通信线程注销并关闭对应的文件句柄
 #define ASY_ER_PARAM -1 // 参数传递错误，重新申请或传递
 #define ASY_ER_EPOLL -2 // 申请EPOLL资源错误，重新申请或传递
 #define ASY_ER_THREAD -3 // 申请线程时发生错误，重新申请或传递
 #define ASY_ER_UNEPFILE -4 // 不支持EPoll的文件描述符，建议放弃注册
 #define ASY_ER_UNKNOW -5 //未知错误，这个一般比较危险，建议abort
+#define ASY_ER_FMEM -6 // 内存不足
+#define ASY_ER_AGAIN -7 // 目标队列已满，数据未能发送
+#define ASY_ER_BUSY -8 // 端口积压达到高水位，已经停止读取，回调应当直接返回
+
+// 应用队列拥塞时端口积压数据的处理方式
+#define ASY_FLOW_OLDEST 0 // 积压超过上限时丢弃最早的数据
+#define ASY_FLOW_LATEST 1 // 只保留最新的一条消息，适合周期刷新的状态量.按端口合并，不区分数据点；
+                          // 每次转发必需是完整的消息，只能用于按消息交付的端口:串口(按帧间隔
+                          // 成帧)、SOCK_SEQPACKET、按长度字段成帧的事务端口.TCP字节流的一次
+                          // 读取不是完整的消息，没有长度字段时不能使用
+#define ASY_FLOW_BLOCK  2 // 积压达到高水位时停止读取端口，降到低水位后恢复，由对端或内核缓冲
+
+// 转发到应用的数据封装为CODEC_CMD_DATA帧，帧头加一个条目头的长度
+#define ASY_FWD_HEAD (CODEC_HEAD_SIZE + 4)
+
+// 文件句柄事件回调，events为epoll事件掩码。句柄以边沿触发方式注册，回调内必需读到EAGAIN为止
+typedef int (*asyncomm_cb)(int fd, uint32_t events, void *arg);
+// 通道释放回调，设置后句柄由释放回调负责关闭
+typedef void (*asyncomm_rel)(void *arg);
+
+// 通道端口操作，write可能在任意线程调用，close只发起关闭，资源在释放回调中回收
+typedef struct {
+    int  (*write)(void *ctx, const void *buf, size_t size);
+    void (*close)(void *ctx);
+}asyport_ops;
+
+// 通信线程定时器的精度，时间轮的一个tick
+#define ASY_TICK_NS 1000000ULL
+
+// 定时器回调，在定时器所属的通信线程中执行
+typedef void (*asytimer_cb)(void *arg);
+
+// 通信线程的定时器，嵌入使用者的结构中.每个通信线程用一个分层时间轮管理所有定时器，
+// 只占用一个timerfd，同一个tick到期的定时器在一次唤醒中全部处理
+typedef struct {
+    tmnode      node; // 时间轮节点
+    asytimer_cb cb;   // 到期回调
+    void       *arg;  // 回调参数
+    void       *rt;   // 所属的通信线程
+}asytimer;
+
+// 请求的结果状态，随CODEC_CMD_RESP返回给应用
+#define ASY_TXN_OK      0 // 收到应答
+#define ASY_TXN_TIMEOUT 1 // 重发次数用完仍然没有应答
+#define ASY_TXN_CLOSED  2 // 端口已经关闭，请求被取消
+#define ASY_TXN_BUSY    3 // 在途请求和等待队列都已满
+#define ASY_TXN_NOPORT  4 // 端口不存在或没有启用事务
+
+// 事务参数，window为0时不启用，端口收到的数据原样转发
+typedef struct {
+    uint16_t window;  // 最多同时在途的请求数量，半双工串口固定为1
+    uint16_t retry;   // 超时后的重发次数
+    uint32_t timeout; // 应答超时时间，单位ms
+    int16_t  seq_off; // 请求和应答中2字节大端序号的位置，由通讯者填写，-1表示按发送顺序匹配应答，
+                      // 这时丢失一个应答会使后面的应答错位，流水线应当配置序号位置
+    int16_t  len_off; // 应答中2字节大端长度字段的位置，-1表示每次读到的数据(串口为一帧)是一个应答.
+                      // TCP等字节流端口没有长度字段时window按1处理，分两次读到的应答仍会被拆开
+    int16_t  len_adj; // 应答总长度 = len_off + 2 + 长度字段的值 + len_adj
+}asytxn_cfg;
+
+typedef struct asytxn asytxn;
+
+// 串口参数
+typedef struct {
+    uint32_t baud;     // 波特率
+    uint8_t  databits; // 数据位，5~8
+    uint8_t  stopbits; // 停止位，1或2
+    char     parity;   // 校验方式，'N'无校验 'E'偶校验 'O'奇校验
+    uint8_t  vmin;     // 缓存字节数达到vmin时立即成帧，0表示不按字节数成帧
+    uint8_t  vtime;    // 帧间隔，单位0.1秒，0表示每次唤醒读到的数据作为一帧
+    uint8_t  flow;     // 积压处理方式，ASY_FLOW_xxx
+    asytxn_cfg txn;    // 事务参数，串口是半双工的，window非0时按1处理
+}asyserial_cfg;
+
+// 初始化异步通信线程，nthread为通信线程数量，fwd_delay为转发数据合并的最长等待时间(us)，
+// 需要在appq_open之后调用
+int asyncomm_init(int nthread, uint32_t fwd_delay);
+// 设置端口积压的高低水位(B)，需要在asyncomm_init之前调用，0使用默认值
+void asyncomm_set_watermark(uint32_t high, uint32_t low);
+// 积压处理方式名称("oldest"/"latest"/"block")转换为ASY_FLOW_xxx，无法识别时返回ASY_ER_PARAM
+int asyncomm_flow_parse(const char *name);
+// 注册文件句柄，cb为NULL时使用默认的读取并转发到应用队列的处理
+int asyncomm_register(int nfd, asyncomm_cb cb, void *arg);
+// 注册文件句柄，指定关注的事件，near_fd有效时与其注册到同一个通信线程
+int asyncomm_attach(int nfd, int near_fd, uint32_t events, asyncomm_cb cb, void *arg);
+// 注册文件句柄到编号为idx的通信线程
+int asyncomm_attach_at(int nfd, int idx, uint32_t events, asyncomm_cb cb, void *arg);
+// 设置通道释放回调
+int asyncomm_set_release(int fd, asyncomm_rel rel);
+// 注销文件句柄，句柄本身由调用者关闭
+int asyncomm_remove(int ofd);
+// 将端口收到的数据封装为CODEC_CMD_DATA帧转发到通讯者到应用的队列，小块数据合并发送，
+// 只能在事件回调中使用
+int asyncomm_forward(int port, const void *buf, size_t size);
+// 应用队列单条消息的最大尺寸
+size_t asyncomm_msgsize(void);
+// 当前通信线程的接收缓冲区，只能在事件回调中使用
+char *asyncomm_rxbuf(void);
+// 接收缓冲区尺寸，读满一次缓冲区转发时正好是一条消息
+size_t asyncomm_rxsize(void);
+// 通信线程数量
+int asyncomm_nreactor(void);
+// 初始化定时器，与near_fd在同一个通信线程，near_fd无效时在通信线程中调用属于当前线程，
+// 否则按负载分配
+int asyncomm_timer_init(asytimer *tm, int near_fd, asytimer_cb cb, void *arg);
+// 定时器所属的通信线程编号，相关的句柄可以用asyncomm_attach_at注册到同一个线程
+int asyncomm_timer_reactor(const asytimer *tm);
+// 启动定时器，deadline为单调时钟的绝对时间(ns)，已经启动的定时器重新计时，可以在任意线程调用
+void asyncomm_timer_at(asytimer *tm, uint64_t deadline);
+// 启动定时器，ms毫秒后到期
+void asyncomm_timer_set(asytimer *tm, uint32_t ms);
+// 停止定时器.在其他线程调用时等待正在执行的回调结束，返回后回调不会再执行；
+// 回调中不能停止属于其他通信线程的定时器，以免互相等待
+void asyncomm_timer_cancel(asytimer *tm);
+// 通知通信线程退出并等待其结束
+int asyncomm_exit(void);
+
+// 登记通道端口，成功返回端口编号
+int asyncomm_port_add(void *ctx, const asyport_ops *ops);
+// 设置端口的积压处理方式，在端口登记之后、注册句柄之前调用
+int asyncomm_port_flow(int port, int policy);
+// 登记句柄转发数据所属的端口，积压达到高水位时停止读取该句柄
+int asyncomm_set_port(int fd, int port);
+// 删除通道端口，在通道的释放回调中调用
+void asyncomm_port_del(int port);
+// 向端口发送数据，未能立即写出的数据缓存后由通信线程发送，成功返回接收的字节数
+int asyncomm_write(int port, const void *buf, size_t size);
+// 关闭端口
+int asyncomm_close(int port);
+
+// 建立端口的事务表，write/ctx为通道的发送操作，超时定时器与near_fd属于同一个通信线程
+asytxn *asytxn_new(int port, const asytxn_cfg *cfg, int (*write)(void *, const void *, size_t),
+    void *ctx, int near_fd);
+// 通道收到的数据，匹配在途请求后作为应答返回给应用，不匹配的数据按普通数据转发，只能在事件回调中使用
+int asytxn_input(asytxn *txn, const void *buf, size_t size);
+// 发送请求，在途请求已满时进入等待队列，队列也满时返回ASY_ER_AGAIN
+int asytxn_request(asytxn *txn, uint32_t tag, const void *buf, size_t size);
+// 连接重建，丢弃拼接到一半的应答，在途请求等待超时重发
+void asytxn_link(asytxn *txn);
+// 取消所有请求并释放事务表，在通道的释放回调中、删除端口之后调用
+void asytxn_free(asytxn *txn);
+// 登记端口的事务表，在端口登记之后、注册句柄之前调用
+int asyncomm_port_txn(int port, asytxn *txn);
+// 向启用了事务的端口发送请求，可以在任意线程调用，端口没有事务表时返回ASY_ER_PARAM
+int asyncomm_request(int port, uint32_t tag, const void *buf, size_t size);
 
-// 初始化异步通信线程
-int asyncomm_init(mqd_t *value);
+// 打开串口并注册到通信线程，成功返回端口编号
+int asyncomm_open_serial(const char *dev, const asyserial_cfg *cfg);
+// 打开TCP客户端，连接断开后按退避时间自动重连，flow为积压处理方式，txn为事务参数(可以为NULL)，
+// 成功返回端口编号.ASY_FLOW_LATEST要求txn启用并配置了长度字段，否则返回ASY_ER_PARAM
+int asyncomm_open_tcpc(const char *host, uint16_t port, int flow, const asytxn_cfg *txn);
+// 打开TCP服务端，每个通信线程各自监听一个SO_REUSEPORT端口，接入的连接使用flow处理积压，
+// 成功返回端口编号.接入的连接没有成帧方式，不支持ASY_FLOW_LATEST
+int asyncomm_open_tcps(const char *host, uint16_t port, int flow);
 
 #endif
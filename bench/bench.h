@@ -0,0 +1,108 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <fcntl.h>
+#include <mqueue.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "appq.h"
+#include "codec.h"
+
+// 性能测试的公共函数，每个性能测试是一个独立的程序，结果输出到标准输出
+
+// 单调时钟，单位ns
+static inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline int bench_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+
+    return (x < y) ? -1 : (x > y);
+}
+
+// 对样本排序后取百分位，pct为0~100
+static inline uint64_t bench_pct(uint64_t *val, size_t num, double pct)
+{
+    if (0 == num) {
+        return 0;
+    }
+    qsort(val, num, sizeof(uint64_t), bench_cmp);
+    size_t idx = (size_t)(pct * (num - 1) / 100.0);
+    return val[idx];
+}
+
+// 防止编译器把只计算不使用的结果优化掉
+static inline void bench_keep(uint64_t val)
+{
+    __asm__ __volatile__("" : : "r"(val) : "memory");
+}
+
+#define BENCH_RX_ITEMS 1024 // 一帧中最多解码的条目数量
+
+// 从通讯者到应用的队列接收帧
+typedef struct {
+    mqd_t      mq;
+    char      *buf;
+    size_t     size;
+    codec_head head;
+    codec_item item[BENCH_RX_ITEMS];
+}bench_rx;
+
+// 用带进程号的队列名打开应用队列，并打开通讯者到应用方向的读取句柄，成功返回0
+static inline int bench_appq_open(bench_rx *rx, const char *tag)
+{
+    char a2q[64], q2a[64];
+    struct mq_attr attr;
+
+    snprintf(a2q, sizeof(a2q), "/bench_%s_a2q_%d", tag, (int)getpid());
+    snprintf(q2a, sizeof(q2a), "/bench_%s_q2a_%d", tag, (int)getpid());
+    if (appq_open(APPQ_MQUEUE, a2q, q2a, 0) != APPQ_OK) {
+        return -1;
+    }
+    rx->mq = mq_open(q2a, O_RDONLY);
+    if (rx->mq == (mqd_t)-1 || mq_getattr(rx->mq, &attr) < 0) {
+        appq_close();
+        return -1;
+    }
+    rx->size = (size_t)attr.mq_msgsize;
+    rx->buf  = (char*)malloc(rx->size);
+    return (NULL == rx->buf) ? -1 : 0;
+}
+
+static inline void bench_appq_close(bench_rx *rx)
+{
+    mq_close(rx->mq);
+    free(rx->buf);
+    appq_close();
+}
+
+// 接收并解码一帧，timeout_ms内没有收到时返回-1，成功返回条目数量
+static inline int bench_rx_frame(bench_rx *rx, int timeout_ms)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec  += 1;
+        ts.tv_nsec -= 1000000000L;
+    }
+    ssize_t len = mq_timedreceive(rx->mq, rx->buf, rx->size, NULL, &ts);
+    if (len < 0) {
+        return -1;
+    }
+    return codec_decode(rx->buf, (size_t)len, &rx->head, rx->item, BENCH_RX_ITEMS);
+}
+
+#endif
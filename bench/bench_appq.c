@@ -0,0 +1,152 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_appq.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :应用队列两种传输方式的往返延迟.父进程作为通讯者用appq打开队列，子进程作为
+//                 应用，收到一条消息后原样发回.父进程发送后等待队列句柄可读再接收(与主循环
+//                 通过epoll等待相同)，输出不同消息尺寸下POSIX消息队列和共享内存环的p50/p99
+//                 往返时间和每秒往返次数
+// Interface      :bench_appq [往返次数]
+// Others         :两边都阻塞等待，包含唤醒对方的时间
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include "appq.h"
+#include "shmring.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_MAXLEN 4096
+
+static uint64_t m_lat[200000];
+static char     m_a2q[64], m_q2a[64];
+
+// 子进程:POSIX消息队列的应用侧
+static void bench_echo_mq(void)
+{
+    char buf[8192];
+    mqd_t rx = mq_open(m_q2a, O_RDONLY);
+    mqd_t tx = mq_open(m_a2q, O_WRONLY);
+
+    if (rx == (mqd_t)-1 || tx == (mqd_t)-1) {
+        _exit(EXIT_FAILURE);
+    }
+    for (;;) {
+        ssize_t len = mq_receive(rx, buf, sizeof(buf), NULL);
+        if (len < 0 || mq_send(tx, buf, (size_t)len, 0) < 0) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// 子进程:共享内存环的应用侧
+static void bench_echo_shm(void)
+{
+    char buf[BENCH_MAXLEN];
+    shmring rx, tx;
+
+    if (shmring_open(m_q2a, &rx) != SHMRING_OK || shmring_open(m_a2q, &tx) != SHMRING_OK) {
+        _exit(EXIT_FAILURE);
+    }
+    for (;;) {
+        int len = shmring_recv_wait(&rx, buf, sizeof(buf), -1);
+        if (len < 0) {
+            _exit(EXIT_FAILURE);
+        }
+        while (shmring_send(&tx, buf, (uint32_t)len) == SHMRING_ER_AGAIN) {
+        }
+    }
+}
+
+// 发送一条消息并等待应答，返回往返时间(ns)
+static uint64_t bench_round(const char *msg, char *buf, size_t len)
+{
+    struct pollfd pfd;
+
+    uint64_t start = bench_now();
+    if (appq_send(msg, len) != APPQ_OK) {
+        fprintf(stderr, "send failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (;;) {
+        int ret = appq_recv(buf, BENCH_MAXLEN * 2);
+        if (ret >= 0) {
+            if ((size_t)ret != len) {
+                fprintf(stderr, "echo size %d != %zu\n", ret, len);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        }
+        if (APPQ_ER_AGAIN != ret) {
+            fprintf(stderr, "recv failed %d\n", ret);
+            exit(EXIT_FAILURE);
+        }
+        pfd.fd     = appq_fd();
+        pfd.events = POLLIN;
+        poll(&pfd, 1, 1000);
+    }
+    return bench_now() - start;
+}
+
+static void bench_case(int kind, int rounds)
+{
+    static const size_t lens[] = {16, 256, 1024, BENCH_MAXLEN};
+    static char msg[BENCH_MAXLEN], buf[BENCH_MAXLEN * 2];
+    int status;
+
+    snprintf(m_a2q, sizeof(m_a2q), "/bench_appq_a2q_%d", (int)getpid());
+    snprintf(m_q2a, sizeof(m_q2a), "/bench_appq_q2a_%d", (int)getpid());
+    if (appq_open(kind, m_a2q, m_q2a, 0) != APPQ_OK) {
+        fprintf(stderr, "open %s failed\n", APPQ_SHM == kind ? "shm" : "mqueue");
+        exit(EXIT_FAILURE);
+    }
+    pid_t pid = fork();
+    if (0 == pid) {
+        (APPQ_SHM == kind) ? bench_echo_shm() : bench_echo_mq();
+    }
+    if (pid < 0) {
+        exit(EXIT_FAILURE);
+    }
+    memset(msg, 0x5A, sizeof(msg));
+    for (size_t idx = 0; idx < sizeof(lens) / sizeof(lens[0]); ++idx) {
+        for (int round = 0; round < rounds / 10; ++round) { // 预热
+            bench_round(msg, buf, lens[idx]);
+        }
+        uint64_t begin = bench_now();
+        for (int round = 0; round < rounds; ++round) {
+            m_lat[round] = bench_round(msg, buf, lens[idx]);
+        }
+        double secs = (bench_now() - begin) / 1e9;
+        uint64_t p50 = bench_pct(m_lat, rounds, 50);
+        uint64_t p99 = bench_pct(m_lat, rounds, 99);
+        printf("%-7s %6zu %10llu %10llu %12.0f\n", APPQ_SHM == kind ? "shm" : "mqueue", lens[idx],
+            (unsigned long long)p50, (unsigned long long)p99, rounds / secs);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    appq_close();
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 50000;
+
+    if (rounds <= 0 || rounds > (int)(sizeof(m_lat) / sizeof(m_lat[0]))) {
+        rounds = 50000;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    printf("%d round trips per size, both sides block until woken\n", rounds);
+    printf("%-7s %6s %10s %10s %12s\n", "queue", "bytes", "p50 ns", "p99 ns", "rtt/s");
+    bench_case(APPQ_MQUEUE, rounds);
+    bench_case(APPQ_SHM, rounds);
+    return EXIT_SUCCESS;
+}
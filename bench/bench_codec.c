@@ -0,0 +1,75 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_codec.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :应用消息编解码的耗时.按不同的条目数量和数据类型编码、解码一帧，输出
+//                 每帧和每个条目的平均纳秒数
+// Interface      :bench_codec [轮数]
+// Others         :无
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "bench.h"
+
+#define BENCH_MAX_ITEMS 1024
+
+static uint8_t    m_buf[65536];
+static codec_item m_item[BENCH_MAX_ITEMS];
+
+static void bench_case(const char *name, uint8_t type, int count, uint16_t vlen, int rounds)
+{
+    codec_writer wr;
+    codec_head head;
+    uint8_t value[64];
+    size_t len = 0;
+
+    memset(value, 0x3C, sizeof(value));
+    uint64_t start = bench_now();
+    for (int round = 0; round < rounds; ++round) {
+        codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_SET, type, 1);
+        for (int idx = 0; idx < count; ++idx) {
+            codec_put(&wr, (uint16_t)idx, value, vlen);
+        }
+        len = codec_end(&wr);
+        bench_keep(len);
+    }
+    double enc = (double)(bench_now() - start) / rounds;
+
+    uint64_t sum = 0;
+    start = bench_now();
+    for (int round = 0; round < rounds; ++round) {
+        int num = codec_decode(m_buf, len, &head, m_item, BENCH_MAX_ITEMS);
+        sum += (uint64_t)num + m_item[num - 1].len;
+    }
+    double dec = (double)(bench_now() - start) / rounds;
+    bench_keep(sum);
+    printf("%-8s %6d %8zu %12.1f %10.2f %12.1f %10.2f\n", name, count, len,
+        enc, enc / count, dec, dec / count);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 200000;
+    static const int counts[] = {1, 16, 256, 1024};
+
+    if (rounds <= 0) {
+        rounds = 200000;
+    }
+    printf("%-8s %6s %8s %12s %10s %12s %10s\n", "type", "items", "bytes",
+        "enc ns/frm", "ns/item", "dec ns/frm", "ns/item");
+    for (size_t idx = 0; idx < sizeof(counts) / sizeof(counts[0]); ++idx) {
+        int scaled = rounds / counts[idx] > 1000 ? rounds / counts[idx] * 16 : 1000;
+        bench_case("uint16", DB_UINT16, counts[idx], 0, scaled);
+        bench_case("float", DB_FLOAT, counts[idx], 0, scaled);
+        bench_case("double", DB_DOUBLE, counts[idx], 0, scaled);
+        bench_case("blob32", DB_BLOB, counts[idx], 32, scaled);
+    }
+    return EXIT_SUCCESS;
+}
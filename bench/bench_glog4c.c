@@ -0,0 +1,113 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_glog4c.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :异步日志调用线程的开销.分别测量级别关闭的调用、只有整数参数的记录和带字符串、
+//                 浮点参数的记录，每批256条，批之间等待后台线程取空缓冲区，不计入丢弃和等待；
+//                 同样的格式直接snprintf作为同步格式化的参考.最后用block方式连续写入，测量
+//                 后台线程格式化并写文件的吞吐量
+// Interface      :bench_glog4c [批数]
+// Others         :日志写入/dev/null，只测量格式化和缓冲区的开销.每批的平均值作为一个样本
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_BATCH  256    // 每批的调用次数，远小于一个线程缓冲区能容纳的记录数量
+#define BENCH_WAIT   15000  // 批之间的等待时间(us)，超过后台线程的取出周期
+#define BENCH_BURST  200000 // 吞吐量测试的记录数量
+#define BENCH_TARGET 100    // 调用开销的目标，ns
+
+static uint64_t m_lat[4096];
+static volatile int m_level = LOG_DEBUG; // 运行时关闭的级别，编译器看不到数值
+
+// 输出一行结果，样本为每批的平均值，target非0时标出超过目标的情况
+static void bench_report(const char *name, int batches, int target)
+{
+    uint64_t p50 = bench_pct(m_lat, batches, 50);
+    uint64_t p99 = bench_pct(m_lat, batches, 99);
+
+    printf("%-22s %8.1f %8.1f %s\n", name, p50 / (double)BENCH_BATCH, p99 / (double)BENCH_BATCH,
+        (target && p50 / BENCH_BATCH > BENCH_TARGET) ? "over target" : "");
+}
+
+int main(int argc, char **argv)
+{
+    static char line[1024];
+    int batches = (argc > 1) ? atoi(argv[1]) : 200;
+    const char *name = "temperature";
+    double val = 23.125;
+
+    if (batches <= 0 || batches > (int)(sizeof(m_lat) / sizeof(m_lat[0]))) {
+        batches = 200;
+    }
+    if (glog4c_config("/dev/null", GLOG4C_DROP) != 0) {
+        fprintf(stderr, "open /dev/null failed\n");
+        return EXIT_FAILURE;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_INFO);
+    glog4c_start();
+    printf("%d batches of %d calls, ns per call (target %d ns)\n", batches, BENCH_BATCH, BENCH_TARGET);
+    printf("%-22s %8s %8s\n", "case", "p50", "p99");
+
+    // 运行时关闭的级别只比较一次
+    for (int b = 0; b < batches; ++b) {
+        uint64_t start = bench_now();
+        for (int k = 0; k < BENCH_BATCH; ++k) {
+            if (m_level <= glog4c_levels[GLOG4C_MODULE]) {
+                glog4c_write(m_level, __FILE__, __LINE__, "off %d %s %f", k, name, val);
+            }
+        }
+        m_lat[b] = bench_now() - start;
+    }
+    bench_report("disabled level", batches, 1);
+
+    for (int b = 0; b < batches; ++b) {
+        uint64_t start = bench_now();
+        for (int k = 0; k < BENCH_BATCH; ++k) {
+            glog4c_info("port=%d len=%u seq=%d\n", b, (unsigned)k, k * 3);
+        }
+        m_lat[b] = bench_now() - start;
+        usleep(BENCH_WAIT);
+    }
+    bench_report("glog4c 3 ints", batches, 1);
+
+    for (int b = 0; b < batches; ++b) {
+        uint64_t start = bench_now();
+        for (int k = 0; k < BENCH_BATCH; ++k) {
+            glog4c_info("obj=%u %s=%.3f at %p\n", (unsigned)b, name, val + k, (void *)line);
+        }
+        m_lat[b] = bench_now() - start;
+        usleep(BENCH_WAIT);
+    }
+    bench_report("glog4c str+double+ptr", batches, 1);
+
+    // 同步格式化的参考
+    for (int b = 0; b < batches; ++b) {
+        uint64_t start = bench_now();
+        for (int k = 0; k < BENCH_BATCH; ++k) {
+            snprintf(line, sizeof(line), "obj=%u %s=%.3f at %p\n", (unsigned)b, name, val + k, (void *)line);
+            bench_keep((uint64_t)line[0]);
+        }
+        m_lat[b] = bench_now() - start;
+    }
+    bench_report("snprintf same format", batches, 0);
+
+    // 后台线程吞吐量，调用线程等待缓冲区空间，不丢弃
+    glog4c_config(NULL, GLOG4C_BLOCK);
+    uint64_t start = bench_now();
+    for (int k = 0; k < BENCH_BURST; ++k) {
+        glog4c_info("obj=%u %s=%.3f at %p\n", (unsigned)k, name, val + k, (void *)line);
+    }
+    glog4c_stop();
+    double secs = (bench_now() - start) / 1e9;
+    printf("block burst: %d records in %.3f s, %.0f records/s\n", BENCH_BURST, secs, BENCH_BURST / secs);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_index.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :测点索引与折半查找的比较.对5~4096个测点的对象，分别用连续编号和在
+//                 0~0x0FFF中稀疏分布的编号，随机查找已有的测点，比较dbmem_get_value(按
+//                 对象建立的直接映射表或Eytzinger表)与原来的折半查找每次查找的耗时
+// Interface      :bench_index [查找次数]
+// Others         :折半查找在同样按编号排序的dbvar数组上进行，与dbmem_binary_search相同；
+//                 dbmem_get_value的时间还包含一次对象目录查找.开始前检查两种查找对
+//                 0~0x0FFF的每个编号结果一致
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_OBJ    30
+#define BENCH_MAXPID 0x0FFF
+
+static dbvar    m_vars[BENCH_MAXPID + 1];  // 折半查找使用的有序测点数组
+static uint16_t m_ids[BENCH_MAXPID + 1];
+static uint16_t *m_order;
+
+static uint32_t m_rand = 1234567U;
+static uint32_t bench_rand(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+// 与dbmem_binary_search相同的折半查找
+static dbvar *bench_bsearch(int num, uint16_t id)
+{
+    uint16_t head = 0, end = (uint16_t)num, idx = 0;
+
+    while (head < end) {
+        idx = (head + end) >> 1;
+        if (id > m_vars[idx].id) {
+            head = idx + 1;
+        } else if (id < m_vars[idx].id) {
+            end  = idx;
+        } else {
+            return &m_vars[idx];
+        }
+    }
+    return NULL;
+}
+
+static void bench_case(const char *name, int num, int sparse, int lookups)
+{
+    // 稀疏编号从0~0x0FFF中随机选取num个，连续编号为0~num-1
+    for (int idx = 0; idx <= BENCH_MAXPID; ++idx) {
+        m_ids[idx] = (uint16_t)idx;
+    }
+    for (int idx = BENCH_MAXPID; idx > 0 && sparse; --idx) {
+        int pick = (int)(bench_rand() % (uint32_t)(idx + 1));
+        uint16_t tmp = m_ids[idx];
+        m_ids[idx]  = m_ids[pick];
+        m_ids[pick] = tmp;
+    }
+    if (dbmem_create_obj(BENCH_OBJ, "index", num) < 0 || dbmem_init_values(BENCH_OBJ, m_ids, (uint16_t)num) < 0) {
+        fprintf(stderr, "create object with %d points failed\n", num);
+        exit(EXIT_FAILURE);
+    }
+    // 折半查找的数组按编号排序，测点编号与数据库中一致
+    int cnt = 0;
+    for (int id = 0; id <= BENCH_MAXPID; ++id) {
+        dbvar *var = dbmem_get_value(BENCH_OBJ, (uint16_t)id);
+        if (NULL != var) {
+            memset(&m_vars[cnt], 0, sizeof(dbvar));
+            m_vars[cnt++].id = (uint32_t)id;
+        }
+    }
+    for (int id = 0; id <= BENCH_MAXPID; ++id) {
+        dbvar *var = dbmem_get_value(BENCH_OBJ, (uint16_t)id);
+        dbvar *ref = bench_bsearch(cnt, (uint16_t)id);
+        if ((NULL == var) != (NULL == ref) || (NULL != var && var->id != ref->id)) {
+            fprintf(stderr, "%s %d: index and binary search differ at id %d\n", name, num, id);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int idx = 0; idx < lookups; ++idx) {
+        m_order[idx] = m_vars[bench_rand() % (uint32_t)cnt].id;
+    }
+    uint64_t sum = 0;
+    uint64_t start = bench_now();
+    for (int idx = 0; idx < lookups; ++idx) {
+        sum += (uintptr_t)bench_bsearch(cnt, m_order[idx]);
+    }
+    double bs = (double)(bench_now() - start) / lookups;
+    start = bench_now();
+    for (int idx = 0; idx < lookups; ++idx) {
+        sum += (uintptr_t)dbmem_get_value(BENCH_OBJ, m_order[idx]);
+    }
+    double ix = (double)(bench_now() - start) / lookups;
+    bench_keep(sum);
+    printf("%-7s %6d %12.1f %10.1f %8.1fx\n", name, num, bs, ix, bs / ix);
+    dbmem_close();
+}
+
+int main(int argc, char **argv)
+{
+    int lookups = (argc > 1) ? atoi(argv[1]) : 4000000;
+    static const int sizes[] = {5, 16, 64, 256, 1024, 4096};
+
+    if (lookups <= 0) {
+        lookups = 4000000;
+    }
+    m_order = (uint16_t *)malloc(sizeof(uint16_t) * lookups);
+    if (NULL == m_order) {
+        return EXIT_FAILURE;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    printf("%-7s %6s %12s %10s %9s\n", "ids", "points", "bsearch ns", "index ns", "speedup");
+    for (size_t idx = 0; idx < sizeof(sizes) / sizeof(sizes[0]); ++idx) {
+        bench_case("dense", sizes[idx], 0, lookups);
+    }
+    // 编号空间只有4096个，稀疏对象最多取一半
+    for (size_t idx = 0; idx < sizeof(sizes) / sizeof(sizes[0]) && sizes[idx] <= 2048; ++idx) {
+        bench_case("sparse", sizes[idx], 1, lookups);
+    }
+    free(m_order);
+    return EXIT_SUCCESS;
+}
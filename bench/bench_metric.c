@@ -0,0 +1,239 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_metric.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :运行统计对吞吐量的影响.与主程序处理应用消息的过程相同，从应用队列读取一帧
+//                 SET消息，解码后写入数据库，再读回一个测点.统计关闭和打开(metric_init/
+//                 metric_exit)交替运行多次，每种条目数量各取最快的一次(排除其它进程的干扰)，
+//                 输出每秒处理的帧数和统计打开后的下降比例，经过队列的下降超过2%时返回失败.
+//                 同时输出不经过队列、只有解码和数据库操作时的比例，作为开销的上限参考
+// Interface      :bench_metric [每次运行的帧数]
+// Others         :统计打开时导出到共享内存，后台线程按1秒的周期发布
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "glog4c.h"
+#include "metric.h"
+#include "bench.h"
+
+#define BENCH_OBJ    90
+#define BENCH_POINTS 1024
+#define BENCH_FRAMES 16   // 预先编码的帧数，轮流使用，保证每次写入都有变化
+#define BENCH_REPEAT 41
+#define BENCH_LIMIT  2.0  // 允许的下降比例(%)
+
+static uint8_t     m_frames[BENCH_FRAMES][8192];
+static size_t      m_lens[BENCH_FRAMES];
+static codec_item  m_items[BENCH_POINTS];
+static uint16_t    m_ids[BENCH_POINTS];
+static uint8_t     m_types[BENCH_POINTS];
+static const void *m_values[BENCH_POINTS];
+static uint32_t    m_sizes[BENCH_POINTS];
+static char        m_shm[64];
+static bench_rx    m_rx;
+static mqd_t       m_app; // 应用侧写入句柄
+
+// 统计关闭时的运行放在另外一个线程中.metric_exit之后已经取得统计数据的线程仍然记录，
+// 这个线程只在统计关闭时运行，始终没有统计数据，与从未启动统计的进程相同
+static sem_t       m_go, m_done;
+static int         m_off_frames, m_off_queue;
+static uint64_t    m_off_used;
+
+// 每帧count个测点，起始编号按帧错开
+static void bench_encode(int count)
+{
+    codec_writer wr;
+
+    for (int frame = 0; frame < BENCH_FRAMES; ++frame) {
+        codec_begin(&wr, m_frames[frame], sizeof(m_frames[frame]), CODEC_CMD_SET, DB_UINT32, BENCH_OBJ);
+        for (int idx = 0; idx < count; ++idx) {
+            uint32_t val = (uint32_t)(frame * 1000003 + idx);
+            codec_put(&wr, (uint16_t)(1 + (frame * 37 + idx * 3) % BENCH_POINTS), &val, 0);
+        }
+        m_lens[frame] = codec_end(&wr);
+    }
+}
+
+// 解码一帧后写入数据库并读回一个测点，与main_dispatch处理SET消息的过程相同
+static uint64_t bench_dispatch(const void *buf, size_t len)
+{
+    codec_head head;
+    dbvar var;
+    uint64_t sum = 0;
+
+    uint64_t start = metric_begin(METRIC_H_DECODE);
+    int count = codec_decode(buf, len, &head, m_items, BENCH_POINTS);
+    metric_end(METRIC_H_DECODE, start);
+    for (int idx = 0; idx < count; ++idx) {
+        m_ids[idx]    = m_items[idx].id;
+        m_types[idx]  = head.type;
+        m_values[idx] = m_items[idx].value;
+        m_sizes[idx]  = m_items[idx].len;
+    }
+    sum += (uint64_t)dbmem_set_values(head.obj_id, m_ids, m_types, m_values, m_sizes, count);
+    if (count > 0 && OBJSYS_RET_OK == dbmem_read_value(head.obj_id, m_ids[0], &var)) {
+        sum += var.u32;
+    }
+    return sum;
+}
+
+// 处理frames帧，返回耗时(ns).queue为0时直接处理内存中的帧；为1时应用侧先把队列写满(不计时)，
+// 再与main_drain_app一样从应用队列读空
+static uint64_t bench_run(int frames, int queue)
+{
+    uint64_t sum = 0, used = 0;
+    int round = 0;
+
+    if (!queue) {
+        uint64_t begin = bench_now();
+        for (; round < frames; ++round) {
+            int frame = round & (BENCH_FRAMES - 1);
+            sum += bench_dispatch(m_frames[frame], m_lens[frame]);
+        }
+        used = bench_now() - begin;
+    }
+    while (round < frames) {
+        int sent = 0;
+        while (round + sent < frames) {
+            int frame = (round + sent) & (BENCH_FRAMES - 1);
+            if (mq_send(m_app, (const char *)m_frames[frame], m_lens[frame], 0) < 0) {
+                break;
+            }
+            ++sent;
+        }
+        uint64_t begin = bench_now();
+        int count = 0;
+        uint64_t bytes = 0;
+        for (;;) {
+            int qsize = appq_recv(m_rx.buf, m_rx.size);
+            if (qsize < 0) {
+                metric_add(METRIC_MQ_EAGAIN, APPQ_ER_AGAIN == qsize);
+                break;
+            }
+            ++count;
+            bytes += (uint64_t)qsize;
+            sum += bench_dispatch(m_rx.buf, (size_t)qsize);
+        }
+        metric_add(METRIC_MQ_MSGS, (uint64_t)count);
+        metric_add(METRIC_MQ_BYTES, bytes);
+        used += bench_now() - begin;
+        if (count != sent) {
+            fprintf(stderr, "queue lost frames\n");
+            exit(EXIT_FAILURE);
+        }
+        round += sent;
+    }
+    bench_keep(sum);
+    return used;
+}
+
+static void *bench_off_thread(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        sem_wait(&m_go);
+        if (m_off_frames <= 0) {
+            return NULL;
+        }
+        m_off_used = bench_run(m_off_frames, m_off_queue);
+        sem_post(&m_done);
+    }
+}
+
+static uint64_t bench_run_off(int frames, int queue)
+{
+    m_off_frames = frames;
+    m_off_queue  = queue;
+    sem_post(&m_go);
+    sem_wait(&m_done);
+    return m_off_used;
+}
+
+static double bench_case(const char *mode, int count, int frames)
+{
+    uint64_t off[BENCH_REPEAT], on[BENCH_REPEAT];
+    int queue = (0 == strcmp(mode, "queue"));
+
+    bench_encode(count);
+    bench_run_off(frames / 4, queue); // 预热
+    for (int rep = 0; rep < BENCH_REPEAT; ++rep) {
+        off[rep] = bench_run_off(frames, queue);
+        if (metric_init(m_shm, NULL, 1000) != METRIC_OK) {
+            fprintf(stderr, "metric_init failed\n");
+            exit(EXIT_FAILURE);
+        }
+        on[rep] = bench_run(frames, queue);
+        metric_exit();
+    }
+    double fps_off = frames / (bench_pct(off, BENCH_REPEAT, 0) / 1e9);
+    double fps_on  = frames / (bench_pct(on, BENCH_REPEAT, 0) / 1e9);
+    double loss    = (fps_off - fps_on) * 100.0 / fps_off;
+    printf("%-6s %6d %14.0f %14.0f %9.2f%%\n", mode, count, fps_off, fps_on, loss);
+    return loss;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : 50000;
+    static const int counts[] = {1, 16, 64, 256};
+    uint16_t ids[BENCH_POINTS];
+    char a2q[64];
+    pthread_t off;
+    double worst = -100.0;
+
+    if (frames <= 0) {
+        frames = 50000;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    snprintf(m_shm, sizeof(m_shm), "/bench_metric_%d", (int)getpid());
+    snprintf(a2q, sizeof(a2q), "/bench_metric_a2q_%d", (int)getpid());
+    if (bench_appq_open(&m_rx, "metric") < 0) {
+        fprintf(stderr, "open app queue failed\n");
+        return EXIT_FAILURE;
+    }
+    m_app = mq_open(a2q, O_WRONLY | O_NONBLOCK);
+    if (m_app == (mqd_t)-1) {
+        bench_appq_close(&m_rx);
+        return EXIT_FAILURE;
+    }
+    for (int idx = 0; idx < BENCH_POINTS; ++idx) {
+        ids[idx] = (uint16_t)(1 + idx);
+    }
+    if (dbmem_create_obj(BENCH_OBJ, "metric", BENCH_POINTS) < 0
+        || dbmem_init_values(BENCH_OBJ, ids, BENCH_POINTS) < 0) {
+        return EXIT_FAILURE;
+    }
+    sem_init(&m_go, 0, 0);
+    sem_init(&m_done, 0, 0);
+    if (pthread_create(&off, NULL, bench_off_thread, NULL) != 0) {
+        return EXIT_FAILURE;
+    }
+    printf("%d frames per run, best of %d alternating off/on runs\n", frames, BENCH_REPEAT);
+    printf("mem: decode and database only (no I/O, upper bound of the overhead)\n");
+    printf("queue: received from the app queue like main_drain_app, this is the throughput limit\n");
+    printf("%-6s %6s %14s %14s %10s\n", "mode", "items", "frames/s off", "frames/s on", "loss");
+    for (size_t idx = 0; idx < sizeof(counts) / sizeof(counts[0]); ++idx) {
+        bench_case("mem", counts[idx], counts[idx] >= 64 ? frames / 8 : frames);
+    }
+    for (size_t idx = 0; idx < sizeof(counts) / sizeof(counts[0]); ++idx) {
+        double loss = bench_case("queue", counts[idx], counts[idx] >= 64 ? frames / 8 : frames);
+        worst = loss > worst ? loss : worst;
+    }
+    m_off_frames = 0;
+    sem_post(&m_go);
+    pthread_join(off, NULL);
+    mq_close(m_app);
+    bench_appq_close(&m_rx);
+    dbmem_close();
+    printf("worst queue loss %.2f%% (limit %.1f%%): %s\n", worst, BENCH_LIMIT, worst < BENCH_LIMIT ? "PASS" : "FAIL");
+    return worst < BENCH_LIMIT ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,116 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_objdir.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :对象目录的性能.分别用连续编号和随机稀疏编号建立10000个对象，统计每个
+//                 对象的建立时间、按编号读取测点的时间(命中和未命中)以及遍历所有对象一次
+//                 的时间
+// Interface      :bench_objdir [对象数量]
+// Others         :每个对象4个测点，读取时间包含对象查找和测点查找
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_LOOKUPS 1000000
+#define BENCH_PASSES  100
+
+static uint16_t m_ids[65536];
+static uint16_t m_order[BENCH_LOOKUPS];
+
+// xorshift随机数，结果可重复
+static uint32_t m_rand = 2463534242U;
+static uint32_t bench_rand(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+static void bench_case(const char *name, int num, int sparse)
+{
+    uint16_t pts[4] = {1, 2, 3, 4};
+    dbvar var;
+    char oname[16];
+
+    // 连续编号为0~num-1；稀疏编号在整个16位空间中随机取不重复的值，对象分散到大部分目录页.
+    // 前num个是建立的对象，其余的用于未命中查找
+    for (int idx = 0; idx < 65536; ++idx) {
+        m_ids[idx] = (uint16_t)idx;
+    }
+    for (int idx = 65535; idx > 0 && sparse; --idx) {
+        int pick = (int)(bench_rand() % (uint32_t)(idx + 1));
+        uint16_t tmp = m_ids[idx];
+        m_ids[idx]  = m_ids[pick];
+        m_ids[pick] = tmp;
+    }
+
+    uint64_t start = bench_now();
+    for (int idx = 0; idx < num; ++idx) {
+        snprintf(oname, sizeof(oname), "o%u", m_ids[idx]);
+        if (dbmem_create_obj(m_ids[idx], oname, 4) < 0 || dbmem_init_values(m_ids[idx], pts, 4) < 0) {
+            fprintf(stderr, "create object %u failed\n", m_ids[idx]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    double create = (double)(bench_now() - start) / num;
+
+    for (int idx = 0; idx < BENCH_LOOKUPS; ++idx) {
+        m_order[idx] = m_ids[bench_rand() % (uint32_t)num];
+    }
+    uint64_t sum = 0;
+    start = bench_now();
+    for (int idx = 0; idx < BENCH_LOOKUPS; ++idx) {
+        sum += dbmem_read_value(m_order[idx], 2, &var);
+    }
+    double hit = (double)(bench_now() - start) / BENCH_LOOKUPS;
+
+    // 未建立的编号
+    for (int idx = 0; idx < BENCH_LOOKUPS; ++idx) {
+        m_order[idx] = m_ids[num + bench_rand() % (uint32_t)(65536 - num)];
+    }
+    start = bench_now();
+    for (int idx = 0; idx < BENCH_LOOKUPS; ++idx) {
+        sum += dbmem_read_value(m_order[idx], 2, &var);
+    }
+    double miss = (double)(bench_now() - start) / BENCH_LOOKUPS;
+
+    int seen = 0;
+    start = bench_now();
+    for (int pass = 0; pass < BENCH_PASSES; ++pass) {
+        for (int id = dbmem_next_obj(-1); id >= 0; id = dbmem_next_obj(id)) {
+            ++seen;
+        }
+    }
+    double iter = (double)(bench_now() - start) / BENCH_PASSES;
+    bench_keep(sum);
+    if (seen != num * BENCH_PASSES || dbmem_obj_count() != (uint32_t)num) {
+        fprintf(stderr, "iterate saw %d objects, expect %d\n", seen / BENCH_PASSES, num);
+        exit(EXIT_FAILURE);
+    }
+    printf("%-7s %7d %12.1f %10.1f %10.1f %12.1f\n", name, num, create, hit, miss, iter / 1e3);
+    dbmem_close();
+}
+
+int main(int argc, char **argv)
+{
+    int num = (argc > 1) ? atoi(argv[1]) : 10000;
+
+    if (num <= 0 || num > 60000) {
+        num = 10000;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    printf("%-7s %7s %12s %10s %10s %12s\n", "ids", "objects", "create ns", "hit ns", "miss ns", "iterate us");
+    bench_case("dense", num, 0);
+    bench_case("sparse", num, 1);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_reactor.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :通信线程数量从1增加到N时的吞吐量.若干写线程向一组socketpair写数据，
+//                 另一端注册到通信线程，回调读到EAGAIN并对数据做一次校验计算，统计
+//                 每秒处理的字节数和回调次数
+// Interface      :bench_reactor [秒数]
+// Others         :每个线程数量在单独的子进程中测量，CPU数量少于线程数量时吞吐量不会增加
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "asyncomm.h"
+#include "appq.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_CHANNELS 64  // socketpair数量
+#define BENCH_WRITERS  4   // 写线程数量
+#define BENCH_CHUNK    512 // 每次写入的字节数
+
+typedef struct {
+    int      fd[2];
+    uint64_t bytes;  // 读到的字节数
+    uint64_t calls;  // 回调次数
+    uint32_t sum;    // 校验值，模拟解析数据的计算量
+}bench_chn;
+
+static bench_chn m_chn[BENCH_CHANNELS];
+static volatile int m_stop;
+
+static int bench_on_read(int fd, uint32_t events, void *arg)
+{
+    bench_chn *chn = (bench_chn*)arg;
+    char buf[4096];
+
+    (void)events;
+    for (;;) {
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) {
+            break;
+        }
+        uint32_t sum = chn->sum;
+        for (ssize_t idx = 0; idx < len; ++idx) {
+            sum = (sum ^ (uint8_t)buf[idx]) * 16777619U;
+        }
+        chn->sum = sum;
+        __atomic_add_fetch(&chn->bytes, (uint64_t)len, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&chn->calls, 1, __ATOMIC_RELAXED);
+    return ASY_OK;
+}
+
+static void *bench_writer(void *arg)
+{
+    int  first = (int)(intptr_t)arg;
+    char buf[BENCH_CHUNK];
+
+    memset(buf, 0x5A, sizeof(buf));
+    while (!m_stop) {
+        int busy = 0;
+        for (int idx = first; idx < BENCH_CHANNELS; idx += BENCH_WRITERS) {
+            if (write(m_chn[idx].fd[1], buf, sizeof(buf)) > 0) {
+                busy = 1;
+            }
+        }
+        if (!busy) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// 在子进程中按nthread个通信线程测量，结果通过管道返回
+static int bench_run(int nthread, int secs, double *mbps, double *calls)
+{
+    char a2q[64], q2a[64];
+
+    snprintf(a2q, sizeof(a2q), "/bench_rt_a2q_%d", (int)getpid());
+    snprintf(q2a, sizeof(q2a), "/bench_rt_q2a_%d", (int)getpid());
+    if (appq_open(APPQ_MQUEUE, a2q, q2a, 0) != APPQ_OK) {
+        return -1;
+    }
+    if (asyncomm_init(nthread, 0) < 0) {
+        appq_close();
+        return -1;
+    }
+    for (int idx = 0; idx < BENCH_CHANNELS; ++idx) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, m_chn[idx].fd) < 0) {
+            return -1;
+        }
+        fcntl(m_chn[idx].fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(m_chn[idx].fd[1], F_SETFL, O_NONBLOCK);
+        if (asyncomm_register(m_chn[idx].fd[0], bench_on_read, &m_chn[idx]) < 0) {
+            return -1;
+        }
+    }
+    pthread_t writer[BENCH_WRITERS];
+    for (int idx = 0; idx < BENCH_WRITERS; ++idx) {
+        pthread_create(&writer[idx], NULL, bench_writer, (void*)(intptr_t)idx);
+    }
+    // 预热后再开始统计
+    usleep(200000);
+    uint64_t bytes0 = 0, calls0 = 0;
+    for (int idx = 0; idx < BENCH_CHANNELS; ++idx) {
+        bytes0 += __atomic_load_n(&m_chn[idx].bytes, __ATOMIC_RELAXED);
+        calls0 += __atomic_load_n(&m_chn[idx].calls, __ATOMIC_RELAXED);
+    }
+    uint64_t start = bench_now();
+    sleep(secs);
+    uint64_t bytes1 = 0, calls1 = 0;
+    for (int idx = 0; idx < BENCH_CHANNELS; ++idx) {
+        bytes1 += __atomic_load_n(&m_chn[idx].bytes, __ATOMIC_RELAXED);
+        calls1 += __atomic_load_n(&m_chn[idx].calls, __ATOMIC_RELAXED);
+    }
+    double elapsed = (bench_now() - start) / 1e9;
+
+    m_stop = 1;
+    for (int idx = 0; idx < BENCH_WRITERS; ++idx) {
+        pthread_join(writer[idx], NULL);
+    }
+    asyncomm_exit();
+    for (int idx = 0; idx < BENCH_CHANNELS; ++idx) {
+        close(m_chn[idx].fd[0]);
+        close(m_chn[idx].fd[1]);
+    }
+    appq_close();
+    *mbps  = (bytes1 - bytes0) / elapsed / 1e6;
+    *calls = (calls1 - calls0) / elapsed;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int secs = (argc > 1) ? atoi(argv[1]) : 1;
+    int nthreads[] = {1, 2, 4};
+    double base = 0;
+
+    if (secs <= 0) {
+        secs = 1;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    printf("reactor scaling: %d channels, %d writers, %d B writes, %ld CPUs online\n",
+        BENCH_CHANNELS, BENCH_WRITERS, BENCH_CHUNK, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%8s %12s %14s %9s\n", "reactors", "MB/s", "callbacks/s", "speedup");
+    for (size_t idx = 0; idx < sizeof(nthreads) / sizeof(nthreads[0]); ++idx) {
+        int pfd[2];
+        double res[2] = {0, 0};
+
+        if (pipe(pfd) < 0) {
+            return EXIT_FAILURE;
+        }
+        fflush(stdout);
+        pid_t pid = fork();
+        if (0 == pid) {
+            close(pfd[0]);
+            if (bench_run(nthreads[idx], secs, &res[0], &res[1]) < 0) {
+                _exit(EXIT_FAILURE);
+            }
+            if (write(pfd[1], res, sizeof(res)) != sizeof(res)) {
+                _exit(EXIT_FAILURE);
+            }
+            _exit(EXIT_SUCCESS);
+        }
+        close(pfd[1]);
+        int status = 0;
+        ssize_t len = read(pfd[0], res, sizeof(res));
+        close(pfd[0]);
+        waitpid(pid, &status, 0);
+        if (len != sizeof(res) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "run with %d reactors failed\n", nthreads[idx]);
+            return EXIT_FAILURE;
+        }
+        if (0 == idx) {
+            base = res[0];
+        }
+        printf("%8d %12.1f %14.0f %8.2fx\n", nthreads[idx], res[0], res[1], res[0] / base);
+    }
+    return EXIT_SUCCESS;
+}
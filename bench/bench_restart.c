@@ -0,0 +1,234 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_restart.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :冷启动和热启动的比较.100000个测点(25个对象，每个4000点，其中十分之一为
+//                 字符串)，冷启动是建立对象后把所有测点重新写入一遍的时间，这是重新采集能达到
+//                 的下限，实际还要加上轮询设备的时间；热启动是建立对象后从快照恢复的时间，
+//                 以及快照之后还有10000个变化记录在日志中时恢复的时间.同时输出生成快照的时间
+//                 和文件尺寸
+// Interface      :bench_restart [数据目录]
+// Others         :默认在/tmp下建立临时目录，结束时删除.每项取5次的中位数，文件已经在页缓存中
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "db_in_mem.h"
+#include "dbsnap.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_OBJS    25
+#define BENCH_PER_OBJ 4000
+#define BENCH_CHANGES 10000
+#define BENCH_REPEAT  5
+#define BENCH_JNL_MS  50
+
+static char     m_dir[256];
+static uint16_t m_ids[BENCH_PER_OBJ];
+static uint8_t  m_types[BENCH_PER_OBJ];
+static const void *m_values[BENCH_PER_OBJ];
+static uint32_t m_sizes[BENCH_PER_OBJ];
+static uint32_t m_u32[BENCH_PER_OBJ];
+static char     m_str[] = "device status text 0123456789";
+
+static void bench_create(void)
+{
+    for (int obj = 1; obj <= BENCH_OBJS; ++obj) {
+        if (dbmem_create_obj(obj, "restart", BENCH_PER_OBJ) < 0
+            || dbmem_init_values(obj, m_ids, BENCH_PER_OBJ) < 0) {
+            fprintf(stderr, "create object %d failed\n", obj);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// 写入所有测点，seed不同时数值不同
+static void bench_fill(uint32_t seed)
+{
+    for (int obj = 1; obj <= BENCH_OBJS; ++obj) {
+        for (int idx = 0; idx < BENCH_PER_OBJ; ++idx) {
+            m_u32[idx] = seed + obj * BENCH_PER_OBJ + idx;
+        }
+        dbmem_set_values(obj, m_ids, m_types, m_values, m_sizes, BENCH_PER_OBJ);
+    }
+}
+
+// 所有测点都有值时返回1
+static int bench_verify(void)
+{
+    dbvar var;
+
+    for (int obj = 1; obj <= BENCH_OBJS; ++obj) {
+        for (int idx = 0; idx < BENCH_PER_OBJ; idx += 97) {
+            if (dbmem_read_value(obj, m_ids[idx], &var) != OBJSYS_RET_OK || var.type != m_types[idx]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void bench_clear(void)
+{
+    struct dirent *ent;
+    char path[512];
+    DIR *dir = opendir(m_dir);
+
+    while (NULL != dir && NULL != (ent = readdir(dir))) {
+        if ('.' != ent->d_name[0]) {
+            snprintf(path, sizeof(path), "%s/%s", m_dir, ent->d_name);
+            unlink(path);
+        }
+    }
+    if (NULL != dir) {
+        closedir(dir);
+    }
+}
+
+static uint64_t bench_median(uint64_t *val)
+{
+    return bench_pct(val, BENCH_REPEAT, 50);
+}
+
+// 冷启动:建立对象后重新写入所有测点
+static uint64_t bench_cold(void)
+{
+    uint64_t start = bench_now();
+    bench_create();
+    bench_fill(1);
+    uint64_t used = bench_now() - start;
+    dbmem_close();
+    return used;
+}
+
+// 热启动:建立对象后从数据目录恢复
+static uint64_t bench_warm(int *restored)
+{
+    uint64_t start = bench_now();
+    bench_create();
+    dbsnap_init(m_dir, BENCH_JNL_MS, 3600);
+    *restored = dbsnap_load();
+    uint64_t used = bench_now() - start;
+    if (!bench_verify()) {
+        fprintf(stderr, "restore is incomplete\n");
+        exit(EXIT_FAILURE);
+    }
+    dbmem_close();
+    return used;
+}
+
+// 子进程:快照之后在数值测点上写入BENCH_CHANGES个变化，日志写完后直接退出，不生成最后的快照
+static void bench_crash(void)
+{
+    bench_create();
+    dbsnap_init(m_dir, BENCH_JNL_MS, 3600);
+    dbsnap_load();
+    dbsnap_start();
+    usleep(BENCH_JNL_MS * 4000);
+    for (int idx = 0; idx < BENCH_CHANGES; ++idx) {
+        uint32_t val = idx;
+        dbmem_set_value(1 + idx % BENCH_OBJS, m_ids[((idx * 7) % BENCH_PER_OBJ) | 1], DB_UINT32, &val, 0);
+    }
+    usleep(BENCH_JNL_MS * 4000);
+    _exit(EXIT_SUCCESS);
+}
+
+static off_t bench_dir_size(const char *prefix)
+{
+    struct dirent *ent;
+    struct stat st;
+    char path[512];
+    off_t size = 0;
+    DIR *dir = opendir(m_dir);
+
+    while (NULL != dir && NULL != (ent = readdir(dir))) {
+        snprintf(path, sizeof(path), "%s/%s", m_dir, ent->d_name);
+        if (0 == strncmp(ent->d_name, prefix, strlen(prefix)) && 0 == stat(path, &st)) {
+            size += st.st_size;
+        }
+    }
+    if (NULL != dir) {
+        closedir(dir);
+    }
+    return size;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t cold[BENCH_REPEAT], warm[BENCH_REPEAT], save[BENCH_REPEAT];
+    int restored = 0, status;
+    int own = (argc <= 1);
+
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    if (own) {
+        snprintf(m_dir, sizeof(m_dir), "/tmp/bench_restart_XXXXXX");
+        if (NULL == mkdtemp(m_dir)) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        snprintf(m_dir, sizeof(m_dir), "%s", argv[1]);
+    }
+    for (int idx = 0; idx < BENCH_PER_OBJ; ++idx) {
+        m_ids[idx]    = (uint16_t)idx;
+        m_types[idx]  = (0 == idx % 10) ? DB_STRING : DB_UINT32;
+        m_values[idx] = (DB_STRING == m_types[idx]) ? (const void *)m_str : (const void *)&m_u32[idx];
+        m_sizes[idx]  = (DB_STRING == m_types[idx]) ? (uint32_t)strlen(m_str) : 0;
+    }
+    bench_clear();
+
+    for (int rep = 0; rep < BENCH_REPEAT; ++rep) {
+        cold[rep] = bench_cold();
+    }
+    // 生成快照
+    for (int rep = 0; rep < BENCH_REPEAT; ++rep) {
+        bench_create();
+        bench_fill(rep);
+        dbsnap_init(m_dir, BENCH_JNL_MS, 3600);
+        uint64_t start = bench_now();
+        dbsnap_save();
+        save[rep] = bench_now() - start;
+        dbmem_close();
+    }
+    for (int rep = 0; rep < BENCH_REPEAT; ++rep) {
+        warm[rep] = bench_warm(&restored);
+    }
+    int points = BENCH_OBJS * BENCH_PER_OBJ;
+    printf("%d points in %d objects, %d%% strings\n", points, BENCH_OBJS, 10);
+    printf("snapshot save %8.2f ms, %lld bytes\n", bench_median(save) / 1e6, (long long)bench_dir_size("db.snap"));
+    printf("cold restart starts empty: the time below only covers writing every point once, "
+        "polling the devices comes on top\n");
+    printf("%-22s %10s %12s %10s\n", "restart", "ms", "points/s", "restored");
+    printf("%-22s %10.2f %12.0f %10d\n", "cold (rewrite all)", bench_median(cold) / 1e6,
+        points / (bench_median(cold) / 1e9), points);
+    printf("%-22s %10.2f %12.0f %10d\n", "warm (snapshot)", bench_median(warm) / 1e6,
+        points / (bench_median(warm) / 1e9), restored);
+
+    // 快照之后还有日志
+    pid_t pid = fork();
+    if (0 == pid) {
+        bench_crash();
+    }
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return EXIT_FAILURE;
+    }
+    for (int rep = 0; rep < BENCH_REPEAT; ++rep) {
+        warm[rep] = bench_warm(&restored);
+    }
+    printf("%-22s %10.2f %12.0f %10d  (journal %lld bytes)\n", "warm (snap + journal)", bench_median(warm) / 1e6,
+        points / (bench_median(warm) / 1e9), restored, (long long)bench_dir_size("db.jnl"));
+
+    bench_clear();
+    if (own) {
+        rmdir(m_dir);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_strpool.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :字符串测点写入的内存申请次数和延迟.在256个测点上按随机长度反复写入字符串，
+//                 输出每次写入的malloc次数、平均耗时和p99耗时.参考行是内存池之前每次写入
+//                 额外付出的malloc新缓冲区、拷贝、free旧缓冲区的开销，不含数据库的其他部分
+// Interface      :bench_strpool [写入次数]
+// Others         :在程序中替换malloc统计申请次数，只适用于glibc.延迟每16次写入采样一次
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_POINTS 256
+#define BENCH_SAMPLE 16
+#define BENCH_OBJ    20
+
+extern void *__libc_malloc(size_t size);
+
+static uint64_t m_mallocs;
+
+// 统计进程中所有的malloc调用
+void *malloc(size_t size)
+{
+    __atomic_add_fetch(&m_mallocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+static uint32_t m_rand = 88172645U;
+static uint32_t bench_rand(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+static char     m_data[4096];
+static uint16_t m_len[1 << 16];  // 预先生成的长度序列，两种实现使用相同的序列
+static uint64_t m_lat[(1 << 24) / BENCH_SAMPLE];
+
+// 输出一行结果
+static void bench_report(const char *name, int maxlen, int count, uint64_t total, uint64_t mallocs, size_t nlat)
+{
+    printf("%-7s %6d %12.3f %10.1f %10llu\n", name, maxlen, (double)mallocs / count,
+        (double)total / count, (unsigned long long)bench_pct(m_lat, nlat, 99));
+}
+
+// 通过内存数据库写入，report为0时只用于预热
+static void bench_db(int maxlen, int count, int report)
+{
+    size_t nlat = 0;
+
+    uint64_t mallocs = __atomic_load_n(&m_mallocs, __ATOMIC_RELAXED);
+    uint64_t start = bench_now();
+    for (int idx = 0; idx < count; ++idx) {
+        uint16_t len = m_len[idx & 0xFFFF] % maxlen + 1;
+        uint16_t id  = (uint16_t)(1 + idx % BENCH_POINTS);
+        if (0 == (idx % BENCH_SAMPLE)) {
+            uint64_t t0 = bench_now();
+            dbmem_set_value(BENCH_OBJ, id, DB_STRING, m_data, len);
+            m_lat[nlat++] = bench_now() - t0;
+        } else {
+            dbmem_set_value(BENCH_OBJ, id, DB_STRING, m_data, len);
+        }
+    }
+    uint64_t total = bench_now() - start;
+    if (!report) {
+        return;
+    }
+    bench_report("dbmem", maxlen, count, total, __atomic_load_n(&m_mallocs, __ATOMIC_RELAXED) - mallocs, nlat);
+}
+
+// 参考:每次写入申请新缓冲区，释放旧缓冲区
+static void bench_ref(int maxlen, int count)
+{
+    static char *slot[BENCH_POINTS];
+    size_t nlat = 0;
+
+    uint64_t mallocs = __atomic_load_n(&m_mallocs, __ATOMIC_RELAXED);
+    uint64_t start = bench_now();
+    for (int idx = 0; idx < count; ++idx) {
+        uint16_t len = m_len[idx & 0xFFFF] % maxlen + 1;
+        int pos = idx % BENCH_POINTS;
+        uint64_t t0 = (0 == (idx % BENCH_SAMPLE)) ? bench_now() : 0;
+        char *mem = (char *)malloc(len + 1);
+        memcpy(mem, m_data, len);
+        mem[len] = '\0';
+        char *old = __atomic_exchange_n(&slot[pos], mem, __ATOMIC_ACQ_REL);
+        free(old);
+        if (0 != t0) {
+            m_lat[nlat++] = bench_now() - t0;
+        }
+    }
+    uint64_t total = bench_now() - start;
+    bench_report("malloc", maxlen, count, total, __atomic_load_n(&m_mallocs, __ATOMIC_RELAXED) - mallocs, nlat);
+    for (int pos = 0; pos < BENCH_POINTS; ++pos) {
+        free(slot[pos]);
+        slot[pos] = NULL;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 1000000;
+    static const int maxlens[] = {7, 63, 255, 2000};
+    uint16_t ids[BENCH_POINTS];
+
+    if (count <= 0 || count > (1 << 24)) {
+        count = 1000000;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    memset(m_data, 'x', sizeof(m_data));
+    for (int idx = 0; idx < (1 << 16); ++idx) {
+        m_len[idx] = (uint16_t)bench_rand();
+    }
+    for (int idx = 0; idx < BENCH_POINTS; ++idx) {
+        ids[idx] = (uint16_t)(1 + idx);
+    }
+    printf("%d random-length string sets on %d points\n", count, BENCH_POINTS);
+    printf("dbmem: dbmem_set_value with inline/pooled storage, malloc: allocation cost it replaces\n");
+    printf("%-7s %6s %12s %10s %10s\n", "path", "maxlen", "malloc/set", "ns/set", "p99 ns");
+    for (size_t idx = 0; idx < sizeof(maxlens) / sizeof(maxlens[0]); ++idx) {
+        if (dbmem_create_obj(BENCH_OBJ, "str", BENCH_POINTS) < 0
+            || dbmem_init_values(BENCH_OBJ, ids, BENCH_POINTS) < 0) {
+            return EXIT_FAILURE;
+        }
+        // 先写一遍让内存池达到稳定状态，只统计之后的写入
+        bench_db(maxlens[idx], count / 10, 0);
+        bench_db(maxlens[idx], count, 1);
+        bench_ref(maxlens[idx], count);
+        dbmem_close();
+    }
+    return EXIT_SUCCESS;
+}
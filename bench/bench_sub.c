@@ -0,0 +1,132 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_sub.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :变化订阅的扇出延迟.对1000个测点的对象建立1~100个订阅，每个周期写入64个
+//                 随机测点后调用dbsub_flush，每个订阅者在回调中读取变化测点的值并编码成
+//                 CHANGE帧.输出从开始flush到最后一个订阅者编码完成的p50/p99延迟，以及平均
+//                 每个订阅者的耗时.full模式所有订阅都覆盖整个对象，split模式把对象均分给
+//                 各个订阅者
+// Interface      :bench_sub [周期数]
+// Others         :不包含发送到应用队列的时间
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "dbsub.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_OBJ    50
+#define BENCH_POINTS 1000
+#define BENCH_WRITES 64
+#define BENCH_MAXSUB 100
+
+typedef struct {
+    char     buf[8192];
+    uint64_t items;
+}bench_sub;
+
+static bench_sub m_subs[BENCH_MAXSUB];
+static uint64_t  m_lat[100000];
+
+static uint32_t m_rand = 362436069U;
+static uint32_t bench_rand(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+// 订阅者回调:读取变化的值并编码，与主程序推送变化的过程相同
+static void bench_notify(void *arg, uint16_t obj_id, const uint16_t *ids, int num)
+{
+    bench_sub *sub = (bench_sub *)arg;
+    codec_writer wr;
+    dbvar var;
+
+    codec_begin(&wr, sub->buf, sizeof(sub->buf), CODEC_CMD_CHANGE, DB_UINT32, obj_id);
+    for (int idx = 0; idx < num; ++idx) {
+        if (OBJSYS_RET_OK == dbmem_read_value(obj_id, ids[idx], &var)) {
+            codec_put(&wr, ids[idx], &var.u32, 0);
+        }
+    }
+    sub->items += codec_end(&wr) > 0 ? num : 0;
+}
+
+static void bench_case(const char *mode, int nsub, int cycles)
+{
+    uint64_t notified = 0;
+
+    for (int idx = 0; idx < nsub; ++idx) {
+        int lo = 1, hi = BENCH_POINTS;
+        if (0 == strcmp(mode, "split")) {
+            lo = 1 + idx * BENCH_POINTS / nsub;
+            hi = (idx + 1) * BENCH_POINTS / nsub;
+        }
+        m_subs[idx].items = 0;
+        if (dbsub_add(BENCH_OBJ, (uint16_t)lo, (uint16_t)hi, bench_notify, &m_subs[idx]) != DBSUB_OK) {
+            fprintf(stderr, "subscribe failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        for (int idx = 0; idx < BENCH_WRITES; ++idx) {
+            uint32_t val = bench_rand();
+            dbmem_set_value(BENCH_OBJ, (uint16_t)(1 + val % BENCH_POINTS), DB_UINT32, &val, 0);
+        }
+        uint64_t start = bench_now();
+        dbsub_flush();
+        m_lat[cycle] = bench_now() - start;
+    }
+    for (int idx = 0; idx < nsub; ++idx) {
+        notified += m_subs[idx].items;
+    }
+    uint64_t total = 0;
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        total += m_lat[cycle];
+    }
+    uint64_t p50 = bench_pct(m_lat, cycles, 50);
+    uint64_t p99 = bench_pct(m_lat, cycles, 99);
+    printf("%-6s %5d %10.1f %10llu %10llu %12.1f\n", mode, nsub, (double)notified / cycles,
+        (unsigned long long)p50, (unsigned long long)p99, (double)total / cycles / nsub);
+    for (int idx = 0; idx < nsub; ++idx) {
+        dbsub_del(BENCH_OBJ, 1, 0, bench_notify, &m_subs[idx]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int cycles = (argc > 1) ? atoi(argv[1]) : 20000;
+    static const int nsubs[] = {1, 2, 5, 10, 20, 50, 100};
+    uint16_t ids[BENCH_POINTS];
+
+    if (cycles <= 0 || cycles > (int)(sizeof(m_lat) / sizeof(m_lat[0]))) {
+        cycles = 20000;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    for (int idx = 0; idx < BENCH_POINTS; ++idx) {
+        ids[idx] = (uint16_t)(1 + idx);
+    }
+    if (dbmem_create_obj(BENCH_OBJ, "sub", BENCH_POINTS) < 0 || dbmem_init_values(BENCH_OBJ, ids, BENCH_POINTS) < 0) {
+        return EXIT_FAILURE;
+    }
+    printf("%d cycles, %d random writes per cycle on %d points\n", cycles, BENCH_WRITES, BENCH_POINTS);
+    printf("%-6s %5s %10s %10s %10s %12s\n", "mode", "subs", "items/cyc", "p50 ns", "p99 ns", "ns/sub");
+    for (size_t idx = 0; idx < sizeof(nsubs) / sizeof(nsubs[0]); ++idx) {
+        bench_case("full", nsubs[idx], cycles);
+    }
+    for (size_t idx = 0; idx < sizeof(nsubs) / sizeof(nsubs[0]); ++idx) {
+        bench_case("split", nsubs[idx], cycles);
+    }
+    dbsub_close();
+    dbmem_close();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,297 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_tcp.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :TCP通道在本机回环上的性能.
+//                 1.每秒建立的连接数:客户端连接服务端、发送1字节，应用队列收到新端口的
+//                   数据后以RST关闭，统计从连接到数据到达应用的完整过程
+//                 2.接收吞吐量:若干客户端向服务端连续写数据，服务端按停止读取的方式处理
+//                   积压，统计应用队列收到的字节数
+//                 3.发送吞吐量:asyncomm_open_tcpc连接到本程序的监听句柄，按不同的块尺寸
+//                   调用asyncomm_write，统计对端读到的字节数，16KiB以上的块走零拷贝路径
+// Interface      :bench_tcp [秒数]
+// Others         :回环上内核会拷贝零拷贝发送的数据，连接会自动退回普通发送
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "asyncomm.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_RX_CLIENTS 4           // 接收吞吐量测试的客户端数量
+#define BENCH_RX_CHUNK   (64 << 10)  // 客户端每次写入的字节数
+
+static bench_rx m_rx;
+static volatile int m_stop;
+static uint64_t m_bytes; // 对端或应用读到的字节数
+
+static int bench_connect(uint16_t port)
+{
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 以RST关闭，不在本机留下TIME_WAIT连接
+static void bench_reset(int fd)
+{
+    struct linger lg = {1, 0};
+
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+// 每秒建立的连接数
+static int bench_accept(uint16_t port, int secs)
+{
+    uint64_t lat[4096];
+    size_t nlat = 0;
+    uint64_t count = 0;
+
+    uint64_t start = bench_now();
+    uint64_t stop  = start + (uint64_t)secs * 1000000000ULL;
+    while (bench_now() < stop) {
+        uint64_t t0 = bench_now();
+        int fd = bench_connect(port);
+        if (fd < 0 || write(fd, "c", 1) != 1) {
+            fprintf(stderr, "connect: %s\n", strerror(errno));
+            return -1;
+        }
+        int got = 0;
+        while (!got) {
+            int num = bench_rx_frame(&m_rx, 1000);
+            if (num < 0) {
+                fprintf(stderr, "no data from accepted connection\n");
+                return -1;
+            }
+            got = (CODEC_CMD_DATA == m_rx.head.cmd && num > 0);
+        }
+        if (nlat < sizeof(lat) / sizeof(lat[0])) {
+            lat[nlat++] = bench_now() - t0;
+        }
+        bench_reset(fd);
+        ++count;
+    }
+    double elapsed = (bench_now() - start) / 1e9;
+    printf("accept: %.0f conn/s, connect->app p50 %.1f us p99 %.1f us\n", count / elapsed,
+        bench_pct(lat, nlat, 50) / 1e3, bench_pct(lat, nlat, 99) / 1e3);
+    return 0;
+}
+
+static void *bench_client(void *arg)
+{
+    int fd = (int)(intptr_t)arg;
+    char *buf = (char *)malloc(BENCH_RX_CHUNK);
+
+    memset(buf, 0x5A, BENCH_RX_CHUNK);
+    while (!m_stop) {
+        if (write(fd, buf, BENCH_RX_CHUNK) < 0) {
+            break;
+        }
+    }
+    free(buf);
+    return NULL;
+}
+
+// 应用读到的数据字节数
+static void *bench_app(void *arg)
+{
+    (void)arg;
+    while (!m_stop) {
+        int num = bench_rx_frame(&m_rx, 100);
+        if (num <= 0 || CODEC_CMD_DATA != m_rx.head.cmd) {
+            continue;
+        }
+        uint64_t bytes = 0;
+        for (int idx = 0; idx < num; ++idx) {
+            bytes += m_rx.item[idx].len;
+        }
+        __atomic_add_fetch(&m_bytes, bytes, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// 在测量窗口内统计m_bytes的增量，返回MB/s
+static double bench_window(int secs)
+{
+    usleep(200000);
+    uint64_t bytes0 = __atomic_load_n(&m_bytes, __ATOMIC_RELAXED);
+    uint64_t start = bench_now();
+    sleep(secs);
+    uint64_t bytes1 = __atomic_load_n(&m_bytes, __ATOMIC_RELAXED);
+    return (bytes1 - bytes0) / ((bench_now() - start) / 1e9) / 1e6;
+}
+
+// 服务端接收数据转发到应用的吞吐量
+static int bench_ingress(uint16_t port, int secs)
+{
+    pthread_t client[BENCH_RX_CLIENTS], app;
+    int fds[BENCH_RX_CLIENTS];
+
+    m_stop  = 0;
+    m_bytes = 0;
+    pthread_create(&app, NULL, bench_app, NULL);
+    for (int idx = 0; idx < BENCH_RX_CLIENTS; ++idx) {
+        fds[idx] = bench_connect(port);
+        if (fds[idx] < 0) {
+            return -1;
+        }
+        pthread_create(&client[idx], NULL, bench_client, (void *)(intptr_t)fds[idx]);
+    }
+    double mbps = bench_window(secs);
+    m_stop = 1;
+    for (int idx = 0; idx < BENCH_RX_CLIENTS; ++idx) {
+        shutdown(fds[idx], SHUT_RDWR);
+        pthread_join(client[idx], NULL);
+        bench_reset(fds[idx]);
+    }
+    pthread_join(app, NULL);
+    printf("ingress: %d clients, %d KiB writes, %.1f MB/s delivered to app\n",
+        BENCH_RX_CLIENTS, BENCH_RX_CHUNK >> 10, mbps);
+    return 0;
+}
+
+// 对端读取线程
+static void *bench_peer(void *arg)
+{
+    int fd = (int)(intptr_t)arg;
+    char buf[65536];
+
+    while (!m_stop) {
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) {
+            break;
+        }
+        __atomic_add_fetch(&m_bytes, (uint64_t)len, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static void *bench_sender(void *arg)
+{
+    int port = ((int *)arg)[0];
+    int size = ((int *)arg)[1];
+    char *buf = (char *)malloc(size);
+
+    memset(buf, 0xA5, size);
+    while (!m_stop) {
+        if (asyncomm_write(port, buf, size) < 0) {
+            sched_yield(); // 发送队列满，等待通信线程写出
+        }
+    }
+    free(buf);
+    return NULL;
+}
+
+// 客户端通过asyncomm_write发送的吞吐量
+static int bench_egress(int secs)
+{
+    static const int sizes[] = {512, 4096, 65536};
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (lfd < 0 || bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(lfd, 1) < 0
+        || getsockname(lfd, (struct sockaddr *)&addr, &alen) < 0) {
+        return -1;
+    }
+    int port = asyncomm_open_tcpc("127.0.0.1", ntohs(addr.sin_port), ASY_FLOW_OLDEST, NULL);
+    if (port < 0) {
+        return -1;
+    }
+    int pfd = accept(lfd, NULL, NULL);
+    if (pfd < 0) {
+        return -1;
+    }
+    usleep(100000); // 等待客户端确认连接建立
+    for (size_t idx = 0; idx < sizeof(sizes) / sizeof(sizes[0]); ++idx) {
+        pthread_t peer, sender;
+        int arg[2] = {port, sizes[idx]};
+
+        m_stop  = 0;
+        m_bytes = 0;
+        pthread_create(&peer, NULL, bench_peer, (void *)(intptr_t)pfd);
+        pthread_create(&sender, NULL, bench_sender, arg);
+        double mbps = bench_window(secs);
+        m_stop = 1;
+        pthread_join(sender, NULL);
+        // 读空发送队列中剩余的数据，让读取线程退出
+        usleep(100000);
+        shutdown(pfd, SHUT_RD);
+        pthread_join(peer, NULL);
+        if (idx + 1 < sizeof(sizes) / sizeof(sizes[0])) {
+            // 重新建立对端读取，丢弃上一轮剩余的数据
+            close(pfd);
+            asyncomm_close(port);
+            port = asyncomm_open_tcpc("127.0.0.1", ntohs(addr.sin_port), ASY_FLOW_OLDEST, NULL);
+            pfd  = (port < 0) ? -1 : accept(lfd, NULL, NULL);
+            if (pfd < 0) {
+                return -1;
+            }
+            usleep(100000);
+        }
+        printf("egress: %6d B writes, %.1f MB/s\n", sizes[idx], mbps);
+    }
+    close(pfd);
+    asyncomm_close(port);
+    close(lfd);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int secs = (argc > 1) ? atoi(argv[1]) : 1;
+    uint16_t port = (uint16_t)(20000 + getpid() % 20000);
+
+    if (secs <= 0) {
+        secs = 1;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    if (bench_appq_open(&m_rx, "tcp") < 0 || asyncomm_init(1, 0) != ASY_OK) {
+        fprintf(stderr, "init failed\n");
+        return EXIT_FAILURE;
+    }
+    int srv = asyncomm_open_tcps("127.0.0.1", port, ASY_FLOW_BLOCK);
+    if (srv < 0) {
+        fprintf(stderr, "listen on %u failed\n", port);
+        return EXIT_FAILURE;
+    }
+    int ret = bench_accept(port, secs);
+    if (0 == ret) {
+        ret = bench_ingress(port, secs);
+    }
+    if (0 == ret) {
+        ret = bench_egress(secs);
+    }
+    asyncomm_close(srv);
+    asyncomm_exit();
+    bench_appq_close(&m_rx);
+    return (0 == ret) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
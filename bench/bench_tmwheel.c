@@ -0,0 +1,206 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :bench_tmwheel.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :分层时间轮的开销和通信线程定时器的到期抖动.第一部分直接操作时间轮:
+//                 10万个定时器随机分布在1分钟(1ms一个tick)内，测量每次插入、重新启动、删除的
+//                 时间，以及逐个tick推进到全部到期时每个定时器的到期开销；第二部分把10万个
+//                 定时器交给通信线程，截止时间均匀分布在2秒内，回调中记录实际执行时间，
+//                 输出相对截止时间和相对tick边界的p50/p99/最大延迟
+// Interface      :bench_tmwheel [定时器数量]
+// Others         :截止时间向上取整到tick，相对截止时间的延迟包含最多1个tick的取整.
+//                 提前到期时返回失败
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "tmwheel.h"
+#include "asyncomm.h"
+#include "glog4c.h"
+#include "bench.h"
+
+#define BENCH_MAX    200000
+#define BENCH_RANGE  60000 // 第一部分的到期范围，tick
+#define BENCH_SPREAD 2000  // 第二部分截止时间的分布范围，ms
+#define BENCH_LEAD   100   // 第二部分第一个截止时间距离开始的时间，ms
+
+typedef struct {
+    asytimer tm;
+    uint64_t deadline; // 截止时间，ns
+    uint64_t fired;    // 回调执行时间，ns
+}bench_timer;
+
+static tmwheel      m_wheel;
+static tmnode       m_node[BENCH_MAX];
+static uint64_t     m_due[BENCH_MAX];
+static bench_timer  m_tm[BENCH_MAX];
+static uint64_t     m_late[BENCH_MAX];
+static uint64_t     m_jit[BENCH_MAX];
+static int          m_left;
+
+static uint32_t m_rand = 2463534242U;
+static uint32_t bench_rand(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+// 第一部分:只测量时间轮本身
+static void bench_wheel(int num)
+{
+    tmnode out, *node;
+    uint64_t base = 1000;
+    int fired = 0;
+
+    tmwheel_init(&m_wheel, base);
+    tmnode_init(&out);
+    for (int idx = 0; idx < num; ++idx) {
+        tmnode_init(&m_node[idx]);
+        m_due[idx] = base + 1 + bench_rand() % BENCH_RANGE;
+    }
+
+    uint64_t start = bench_now();
+    for (int idx = 0; idx < num; ++idx) {
+        tmwheel_add(&m_wheel, &m_node[idx], m_due[idx]);
+    }
+    uint64_t t_add = bench_now() - start;
+
+    // 重新启动:超时类定时器最常见的操作，先删除再插入到新的位置
+    for (int idx = 0; idx < num; ++idx) {
+        m_due[idx] = base + 1 + bench_rand() % BENCH_RANGE;
+    }
+    start = bench_now();
+    for (int idx = 0; idx < num; ++idx) {
+        tmwheel_add(&m_wheel, &m_node[idx], m_due[idx]);
+    }
+    uint64_t t_readd = bench_now() - start;
+
+    start = bench_now();
+    for (int idx = 0; idx < num; ++idx) {
+        tmwheel_del(&m_wheel, &m_node[idx]);
+    }
+    uint64_t t_del = bench_now() - start;
+
+    for (int idx = 0; idx < num; ++idx) {
+        tmwheel_add(&m_wheel, &m_node[idx], m_due[idx]);
+    }
+    // 逐个tick推进，与通信线程每个tick唤醒一次的最坏情况相同
+    uint64_t ticks = 0;
+    start = bench_now();
+    for (uint64_t now = base + 1; 0 != m_wheel.count; ++now, ++ticks) {
+        tmwheel_advance(&m_wheel, now, &out);
+        while (NULL != (node = tmwheel_pop(&out))) {
+            if (node->expire != now) {
+                fprintf(stderr, "timer expired at %llu, due %llu\n",
+                    (unsigned long long)now, (unsigned long long)node->expire);
+                exit(EXIT_FAILURE);
+            }
+            ++fired;
+        }
+    }
+    uint64_t t_adv = bench_now() - start;
+    if (fired != num) {
+        fprintf(stderr, "fired %d of %d timers\n", fired, num);
+        exit(EXIT_FAILURE);
+    }
+    printf("wheel: %d timers over %d ticks\n", num, BENCH_RANGE);
+    printf("  insert  %8.1f ns/timer\n", (double)t_add / num);
+    printf("  restart %8.1f ns/timer\n", (double)t_readd / num);
+    printf("  delete  %8.1f ns/timer\n", (double)t_del / num);
+    printf("  expire  %8.1f ns/timer (%llu ticks, %.1f ns/tick incl. cascade)\n",
+        (double)t_adv / num, (unsigned long long)ticks, (double)t_adv / ticks);
+}
+
+static void bench_on_timer(void *arg)
+{
+    bench_timer *bt = (bench_timer *)arg;
+
+    bt->fired = bench_now();
+    __atomic_sub_fetch(&m_left, 1, __ATOMIC_RELEASE);
+}
+
+// 第二部分:通信线程中定时器的实际执行时间
+static int bench_jitter(int num)
+{
+    int early = 0;
+
+    __atomic_store_n(&m_left, num, __ATOMIC_RELAXED);
+    for (int idx = 0; idx < num; ++idx) {
+        if (asyncomm_timer_init(&m_tm[idx].tm, -1, bench_on_timer, &m_tm[idx]) != ASY_OK) {
+            fprintf(stderr, "timer init failed\n");
+            return -1;
+        }
+    }
+    uint64_t start = bench_now() + BENCH_LEAD * 1000000ULL;
+    uint64_t spread = (uint64_t)BENCH_SPREAD * 1000000ULL;
+    uint64_t begin = bench_now();
+    for (int idx = 0; idx < num; ++idx) {
+        m_tm[idx].fired    = 0;
+        m_tm[idx].deadline = start + (uint64_t)bench_rand() % spread;
+        asyncomm_timer_at(&m_tm[idx].tm, m_tm[idx].deadline);
+    }
+    uint64_t t_arm = bench_now() - begin;
+    while (__atomic_load_n(&m_left, __ATOMIC_ACQUIRE) > 0) {
+        if (bench_now() > start + spread + 5000000000ULL) {
+            fprintf(stderr, "%d timers did not fire\n", m_left);
+            return -1;
+        }
+        usleep(10000);
+    }
+    for (int idx = 0; idx < num; ++idx) {
+        uint64_t tick = (m_tm[idx].deadline + ASY_TICK_NS - 1) / ASY_TICK_NS * ASY_TICK_NS;
+        if (m_tm[idx].fired < m_tm[idx].deadline) {
+            ++early;
+            m_late[idx] = 0;
+            m_jit[idx]  = 0;
+            continue;
+        }
+        m_late[idx] = m_tm[idx].fired - m_tm[idx].deadline;
+        m_jit[idx]  = m_tm[idx].fired - tick;
+    }
+    printf("reactor: %d timers over %d ms, %d thread(s), arm %.1f ns/timer\n",
+        num, BENCH_SPREAD, asyncomm_nreactor(), (double)t_arm / num);
+    printf("  %-14s %10s %10s %10s\n", "late (us)", "p50", "p99", "max");
+    printf("  %-14s %10.1f %10.1f %10.1f\n", "from deadline", bench_pct(m_late, num, 50) / 1e3,
+        bench_pct(m_late, num, 99) / 1e3, bench_pct(m_late, num, 100) / 1e3);
+    printf("  %-14s %10.1f %10.1f %10.1f\n", "from tick", bench_pct(m_jit, num, 50) / 1e3,
+        bench_pct(m_jit, num, 99) / 1e3, bench_pct(m_jit, num, 100) / 1e3);
+    if (0 != early) {
+        fprintf(stderr, "%d timers fired before their deadline\n", early);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int num = (argc > 1) ? atoi(argv[1]) : 100000;
+    bench_rx rx;
+
+    if (num <= 0 || num > BENCH_MAX) {
+        num = 100000;
+    }
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    bench_wheel(num);
+
+    if (bench_appq_open(&rx, "tmwheel") != 0) {
+        fprintf(stderr, "open queue failed\n");
+        return EXIT_FAILURE;
+    }
+    if (asyncomm_init(1, 0) < 0) {
+        bench_appq_close(&rx);
+        fprintf(stderr, "init failed\n");
+        return EXIT_FAILURE;
+    }
+    int ret = bench_jitter(num);
+    asyncomm_exit();
+    bench_appq_close(&rx);
+    return (0 == ret) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
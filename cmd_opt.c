@@ -14,6 +14,7 @@
 *------------------------------------------------------------------------------
 ******************************************************************************/
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <getopt.h> //获取命令行参数
 #include <unistd.h>
@@ -25,6 +26,7 @@
 #include <libxml/tree.h>
 
 #include "cmd_opt.h"
+#define GLOG4C_MODULE GLOG4C_MOD_CMDOPT
 #include "glog4c.h"
 #include "db_in_mem.h"
 #include "objects.h"
@@ -85,22 +87,88 @@ int cmdopt_parser_cmd(int argc, char **argv)
 //加载和读取配置文件
 #define XML_NODE     1 // 代表是xml的节点
 #define XML_PROPERTY 0 // 代表是xml的属性
+#define XML_MUST     1 // 配置文件中必需存在
+#define XML_OPTION   0 // 可选配置，不存在时保持默认值
 typedef struct {
     char *xmlpath; // xml属性路径
     char *name;    // 属性名称
     uint32_t type; // 对应属性的数据类型，引用自db_in_mem.h
     uint16_t node; // 
     uint16_t id;   // 对应系统属性的键
+    uint16_t must; // 是否为必需的配置
 }xmlcontent;
 
 xmlcontent xml_content[] = {
-    {"/Communicator/System/AppToQueue", "",     DB_STRING, XML_NODE,     OBJSYS_CFG_A2Q},
-    {"/Communicator/System/QeueuToApp", "",     DB_STRING, XML_NODE,     OBJSYS_CFG_Q2A},
-    {"/Communicator/Serial[@Enable]", "Enable", DB_BOOL,   XML_PROPERTY, OBJSYS_SERIAL_EN},
-    {"/Communicator/Serial/COM1",     "",       DB_STRING, XML_NODE,     OBJSYS_SERIAL1},
+    {"/Communicator/System/AppToQueue", "",     DB_STRING, XML_NODE,     OBJSYS_CFG_A2Q,    XML_MUST},
+    {"/Communicator/System/QeueuToApp", "",     DB_STRING, XML_NODE,     OBJSYS_CFG_Q2A,    XML_MUST},
+    {"/Communicator/System/AppTransport", "",   DB_STRING, XML_NODE,     OBJSYS_APP_TRANSPORT, XML_OPTION},
+    {"/Communicator/System/AppRingSize", "",    DB_UINT32, XML_NODE,     OBJSYS_APP_RING,   XML_OPTION},
+    {"/Communicator/System/ForwardDelay", "",   DB_UINT32, XML_NODE,     OBJSYS_FWD_DELAY,  XML_OPTION},
+    {"/Communicator/System/DrainRecords", "",   DB_UINT32, XML_NODE,     OBJSYS_DRAIN_RECORDS, XML_OPTION},
+    {"/Communicator/System/DrainBytes", "",     DB_UINT32, XML_NODE,     OBJSYS_DRAIN_BYTES, XML_OPTION},
+    {"/Communicator/System/FlowHigh",   "",     DB_UINT32, XML_NODE,     OBJSYS_FLOW_HIGH,  XML_OPTION},
+    {"/Communicator/System/FlowLow",    "",     DB_UINT32, XML_NODE,     OBJSYS_FLOW_LOW,   XML_OPTION},
+    {"/Communicator/System/IoThreads",  "",     DB_UINT32, XML_NODE,     OBJSYS_IO_THREADS, XML_OPTION},
+    {"/Communicator/System/SubCycle",   "",     DB_UINT32, XML_NODE,     OBJSYS_SUB_CYCLE,  XML_OPTION},
+    {"/Communicator/System/ShmName",    "",     DB_STRING, XML_NODE,     OBJSYS_SHM_NAME,   XML_OPTION},
+    {"/Communicator/System/DataDir",    "",     DB_STRING, XML_NODE,     OBJSYS_DATA_DIR,   XML_OPTION},
+    {"/Communicator/System/SnapPeriod", "",     DB_UINT32, XML_NODE,     OBJSYS_SNAP_PERIOD, XML_OPTION},
+    {"/Communicator/System/JournalPeriod", "",  DB_UINT32, XML_NODE,     OBJSYS_JNL_PERIOD, XML_OPTION},
+    {"/Communicator/System/HistBytes",  "",     DB_UINT32, XML_NODE,     OBJSYS_HIST_BYTES, XML_OPTION},
+    {"/Communicator/System/LogFile",    "",     DB_STRING, XML_NODE,     OBJSYS_LOG_FILE,   XML_OPTION},
+    {"/Communicator/System/LogBlock",   "",     DB_BOOL,   XML_NODE,     OBJSYS_LOG_BLOCK,  XML_OPTION},
+    {"/Communicator/System/LogLevel",   "",     DB_STRING, XML_NODE,     OBJSYS_LOG_LEVEL,  XML_OPTION},
+    {"/Communicator/System/LogLevel[@Asyncomm]", "Asyncomm", DB_STRING, XML_PROPERTY, OBJSYS_LOG_ASYNCOMM, XML_OPTION},
+    {"/Communicator/System/LogLevel[@Dbmem]",    "Dbmem",    DB_STRING, XML_PROPERTY, OBJSYS_LOG_DBMEM,    XML_OPTION},
+    {"/Communicator/System/LogLevel[@Cmdopt]",   "Cmdopt",   DB_STRING, XML_PROPERTY, OBJSYS_LOG_CMDOPT,   XML_OPTION},
+    {"/Communicator/System/MetricShm",  "",     DB_STRING, XML_NODE,     OBJSYS_METRIC_SHM, XML_OPTION},
+    {"/Communicator/System/MetricSocket", "",   DB_STRING, XML_NODE,     OBJSYS_METRIC_SOCK, XML_OPTION},
+    {"/Communicator/System/MetricPeriod", "",   DB_UINT32, XML_NODE,     OBJSYS_METRIC_PERIOD, XML_OPTION},
+    {"/Communicator/Serial[@Enable]", "Enable", DB_BOOL,   XML_PROPERTY, OBJSYS_SERIAL_EN,  XML_MUST},
+    {"/Communicator/Serial/COM1",     "",       DB_STRING, XML_NODE,     OBJSYS_SERIAL1,    XML_MUST},
+    {"/Communicator/Serial/COM1[@Baud]",     "Baud",     DB_UINT32, XML_PROPERTY, OBJSYS_SERIAL1_BAUD,  XML_OPTION},
+    {"/Communicator/Serial/COM1[@Parity]",   "Parity",   DB_STRING, XML_PROPERTY, OBJSYS_SERIAL1_PAR,   XML_OPTION},
+    {"/Communicator/Serial/COM1[@DataBits]", "DataBits", DB_UINT32, XML_PROPERTY, OBJSYS_SERIAL1_DATA,  XML_OPTION},
+    {"/Communicator/Serial/COM1[@StopBits]", "StopBits", DB_UINT32, XML_PROPERTY, OBJSYS_SERIAL1_STOP,  XML_OPTION},
+    {"/Communicator/Serial/COM1[@VMin]",     "VMin",     DB_UINT32, XML_PROPERTY, OBJSYS_SERIAL1_VMIN,  XML_OPTION},
+    {"/Communicator/Serial/COM1[@VTime]",    "VTime",    DB_UINT32, XML_PROPERTY, OBJSYS_SERIAL1_VTIME, XML_OPTION},
+    {"/Communicator/Serial/COM1[@Flow]",     "Flow",     DB_STRING, XML_PROPERTY, OBJSYS_SERIAL1_FLOW,  XML_OPTION},
+    {"/Communicator/Serial/COM1[@TxnTimeout]", "TxnTimeout", DB_UINT32, XML_PROPERTY, OBJSYS_SERIAL1_TXN_TIMEOUT, XML_OPTION},
+    {"/Communicator/Serial/COM1[@TxnRetry]", "TxnRetry", DB_UINT32, XML_PROPERTY, OBJSYS_SERIAL1_TXN_RETRY, XML_OPTION},
+    {"/Communicator/Tcp/Server",        "",     DB_STRING, XML_NODE,     OBJSYS_TCPS_ADDR,  XML_OPTION},
+    {"/Communicator/Tcp/Server[@Flow]", "Flow", DB_STRING, XML_PROPERTY, OBJSYS_TCPS_FLOW,  XML_OPTION},
+    {"/Communicator/Tcp/Client",        "",     DB_STRING, XML_NODE,     OBJSYS_TCPC_ADDR,  XML_OPTION},
+    {"/Communicator/Tcp/Client[@Flow]", "Flow", DB_STRING, XML_PROPERTY, OBJSYS_TCPC_FLOW,  XML_OPTION},
+    {"/Communicator/Tcp/Client[@TxnWindow]",  "TxnWindow",  DB_UINT32, XML_PROPERTY, OBJSYS_TCPC_TXN_WINDOW,  XML_OPTION},
+    {"/Communicator/Tcp/Client[@TxnTimeout]", "TxnTimeout", DB_UINT32, XML_PROPERTY, OBJSYS_TCPC_TXN_TIMEOUT, XML_OPTION},
+    {"/Communicator/Tcp/Client[@TxnRetry]",   "TxnRetry",   DB_UINT32, XML_PROPERTY, OBJSYS_TCPC_TXN_RETRY,   XML_OPTION},
+    {"/Communicator/Tcp/Client[@TxnSeq]",     "TxnSeq",     DB_UINT32, XML_PROPERTY, OBJSYS_TCPC_TXN_SEQ,     XML_OPTION},
+    {"/Communicator/Tcp/Client[@TxnLen]",     "TxnLen",     DB_UINT32, XML_PROPERTY, OBJSYS_TCPC_TXN_LEN,     XML_OPTION},
+    {"/Communicator/Tcp/Client[@TxnLenAdj]",  "TxnLenAdj",  DB_UINT32, XML_PROPERTY, OBJSYS_TCPC_TXN_LENADJ,  XML_OPTION},
 };
 
-int cmdopt_parser_cfg(char *file)
+// 将配置字符串按测点类型转换后存储到系统对象中
+static void cmdopt_store(xmlcontent *item, xmlChar *str_value)
+{
+    int xml_int = 0;
+    uint32_t xml_u32 = 0;
+
+    switch (item->type) {
+    case DB_STRING:
+        dbmem_set_value(OBJSYS_ID, item->id, item->type, str_value, xmlStrlen(str_value));
+    break;
+    case DB_BOOL:
+        xml_int = xmlStrEqual(str_value, (const xmlChar*)"Enable");
+        dbmem_set_value(OBJSYS_ID, item->id, item->type, &xml_int, sizeof(xml_int));
+    break;
+    case DB_UINT32:
+        xml_u32 = (uint32_t)strtoul((const char *)str_value, NULL, 0);
+        dbmem_set_value(OBJSYS_ID, item->id, item->type, &xml_u32, sizeof(xml_u32));
+    break;
+    }
+}
+
+int cmdopt_parser_cfg(const char *file)
 {
     if (file == NULL) {
         return CMDOPT_FILE;
@@ -130,7 +198,6 @@ int cmdopt_parser_cfg(char *file)
     xmlXPathObjectPtr xml_retsult;// 存储xpath临时搜索结果，xml节点或属性数据
     xmlChar *str_value;
     int xmlsize = sizeof(xml_content) / sizeof(xmlcontent);
-    int xml_int = 0;
     for (int tmp = 0; tmp < xmlsize; ++tmp) {
         xml_retsult = xmlXPathEvalExpression((const xmlChar*)xml_content[tmp].xmlpath, xml_contex);
         // 如果没有检索到就跳过当前的值
@@ -140,8 +207,11 @@ int cmdopt_parser_cfg(char *file)
             continue;
         }
         if (xmlXPathNodeSetIsEmpty(xml_retsult->nodesetval)) {
-            glog4c_info("Can't read needs values from config file.\n")
             xmlXPathFreeObject(xml_retsult);
+            if (XML_OPTION == xml_content[tmp].must) {
+                continue;
+            }
+            glog4c_info("Can't read needs values from config file.\n");
             ret = CMDOPT_PARSE;
             break;
         }
@@ -154,15 +224,7 @@ int cmdopt_parser_cfg(char *file)
                 continue;
             }
             // 将数据转换为内部数据并存储到数据库中
-            switch (xml_content[tmp].type) {
-            case DB_STRING:
-                dbmem_set_value(OBJSYS_ID, xml_content[tmp].id, xml_content[tmp].type, str_value, xmlStrlen(str_value));
-            break;
-            case DB_BOOL:
-                xml_int = xmlStrEqual(str_value, (const xmlChar*)"Enable");
-                dbmem_set_value(OBJSYS_ID, xml_content[tmp].id, xml_content[tmp].type, &xml_int, sizeof(xml_int));
-            break;
-            }
+            cmdopt_store(&xml_content[tmp], str_value);
             xmlFree(str_value);
         } else {
             // 如果是属性则加载属性
@@ -172,17 +234,12 @@ int cmdopt_parser_cfg(char *file)
                 continue;
             }
             // 将数据转换为内部数据并存储到数据库中
-            switch (xml_content[tmp].type) {
-            case DB_BOOL:
-                xml_int = xmlStrEqual(str_value, (const xmlChar*)"Enable");
-                dbmem_set_value(OBJSYS_ID, xml_content[tmp].id, xml_content[tmp].type, &xml_int, sizeof(xml_int));
-            break;
-            }
+            cmdopt_store(&xml_content[tmp], str_value);
             xmlFree(str_value);
         }
         xmlXPathFreeObject(xml_retsult);
     }
-    glog4c_hit("printf obj info\n");
+    glog4c_debug("printf obj info\n");
     dbmem_print_property(OBJSYS_ID);
 
     xmlFreeDoc(xml_doc); // 关闭文件
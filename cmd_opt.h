@@ -10,6 +10,6 @@
 
 //命令行解析
 int cmdopt_parser_cmd(int argc, char **argv);
-int cmdopt_parser_cfg(char *file);
+int cmdopt_parser_cfg(const char *file);
 
 #endif
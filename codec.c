@@ -0,0 +1,320 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :codec.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :应用消息编解码。解码直接在接收缓冲区上进行，条目提取到调用者提供的数组中，
+//                 整个过程不申请内存；编码直接写入发送缓冲区。
+// Interface      :无
+// Others         :帧头、编号和长度字段按小端序逐字节拼接，不依赖平台字节序和地址对齐；
+//                 定长值按主机字节序原样拷贝
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "codec.h"
+
+// 各数据类型在帧中的长度，0为变长，-1为未知类型
+static const int8_t m_type_size[] = {
+    0,  // DB_NULL，只有编号
+    1,  // DB_INT8
+    1,  // DB_UINT8
+    2,  // DB_INT16
+    2,  // DB_UINT16
+    4,  // DB_INT32
+    4,  // DB_UINT32
+    8,  // DB_INT64
+    8,  // DB_UINT64
+    4,  // DB_FLOAT
+    8,  // DB_DOUBLE
+    0,  // DB_STRING
+    0,  // DB_BLOB
+    4,  // DB_BOOL，与db_in_mem中的存储一致
+};
+
+#define CODEC_VAR_TYPE(t) (DB_STRING == (t) || DB_BLOB == (t))
+
+static inline uint16_t codec_rd16(const uint8_t *pos)
+{
+    return (uint16_t)(pos[0] | (pos[1] << 8));
+}
+
+static inline void codec_wr16(uint8_t *pos, uint16_t val)
+{
+    pos[0] = (uint8_t)val;
+    pos[1] = (uint8_t)(val >> 8);
+}
+
+// 按类型长度拷贝定长值，主机字节序，低地址对齐，与dbvar联合体一致.长度用常量分支，
+// 变长memcpy会被展开为rep movs，8字节值也要几十纳秒
+static inline void codec_rdval(uint64_t *raw, const uint8_t *pos, int vsize)
+{
+    *raw = 0;
+    switch (vsize) {
+    case 1:
+        memcpy(raw, pos, 1);
+    break;
+    case 2:
+        memcpy(raw, pos, 2);
+    break;
+    case 4:
+        memcpy(raw, pos, 4);
+    break;
+    case 8:
+        memcpy(raw, pos, 8);
+    break;
+    default:
+    break;
+    }
+}
+
+int codec_type_size(uint8_t type)
+{
+    if (type >= sizeof(m_type_size)) {
+        return -1;
+    }
+    return m_type_size[type];
+}
+
+size_t codec_item_size(uint8_t type, uint16_t len)
+{
+    if (CODEC_VAR_TYPE(type)) {
+        return 4 + (size_t)len;
+    }
+    return 2 + (size_t)codec_type_size(type);
+}
+
+//------------------------------------------------------------------------------
+// Function       :codec_decode
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :解码一帧.定长类型先按数量一次算出总长度完成校验，再顺序拷贝条目；变长
+//                 类型在提取条目的同时检查每个条目的长度，一次遍历完成.
+// Input          :buf:接收缓冲区
+//                :size:帧长度
+//                :max:items数组的容量
+// Output         :head:帧头
+//                :items:条目数组
+// Return         :成功返回条目数量，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int codec_decode(const void *buf, size_t size, codec_head *head, codec_item *items, int max)
+{
+    const uint8_t *pos = (const uint8_t *)buf;
+    const uint8_t *end;
+
+    if (NULL == buf || NULL == head || (NULL == items && max > 0)) {
+        return CODEC_ER_PARAM;
+    }
+    if (size < CODEC_HEAD_SIZE) {
+        return CODEC_ER_SHORT;
+    }
+    head->cmd    = codec_rd16(pos);
+    head->count  = codec_rd16(pos + 2);
+    head->type   = pos[4];
+    head->obj_id = codec_rd16(pos + 5);
+    int vsize = codec_type_size(head->type);
+    if (vsize < 0) {
+        return CODEC_ER_TYPE;
+    }
+    if (head->count > max) {
+        return CODEC_ER_COUNT;
+    }
+    pos += CODEC_HEAD_SIZE;
+    end  = (const uint8_t *)buf + size;
+
+    if (!CODEC_VAR_TYPE(head->type)) {
+        size_t step = 2 + (size_t)vsize;
+        if ((size_t)(end - pos) != step * head->count) {
+            return CODEC_ER_SHORT;
+        }
+        for (int idx = 0; idx < head->count; ++idx, pos += step) {
+            codec_item *item = &items[idx];
+            item->id    = codec_rd16(pos);
+            item->len   = (uint16_t)vsize;
+            codec_rdval(&item->raw, pos + 2, vsize);
+            item->value = &item->raw;
+        }
+        return head->count;
+    }
+
+    for (int idx = 0; idx < head->count; ++idx) {
+        if (end - pos < 4) {
+            return CODEC_ER_SHORT;
+        }
+        codec_item *item = &items[idx];
+        item->id    = codec_rd16(pos);
+        item->len   = codec_rd16(pos + 2);
+        item->value = pos + 4;
+        pos += 4;
+        if ((size_t)(end - pos) < item->len) {
+            return CODEC_ER_SHORT;
+        }
+        pos += item->len;
+    }
+    if (pos != end) {
+        return CODEC_ER_SHORT;
+    }
+    return head->count;
+}
+
+int codec_begin(codec_writer *wr, void *buf, size_t cap, uint16_t cmd, uint8_t type, uint16_t obj_id)
+{
+    if (NULL == wr || NULL == buf || codec_type_size(type) < 0) {
+        return CODEC_ER_PARAM;
+    }
+    if (cap < CODEC_HEAD_SIZE) {
+        return CODEC_ER_SPACE;
+    }
+    wr->buf   = (uint8_t *)buf;
+    wr->cap   = cap;
+    wr->len   = CODEC_HEAD_SIZE;
+    wr->count = 0;
+    wr->type  = type;
+    codec_wr16(wr->buf, cmd);
+    codec_wr16(wr->buf + 2, 0);
+    wr->buf[4] = type;
+    codec_wr16(wr->buf + 5, obj_id);
+    return CODEC_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :codec_put
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :追加一个条目，空间不足时不写入任何内容，调用者可以结束当前帧后重新开始
+// Input          :wr:编码器
+//                :id:测点编号
+//                :value:值，定长类型按类型长度读取
+//                :len:变长类型的数据长度
+// Output         :无
+// Return         :成功返回CODEC_OK，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int codec_put(codec_writer *wr, uint16_t id, const void *value, uint16_t len)
+{
+    size_t need = codec_item_size(wr->type, len);
+
+    if (0xFFFF == wr->count) {
+        return CODEC_ER_COUNT;
+    }
+    if (wr->cap - wr->len < need) {
+        return CODEC_ER_SPACE;
+    }
+    uint8_t *pos = wr->buf + wr->len;
+    codec_wr16(pos, id);
+    if (CODEC_VAR_TYPE(wr->type)) {
+        codec_wr16(pos + 2, len);
+        if (len > 0 && pos + 4 != (const uint8_t *)value) {
+            memmove(pos + 4, value, len); // 数据可能已经位于缓冲区中帧头之后
+        }
+    } else if (need > 2) {
+        memcpy(pos + 2, value, need - 2);
+    }
+    wr->len += need;
+    ++wr->count;
+    return CODEC_OK;
+}
+
+size_t codec_end(codec_writer *wr)
+{
+    codec_wr16(wr->buf + 2, wr->count);
+    return wr->len;
+}
+
+//------------------------------------------------------------------------------
+// Function       :codec_put_hist_query
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :追加一个历史查询条目，值为 起始时间8B | 结束时间8B | 最多样本数2B，主机字节序
+// Input          :wr:编码器，类型为DB_BLOB
+//                :id:测点编号
+//                :from:起始时间，从1970年开始的毫秒数
+//                :to:结束时间，包含在内
+//                :max:最多返回的样本数量，超过时保留最新的样本
+// Output         :无
+// Return         :成功返回CODEC_OK，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int codec_put_hist_query(codec_writer *wr, uint16_t id, uint64_t from, uint64_t to, uint16_t max)
+{
+    uint8_t val[CODEC_HIST_QUERY];
+
+    if (DB_BLOB != wr->type) {
+        return CODEC_ER_TYPE;
+    }
+    memcpy(val, &from, 8);
+    memcpy(val + 8, &to, 8);
+    memcpy(val + 16, &max, 2);
+    return codec_put(wr, id, val, sizeof(val));
+}
+
+// 取出历史查询条件，条目长度不对时返回CODEC_ER_SHORT
+int codec_get_hist_query(const codec_item *item, uint64_t *from, uint64_t *to, uint16_t *max)
+{
+    const uint8_t *val = (const uint8_t *)item->value;
+
+    if (CODEC_HIST_QUERY != item->len) {
+        return CODEC_ER_SHORT;
+    }
+    memcpy(from, val, 8);
+    memcpy(to, val + 8, 8);
+    memcpy(max, val + 16, 2);
+    return CODEC_OK;
+}
+
+// 追加一个历史样本条目，值为 时间8B | 类型1B | 值8B，主机字节序
+int codec_put_sample(codec_writer *wr, uint16_t id, uint64_t ts, uint8_t type, uint64_t raw)
+{
+    uint8_t val[CODEC_HIST_SAMPLE];
+
+    if (DB_BLOB != wr->type) {
+        return CODEC_ER_TYPE;
+    }
+    memcpy(val, &ts, 8);
+    val[8] = type;
+    memcpy(val + 9, &raw, 8);
+    return codec_put(wr, id, val, sizeof(val));
+}
+
+// 取出历史样本，条目长度不对时返回CODEC_ER_SHORT
+int codec_get_sample(const codec_item *item, uint64_t *ts, uint8_t *type, uint64_t *raw)
+{
+    const uint8_t *val = (const uint8_t *)item->value;
+
+    if (CODEC_HIST_SAMPLE != item->len) {
+        return CODEC_ER_SHORT;
+    }
+    memcpy(ts, val, 8);
+    *type = val[8];
+    memcpy(raw, val + 9, 8);
+    return CODEC_OK;
+}
+
+static const char *m_codec_err[] = {
+    "Nothing",                     // CODEC_OK
+    "Codec parameter is error.",   // CODEC_ER_PARAM
+    "Frame length is error.",      // CODEC_ER_SHORT
+    "Unknow data type.",           // CODEC_ER_TYPE
+    "Too many items in frame.",    // CODEC_ER_COUNT
+    "Out of frame space.",         // CODEC_ER_SPACE
+};
+
+const char *codec_err_str(int err)
+{
+    if (err > 0 || err < CODEC_ER_SPACE) {
+        return m_codec_err[0];
+    }
+    return m_codec_err[-err];
+}
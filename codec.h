@@ -0,0 +1,99 @@
+#ifndef CODEC_H_
+#define CODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 应用与通讯者之间的消息格式，帧头、编号和长度字段为小端序，定长值按主机字节序存放，
+// 与dbvar中的存储一致(应用和通讯者运行在同一台机器上)
+//   命令2B | 数量2B | 类型1B | 对象2B | 数量个条目
+// 条目格式由类型决定:
+//   定长类型  编号2B | 值(按类型长度，主机字节序)
+//   DB_STRING/DB_BLOB 编号2B | 长度2B | 数据
+//   DB_NULL   编号2B
+// 类型字段直接使用db_in_mem.h中的DB_*定义，一帧中所有条目类型相同
+
+#define CODEC_HEAD_SIZE 7 // 帧头长度，包含对象编号
+
+// 命令定义
+#define CODEC_CMD_SET   0x0001 // 应用->通讯者，设置测点值
+#define CODEC_CMD_GET   0x0002 // 应用->通讯者，读取测点值，类型为DB_NULL
+#define CODEC_CMD_VALUE 0x0003 // 通讯者->应用，测点值，格式与SET相同
+#define CODEC_CMD_SUB   0x0004 // 应用->通讯者，订阅测点变化，类型为DB_UINT16，编号为起始编号，值为结束编号
+#define CODEC_CMD_UNSUB 0x0005 // 应用->通讯者，取消订阅，格式与SUB相同，数量为0时取消对象的所有订阅
+#define CODEC_CMD_CHANGE 0x0006 // 通讯者->应用，每个周期内变化的测点值，格式与VALUE相同
+#define CODEC_CMD_HIST  0x0007 // 应用->通讯者，查询历史样本，类型为DB_BLOB，编号为测点编号，
+                               // 值为 起始时间8B | 结束时间8B | 最多样本数2B，时间为从1970年开始的毫秒数
+#define CODEC_CMD_HISTORY 0x0008 // 通讯者->应用，历史样本，类型为DB_BLOB，每个样本一个条目，编号为测点编号，
+                               // 值为 时间8B | 类型1B | 值8B，同一测点按时间升序.每个查询帧至少应答一帧
+#define CODEC_CMD_DATA  0x0010 // 通讯者->应用，通道收到的数据，编号为端口号，类型为DB_BLOB
+#define CODEC_CMD_WRITE 0x0011 // 应用->通讯者，向通道发送数据，编号为端口号，类型为DB_BLOB
+#define CODEC_CMD_REQ   0x0012 // 应用->通讯者，向通道发送请求并等待应答，编号为端口号，类型为DB_BLOB，
+                               // 值为 标签4B | 请求，标签由应用指定，原样带回
+#define CODEC_CMD_RESP  0x0013 // 通讯者->应用，请求的结果，编号为端口号，类型为DB_BLOB，
+                               // 值为 标签4B | 状态1B | 应答，状态见asyncomm.h中的ASY_TXN_xxx
+
+#define CODEC_PORT_NONE 0xFFFF // 数据不属于任何端口
+#define CODEC_HIST_QUERY  18    // 历史查询条目值的长度
+#define CODEC_HIST_SAMPLE 17    // 历史样本条目值的长度
+
+// 函数返回结果定义
+#define CODEC_OK         0
+#define CODEC_ER_PARAM  -1 // 参数错误
+#define CODEC_ER_SHORT  -2 // 帧长度与内容不符
+#define CODEC_ER_TYPE   -3 // 未知的数据类型
+#define CODEC_ER_COUNT  -4 // 条目数量超出调用者提供的空间
+#define CODEC_ER_SPACE  -5 // 编码缓冲区空间不足
+
+// 帧头
+typedef struct {
+    uint16_t cmd;    // 命令
+    uint16_t count;  // 条目数量
+    uint8_t  type;   // 条目数据类型
+    uint16_t obj_id; // 对象编号
+}codec_head;
+
+// 解码后的条目，定长值拷贝到raw中保证对齐，变长值直接指向原始缓冲区
+typedef struct {
+    uint16_t    id;    // 测点编号或端口号
+    uint16_t    len;   // 值的长度
+    const void *value; // 值，定长类型指向raw
+    union {
+        uint64_t raw;
+        double   d;
+    };
+}codec_item;
+
+// 编码器，直接在调用者提供的缓冲区中组帧
+typedef struct {
+    uint8_t *buf;   // 缓冲区
+    size_t   cap;   // 缓冲区容量
+    size_t   len;   // 已经编码的长度
+    uint16_t count; // 已经编码的条目数量
+    uint8_t  type;  // 条目数据类型
+}codec_writer;
+
+// 数据类型在帧中的长度，变长类型返回0，未知类型返回-1
+int codec_type_size(uint8_t type);
+// 解码一帧，一次遍历完成校验和条目提取，不申请内存，返回条目数量
+int codec_decode(const void *buf, size_t size, codec_head *head, codec_item *items, int max);
+// 开始编码一帧
+int codec_begin(codec_writer *wr, void *buf, size_t cap, uint16_t cmd, uint8_t type, uint16_t obj_id);
+// 追加一个条目，定长类型忽略len
+int codec_put(codec_writer *wr, uint16_t id, const void *value, uint16_t len);
+// 结束编码，回填数量，返回帧长度
+size_t codec_end(codec_writer *wr);
+// 追加一个历史查询条目，编码器类型必需为DB_BLOB
+int codec_put_hist_query(codec_writer *wr, uint16_t id, uint64_t from, uint64_t to, uint16_t max);
+// 从HIST帧的条目中取出查询条件
+int codec_get_hist_query(const codec_item *item, uint64_t *from, uint64_t *to, uint16_t *max);
+// 追加一个历史样本条目，raw为样本值的64位内容，编码器类型必需为DB_BLOB
+int codec_put_sample(codec_writer *wr, uint16_t id, uint64_t ts, uint8_t type, uint64_t raw);
+// 从HISTORY帧的条目中取出样本
+int codec_get_sample(const codec_item *item, uint64_t *ts, uint8_t *type, uint64_t *raw);
+// 单个条目编码后的长度
+size_t codec_item_size(uint8_t type, uint16_t len);
+// 格式化错误消息
+const char *codec_err_str(int err);
+
+#endif
@@ -7,7 +7,9 @@
 //                 进行存储。存储前所有数据会进行希尔排序，让所有的数据按顺序存储，方便后续高
 //                 效搜索。
 // Interface      :无
-// Others         :无
+// Others         :读者不加锁:数值通过每个测点的顺序锁读取一致副本；字符串和二进制数据写入时
+//                 替换指针，旧数据按纪元(epoch)延迟释放，直到所有可能引用它的读者退出读临界
+//                 区.写者按对象互斥
 //-----------------------------------------------------------------------------
 // History:        初稿
 //-----------------------------------------------------------------------------
@@ -19,41 +21,486 @@
 #include <string.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
+#define GLOG4C_MODULE GLOG4C_MOD_DBMEM
 #include "glog4c.h"
 #include "db_in_mem.h"
+#include "dbconv.h"
+#include "dbshm.h"
+#include "dbhist.h"
+#include "metric.h"
 
-#define DBMEM_MAX_OBJS      8
 #define DBMEM_OBJ_NAME_SIZE 20
+// 对象目录分两级，对象编号高8位索引目录页，低8位索引页内对象，共覆盖65536个编号
+#define DBMEM_DIR_BITS      8
+#define DBMEM_DIR_SIZE      (1 << DBMEM_DIR_BITS)
+#define DBMEM_DIR_MASK      (DBMEM_DIR_SIZE - 1)
 
-//定义的最大对象数量，目前是32，对应4个字节
-uint8_t m_objid[DBMEM_MAX_OBJS >> 3] = {0};
+#define DBMEM_MAX_READERS   64 // 同时存在的读者线程数量上限
+#define DBMEM_CACHE_LINE    64
+
+// 字符串和二进制数据按尺寸分级从对象的内存池中申请，级别n的块尺寸为32<<n(含头部)
+#define DBMEM_SLAB_SHIFT    5
+#define DBMEM_SLAB_CLASSES  8      // 32B~4KB，更大的数据直接使用malloc
+#define DBMEM_SLAB_LARGE    0xFF   // 直接申请的大块
+#define DBMEM_CHUNK_SIZE    16384  // 内存池每次向系统申请的尺寸
+#define DBMEM_RETIRE_BATCH  16     // 待释放数据达到该数量才扫描读者槽位，分摊扫描开销
+
+// 测点索引，在初始化测点时按对象的编号分布自动选择
+#define DBMEM_MAX_PID       0x0FFF // 测点编号只有12位
+#define DBMEM_IDX_NONE      0      // 未建立索引，使用折半查找
+#define DBMEM_IDX_DIRECT    1      // 直接映射表，按编号直接取得测点位置
+#define DBMEM_IDX_EYTZ      2      // Eytzinger布局的有序表，用于编号稀疏的对象
+#define DBMEM_DIRECT_RATIO  8      // 最大编号不超过测点数量的该倍数时使用直接映射表
+#define DBMEM_DIRTY_WORDS   ((DBMEM_MAX_PID + 64) / 64) // 变化位图按最多测点数量申请，与初始化顺序无关
+#define DBMEM_BLOCK_CHUNK   256    // 整块写入每次转换和比较的测点数量，决定栈上缓冲区的大小
+
+// 对象存储布局
+#define DBMEM_LAYOUT_AOS    0      // 测点数组，每个测点16字节，支持所有类型
+#define DBMEM_LAYOUT_SOA    1      // 编号、类型、数值分列连续存储，只支持数值类型
+
+// Eytzinger布局的索引项
+typedef struct {
+    uint16_t id;  // 测点编号
+    uint16_t pos; // 测点在属性数组中的位置
+}dbeytz;
+
+// 字符串和二进制数据的头部，数据被替换后用于挂接到待释放链表和空闲链表
+typedef struct dbrcu {
+    struct dbrcu *next;  // 待释放链表或空闲链表
+    uint64_t      epoch; // 被替换时的纪元
+    uint32_t      cls;   // 尺寸级别
+    uint32_t      rsv;
+}dbrcu;
+
+// 内存池向系统申请的大块，对象关闭时整体释放
+typedef struct dbchunk {
+    struct dbchunk *next;
+    uint64_t        rsv; // 保证后续数据8字节对齐
+}dbchunk;
 
 //定义了系统级对象
 typedef struct {
     uint16_t obj_id;                    // 对象编号
     char     name[DBMEM_OBJ_NAME_SIZE]; // 对象名称
     uint16_t psize;                     // 测点数量
-    dbvar    property[];                // 对象属性
+    pthread_mutex_t wlock;              // 写者互斥锁，同一对象的写入串行执行，同时保护内存池
+    dbrcu   *retired;                   // 待释放链表
+    uint32_t nretired;                  // 待释放数量
+    dbrcu   *freelist[DBMEM_SLAB_CLASSES]; // 各级别的空闲块
+    dbchunk *chunks;                    // 已经申请的大块
+    char    *bump;                      // 当前大块中未分配区域的起始位置
+    size_t   bump_left;                 // 当前大块中未分配区域的尺寸
+    uint8_t  idx_kind;                  // 索引类型
+    uint16_t idx_size;                  // 直接映射表的长度或Eytzinger表的测点数量
+    union {
+        uint16_t *direct;               // 直接映射表，值为测点位置加1，0表示不存在
+        dbeytz   *eytz;                 // Eytzinger表，下标从1开始
+    };
+    uint8_t   layout;                   // 存储布局
+    uint32_t  soa_seq;                  // 列存储的顺序锁计数，整个对象共用一个
+    uint16_t *soa_id;                   // 列存储的测点编号，升序
+    uint8_t  *soa_type;                 // 列存储的数据类型
+    uint64_t *soa_val;                  // 列存储的数值，按dbvar联合体的方式保存
+    uint8_t   watch;                    // 打开变化记录的通道掩码，为0时写入路径不做任何记录
+    uint64_t *dirty[DBMEM_WATCH_CHANS]; // 每个通道的变化位图，按测点位置索引，打开时才申请，受写锁保护
+    uint32_t  ndirty[DBMEM_WATCH_CHANS];// 位图中置位的数量，为0时取变化直接返回
+    dbshm_slot *shm;                    // 共享内存中的测点槽，导出后每次写入同步更新
+    dbhist   *hist;                     // 历史记录，打开后每次写入追加一个样本
+    dbvar    property[];                // 对象属性，列存储时为空
 }objsys;
 
-//定义系统对象
-objsys *m_objsys[DBMEM_MAX_OBJS] = {NULL};
+// 对象目录页，只在第一次有对象落入时申请，进程退出前不释放
+typedef struct {
+    uint32_t count;                 // 页内对象数量，遍历时跳过空页
+    objsys  *obj[DBMEM_DIR_SIZE];   // 页内对象
+}objpage;
+
+//定义系统对象目录，查找不加锁，创建和删除由m_dir_lock串行
+static objpage *m_objdir[DBMEM_DIR_SIZE] = {NULL};
+static uint32_t m_objnum = 0; // 对象总数
+static uint8_t *m_shm = NULL;  // 共享内存导出区域
+static size_t   m_shm_size = 0;
+static char     m_shm_name[64];
+static pthread_mutex_t m_dir_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 读者槽位，每个读者线程独占一个，按缓存行对齐避免伪共享
+typedef struct {
+    uint64_t epoch; // 进入读临界区时的纪元，0表示不在临界区内
+    uint32_t used;  // 槽位是否已经被线程占用
+    char     pad[DBMEM_CACHE_LINE - 12];
+}dbreader;
+
+static dbreader m_readers[DBMEM_MAX_READERS] __attribute__((aligned(DBMEM_CACHE_LINE)));
+static uint64_t m_epoch = 1;                          // 全局纪元，每次替换数据后递增
+static pthread_key_t   m_reader_key;
+static pthread_once_t  m_reader_once = PTHREAD_ONCE_INIT;
+static __thread int    m_reader_slot  = -1;           // 当前线程的读者槽位
+static __thread int    m_reader_depth = 0;            // 读临界区嵌套深度
+// 槽位用完后的读者改为持有读锁，写者回收数据前必需能取得写锁，回收不会等待这些读者
+static pthread_rwlock_t m_reader_ovf = PTHREAD_RWLOCK_INITIALIZER;
+static __thread int    m_reader_ovf_on = 0;           // 当前临界区持有m_reader_ovf
+static int             m_reader_ovf_warned = 0;
+
+// 线程退出时归还读者槽位
+static void dbmem_reader_exit(void *arg)
+{
+    dbreader *rd = (dbreader *)arg;
+
+    __atomic_store_n(&rd->epoch, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&rd->used, 0, __ATOMIC_RELEASE);
+}
+
+static void dbmem_reader_key(void)
+{
+    pthread_key_create(&m_reader_key, dbmem_reader_exit);
+}
+
+// 为当前线程申请读者槽位，槽位用完时返回-1
+static int dbmem_reader_slot(void)
+{
+    pthread_once(&m_reader_once, dbmem_reader_key);
+    for (int idx = 0; idx < DBMEM_MAX_READERS; ++idx) {
+        uint32_t expect = 0;
+        if (__atomic_compare_exchange_n(&m_readers[idx].used, &expect, 1, 0,
+                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            pthread_setspecific(m_reader_key, &m_readers[idx]);
+            return idx;
+        }
+    }
+    return -1;
+}
+
+void dbmem_read_lock(void)
+{
+    if (m_reader_depth++ > 0) {
+        return;
+    }
+    if (m_reader_slot < 0) {
+        m_reader_slot = dbmem_reader_slot();
+    }
+    // 槽位用完时退回读写锁，下次进入临界区时再尝试申请槽位
+    if (m_reader_slot < 0) {
+        if (!__atomic_exchange_n(&m_reader_ovf_warned, 1, __ATOMIC_RELAXED)) {
+            glog4c_warn("more than %d reader threads, fall back to reader lock\n", DBMEM_MAX_READERS);
+        }
+        pthread_rwlock_rdlock(&m_reader_ovf);
+        m_reader_ovf_on = 1;
+        return;
+    }
+    // 先公布纪元再读取测点，与写者的替换和扫描构成全序
+    uint64_t epoch = __atomic_load_n(&m_epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&m_readers[m_reader_slot].epoch, epoch, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void dbmem_read_unlock(void)
+{
+    if (m_reader_depth <= 0 || --m_reader_depth > 0) {
+        return;
+    }
+    if (m_reader_ovf_on) {
+        m_reader_ovf_on = 0;
+        pthread_rwlock_unlock(&m_reader_ovf);
+        return;
+    }
+    __atomic_store_n(&m_readers[m_reader_slot].epoch, 0, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_payload_alloc
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :从对象的内存池申请字符串和二进制数据空间，数据前面预留头部.优先使用
+//                 同级别的空闲块，其次从当前大块中切分，大块用完后再向系统申请，
+//                 稳定运行后相同尺寸的反复写入不再调用malloc.调用者持有对象写锁
+// Input          :obj_tmp:对象
+//                :size:数据尺寸
+// Output         :无
+// Return         :成功返回数据地址，失败返回NULL
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 改为按对象分级的内存池
+//------------------------------------------------------------------------------
+static void *dbmem_payload_alloc(objsys *obj_tmp, uint32_t size)
+{
+    size_t need = sizeof(dbrcu) + size;
+    uint32_t cls = 0;
+    dbrcu *head;
+
+    while (cls < DBMEM_SLAB_CLASSES && ((size_t)1 << (cls + DBMEM_SLAB_SHIFT)) < need) {
+        ++cls;
+    }
+    if (cls >= DBMEM_SLAB_CLASSES) {
+        head = (dbrcu *)malloc(need);
+        if (NULL == head) {
+            return NULL;
+        }
+        metric_add(METRIC_ALLOC, 1);
+        head->cls = DBMEM_SLAB_LARGE;
+        return head + 1;
+    }
+    head = obj_tmp->freelist[cls];
+    if (NULL != head) {
+        obj_tmp->freelist[cls] = head->next;
+        return head + 1;
+    }
+    size_t bsize = (size_t)1 << (cls + DBMEM_SLAB_SHIFT);
+    if (obj_tmp->bump_left < bsize) {
+        // 当前大块剩余空间不足，剩余部分放弃，申请新的大块
+        dbchunk *chunk = (dbchunk *)malloc(sizeof(dbchunk) + DBMEM_CHUNK_SIZE);
+        if (NULL == chunk) {
+            return NULL;
+        }
+        metric_add(METRIC_ALLOC, 1);
+        chunk->next        = obj_tmp->chunks;
+        obj_tmp->chunks    = chunk;
+        obj_tmp->bump      = (char *)(chunk + 1);
+        obj_tmp->bump_left = DBMEM_CHUNK_SIZE;
+    }
+    head = (dbrcu *)obj_tmp->bump;
+    obj_tmp->bump      += bsize;
+    obj_tmp->bump_left -= bsize;
+    head->cls = cls;
+    return head + 1;
+}
+
+// 回收数据空间，池中的块放回空闲链表，大块直接释放.只能在确定没有读者时调用
+static void dbmem_payload_free(objsys *obj_tmp, dbrcu *head)
+{
+    if (DBMEM_SLAB_LARGE == head->cls) {
+        free(head);
+    } else {
+        head->next = obj_tmp->freelist[head->cls];
+        obj_tmp->freelist[head->cls] = head;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_retire
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :延迟回收被替换的字符串和二进制数据.数据挂接到对象的待释放链表并推进
+//                 纪元，积累一批后检查读者，所有读者的纪元都大于数据被替换时的纪元后才
+//                 放回内存池.读者在替换
+//                 后进入临界区时读到的纪元一定更大，也一定看到了新的指针.调用者持有对象写锁
+// Input          :obj_tmp:对象
+//                :mem:被替换的数据
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 待释放链表移到对象中，由对象写锁保护
+//------------------------------------------------------------------------------
+static void dbmem_retire(objsys *obj_tmp, void *mem)
+{
+    uint64_t min_epoch = UINT64_MAX;
+    dbrcu *head = (dbrcu *)mem - 1;
+    dbrcu **pos;
+
+    head->epoch = __atomic_fetch_add(&m_epoch, 1, __ATOMIC_SEQ_CST);
+    head->next  = obj_tmp->retired;
+    obj_tmp->retired = head;
+    if (++obj_tmp->nretired < DBMEM_RETIRE_BATCH) {
+        return;
+    }
+
+    // 没有槽位的读者不公布纪元，有这样的读者在临界区内时本次不回收
+    if (pthread_rwlock_trywrlock(&m_reader_ovf) != 0) {
+        return;
+    }
+    pthread_rwlock_unlock(&m_reader_ovf);
+    // 找出仍在临界区内的最早的读者
+    for (int idx = 0; idx < DBMEM_MAX_READERS; ++idx) {
+        uint64_t epoch = __atomic_load_n(&m_readers[idx].epoch, __ATOMIC_SEQ_CST);
+        if (0 != epoch && epoch < min_epoch) {
+            min_epoch = epoch;
+        }
+    }
+    for (pos = &obj_tmp->retired; NULL != *pos;) {
+        dbrcu *cur = *pos;
+        if (cur->epoch < min_epoch) {
+            *pos = cur->next;
+            --obj_tmp->nretired;
+            dbmem_payload_free(obj_tmp, cur);
+        } else {
+            pos = &cur->next;
+        }
+    }
+}
+
+// 开始修改测点，顺序计数变为奇数
+static inline void dbmem_write_begin(dbvar *var)
+{
+    __atomic_store_n(&var->seq, var->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// 结束修改测点，顺序计数恢复为偶数
+static inline void dbmem_write_end(dbvar *var)
+{
+    __atomic_store_n(&var->seq, var->seq + 1, __ATOMIC_RELEASE);
+}
+
+// 数值类型的字长，字符串和二进制数据为0
+static const uint8_t m_type_len[] = {
+    0, 1, 1, 2, 2, 4, 4, 8, 8, 4, 8, 0, 0, 4
+};
+
+// 列存储对象开始修改，整个对象的顺序计数变为奇数
+static inline void dbmem_soa_begin(objsys *obj_tmp)
+{
+    __atomic_store_n(&obj_tmp->soa_seq, obj_tmp->soa_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void dbmem_soa_end(objsys *obj_tmp)
+{
+    __atomic_store_n(&obj_tmp->soa_seq, obj_tmp->soa_seq + 1, __ATOMIC_RELEASE);
+}
+
+// 列存储对象的读者等待写入结束，返回开始时的顺序计数
+static inline uint32_t dbmem_soa_read_begin(const objsys *obj_tmp)
+{
+    uint32_t seq;
+
+    while ((seq = __atomic_load_n(&obj_tmp->soa_seq, __ATOMIC_ACQUIRE)) & 1) {
+        sched_yield();
+    }
+    return seq;
+}
+
+// 列存储对象的读者检查读取期间是否有写入，有写入时需要重读
+static inline int dbmem_soa_read_retry(const objsys *obj_tmp, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&obj_tmp->soa_seq, __ATOMIC_RELAXED) != seq;
+}
+
+// 记录测点变化，没有通道打开时只有一次判断，调用者持有对象写锁
+static inline void dbmem_mark(objsys *obj_tmp, int pos)
+{
+    if (0 != obj_tmp->watch) {
+        uint64_t bit = 1ULL << (pos & 63);
+        for (int chan = 0; chan < DBMEM_WATCH_CHANS; ++chan) {
+            uint64_t *dirty = obj_tmp->dirty[chan];
+            if (NULL != dirty && !(dirty[pos >> 6] & bit)) {
+                dirty[pos >> 6] |= bit;
+                ++obj_tmp->ndirty[chan];
+            }
+        }
+    }
+}
+
+// 把测点同步到共享内存的测点槽，调用者持有对象写锁
+static void dbmem_publish(objsys *obj_tmp, int pos)
+{
+    dbshm_slot *slot = obj_tmp->shm + pos;
+
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        slot->type = obj_tmp->soa_type[pos];
+        slot->len  = m_type_len[slot->type];
+        slot->u64  = obj_tmp->soa_val[pos];
+    } else {
+        const dbvar *var = &obj_tmp->property[pos];
+        slot->type = var->type;
+        slot->len  = var->len;
+        if (DB_STRING == var->type || DB_BLOB == var->type) {
+            const void *data = (DB_STRING == var->type) ? (const void *)dbvar_str(var) : dbvar_blob(var);
+            uint32_t n = var->len < DBSHM_DATA ? var->len : DBSHM_DATA;
+            memcpy(slot->data, data, n);
+            if (n < DBSHM_DATA) {
+                slot->data[n] = '\0';
+            }
+        } else {
+            slot->u64 = var->u64;
+        }
+    }
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+}
+
+// 把测点的新值追加到历史记录，字符串和二进制数据不记录，调用者持有对象写锁
+static void dbmem_record(objsys *obj_tmp, int pos)
+{
+    int type;
+    uint64_t raw;
+
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        type = obj_tmp->soa_type[pos];
+        raw  = obj_tmp->soa_val[pos];
+    } else {
+        type = obj_tmp->property[pos].type;
+        raw  = obj_tmp->property[pos].u64;
+    }
+    if (0 != m_type_len[type]) {
+        dbhist_append(obj_tmp->hist, pos, dbhist_now(), type, raw);
+    }
+}
+
+// 测点写入后记录变化、同步共享内存并追加历史，都没有打开时只有三次判断
+static inline void dbmem_touch(objsys *obj_tmp, int pos)
+{
+    dbmem_mark(obj_tmp, pos);
+    if (NULL != obj_tmp->shm) {
+        dbmem_publish(obj_tmp, pos);
+    }
+    if (NULL != obj_tmp->hist) {
+        dbmem_record(obj_tmp, pos);
+    }
+}
+
+// 按编号查找对象，两次数组访问，不存在时返回NULL
+static inline objsys *dbmem_find(uint16_t obj_id)
+{
+    objpage *page = __atomic_load_n(&m_objdir[obj_id >> DBMEM_DIR_BITS], __ATOMIC_ACQUIRE);
+
+    if (NULL == page) {
+        return NULL;
+    }
+    return __atomic_load_n(&page->obj[obj_id & DBMEM_DIR_MASK], __ATOMIC_ACQUIRE);
+}
 
 // 对象编号查询
 int dbmem_get_id(uint16_t id)
 {
-    return (m_objid[id >> 3] >> (id & 7)) & 1;
+    return NULL != dbmem_find(id);
 }
-// 对象编号设置
-void dbmem_set_id(uint16_t id)
+
+// 查找编号大于obj_id的下一个对象，没有时返回-1.遍历所有对象时从-1开始，空页整页跳过
+int dbmem_next_obj(int obj_id)
 {
-    m_objid[id >> 3] |= 1 << (id & 7);
+    for (int id = obj_id + 1; id <= 0xFFFF;) {
+        objpage *page = __atomic_load_n(&m_objdir[id >> DBMEM_DIR_BITS], __ATOMIC_ACQUIRE);
+        if (NULL == page || 0 == __atomic_load_n(&page->count, __ATOMIC_RELAXED)) {
+            id = ((id >> DBMEM_DIR_BITS) + 1) << DBMEM_DIR_BITS;
+            continue;
+        }
+        for (; id <= 0xFFFF; ++id) {
+            if (NULL != __atomic_load_n(&page->obj[id & DBMEM_DIR_MASK], __ATOMIC_ACQUIRE)) {
+                return id;
+            }
+            if (DBMEM_DIR_MASK == (id & DBMEM_DIR_MASK)) {
+                ++id;
+                break;
+            }
+        }
+    }
+    return -1;
 }
-// 删除对象编号
-void dbmem_clear_id(uint16_t id)
+
+// 对象数量
+uint32_t dbmem_obj_count(void)
 {
-    m_objid[id >> 3] &= ~(1 << (id & 7));
+    return __atomic_load_n(&m_objnum, __ATOMIC_RELAXED);
 }
 
 // 希尔排序
@@ -106,24 +553,24 @@ void dbmem_shell_sort(uint16_t arr[], int num)
 // Author         :llemmx    
 // Date           :2017-07-31
 // Description    :折半查找，由于数组较小所以折半查找效率很高
-// Input          :obj_id:对象编号
+// Input          :obj_tmp:对象
 //                :id:属性测点编号
 // Output         :无
 // Return         :无
 //------------------------------------------------------------------------------
 // Modification History: 
 // 2018-07-31 (llemmx): 创建
+// 2026-10-17 (llemmx): 直接传入对象，由调用者完成目录查找；修正编号不存在时死循环的问题
 //------------------------------------------------------------------------------
-dbvar *dbmem_binary_search(uint16_t obj_id, uint16_t id)
+dbvar *dbmem_binary_search(objsys *obj_tmp, uint16_t id)
 {
     // 内部函数，已经确保参数正确
-    objsys *obj_tmp = m_objsys[obj_id];
     uint16_t head = 0, end = obj_tmp->psize, idx=0;
     
     while (head < end) {
         idx = (head + end) >> 1;
         if (id > obj_tmp->property[idx].id) {
-            head = idx;
+            head = idx + 1;
         } else if (id < obj_tmp->property[idx].id) {
             end  = idx;
         } else {
@@ -133,239 +580,1293 @@ dbvar *dbmem_binary_search(uint16_t obj_id, uint16_t id)
     return NULL;
 }
 
+// 取得第pos个测点的编号，与存储布局无关
+static inline uint16_t dbmem_pid(const objsys *obj_tmp, int pos)
+{
+    return DBMEM_LAYOUT_SOA == obj_tmp->layout ? obj_tmp->soa_id[pos] : obj_tmp->property[pos].id;
+}
+
+// 查找第一个编号不小于id的测点位置
+static int dbmem_lower_bound(const objsys *obj_tmp, uint16_t id)
+{
+    int head = 0, end = obj_tmp->psize;
+
+    while (head < end) {
+        int idx = (head + end) >> 1;
+        if (dbmem_pid(obj_tmp, idx) < id) {
+            head = idx + 1;
+        } else {
+            end = idx;
+        }
+    }
+    return head;
+}
+
+// 按中序遍历把有序的测点填入Eytzinger表，k为当前节点，返回下一个待填入的有序位置
+static int dbmem_eytz_fill(objsys *obj_tmp, dbeytz *eytz, int pos, int k)
+{
+    if (k <= obj_tmp->psize) {
+        pos = dbmem_eytz_fill(obj_tmp, eytz, pos, 2 * k);
+        eytz[k].id  = dbmem_pid(obj_tmp, pos);
+        eytz[k].pos = pos;
+        ++pos;
+        pos = dbmem_eytz_fill(obj_tmp, eytz, pos, 2 * k + 1);
+    }
+    return pos;
+}
+
 //------------------------------------------------------------------------------
-// Function       :dbmem_create_obj
-// Author         :llemmx    
-// Date           :2017-07-31
-// Description    :创建设备对象
-// Input          :obj_id:对象编号
-//                :name:对象名称
-//                :size:对象属性的个数，注意不是字节数
+// Function       :dbmem_build_index
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :为对象建立测点索引.最大编号不超过测点数量的DBMEM_DIRECT_RATIO倍时使用
+//                 直接映射表，查找只需要一次数组访问；否则使用Eytzinger布局，查找时按
+//                 固定模式下降，分支可预测且缓存友好.测点必需已经按编号排序
+// Input          :obj_tmp:对象
 // Output         :无
 // Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
 //------------------------------------------------------------------------------
-// Modification History: 
-// 2017-07-31 (llemmx): 创建
+// Modification History:
+// 2026-10-17 (llemmx): 创建
 //------------------------------------------------------------------------------
-int dbmem_create_obj(uint16_t obj_id, const char *name, int size)
+static int dbmem_build_index(objsys *obj_tmp)
+{
+    int num = obj_tmp->psize;
+
+    free(obj_tmp->direct);
+    obj_tmp->direct   = NULL;
+    obj_tmp->idx_kind = DBMEM_IDX_NONE;
+    obj_tmp->idx_size = 0;
+    if (0 == num) {
+        return OBJSYS_RET_OK;
+    }
+    int max_id = dbmem_pid(obj_tmp, num - 1);
+    if (max_id + 1 <= num * DBMEM_DIRECT_RATIO) {
+        uint16_t *direct = (uint16_t*)calloc(max_id + 1, sizeof(uint16_t));
+        if (NULL == direct) {
+            return OBJSYS_RET_FMEM;
+        }
+        for (int pos = 0; pos < num; ++pos) {
+            direct[dbmem_pid(obj_tmp, pos)] = pos + 1;
+        }
+        obj_tmp->direct   = direct;
+        obj_tmp->idx_size = max_id + 1;
+        obj_tmp->idx_kind = DBMEM_IDX_DIRECT;
+    } else {
+        dbeytz *eytz = (dbeytz*)malloc(sizeof(dbeytz) * (num + 1));
+        if (NULL == eytz) {
+            return OBJSYS_RET_FMEM;
+        }
+        eytz[0].id  = 0;
+        eytz[0].pos = 0;
+        dbmem_eytz_fill(obj_tmp, eytz, 0, 1);
+        obj_tmp->eytz     = eytz;
+        obj_tmp->idx_size = num;
+        obj_tmp->idx_kind = DBMEM_IDX_EYTZ;
+    }
+    return OBJSYS_RET_OK;
+}
+
+// 按编号查找测点位置，不存在时返回-1
+static inline int dbmem_locate(objsys *obj_tmp, uint16_t id)
+{
+    if (DBMEM_IDX_DIRECT == obj_tmp->idx_kind) {
+        if (id >= obj_tmp->idx_size) {
+            return -1;
+        }
+        return (int)obj_tmp->direct[id] - 1;
+    }
+    if (DBMEM_IDX_EYTZ == obj_tmp->idx_kind) {
+        const dbeytz *eytz = obj_tmp->eytz;
+        uint32_t k = 1, num = obj_tmp->idx_size;
+        // 下降过程只有比较结果参与计算，没有数据相关的分支
+        while (k <= num) {
+            k = 2 * k + (eytz[k].id < id);
+        }
+        // 去掉最后连续向右下降的步数，得到第一个不小于id的节点
+        k >>= __builtin_ffs(~k);
+        if (0 == k || eytz[k].id != id) {
+            return -1;
+        }
+        return eytz[k].pos;
+    }
+    int pos = dbmem_lower_bound(obj_tmp, id);
+    return (pos < obj_tmp->psize && dbmem_pid(obj_tmp, pos) == id) ? pos : -1;
+}
+
+// 按编号查找测点，不存在或对象为列存储时返回NULL
+static inline dbvar *dbmem_lookup(objsys *obj_tmp, uint16_t id)
+{
+    if (DBMEM_LAYOUT_AOS != obj_tmp->layout) {
+        return NULL;
+    }
+    int pos = dbmem_locate(obj_tmp, id);
+    return (pos < 0) ? NULL : &obj_tmp->property[pos];
+}
+
+// 按指定布局创建对象，列存储对象的测点只占用编号、类型和数值各自的列
+static int dbmem_create(uint16_t obj_id, const char *name, int size, uint8_t layout)
 {
-    if (NULL == name || obj_id > DBMEM_MAX_OBJS) {
+    int result = OBJSYS_RET_OK;
+
+    if (NULL == name || size < 0 || size > 0xFFFF) {
         glog4c_err("Error param name\n");
         return OBJSYS_RET_PARAM;
     }
+    pthread_mutex_lock(&m_dir_lock);
+    // 目录页在第一次使用时申请
+    objpage *page = m_objdir[obj_id >> DBMEM_DIR_BITS];
+    if (NULL == page) {
+        page = (objpage*)calloc(1, sizeof(objpage));
+        if (NULL == page) {
+            glog4c_err(strerror(errno));
+            result = OBJSYS_RET_FMEM;
+            goto EXIT_CO;
+        }
+        __atomic_store_n(&m_objdir[obj_id >> DBMEM_DIR_BITS], page, __ATOMIC_RELEASE);
+    }
     //创建对象
-    if (dbmem_get_id(obj_id) == 0) {
-        // 在位表中注册对象
-        dbmem_set_id(obj_id);
+    if (NULL == page->obj[obj_id & DBMEM_DIR_MASK]) {
         // 根据属性数量分配空间，一般来说分配后不会随便改变数量
         objsys *obtmp;
-        obtmp = (objsys*)malloc(sizeof(objsys) + (sizeof(dbvar) * size));
+        size_t nvar = (DBMEM_LAYOUT_SOA == layout) ? 0 : (size_t)size;
+        obtmp = (objsys*)calloc(1, sizeof(objsys) + (sizeof(dbvar) * nvar));
         if (NULL == obtmp){
             glog4c_err(strerror(errno));
-            dbmem_clear_id(obj_id);
-            return OBJSYS_RET_FMEM;
+            result = OBJSYS_RET_FMEM;
+            goto EXIT_CO;
+        }
+        if (DBMEM_LAYOUT_SOA == layout) {
+            // 数值列按缓存行对齐，批量读取时整行搬运
+            obtmp->soa_id   = (uint16_t*)calloc(size + 1, sizeof(uint16_t));
+            obtmp->soa_type = (uint8_t*)calloc(size + 1, sizeof(uint8_t));
+            if (posix_memalign((void **)&obtmp->soa_val, DBMEM_CACHE_LINE, sizeof(uint64_t) * (size + 1)) != 0) {
+                obtmp->soa_val = NULL;
+            }
+            if (NULL == obtmp->soa_id || NULL == obtmp->soa_type || NULL == obtmp->soa_val) {
+                glog4c_err(strerror(errno));
+                free(obtmp->soa_id);
+                free(obtmp->soa_type);
+                free(obtmp->soa_val);
+                free(obtmp);
+                result = OBJSYS_RET_FMEM;
+                goto EXIT_CO;
+            }
+            memset(obtmp->soa_val, 0, sizeof(uint64_t) * (size + 1));
         }
         obtmp->obj_id = obj_id;
         obtmp->psize  = size;
-        strncpy(obtmp->name, name, DBMEM_OBJ_NAME_SIZE);
-        m_objsys[obj_id] = obtmp;
+        obtmp->layout = layout;
+        pthread_mutex_init(&obtmp->wlock, NULL);
+        strncpy(obtmp->name, name, DBMEM_OBJ_NAME_SIZE - 1);
+        // 对象初始化完毕后再公布到目录中
+        __atomic_store_n(&page->obj[obj_id & DBMEM_DIR_MASK], obtmp, __ATOMIC_RELEASE);
+        ++page->count;
+        __atomic_fetch_add(&m_objnum, 1, __ATOMIC_RELAXED);
     }else{
-        return OBJSYS_RET_IDUSED;
+        result = OBJSYS_RET_IDUSED;
     }
-    return OBJSYS_RET_OK;
+EXIT_CO:
+    pthread_mutex_unlock(&m_dir_lock);
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_create_obj
+// Author         :llemmx    
+// Date           :2017-07-31
+// Description    :创建设备对象
+// Input          :obj_id:对象编号
+//                :name:对象名称
+//                :size:对象属性的个数，注意不是字节数
+// Output         :无
+// Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History: 
+// 2017-07-31 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbmem_create_obj(uint16_t obj_id, const char *name, int size)
+{
+    return dbmem_create(obj_id, name, size, DBMEM_LAYOUT_AOS);
+}
+
+// 创建列存储对象，只能保存数值类型，适合大量遥测测点的批量扫描
+int dbmem_create_soa(uint16_t obj_id, const char *name, int size)
+{
+    return dbmem_create(obj_id, name, size, DBMEM_LAYOUT_SOA);
 }
 
 // 初始化对象属性值，在创建对象后就要立刻初始化
 int dbmem_init_values(uint16_t obj_id, uint16_t *var, uint16_t size)
 {
-    if (NULL == var || size == 0 || obj_id > DBMEM_MAX_OBJS) {
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (NULL == var || size == 0) {
         glog4c_err("Error param var\n");
         return OBJSYS_RET_PARAM;
     }
-    if (0 == dbmem_get_id(obj_id)){
+    if (NULL == obj_tmp){
         return OBJSYS_RET_UNKNOWOBJ;
     }
+    if (NULL != obj_tmp->shm) { // 共享内存布局已经固定，不能再改变测点
+        glog4c_err("Object is exported\n");
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL != obj_tmp->hist) { // 历史记录按测点位置建立
+        glog4c_err("Object has history\n");
+        return OBJSYS_RET_PARAM;
+    }
+    for (int idx = 0; idx < size; ++idx) {
+        if (var[idx] > DBMEM_MAX_PID) { // 超出12位的编号会在测点中被截断
+            glog4c_err("Error param var id\n");
+            return OBJSYS_RET_PARAM;
+        }
+    }
     //索引排序
     //测点顺序初始化，一旦初始化完毕后不可再变动
-    uint16_t  len = sizeof(uint16_t) * size;
+    size_t    len = sizeof(uint16_t) * size;
     uint16_t *tmp = (uint16_t*)malloc(len);
+    if (NULL == tmp) {
+        return OBJSYS_RET_FMEM;
+    }
     memcpy(tmp, var, len);
     // 对测点进行排序，为后面的快速查询做准备
     dbmem_shell_sort(tmp, size);
     // 初始化每个属性的编号
-    objsys *obj_tmp = m_objsys[obj_id];
     // 检查对象属性与设置的属性数量是否一致，如果不一致则仅按最大值初始化，记录警告
     int max_num = size > obj_tmp->psize ? obj_tmp->psize : size;
-    for (int id = 0; id < max_num; ++id) {
-        obj_tmp->property[id].id = tmp[id];
-        obj_tmp->property[id].u64 = 0; // 初始化为0，避免随机数
+    for (int id = 0; id < max_num && DBMEM_LAYOUT_SOA == obj_tmp->layout; ++id) {
+        obj_tmp->soa_id[id]   = tmp[id];
+        obj_tmp->soa_type[id] = DB_NULL;
+        obj_tmp->soa_val[id]  = 0;
+    }
+    for (int id = 0; id < max_num && DBMEM_LAYOUT_AOS == obj_tmp->layout; ++id) {
+        obj_tmp->property[id].id   = tmp[id];
+        obj_tmp->property[id].type = DB_NULL;
+        obj_tmp->property[id].len  = 0;
+        obj_tmp->property[id].seq  = 0;
+        obj_tmp->property[id].u64  = 0; // 初始化为0，避免随机数
     }
+    // 测点少于创建时的数量时，未初始化的部分不参与查找
+    obj_tmp->psize = max_num;
 
     free(tmp);
-    return OBJSYS_RET_OK;
+    return dbmem_build_index(obj_tmp);
 }
 
-//保存单条对象数据
-int dbmem_set_value(uint16_t obj_id, uint16_t var_id, int type, void *value, uint32_t size)
+// 将数值转换为对应变量，字符串和二进制数据不在这里处理
+static void dbmem_scalar(dbvar *var_tmp, int type, const void *value)
 {
-    int result = OBJSYS_RET_OK;
-    
-    // 参数检查
-    if (NULL == value) {
-        glog4c_info("Paramater is error!\n");
-        result = OBJSYS_RET_PARAM;
-        goto EXIT_SV;
+    var_tmp->u64 = 0; // 高位清0，保存的原始值与dbconv_widen的结果一致
+    switch (type){
+    case DB_INT8:
+        var_tmp->i8  = *(int8_t*)value;
+        var_tmp->len = sizeof(int8_t);
+    break;
+    case DB_UINT8:
+        var_tmp->u8  = *(uint8_t*)value;
+        var_tmp->len = sizeof(uint8_t);
+    break;
+    case DB_INT16:
+        var_tmp->i16  = *(int16_t*)value;
+        var_tmp->len  = sizeof(int16_t);
+    break;
+    case DB_UINT16:
+        var_tmp->u16  = *(uint16_t*)value;
+        var_tmp->len  = sizeof(uint16_t);
+    break;
+    case DB_INT32:
+        var_tmp->i32  = *(int32_t*)value;
+        var_tmp->len  = sizeof(int32_t);
+    break;
+    case DB_UINT32:
+        var_tmp->u32 = *(uint32_t*)value;
+        var_tmp->len = sizeof(uint32_t);
+    break;
+    case DB_INT64:
+        var_tmp->i64  = (*(int64_t*)value);
+        var_tmp->len  = sizeof(int64_t);
+    break;
+    case DB_UINT64:
+        var_tmp->u64 = (*(uint64_t*)value);
+        var_tmp->len = sizeof(uint64_t);
+    break;
+    case DB_FLOAT:
+        var_tmp->f  = (*(float*)value);
+        var_tmp->len = sizeof(float);
+    break;
+    case DB_DOUBLE:
+        var_tmp->d = (*(double*)value);
+        var_tmp->len = sizeof(double);
+    break;
+    case DB_BOOL:
+        var_tmp->bl   = *(int32_t*)value;
+        var_tmp->len  = sizeof(int32_t);
+    break;
+    default:
+        var_tmp->len = 0;
     }
+}
 
-    // 目前只存储一个配置文件路径
-    if (dbmem_get_id(obj_id) == 1) {
-        // 取出对应的对象
-        dbvar *var_tmp = dbmem_binary_search(obj_id, var_id);
-        if (var_tmp == NULL){
-            glog4c_info("We can't find id form obj_id=%d\n", obj_id);
-            result = OBJSYS_RET_UNKNOWOBJ;
-            goto EXIT_SV;
+//------------------------------------------------------------------------------
+// Function       :dbmem_store
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :将数据按类型保存到测点中.短字符串和短二进制数据直接保存在测点内；其他的
+//                 先从内存池申请新空间再回收旧空间，申请失败时测点保持原值.调用者持有对象写锁
+// Input          :obj_tmp:测点所属对象
+//                :var_tmp:测点
+//                :type:数据类型
+//                :value:数据
+//                :size:字符串和二进制数据的长度，单位B
+// Output         :无
+// Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 从dbmem_set_value中拆分，单条和批量写入共用
+//------------------------------------------------------------------------------
+static int dbmem_store(objsys *obj_tmp, dbvar *var_tmp, int type, const void *value, uint32_t size)
+{
+    void *mem = NULL, *old = NULL;
+    int sso = 0;
+
+    // 为字符串和二进制数据分配空间，数据在公布指针之前准备好
+    if (DB_STRING == type || DB_BLOB == type) {
+        if (size > 0xFFFF) { // 长度字段只有16位
+            return OBJSYS_RET_PARAM;
         }
-        char *str    = NULL;
-        //uint8_t *buf = NULL;
-        //int size     = 0;
-
-        //如果设置的数据类型不一致，并且是字符串等需要重新释放
-        if (DB_STRING == var_tmp->type) {
-            free(var_tmp->str);
-        } else if (DB_BLOB == var_tmp->type) {
-            free(var_tmp->blob);
-        }
-        if (type != var_tmp->type) {
-            var_tmp->type = type;
-        }
-
-        // 将数据转换为对应变量
-        switch (type){
-        case DB_INT8:
-            var_tmp->i8  = (*(int8_t*)value) & 0xFF;
-            var_tmp->len = sizeof(int8_t);
-        break;
-        case DB_UINT8:
-            var_tmp->u8  = (*(uint8_t*)value) & 0xFF;
-            var_tmp->len = sizeof(uint8_t);
-        break;
-        case DB_INT16:
-            var_tmp->i16  = (*(int16_t*)value) & 0xFFFF;
-            var_tmp->len  = sizeof(int16_t);
-        break;
-        case DB_UINT16:
-            var_tmp->u16  = (*(uint16_t*)value) & 0xFFFF;
-            var_tmp->len  = sizeof(uint16_t);
-        break;
-        case DB_INT32:
-            var_tmp->i32  = (*(int32_t*)value) & 0xFFFFFFFF;
-            var_tmp->len  = sizeof(int32_t);
-        break;
-        case DB_UINT32:
-            var_tmp->u32 = (*(uint32_t*)value) & 0xFFFFFFFF;
-            var_tmp->len = sizeof(uint32_t);
-        break;
-        case DB_INT64:
-            var_tmp->i64  = (*(int64_t*)value);
-            var_tmp->len  = sizeof(int64_t);
-        break;
-        case DB_UINT64:
-            var_tmp->u64 = (*(uint64_t*)value);
-            var_tmp->len = sizeof(uint64_t);
-        break;
-        case DB_FLOAT:
-            var_tmp->f  = (*(float*)value);
-            var_tmp->len = sizeof(float);
-        break;
-        case DB_DOUBLE:
-            var_tmp->d = (*(double*)value);
-            var_tmp->len = sizeof(double);
-        break;
-        case DB_STRING: // 保存字符串格式，单位B
-            // 取出字符串
-            str = (char*)value;
-            /*if (NULL == str) {
-                result = OBJSYS_RET_PARAM;
-                goto EXIT_SV;
-            }*/
-            // 为测点分配空间
-            var_tmp->str = (char*)malloc(size + 1);
-            if (NULL == var_tmp->str){
+        sso = size <= (DB_STRING == type ? DBVAR_SSO_STR : DBVAR_SSO_BLOB);
+        if (!sso) {
+            mem = dbmem_payload_alloc(obj_tmp, DB_STRING == type ? size + 1 : size);
+            if (NULL == mem) {
                 glog4c_err(strerror(errno));
-                result = OBJSYS_RET_FMEM;
-                goto EXIT_SV;
+                return OBJSYS_RET_FMEM;
             }
-            // 拷贝字符串, 这里必需用安全字符串拷贝，否则发生过缓冲溢出的问题
-            strncpy(var_tmp->str, str, size);
-            var_tmp->str[size] = '\0';
-            var_tmp->len = size;
-        break;
-        case DB_BLOB: // 保存二进制数据，单位B;这里取值时需要注意还有大小参数
-            {
-                // 取出数组
-                /*uint8_t *buf = (uint8_t*)value;
-                if (NULL == buf) {
-                    result = OBJSYS_RET_PARAM;
-                    goto EXIT_SV;
-                }*/
-                // 为测点分配空间
-                var_tmp->blob = (uint8_t*)malloc(size);
-                if (NULL == var_tmp->blob){
-                    glog4c_err(strerror(errno));
-                    result = OBJSYS_RET_FMEM;
-                    goto EXIT_SV;
-                }
-                memcpy(var_tmp->blob, (uint8_t*)value, size);
-                var_tmp->len = size;
+            memcpy(mem, value, size);
+            if (DB_STRING == type) {
+                ((char *)mem)[size] = '\0';
             }
-        break;
-        case DB_BOOL:
-            var_tmp->bl   = (*(int32_t*)value) & 0xFFFFFFFF;
-            var_tmp->len  = sizeof(int32_t);
-        break;
-        default:
-            var_tmp->len = 0;
         }
     }
-EXIT_SV:
-    return result;
-}
+    //如果原来保存的是字符串等，替换后延迟回收
+    if ((DB_STRING == var_tmp->type && var_tmp->len > DBVAR_SSO_STR)
+        || (DB_BLOB == var_tmp->type && var_tmp->len > DBVAR_SSO_BLOB)) {
+        old = var_tmp->str;
+    }
 
-//读取单条对象数据指针
-dbvar *dbmem_get_value(uint16_t obj_id, uint16_t var_id)
-{
+    dbmem_write_begin(var_tmp);
+    if (type != var_tmp->type) {
+        var_tmp->type = type;
+    }
+
+    // 将数据转换为对应变量
+    switch (type){
+    case DB_STRING: // 保存字符串格式，单位B，结尾已经补0
+        if (sso) {
+            memset(var_tmp->sso, 0, sizeof(var_tmp->sso));
+            memcpy(var_tmp->sso, value, size);
+        } else {
+            var_tmp->str = (char*)mem;
+        }
+        var_tmp->len = size;
+    break;
+    case DB_BLOB: // 保存二进制数据，单位B;这里取值时需要注意还有大小参数
+        if (sso) {
+            memcpy(var_tmp->sso, value, size);
+        } else {
+            var_tmp->blob = (uint8_t*)mem;
+        }
+        var_tmp->len = size;
+    break;
+    default:
+        dbmem_scalar(var_tmp, type, value);
+    }
+    dbmem_write_end(var_tmp);
+    dbmem_touch(obj_tmp, (int)(var_tmp - obj_tmp->property));
+
+    if (NULL != old) {
+        dbmem_retire(obj_tmp, old);
+    }
+    return OBJSYS_RET_OK;
+}
+
+// 保存列存储对象的数值，调用者持有对象写锁并已经开始修改
+static int dbmem_soa_store(objsys *obj_tmp, int pos, int type, const void *value)
+{
+    dbvar tmp;
+
+    if (DB_STRING == type || DB_BLOB == type || type >= (int)sizeof(m_type_len)) {
+        return OBJSYS_RET_TYPE;
+    }
+    dbmem_scalar(&tmp, type, value);
+    obj_tmp->soa_type[pos] = type;
+    obj_tmp->soa_val[pos]  = tmp.u64;
+    dbmem_touch(obj_tmp, pos);
+    return OBJSYS_RET_OK;
+}
+
+// 按存储布局保存一个测点，调用者持有对象写锁
+static int dbmem_put(objsys *obj_tmp, uint16_t var_id, int type, const void *value, uint32_t size)
+{
+    int pos = dbmem_locate(obj_tmp, var_id);
+
+    if (pos < 0) {
+        return OBJSYS_RET_UNKNOWID;
+    }
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        return dbmem_soa_store(obj_tmp, pos, type, value);
+    }
+    return dbmem_store(obj_tmp, &obj_tmp->property[pos], type, value, size);
+}
+
+//保存单条对象数据
+int dbmem_set_value(uint16_t obj_id, uint16_t var_id, int type, void *value, uint32_t size)
+{
+    int result = OBJSYS_RET_OK;
+    
+    // 参数检查
+    if (NULL == value) {
+        glog4c_warn("Paramater is error!\n");
+        result = OBJSYS_RET_PARAM;
+        goto EXIT_SV;
+    }
+
+    // 取出对应的对象
+    objsys *obj_tmp = dbmem_find(obj_id);
+    if (NULL != obj_tmp) {
+        if (dbmem_locate(obj_tmp, var_id) < 0){
+            glog4c_debug("We can't find id form obj_id=%d\n", obj_id);
+            result = OBJSYS_RET_UNKNOWOBJ;
+            goto EXIT_SV;
+        }
+        uint64_t start = metric_begin(METRIC_H_DB_SET);
+        pthread_mutex_lock(&obj_tmp->wlock);
+        if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+            dbmem_soa_begin(obj_tmp);
+        }
+        result = dbmem_put(obj_tmp, var_id, type, value, size);
+        if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+            dbmem_soa_end(obj_tmp);
+        }
+        pthread_mutex_unlock(&obj_tmp->wlock);
+        metric_end(METRIC_H_DB_SET, start);
+        metric_add(METRIC_DB_SET, OBJSYS_RET_OK == result);
+    }
+EXIT_SV:
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_set_values
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :批量保存同一对象的多条数据.对象只检查一次，写锁只获取一次，测点位置通过
+//                 对象索引O(1)取得，编号顺序不影响效率.未知测点跳过，不影响其他测点.
+//                 列存储对象整批只修改一次顺序计数，读者看到的是整批写入前或写入后的状态
+// Input          :obj_id:对象编号
+//                :ids:测点编号数组
+//                :types:数据类型数组
+//                :values:数据指针数组
+//                :sizes:字符串和二进制数据的长度数组，全部是定长类型时可以为NULL
+//                :num:数组长度
+// Output         :无
+// Return         :成功返回保存的测点数量,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 游标归并查找改为索引查找
+//------------------------------------------------------------------------------
+int dbmem_set_values(uint16_t obj_id, const uint16_t *ids, const uint8_t *types,
+    const void *const *values, const uint32_t *sizes, int num)
+{
+    int count = 0, unknow = 0;
+
+    if (NULL == ids || NULL == types || NULL == values || num < 0) {
+        glog4c_warn("Paramater is error!\n");
+        return OBJSYS_RET_PARAM;
+    }
+    objsys *obj_tmp = dbmem_find(obj_id);
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+
+    uint64_t start = metric_begin(METRIC_H_DB_SET);
+    pthread_mutex_lock(&obj_tmp->wlock);
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        dbmem_soa_begin(obj_tmp);
+    }
+    for (int idx = 0; idx < num; ++idx) {
+        if (NULL == values[idx]) {
+            ++unknow;
+            continue;
+        }
+        int ret = dbmem_put(obj_tmp, ids[idx], types[idx], values[idx], NULL == sizes ? 0 : sizes[idx]);
+        if (OBJSYS_RET_OK == ret) {
+            ++count;
+        } else if (OBJSYS_RET_UNKNOWID == ret) {
+            ++unknow;
+        }
+    }
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        dbmem_soa_end(obj_tmp);
+    }
+    pthread_mutex_unlock(&obj_tmp->wlock);
+    metric_end(METRIC_H_DB_SET, start);
+    metric_add(METRIC_DB_SET, count);
+    if (unknow > 0) {
+        glog4c_debug("Skip %d unknow ids form obj_id=%d\n", unknow, obj_id);
+    }
+    return count;
+}
+
+// 保存整块写入中已经转换好的原始值，调用者持有对象写锁
+static void dbmem_put_raw(objsys *obj_tmp, int pos, int type, uint64_t raw, const void *value)
+{
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        obj_tmp->soa_type[pos] = type;
+        obj_tmp->soa_val[pos]  = raw;
+        dbmem_touch(obj_tmp, pos);
+        return;
+    }
+    dbvar *var_tmp = &obj_tmp->property[pos];
+    if (DB_STRING == var_tmp->type || DB_BLOB == var_tmp->type) {
+        // 原来的字符串或二进制数据需要回收，走普通保存流程
+        dbmem_store(obj_tmp, var_tmp, type, value, 0);
+        return;
+    }
+    dbmem_write_begin(var_tmp);
+    var_tmp->type = type;
+    var_tmp->len  = m_type_len[type];
+    var_tmp->u64  = raw;
+    dbmem_write_end(var_tmp);
+    dbmem_touch(obj_tmp, pos);
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_set_block
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :保存编号连续、类型相同的一块数值，例如一次轮询读到的寄存器.整块先转换为
+//                 原始值，再与保存的值比较，只写入变化的测点.死区大于0时差的绝对值超过死区
+//                 才算变化，类型不同的测点总是算变化.转换和比较使用dbconv中的向量化实现.
+//                 死区小于0(DBMEM_BAND_ALL)时不比较，每个已知测点都写入并标记变化，历史、
+//                 订阅和日志与dbmem_set_values逐个写入相同.列存储对象整块只修改一次顺序
+//                 计数.未知测点跳过
+// Input          :obj_id:对象编号
+//                :id_start:第一个测点的编号
+//                :type:数据类型，只支持定长数值类型
+//                :values:数值数组，DB_BOOL为int32_t数组
+//                :num:数组长度
+//                :deadband:死区，等于0时只要数值不同就写入，小于0时全部写入
+// Output         :changed:变化位图，第k个测点对应changed[k/32]的第k%32位，长度为(num+31)/32，
+//                 可以为NULL
+// Return         :成功返回写入的测点数量,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 增加DBMEM_BAND_ALL
+//------------------------------------------------------------------------------
+int dbmem_set_block(uint16_t obj_id, uint16_t id_start, int type, const void *values,
+    int num, double deadband, uint32_t *changed)
+{
+    uint64_t nraw[DBMEM_BLOCK_CHUNK], oraw[DBMEM_BLOCK_CHUNK];
+    double   nval[DBMEM_BLOCK_CHUNK], oval[DBMEM_BLOCK_CHUNK];
+    int16_t  pos[DBMEM_BLOCK_CHUNK];
+    uint32_t diff[DBMEM_BLOCK_CHUNK / 32], band[DBMEM_BLOCK_CHUNK / 32];
+    uint32_t force[DBMEM_BLOCK_CHUNK / 32], miss[DBMEM_BLOCK_CHUNK / 32];
+    int count = 0;
+
+    if (NULL == values || num <= 0 || (int)id_start + num - 1 > DBMEM_MAX_PID
+        || type <= DB_NULL || type >= (int)sizeof(m_type_len) || DB_STRING == type || DB_BLOB == type) {
+        return OBJSYS_RET_PARAM;
+    }
+    objsys *obj_tmp = dbmem_find(obj_id);
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    int width = m_type_len[type];
+
+    uint64_t start = metric_begin(METRIC_H_DB_SET);
+    pthread_mutex_lock(&obj_tmp->wlock);
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        dbmem_soa_begin(obj_tmp);
+    }
+    for (int base = 0; base < num; base += DBMEM_BLOCK_CHUNK) {
+        int n = num - base < DBMEM_BLOCK_CHUNK ? num - base : DBMEM_BLOCK_CHUNK;
+        const uint8_t *src = (const uint8_t *)values + base * width;
+
+        dbconv_widen(type, src, n, nraw);
+        memset(force, 0, sizeof(force));
+        memset(miss, 0, sizeof(miss));
+
+        // 测点按编号有序保存，从第一个编号的位置开始顺序归并取得旧值
+        int cur = dbmem_lower_bound(obj_tmp, id_start + base);
+        for (int k = 0; k < n; ++k) {
+            uint16_t id = id_start + base + k;
+            uint8_t otype;
+            if (cur >= obj_tmp->psize || dbmem_pid(obj_tmp, cur) != id) {
+                pos[k]  = -1;
+                oraw[k] = nraw[k];
+                miss[k / 32] |= 1u << (k % 32);
+                continue;
+            }
+            pos[k] = cur;
+            if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+                otype   = obj_tmp->soa_type[cur];
+                oraw[k] = obj_tmp->soa_val[cur];
+            } else {
+                otype   = obj_tmp->property[cur].type;
+                oraw[k] = obj_tmp->property[cur].u64;
+            }
+            if (otype != type) {
+                force[k / 32] |= 1u << (k % 32);
+            }
+            ++cur;
+        }
+
+        if (deadband < 0) {
+            memset(diff, 0xFF, sizeof(diff));
+        } else {
+            dbconv_diff(nraw, oraw, n, diff);
+        }
+        if (deadband > 0) {
+            dbconv_to_double(type, nraw, n, nval);
+            dbconv_to_double(type, oraw, n, oval);
+            dbconv_band(nval, oval, n, deadband, band);
+        }
+        for (int w = 0; w < (n + 31) / 32; ++w) {
+            uint32_t bits = diff[w];
+            if (deadband > 0) {
+                bits &= band[w];
+            }
+            bits = (bits | force[w]) & ~miss[w];
+            if (w == (n - 1) / 32 && 0 != n % 32) {
+                bits &= (1u << (n % 32)) - 1;
+            }
+            if (NULL != changed) {
+                changed[(base >> 5) + w] = bits;
+            }
+            count += __builtin_popcount(bits);
+            while (bits) {
+                int k = w * 32 + __builtin_ctz(bits);
+                bits &= bits - 1;
+                dbmem_put_raw(obj_tmp, pos[k], type, nraw[k], src + k * width);
+            }
+        }
+    }
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        dbmem_soa_end(obj_tmp);
+    }
+    pthread_mutex_unlock(&obj_tmp->wlock);
+    metric_end(METRIC_H_DB_SET, start);
+    metric_add(METRIC_DB_SET, count);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_watch
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :打开或关闭对象在一个通道上的变化记录.打开后每次写入在该通道的变化位图中
+//                 标记测点位置，同一测点多次写入只标记一次，由dbmem_take_dirty取走；关闭时
+//                 丢弃未取走的变化.各通道互不影响，订阅和日志分别使用自己的通道
+// Input          :obj_id:对象编号
+//                :chan:通道，DBMEM_WATCH_*
+//                :on:非0打开，0关闭
+// Output         :无
+// Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 增加通道
+//------------------------------------------------------------------------------
+int dbmem_watch(uint16_t obj_id, int chan, int on)
+{
+    uint64_t *mem = NULL, *old = NULL;
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (chan < 0 || chan >= DBMEM_WATCH_CHANS) {
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    if (on) {
+        mem = (uint64_t *)calloc(DBMEM_DIRTY_WORDS, sizeof(uint64_t));
+        if (NULL == mem) {
+            return OBJSYS_RET_FMEM;
+        }
+    }
+    pthread_mutex_lock(&obj_tmp->wlock);
+    if (!on || NULL == obj_tmp->dirty[chan]) {
+        old = obj_tmp->dirty[chan];
+        obj_tmp->dirty[chan]  = mem;
+        obj_tmp->ndirty[chan] = 0;
+        obj_tmp->watch = on ? (obj_tmp->watch | (1 << chan)) : (obj_tmp->watch & ~(1 << chan));
+        mem = NULL;
+    }
+    pthread_mutex_unlock(&obj_tmp->wlock);
+    // 写入者只在写锁内使用位图，解锁后可以直接释放
+    free(old);
+    free(mem);
+    return OBJSYS_RET_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_take_dirty
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :取走对象在一个通道上有变化的测点编号并清除对应标记，编号按升序输出.超过
+//                 max的变化保留到下一次
+// Input          :obj_id:对象编号
+//                :chan:通道，DBMEM_WATCH_*
+//                :max:输出数组的容量
+// Output         :ids:有变化的测点编号
+// Return         :成功返回输出的数量,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 增加通道
+//------------------------------------------------------------------------------
+int dbmem_take_dirty(uint16_t obj_id, int chan, uint16_t *ids, int max)
+{
+    int count = 0;
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (NULL == ids || max < 0 || chan < 0 || chan >= DBMEM_WATCH_CHANS) {
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    pthread_mutex_lock(&obj_tmp->wlock);
+    uint64_t *dirty = obj_tmp->dirty[chan];
+    if (NULL == dirty || 0 == obj_tmp->ndirty[chan]) {
+        pthread_mutex_unlock(&obj_tmp->wlock);
+        return 0;
+    }
+    // 测点位置与编号的顺序一致，按位置扫描得到的编号是有序的
+    for (int w = 0; w < DBMEM_DIRTY_WORDS && count < max; ++w) {
+        uint64_t bits = dirty[w];
+        while (bits && count < max) {
+            int b = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            dirty[w] &= ~(1ULL << b);
+            ids[count++] = dbmem_pid(obj_tmp, w * 64 + b);
+        }
+    }
+    obj_tmp->ndirty[chan] -= count;
+    pthread_mutex_unlock(&obj_tmp->wlock);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_put_dirty
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :重新标记一个通道上的变化，用于取走变化后处理失败(例如日志写入失败)时
+//                 放回，下次dbmem_take_dirty再次取得.只修改该通道，已经标记的和未知测点跳过
+// Input          :obj_id:对象编号
+//                :chan:通道，DBMEM_WATCH_*
+//                :ids:测点编号
+//                :num:数量
+// Output         :无
+// Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbmem_put_dirty(uint16_t obj_id, int chan, const uint16_t *ids, int num)
+{
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (NULL == ids || num < 0 || chan < 0 || chan >= DBMEM_WATCH_CHANS) {
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    pthread_mutex_lock(&obj_tmp->wlock);
+    uint64_t *dirty = obj_tmp->dirty[chan];
+    for (int idx = 0; idx < num && NULL != dirty; ++idx) {
+        int pos = dbmem_lower_bound(obj_tmp, ids[idx]);
+        if (pos >= obj_tmp->psize || dbmem_pid(obj_tmp, pos) != ids[idx]) {
+            continue;
+        }
+        uint64_t bit = 1ULL << (pos & 63);
+        if (!(dirty[pos >> 6] & bit)) {
+            dirty[pos >> 6] |= bit;
+            ++obj_tmp->ndirty[chan];
+        }
+    }
+    pthread_mutex_unlock(&obj_tmp->wlock);
+    return OBJSYS_RET_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_history
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :为对象打开历史记录，之后每次写入数值测点都追加一个带时间的样本.打开后
+//                 不能再初始化测点，历史记录随对象在dbmem_close时释放
+// Input          :obj_id:对象编号
+//                :bytes:每个测点的压缩样本空间，按128字节的块取整，至少两个块
+// Output         :无
+// Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbmem_history(uint16_t obj_id, uint32_t bytes)
+{
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    if (0 == obj_tmp->psize || NULL != obj_tmp->hist) {
+        return OBJSYS_RET_PARAM;
+    }
+    dbhist *hist = dbhist_create(obj_tmp->psize, bytes);
+    if (NULL == hist) {
+        glog4c_err(strerror(errno));
+        return OBJSYS_RET_FMEM;
+    }
+    pthread_mutex_lock(&obj_tmp->wlock);
+    if (NULL != obj_tmp->hist) {
+        pthread_mutex_unlock(&obj_tmp->wlock);
+        dbhist_free(hist);
+        return OBJSYS_RET_PARAM;
+    }
+    __atomic_store_n(&obj_tmp->hist, hist, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&obj_tmp->wlock);
+    glog4c_info("obj_id=%d history %zu bytes\n", obj_id, dbhist_size(hist));
+    return OBJSYS_RET_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_get_history
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :读取测点在时间范围内的历史样本，不加锁，不阻塞写入.最近N个样本使用
+//                 from=0、to=UINT64_MAX、max=N；最近T毫秒使用from=当前时间-T
+// Input          :obj_id:对象编号
+//                :var_id:测点编号
+//                :from:起始时间，从1970年开始的毫秒数
+//                :to:结束时间，包含在内
+//                :max:输出数组的容量
+// Output         :out:样本，按时间升序
+// Return         :成功返回样本数量，超过max时只保留最新的样本,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbmem_get_history(uint16_t obj_id, uint16_t var_id, uint64_t from, uint64_t to,
+    dbsample *out, int max)
+{
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (NULL == out || max <= 0) {
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    dbhist *hist = __atomic_load_n(&obj_tmp->hist, __ATOMIC_ACQUIRE);
+    if (NULL == hist) {
+        return OBJSYS_RET_PARAM;
+    }
+    int pos = dbmem_locate(obj_tmp, var_id);
+    if (pos < 0) {
+        return OBJSYS_RET_UNKNOWID;
+    }
+    return dbhist_query(hist, pos, from, to, out, max);
+}
+
+//读取单条对象数据指针，列存储对象没有测点结构，返回NULL
+dbvar *dbmem_get_value(uint16_t obj_id, uint16_t var_id)
+{
     dbvar *var_tmp = NULL;
+    objsys *obj_tmp = dbmem_find(obj_id);
     // 如果这个对象存在
-    if (dbmem_get_id(obj_id) == 1) {
+    if (NULL != obj_tmp) {
         // 取出对应的对象
-        var_tmp = dbmem_binary_search(obj_id, var_id);
+        var_tmp = dbmem_lookup(obj_tmp, var_id);
         if (var_tmp == NULL){
-            glog4c_info("We can't find id form obj_id=%d\n", obj_id);
+            glog4c_debug("We can't find id form obj_id=%d\n", obj_id);
+        } else {
+            metric_add(METRIC_DB_GET, 1);
         }
     }
     return var_tmp;
 }
 
+//------------------------------------------------------------------------------
+// Function       :dbmem_read_value
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :按顺序锁读取测点的一致副本.读取期间顺序计数为奇数或发生变化时重读，
+//                 读者不加锁也不会阻塞写者
+// Input          :obj_id:对象编号
+//                :var_id:测点编号
+// Output         :out:测点副本
+// Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+// 按顺序锁拷贝单个测点
+static inline void dbmem_var_copy(const dbvar *var, dbvar *out)
+{
+    uint32_t seq0, seq1;
+
+    for (;;) {
+        seq0 = __atomic_load_n(&var->seq, __ATOMIC_ACQUIRE);
+        if (seq0 & 1) { // 写者正在修改
+            sched_yield();
+            continue;
+        }
+        memcpy(out, var, sizeof(dbvar));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq1 = __atomic_load_n(&var->seq, __ATOMIC_RELAXED);
+        if (seq0 == seq1) {
+            break;
+        }
+    }
+}
+
+int dbmem_read_value(uint16_t obj_id, uint16_t var_id, dbvar *out)
+{
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (NULL == out) {
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    uint64_t start = metric_begin(METRIC_H_DB_GET);
+    int pos = dbmem_locate(obj_tmp, var_id);
+    if (pos < 0) {
+        return OBJSYS_RET_UNKNOWID;
+    }
+    metric_add(METRIC_DB_GET, 1);
+    if (DBMEM_LAYOUT_AOS == obj_tmp->layout) {
+        dbmem_var_copy(&obj_tmp->property[pos], out);
+        metric_end(METRIC_H_DB_GET, start);
+        return OBJSYS_RET_OK;
+    }
+    // 列存储对象按对象的顺序锁读取，再组装成测点结构
+    uint8_t  type;
+    uint64_t val;
+    uint32_t seq;
+    do {
+        seq  = dbmem_soa_read_begin(obj_tmp);
+        type = obj_tmp->soa_type[pos];
+        val  = obj_tmp->soa_val[pos];
+    } while (dbmem_soa_read_retry(obj_tmp, seq));
+    memset(out, 0, sizeof(dbvar));
+    out->id   = var_id;
+    out->type = type;
+    out->len  = m_type_len[type];
+    out->u64  = val;
+    metric_end(METRIC_H_DB_GET, start);
+    return OBJSYS_RET_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_get_range
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :读取编号在[id_lo, id_hi]之间的所有测点.列存储对象的数值列连续存放，
+//                 整段直接拷贝并只做一次顺序锁校验，得到的是整个区间的一致快照；测点数组
+//                 对象逐个按测点的顺序锁拷贝.字符串和二进制测点的数值输出为0
+// Input          :obj_id:对象编号
+//                :id_lo:起始编号
+//                :id_hi:结束编号，包含在内
+//                :max:输出数组的容量
+// Output         :ids:测点编号，可以为NULL
+//                :types:数据类型，可以为NULL
+//                :values:数值，按dbvar联合体的方式保存
+// Return         :成功返回输出的测点数量，超过max时截断，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbmem_get_range(uint16_t obj_id, uint16_t id_lo, uint16_t id_hi,
+    uint16_t *ids, uint8_t *types, uint64_t *values, int max)
+{
+    objsys *obj_tmp = dbmem_find(obj_id);
+
+    if (NULL == values || max < 0 || id_lo > id_hi) {
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    int head = dbmem_lower_bound(obj_tmp, id_lo);
+    int end  = (id_hi >= DBMEM_MAX_PID) ? obj_tmp->psize : dbmem_lower_bound(obj_tmp, id_hi + 1);
+    int num  = end - head;
+    if (num > max) {
+        num = max;
+    }
+    if (num <= 0) {
+        return 0;
+    }
+
+    uint64_t start = metric_begin(METRIC_H_DB_GET);
+    metric_add(METRIC_DB_GET, num);
+    if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+        uint32_t seq;
+        // 编号初始化后不再变化，不需要放在顺序锁内
+        if (NULL != ids) {
+            memcpy(ids, &obj_tmp->soa_id[head], sizeof(uint16_t) * num);
+        }
+        do {
+            seq = dbmem_soa_read_begin(obj_tmp);
+            memcpy(values, &obj_tmp->soa_val[head], sizeof(uint64_t) * num);
+            if (NULL != types) {
+                memcpy(types, &obj_tmp->soa_type[head], num);
+            }
+        } while (dbmem_soa_read_retry(obj_tmp, seq));
+        metric_end(METRIC_H_DB_GET, start);
+        return num;
+    }
+    for (int idx = 0; idx < num; ++idx) {
+        dbvar var;
+        dbmem_var_copy(&obj_tmp->property[head + idx], &var);
+        if (NULL != ids) {
+            ids[idx] = var.id;
+        }
+        if (NULL != types) {
+            types[idx] = var.type;
+        }
+        values[idx] = (DB_STRING == var.type || DB_BLOB == var.type) ? 0 : var.u64;
+    }
+    metric_end(METRIC_H_DB_GET, start);
+    return num;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_get_values
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :批量读取同一对象的多个测点，测点位置通过索引取得.列存储对象整批只做一次
+//                 顺序锁校验.未知测点的类型输出为DB_NULL
+// Input          :obj_id:对象编号
+//                :ids:测点编号数组
+//                :num:数组长度
+// Output         :types:数据类型，可以为NULL
+//                :values:数值，按dbvar联合体的方式保存
+// Return         :成功返回找到的测点数量，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbmem_get_values(uint16_t obj_id, const uint16_t *ids, int num, uint8_t *types, uint64_t *values)
+{
+    objsys *obj_tmp = dbmem_find(obj_id);
+    int count;
+    uint32_t seq = 0;
+
+    if (NULL == ids || NULL == values || num < 0) {
+        return OBJSYS_RET_PARAM;
+    }
+    if (NULL == obj_tmp) {
+        return OBJSYS_RET_UNKNOWOBJ;
+    }
+    uint64_t start = metric_begin(METRIC_H_DB_GET);
+    do {
+        count = 0;
+        if (DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+            seq = dbmem_soa_read_begin(obj_tmp);
+        }
+        for (int idx = 0; idx < num; ++idx) {
+            int pos = dbmem_locate(obj_tmp, ids[idx]);
+            uint8_t type = DB_NULL;
+            uint64_t val = 0;
+            if (pos >= 0 && DBMEM_LAYOUT_SOA == obj_tmp->layout) {
+                type = obj_tmp->soa_type[pos];
+                val  = obj_tmp->soa_val[pos];
+            } else if (pos >= 0) {
+                dbvar var;
+                dbmem_var_copy(&obj_tmp->property[pos], &var);
+                type = var.type;
+                val  = (DB_STRING == var.type || DB_BLOB == var.type) ? 0 : var.u64;
+            }
+            count += (pos >= 0);
+            if (NULL != types) {
+                types[idx] = type;
+            }
+            values[idx] = val;
+        }
+    } while (DBMEM_LAYOUT_SOA == obj_tmp->layout && dbmem_soa_read_retry(obj_tmp, seq));
+    metric_add(METRIC_DB_GET, count);
+    metric_end(METRIC_H_DB_GET, start);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbmem_export
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :把当前所有对象的测点导出到共享内存，布局见dbshm.h.导出后每次写入同步
+//                 更新对应的测点槽，应用进程通过dbshm.h直接读取.导出时对象和测点必需已经
+//                 初始化完毕，之后创建的对象不会导出，已导出的对象不能再初始化测点
+// Input          :name:共享内存名称，格式与shm_open相同，例如"/communicator"
+// Output         :无
+// Return         :成功返回OBJSYS_RET_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbmem_export(const char *name)
+{
+    uint64_t size = sizeof(dbshm_head);
+    int nobj = 0;
+
+    if (NULL == name || strlen(name) >= sizeof(m_shm_name) || NULL != m_shm) {
+        return OBJSYS_RET_PARAM;
+    }
+    // 第一遍计算区域尺寸：对象表、编号索引，测点槽按缓存行对齐放在最后
+    for (int id = dbmem_next_obj(-1); id >= 0; id = dbmem_next_obj(id)) {
+        objsys *obj_tmp = dbmem_find(id);
+        int max_id = obj_tmp->psize > 0 ? dbmem_pid(obj_tmp, obj_tmp->psize - 1) : 0;
+        size += sizeof(dbshm_obj) + ((sizeof(uint16_t) * (max_id + 1) + 7) & ~7ULL);
+        ++nobj;
+    }
+    size = (size + DBMEM_CACHE_LINE - 1) & ~(uint64_t)(DBMEM_CACHE_LINE - 1);
+    uint64_t slot_base = size;
+    for (int id = dbmem_next_obj(-1); id >= 0; id = dbmem_next_obj(id)) {
+        size += sizeof(dbshm_slot) * dbmem_find(id)->psize;
+    }
+    if (nobj > 0xFFFF || size > 0xFFFFFFFFULL) {
+        return OBJSYS_RET_PARAM;
+    }
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        glog4c_err(strerror(errno));
+        return OBJSYS_RET_PARAM;
+    }
+    if (ftruncate(fd, size) < 0) {
+        glog4c_err(strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return OBJSYS_RET_FMEM;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base) {
+        glog4c_err(strerror(errno));
+        shm_unlink(name);
+        return OBJSYS_RET_FMEM;
+    }
+    m_shm      = (uint8_t *)base;
+    m_shm_size = size;
+    strcpy(m_shm_name, name);
+
+    // 第二遍填写对象表和索引，再在写锁内挂上测点槽并写入当前值
+    dbshm_head *head = (dbshm_head *)m_shm;
+    dbshm_obj  *tab  = (dbshm_obj *)(m_shm + sizeof(dbshm_head));
+    uint32_t index_off = sizeof(dbshm_head) + sizeof(dbshm_obj) * nobj;
+    uint32_t slot_off  = slot_base;
+    int cnt = 0;
+    for (int id = dbmem_next_obj(-1); id >= 0 && cnt < nobj; id = dbmem_next_obj(id), ++cnt) {
+        objsys *obj_tmp = dbmem_find(id);
+        int max_id = obj_tmp->psize > 0 ? dbmem_pid(obj_tmp, obj_tmp->psize - 1) : 0;
+        uint16_t *index = (uint16_t *)(m_shm + index_off);
+        dbshm_slot *slot = (dbshm_slot *)(m_shm + slot_off);
+
+        tab[cnt].obj_id    = id;
+        tab[cnt].npoint    = obj_tmp->psize;
+        tab[cnt].max_id    = max_id;
+        tab[cnt].index_off = index_off;
+        tab[cnt].slot_off  = slot_off;
+        pthread_mutex_lock(&obj_tmp->wlock);
+        for (int pos = 0; pos < obj_tmp->psize; ++pos) {
+            index[dbmem_pid(obj_tmp, pos)] = pos + 1;
+            slot[pos].id = dbmem_pid(obj_tmp, pos);
+        }
+        obj_tmp->shm = slot;
+        for (int pos = 0; pos < obj_tmp->psize; ++pos) {
+            dbmem_publish(obj_tmp, pos);
+        }
+        pthread_mutex_unlock(&obj_tmp->wlock);
+        index_off += (sizeof(uint16_t) * (max_id + 1) + 7) & ~7U;
+        slot_off  += sizeof(dbshm_slot) * obj_tmp->psize;
+    }
+    head->version   = DBSHM_VERSION;
+    head->slot_size = sizeof(dbshm_slot);
+    head->size      = size;
+    head->nobj      = cnt;
+    head->obj_off   = sizeof(dbshm_head);
+    // 魔数最后写入，应用看到魔数时其他内容都已经完整
+    __atomic_store_n(&head->magic, DBSHM_MAGIC, __ATOMIC_RELEASE);
+    return OBJSYS_RET_OK;
+}
+
 //消除内存结构
 int dbmem_close(void)
 {
     // 枚举所有对象的所有变量
-    for (int idx=0; idx < DBMEM_MAX_OBJS; ++idx){
-        if (m_objsys[idx] != NULL){
-            for (int imp = 0; imp < m_objsys[idx]->psize; ++imp) {
+    pthread_mutex_lock(&m_dir_lock);
+    for (int pg = 0; pg < DBMEM_DIR_SIZE; ++pg) {
+        objpage *page = m_objdir[pg];
+        if (NULL == page) {
+            continue;
+        }
+        for (int idx = 0; idx < DBMEM_DIR_SIZE && page->count > 0; ++idx){
+            objsys *cur = page->obj[idx];
+            if (NULL == cur) {
+                continue;
+            }
+            // 池中的块随大块整体释放，只有直接申请的大块需要逐个释放
+            for (int imp = 0; imp < cur->psize && DBMEM_LAYOUT_AOS == cur->layout; ++imp) {
+                dbvar *var = &cur->property[imp];
                 int con = 0;
-                con  = (DB_STRING == m_objsys[idx]->property[imp].type);
-                con |= (DB_BLOB == m_objsys[idx]->property[imp].type);
-                con &= (NULL != m_objsys[idx]->property[imp].str);
-                if (con) {
-                    free(m_objsys[idx]->property[imp].str);
+                con  = (DB_STRING == var->type && var->len > DBVAR_SSO_STR);
+                con |= (DB_BLOB == var->type && var->len > DBVAR_SSO_BLOB);
+                if (con && DBMEM_SLAB_LARGE == ((dbrcu *)var->str - 1)->cls) {
+                    free((dbrcu *)var->str - 1);
+                }
+            }
+            while (NULL != cur->retired) {
+                dbrcu *head = cur->retired;
+                cur->retired = head->next;
+                if (DBMEM_SLAB_LARGE == head->cls) {
+                    free(head);
                 }
             }
-            free(m_objsys[idx]);
+            while (NULL != cur->chunks) {
+                dbchunk *chunk = cur->chunks;
+                cur->chunks = chunk->next;
+                free(chunk);
+            }
+            free(cur->direct);
+            free(cur->soa_id);
+            free(cur->soa_type);
+            free(cur->soa_val);
+            for (int chan = 0; chan < DBMEM_WATCH_CHANS; ++chan) {
+                free(cur->dirty[chan]);
+            }
+            dbhist_free(cur->hist);
+            pthread_mutex_destroy(&cur->wlock);
+            free(cur);
+            page->obj[idx] = NULL;
+            --page->count;
         }
+        m_objdir[pg] = NULL;
+        free(page);
     }
-    glog4c_hit("close memory db\n")
+    m_objnum = 0;
+    pthread_mutex_unlock(&m_dir_lock);
+    if (NULL != m_shm) {
+        munmap(m_shm, m_shm_size);
+        shm_unlink(m_shm_name);
+        m_shm = NULL;
+    }
+    glog4c_hit("close memory db\n");
     return OBJSYS_RET_OK;
 }
 
@@ -375,7 +1876,7 @@ static char *errstr[] = {
     "The object id was used.", // OBJSYS_RET_IDUSED-2
     "Out of memory.",          // OBJSYS_RET_FMEM-3
     "Unknow object id.",       // OBJSYS_RET_UNKNOWOBJ-4
-    "Unknow property id."      // OBJSYS_RET_UNKNOWID-5
+    "Unknow property id.",     // OBJSYS_RET_UNKNOWID-5
     "Error data type."         // OBJSYS_RET_TYPE-6
 };
 
@@ -393,54 +1894,61 @@ void dbmem_print_property(uint16_t obj_id)
 {
     objsys *cur;
     // 如果这个对象存在
-    if (dbmem_get_id(obj_id) == 1) {
-        cur = m_objsys[obj_id];
+    cur = dbmem_find(obj_id);
+    if (NULL != cur) {
 
-        glog4c_info("obj id = %d\n", cur->obj_id);
-        glog4c_info("obj name = %s\n", cur->name);
+        glog4c_debug("obj id = %d\n", cur->obj_id);
+        glog4c_debug("obj name = %s\n", cur->name);
         for (int idx = 0; idx < cur->psize; ++idx) {
-            switch (cur->property[idx].type) {
+            dbvar tmp;
+            const dbvar *v = &tmp;
+            if (DBMEM_LAYOUT_AOS == cur->layout) {
+                v = &cur->property[idx];
+            } else if (dbmem_read_value(cur->obj_id, cur->soa_id[idx], &tmp) != OBJSYS_RET_OK) {
+                continue;
+            }
+            switch (v->type) {
             case DB_NULL:
-                glog4c_info("id=%d::value = NULL\n", cur->property[idx].id);
+                glog4c_debug("id=%d::value = NULL\n", v->id);
             break;
             case DB_INT8:
-                glog4c_info("id=%d::value = %d\n", cur->property[idx].id, cur->property[idx].i8);
+                glog4c_debug("id=%d::value = %d\n", v->id, v->i8);
             break;
             case DB_INT16:
-                glog4c_info("id=%d::value = %d\n", cur->property[idx].id, cur->property[idx].i16);
+                glog4c_debug("id=%d::value = %d\n", v->id, v->i16);
             break;
             case DB_INT32:
-                glog4c_info("id=%d::value = %d\n", cur->property[idx].id, cur->property[idx].i32);
+                glog4c_debug("id=%d::value = %d\n", v->id, v->i32);
             break;
             case DB_INT64:
-                glog4c_info("id=%d::value = %li\n", cur->property[idx].id, cur->property[idx].i64);
+                glog4c_debug("id=%d::value = %li\n", v->id, v->i64);
             break;
             case DB_UINT8:
-                glog4c_info("id=%d::value = %d\n", cur->property[idx].id, cur->property[idx].u8);
+                glog4c_debug("id=%d::value = %d\n", v->id, v->u8);
             break;
             case DB_UINT16:
-                glog4c_info("id=%d::value = %d\n", cur->property[idx].id, cur->property[idx].u16);
+                glog4c_debug("id=%d::value = %d\n", v->id, v->u16);
             break;
             case DB_UINT32:
-                glog4c_info("id=%d::value = %d\n", cur->property[idx].id, cur->property[idx].u32);
+                glog4c_debug("id=%d::value = %d\n", v->id, v->u32);
             break;
             case DB_UINT64:
-                glog4c_info("id=%d::value = %ld\n", cur->property[idx].id, cur->property[idx].u64);
+                glog4c_debug("id=%d::value = %ld\n", v->id, v->u64);
             break;
             case DB_FLOAT:
-                glog4c_info("id=%d::value = %f\n", cur->property[idx].id, cur->property[idx].f);
+                glog4c_debug("id=%d::value = %f\n", v->id, v->f);
             break;
             case DB_DOUBLE:
-                glog4c_info("id=%d::value = %f\n", cur->property[idx].id, cur->property[idx].d);
+                glog4c_debug("id=%d::value = %f\n", v->id, v->d);
             break;
             case DB_STRING:
-                glog4c_info("id=%d::value = %s\n", cur->property[idx].id, cur->property[idx].str);
+                glog4c_debug("id=%d::value = %s\n", v->id, dbvar_str(v));
             break;
             case DB_BLOB:
-                glog4c_info("id=%d::value size = %d\n", cur->property[idx].id, cur->property[idx].len);
+                glog4c_debug("id=%d::value size = %d\n", v->id, v->len);
             break;
             case DB_BOOL:
-                glog4c_info("id=%d::value = %d\n", cur->property[idx].id, cur->property[idx].bl);
+                glog4c_debug("id=%d::value = %d\n", v->id, v->bl);
             break;
             }
         }
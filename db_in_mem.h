@@ -28,6 +28,7 @@ typedef struct {
         //数据长度，如果是固定长度则为变量的字长，如果是字符串则表示数据总长为xxB
         uint32_t len :16;
     };
+    uint32_t seq; //顺序锁计数，奇数表示正在写入，读者通过dbmem_read_value获得一致的副本
     union {
         int8_t   i8;
         uint8_t  u8;
@@ -42,9 +43,51 @@ typedef struct {
         char     *str;
         uint8_t  *blob;
         int32_t  bl;
+        char     sso[8]; //短字符串和短二进制数据直接保存在测点内，不申请内存
     };
 }dbvar;
 
+// 不超过该长度的字符串(不含结尾0)和二进制数据保存在sso中
+#define DBVAR_SSO_STR  7
+#define DBVAR_SSO_BLOB 8
+
+// 取得字符串测点的内容，短字符串指向测点内部，所以对副本调用时指向副本
+static inline const char *dbvar_str(const dbvar *var)
+{
+    return var->len <= DBVAR_SSO_STR ? var->sso : var->str;
+}
+
+// 取得二进制测点的内容
+static inline const uint8_t *dbvar_blob(const dbvar *var)
+{
+    return var->len <= DBVAR_SSO_BLOB ? (const uint8_t *)var->sso : var->blob;
+}
+
+// 历史样本，数值按dbvar联合体的方式保存
+typedef struct {
+    uint64_t ts;   // 时间，从1970年开始的毫秒数
+    uint8_t  type; // 数据类型，只有定长数值类型
+    uint8_t  rsv[7];
+    union {
+        int8_t   i8;
+        uint8_t  u8;
+        int16_t  i16;
+        uint16_t u16;
+        int32_t  i32;
+        uint32_t u32;
+        int64_t  i64;
+        uint64_t u64;
+        float    f;
+        double   d;
+        int32_t  bl;
+    };
+}dbsample;
+
+// 变化记录通道，每个通道有独立的变化位图，互不影响
+#define DBMEM_WATCH_SUB   0 // 变化订阅
+#define DBMEM_WATCH_LOG   1 // 变化日志
+#define DBMEM_WATCH_CHANS 2
+
 //函数反回结果定义
 #define OBJSYS_RET_OK         0
 #define OBJSYS_RET_PARAM     -1 // 参数错误
@@ -58,12 +101,51 @@ typedef struct {
 // 使用顺序是创建对象->初始化属性->设置默认值,最后是用完毕后要消除内存结构
 // 创建对象,内部对象创建参考objects.h,外部对象参考相应的配置文件
 int dbmem_create_obj(uint16_t obj_id, const char *name, int size);
-// 初始化对象属性
+// 创建列存储对象，编号、类型和数值分列连续存放，只能保存数值类型，适合点数多的数值对象
+int dbmem_create_soa(uint16_t obj_id, const char *name, int size);
+// 查找编号大于obj_id的下一个对象，从-1开始遍历所有对象，没有更多对象时返回-1
+int dbmem_next_obj(int obj_id);
+// 当前对象数量
+uint32_t dbmem_obj_count(void);
+// 初始化对象属性，测点编号不能超过0x0FFF，同时为对象建立查找索引
 int dbmem_init_values(uint16_t obj_id, uint16_t *var, uint16_t size);
 // 保存单条对象数据
 int dbmem_set_value(uint16_t obj_id, uint16_t var_id, int type, void *value, uint32_t size);
-// 读取单条对象数据
+// 批量保存同一对象的多条数据，返回保存的数量
+int dbmem_set_values(uint16_t obj_id, const uint16_t *ids, const uint8_t *types,
+    const void *const *values, const uint32_t *sizes, int num);
+// dbmem_set_block的死区取这个值时不比较，所有已知测点都写入，与dbmem_set_values相同
+#define DBMEM_BAND_ALL (-1.0)
+// 保存编号连续、类型相同的一块数值，只写入超出死区的变化值，changed输出变化位图，返回写入数量
+int dbmem_set_block(uint16_t obj_id, uint16_t id_start, int type, const void *values,
+    int num, double deadband, uint32_t *changed);
+// 打开或关闭对象在chan通道上的变化记录，同一测点在两次取走之间的多次写入只记录一次
+int dbmem_watch(uint16_t obj_id, int chan, int on);
+// 取走chan通道上有变化的测点编号，按升序输出，返回数量
+int dbmem_take_dirty(uint16_t obj_id, int chan, uint16_t *ids, int max);
+// 重新标记chan通道上的变化，取走后处理失败时放回，下次取走时再次得到
+int dbmem_put_dirty(uint16_t obj_id, int chan, const uint16_t *ids, int num);
+// 为对象打开历史记录，每个测点保存bytes字节的压缩样本，需要在对象初始化完成后调用
+int dbmem_history(uint16_t obj_id, uint32_t bytes);
+// 读取测点时间在[from, to]之间的历史样本，按时间升序输出，超过max时保留最新的样本，返回数量
+int dbmem_get_history(uint16_t obj_id, uint16_t var_id, uint64_t from, uint64_t to,
+    dbsample *out, int max);
+// 读取单条对象数据，返回的指针直接指向测点，只适合在没有并发写入时使用，列存储对象返回NULL
 dbvar *dbmem_get_value(uint16_t obj_id, uint16_t var_id);
+// 读取单条对象数据的一致副本，读者不会被写者阻塞.副本中的字符串和二进制数据指针只在
+// dbmem_read_lock和dbmem_read_unlock之间有效
+int dbmem_read_value(uint16_t obj_id, uint16_t var_id, dbvar *out);
+// 读取编号在[id_lo, id_hi]之间的测点，ids和types可以为NULL，返回输出的数量
+int dbmem_get_range(uint16_t obj_id, uint16_t id_lo, uint16_t id_hi,
+    uint16_t *ids, uint8_t *types, uint64_t *values, int max);
+// 批量读取多个测点的数值，未知测点类型为DB_NULL，返回找到的数量
+int dbmem_get_values(uint16_t obj_id, const uint16_t *ids, int num, uint8_t *types, uint64_t *values);
+// 进入读临界区，临界区内读到的字符串和二进制数据不会被释放，可以嵌套
+void dbmem_read_lock(void);
+// 退出读临界区
+void dbmem_read_unlock(void);
+// 把所有对象导出到共享内存，应用进程通过dbshm.h直接读取，需要在对象初始化完成后调用
+int dbmem_export(const char *name);
 // 打印对象属性
 void dbmem_print_property(uint16_t obj_id);
 // 格式化错误消息
@@ -0,0 +1,346 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :dbconv.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :测点数组的批量类型转换和变化比较。x86使用SSE2(编译时打开-mavx2则使用AVX2)，
+//                 ARM使用NEON，其他平台以及数组尾部使用普通循环。
+// Interface      :无
+// Others         :16位和32位数据的扩展、原始值比较使用向量指令；8位数据的扩展和原始值转换为
+//                 double使用普通循环。ARMv7的NEON没有双精度运算，死区比较只在AArch64上向量化
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <string.h>
+
+#include "db_in_mem.h"
+#include "dbconv.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DBCONV_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DBCONV_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DBCONV_NEON
+#endif
+
+// 16位数据扩展为64位
+static void dbconv_widen16(const uint16_t *src, int num, uint64_t *dst)
+{
+    int idx = 0;
+
+#if defined(DBCONV_AVX2)
+    for (; idx + 4 <= num; idx += 4) {
+        __m128i v = _mm_loadl_epi64((const __m128i *)(src + idx));
+        _mm256_storeu_si256((__m256i *)(dst + idx), _mm256_cvtepu16_epi64(v));
+    }
+#elif defined(DBCONV_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; idx + 8 <= num; idx += 8) {
+        __m128i v  = _mm_loadu_si128((const __m128i *)(src + idx));
+        __m128i lo = _mm_unpacklo_epi16(v, zero);
+        __m128i hi = _mm_unpackhi_epi16(v, zero);
+        _mm_storeu_si128((__m128i *)(dst + idx),     _mm_unpacklo_epi32(lo, zero));
+        _mm_storeu_si128((__m128i *)(dst + idx + 2), _mm_unpackhi_epi32(lo, zero));
+        _mm_storeu_si128((__m128i *)(dst + idx + 4), _mm_unpacklo_epi32(hi, zero));
+        _mm_storeu_si128((__m128i *)(dst + idx + 6), _mm_unpackhi_epi32(hi, zero));
+    }
+#elif defined(DBCONV_NEON)
+    for (; idx + 8 <= num; idx += 8) {
+        uint16x8_t v  = vld1q_u16(src + idx);
+        uint32x4_t lo = vmovl_u16(vget_low_u16(v));
+        uint32x4_t hi = vmovl_u16(vget_high_u16(v));
+        vst1q_u64(dst + idx,     vmovl_u32(vget_low_u32(lo)));
+        vst1q_u64(dst + idx + 2, vmovl_u32(vget_high_u32(lo)));
+        vst1q_u64(dst + idx + 4, vmovl_u32(vget_low_u32(hi)));
+        vst1q_u64(dst + idx + 6, vmovl_u32(vget_high_u32(hi)));
+    }
+#endif
+    for (; idx < num; ++idx) {
+        dst[idx] = src[idx];
+    }
+}
+
+// 32位数据扩展为64位
+static void dbconv_widen32(const uint32_t *src, int num, uint64_t *dst)
+{
+    int idx = 0;
+
+#if defined(DBCONV_AVX2)
+    for (; idx + 4 <= num; idx += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + idx));
+        _mm256_storeu_si256((__m256i *)(dst + idx), _mm256_cvtepu32_epi64(v));
+    }
+#elif defined(DBCONV_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; idx + 4 <= num; idx += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + idx));
+        _mm_storeu_si128((__m128i *)(dst + idx),     _mm_unpacklo_epi32(v, zero));
+        _mm_storeu_si128((__m128i *)(dst + idx + 2), _mm_unpackhi_epi32(v, zero));
+    }
+#elif defined(DBCONV_NEON)
+    for (; idx + 4 <= num; idx += 4) {
+        uint32x4_t v = vld1q_u32(src + idx);
+        vst1q_u64(dst + idx,     vmovl_u32(vget_low_u32(v)));
+        vst1q_u64(dst + idx + 2, vmovl_u32(vget_high_u32(v)));
+    }
+#endif
+    for (; idx < num; ++idx) {
+        dst[idx] = src[idx];
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbconv_widen
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :将定长数值数组转换为原始值数组.有符号数按位扩展(高位补0)，与单个写入时
+//                 保存的内容相同，不做符号扩展
+// Input          :type:数据类型
+//                :src:源数组，DB_BOOL为int32_t数组
+//                :num:元素数量
+// Output         :dst:原始值数组
+// Return         :成功返回0，类型不是定长数值时返回-1
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbconv_widen(int type, const void *src, int num, uint64_t *dst)
+{
+    switch (type) {
+    case DB_INT8:
+    case DB_UINT8:
+        for (int idx = 0; idx < num; ++idx) {
+            dst[idx] = ((const uint8_t *)src)[idx];
+        }
+    break;
+    case DB_INT16:
+    case DB_UINT16:
+        dbconv_widen16((const uint16_t *)src, num, dst);
+    break;
+    case DB_INT32:
+    case DB_UINT32:
+    case DB_FLOAT:
+    case DB_BOOL:
+        dbconv_widen32((const uint32_t *)src, num, dst);
+    break;
+    case DB_INT64:
+    case DB_UINT64:
+    case DB_DOUBLE:
+        memcpy(dst, src, sizeof(uint64_t) * num);
+    break;
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbconv_to_double
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :将原始值按类型解释为数值并转换为double.类型判断放在循环外，循环体可以由
+//                 编译器展开
+// Input          :type:数据类型
+//                :raw:原始值数组
+//                :num:元素数量
+// Output         :dst:数值数组，非数值类型输出0
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+void dbconv_to_double(int type, const uint64_t *raw, int num, double *dst)
+{
+    union {
+        uint32_t u;
+        float    f;
+    }f32;
+    union {
+        uint64_t u;
+        double   d;
+    }f64;
+
+    switch (type) {
+    case DB_INT8:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = (int8_t)raw[idx];
+    break;
+    case DB_UINT8:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = (uint8_t)raw[idx];
+    break;
+    case DB_INT16:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = (int16_t)raw[idx];
+    break;
+    case DB_UINT16:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = (uint16_t)raw[idx];
+    break;
+    case DB_INT32:
+    case DB_BOOL:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = (int32_t)raw[idx];
+    break;
+    case DB_UINT32:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = (uint32_t)raw[idx];
+    break;
+    case DB_INT64:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = (int64_t)raw[idx];
+    break;
+    case DB_UINT64:
+        for (int idx = 0; idx < num; ++idx) dst[idx] = raw[idx];
+    break;
+    case DB_FLOAT:
+        for (int idx = 0; idx < num; ++idx) {
+            f32.u = (uint32_t)raw[idx];
+            dst[idx] = f32.f;
+        }
+    break;
+    case DB_DOUBLE:
+        for (int idx = 0; idx < num; ++idx) {
+            f64.u = raw[idx];
+            dst[idx] = f64.d;
+        }
+    break;
+    default:
+        memset(dst, 0, sizeof(double) * num);
+    }
+}
+
+// 比较最多32个原始值，返回不相等位置的位图
+static inline uint32_t dbconv_diff_word(const uint64_t *a, const uint64_t *b, int num)
+{
+    uint32_t bits = 0;
+    int idx = 0;
+
+#if defined(DBCONV_AVX2)
+    for (; idx + 4 <= num; idx += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + idx));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + idx));
+        int eq = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, y)));
+        bits |= (uint32_t)(~eq & 0xF) << idx;
+    }
+#elif defined(DBCONV_SSE2)
+    // SSE2没有64位比较，两个32位半字都相等才算相等
+    for (; idx + 2 <= num; idx += 2) {
+        __m128i x  = _mm_loadu_si128((const __m128i *)(a + idx));
+        __m128i y  = _mm_loadu_si128((const __m128i *)(b + idx));
+        __m128i e  = _mm_cmpeq_epi32(x, y);
+        e = _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+        int eq = _mm_movemask_pd(_mm_castsi128_pd(e));
+        bits |= (uint32_t)(~eq & 0x3) << idx;
+    }
+#elif defined(DBCONV_NEON)
+    // ARMv7没有64位比较，两个32位半字都相等才算相等
+    for (; idx + 2 <= num; idx += 2) {
+        uint32x4_t x = vreinterpretq_u32_u64(vld1q_u64(a + idx));
+        uint32x4_t y = vreinterpretq_u32_u64(vld1q_u64(b + idx));
+        uint32x4_t e = vceqq_u32(x, y);
+        e = vandq_u32(e, vrev64q_u32(e));
+        bits |= (uint32_t)(0 == vgetq_lane_u32(e, 0)) << idx;
+        bits |= (uint32_t)(0 == vgetq_lane_u32(e, 2)) << (idx + 1);
+    }
+#endif
+    for (; idx < num; ++idx) {
+        bits |= (uint32_t)(a[idx] != b[idx]) << idx;
+    }
+    return bits;
+}
+
+// 比较最多32个数值，返回超出死区位置的位图
+static inline uint32_t dbconv_band_word(const double *a, const double *b, int num, double band)
+{
+    uint32_t bits = 0;
+    int idx = 0;
+
+#if defined(DBCONV_AVX2)
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d bv   = _mm256_set1_pd(band);
+    for (; idx + 4 <= num; idx += 4) {
+        __m256d d  = _mm256_sub_pd(_mm256_loadu_pd(a + idx), _mm256_loadu_pd(b + idx));
+        __m256d le = _mm256_cmp_pd(_mm256_andnot_pd(sign, d), bv, _CMP_LE_OQ);
+        bits |= (uint32_t)(~_mm256_movemask_pd(le) & 0xF) << idx;
+    }
+#elif defined(DBCONV_SSE2)
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d bv   = _mm_set1_pd(band);
+    for (; idx + 2 <= num; idx += 2) {
+        __m128d d  = _mm_sub_pd(_mm_loadu_pd(a + idx), _mm_loadu_pd(b + idx));
+        __m128d le = _mm_cmple_pd(_mm_andnot_pd(sign, d), bv);
+        bits |= (uint32_t)(~_mm_movemask_pd(le) & 0x3) << idx;
+    }
+#elif defined(DBCONV_NEON) && defined(__aarch64__)
+    const float64x2_t bv = vdupq_n_f64(band);
+    for (; idx + 2 <= num; idx += 2) {
+        float64x2_t d  = vabdq_f64(vld1q_f64(a + idx), vld1q_f64(b + idx));
+        uint64x2_t  le = vcleq_f64(d, bv);
+        bits |= (uint32_t)(0 == vgetq_lane_u64(le, 0)) << idx;
+        bits |= (uint32_t)(0 == vgetq_lane_u64(le, 1)) << (idx + 1);
+    }
+#endif
+    for (; idx < num; ++idx) {
+        double d = a[idx] - b[idx];
+        if (d < 0) {
+            d = -d;
+        }
+        bits |= (uint32_t)!(d <= band) << idx;
+    }
+    return bits;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbconv_diff
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :逐个比较两组原始值
+// Input          :a:第一组原始值
+//                :b:第二组原始值
+//                :num:元素数量
+// Output         :bitmap:不相等的位置1
+// Return         :不相等的数量
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbconv_diff(const uint64_t *a, const uint64_t *b, int num, uint32_t *bitmap)
+{
+    int count = 0;
+
+    for (int idx = 0; idx < num; idx += 32) {
+        uint32_t bits = dbconv_diff_word(a + idx, b + idx, num - idx < 32 ? num - idx : 32);
+        bitmap[idx / 32] = bits;
+        count += __builtin_popcount(bits);
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbconv_band
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :逐个比较两组数值是否超出死区.差值为NaN时认为超出，调用者需要再与原始值的
+//                 比较结果相与，排除两边完全相同的情况
+// Input          :a:第一组数值
+//                :b:第二组数值
+//                :num:元素数量
+//                :band:死区，差的绝对值小于等于死区认为没有变化
+// Output         :bitmap:超出死区的位置1
+// Return         :超出死区的数量
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbconv_band(const double *a, const double *b, int num, double band, uint32_t *bitmap)
+{
+    int count = 0;
+
+    for (int idx = 0; idx < num; idx += 32) {
+        uint32_t bits = dbconv_band_word(a + idx, b + idx, num - idx < 32 ? num - idx : 32, band);
+        bitmap[idx / 32] = bits;
+        count += __builtin_popcount(bits);
+    }
+    return count;
+}
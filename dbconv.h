@@ -0,0 +1,21 @@
+#ifndef DBCONV_H_
+#define DBCONV_H_
+
+#include <stdint.h>
+
+// 测点数组的批量转换与比较，供db_in_mem的整块写入使用
+// 原始值(raw)是数值按dbvar联合体保存后的64位内容，宽度不足64位的类型高位补0，
+// 与小端平台上先清零u64再写入对应成员的结果一致
+// 比较结果按位图输出，第k个元素对应bitmap[k/32]的第k%32位，位图长度为(num+31)/32
+
+// 将num个type类型的数值转换为原始值，DB_BOOL的源数据为int32_t
+// 成功返回0，类型不是定长数值时返回-1
+int dbconv_widen(int type, const void *src, int num, uint64_t *dst);
+// 将num个type类型的原始值转换为double，用于死区比较
+void dbconv_to_double(int type, const uint64_t *raw, int num, double *dst);
+// 比较两组原始值，不相等的位置1，返回置位数量
+int dbconv_diff(const uint64_t *a, const uint64_t *b, int num, uint32_t *bitmap);
+// 比较两组数值，差的绝对值超过死区或者无法比较(NaN)的位置1，返回置位数量
+int dbconv_band(const double *a, const double *b, int num, double band, uint32_t *bitmap);
+
+#endif
@@ -0,0 +1,466 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :dbhist.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :测点历史记录。每个测点一个由历史块组成的环，块内样本按位压缩：时间保存
+//                 二阶差分，浮点数保存与前一个值的异或结果，整数保存与前一个值的差。
+// Interface      :无
+// Others         :写者只修改当前块，每次追加前后递增块的顺序计数；读者先原子读取当前块序号，
+//                 再从最早的块开始逐块复制并校验顺序计数和块序号，复制期间被覆盖的块连同之前
+//                 的样本一起丢弃，输出总是连续的.解码只使用副本，不会读到写了一半的数据
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dbhist.h"
+
+#define DBHIST_HEAD   32                               // 块头尺寸
+#define DBHIST_BITS   ((DBHIST_BLOCK - DBHIST_HEAD) * 8) // 块内可用的位数
+#define DBHIST_NOWIN  0xFF                             // 块内还没有建立异或窗口
+#define DBHIST_FIELDS 6                                // 一个样本最多的编码段数
+
+// 历史块，读者整块复制
+typedef struct {
+    uint32_t seq;   // 顺序锁计数，奇数表示正在写入
+    uint32_t bno;   // 块序号，从1开始递增，0表示空块
+    uint16_t count; // 样本数量
+    uint16_t bits;  // 已经使用的位数
+    uint8_t  type;  // 块内样本的数据类型，类型改变时开始新块
+    uint8_t  rsv[3];
+    uint64_t t0;    // 第一个样本的时间
+    uint64_t v0;    // 第一个样本的编码值
+    uint8_t  data[DBHIST_BLOCK - DBHIST_HEAD];
+}dbhist_blk;
+
+// 测点的写入状态，只有bno会被读者访问
+typedef struct {
+    uint64_t ts;    // 上一个样本的时间
+    int64_t  delta; // 上一个样本的时间差
+    uint64_t val;   // 上一个样本的编码值
+    uint32_t bno;   // 当前块序号，0表示还没有样本
+    uint8_t  lead;  // 异或窗口的前导0数量，DBHIST_NOWIN表示没有窗口
+    uint8_t  trail; // 异或窗口的尾部0数量
+    uint8_t  rsv[2];
+}dbhist_cur;
+
+struct dbhist {
+    int         npoint; // 测点数量
+    uint32_t    nblk;   // 每个测点的块数量
+    dbhist_cur *cur;    // 测点写入状态
+    dbhist_blk *blk;    // 所有测点的块，测点pos的块从pos*nblk开始
+};
+
+// 一个样本的编码结果，先计算长度，放得下才写入块中
+typedef struct {
+    uint64_t val[DBHIST_FIELDS];
+    uint8_t  len[DBHIST_FIELDS];
+    int      num;
+    int      bits;
+    uint8_t  lead;
+    uint8_t  trail;
+}dbhist_code;
+
+static inline void dbhist_emit(dbhist_code *code, uint64_t val, int len)
+{
+    code->val[code->num] = val;
+    code->len[code->num] = (uint8_t)len;
+    ++code->num;
+    code->bits += len;
+}
+
+// 浮点数使用异或编码，其他数值使用差值编码
+static inline int dbhist_is_float(int type)
+{
+    return DB_FLOAT == type || DB_DOUBLE == type;
+}
+
+// 有符号整数的原始值高位补0，差值编码前先做符号扩展，跨过0时差值仍然很小
+static inline uint64_t dbhist_widen(int type, uint64_t raw)
+{
+    switch (type) {
+    case DB_INT8:  return (uint64_t)(int64_t)(int8_t)raw;
+    case DB_INT16: return (uint64_t)(int64_t)(int16_t)raw;
+    case DB_INT32:
+    case DB_BOOL:  return (uint64_t)(int64_t)(int32_t)raw;
+    default:       return raw;
+    }
+}
+
+// 编码值还原为原始值，截掉符号扩展的高位
+static inline uint64_t dbhist_narrow(int type, uint64_t val)
+{
+    switch (type) {
+    case DB_INT8:
+    case DB_UINT8:  return val & 0xFF;
+    case DB_INT16:
+    case DB_UINT16: return val & 0xFFFF;
+    case DB_INT32:
+    case DB_UINT32:
+    case DB_FLOAT:
+    case DB_BOOL:   return val & 0xFFFFFFFF;
+    default:        return val;
+    }
+}
+
+// 有符号整数按大小分档编码:0 | 10+7位 | 110+9位 | 1110+12位 | 1111+64位
+static void dbhist_enc_int(dbhist_code *code, int64_t val)
+{
+    if (0 == val) {
+        dbhist_emit(code, 0, 1);
+    } else if (val >= -64 && val <= 63) {
+        dbhist_emit(code, 0x2, 2);
+        dbhist_emit(code, (uint64_t)val & 0x7F, 7);
+    } else if (val >= -256 && val <= 255) {
+        dbhist_emit(code, 0x6, 3);
+        dbhist_emit(code, (uint64_t)val & 0x1FF, 9);
+    } else if (val >= -2048 && val <= 2047) {
+        dbhist_emit(code, 0xE, 4);
+        dbhist_emit(code, (uint64_t)val & 0xFFF, 12);
+    } else {
+        dbhist_emit(code, 0xF, 4);
+        dbhist_emit(code, (uint64_t)val, 64);
+    }
+}
+
+// 异或编码:相同时为0；有效位落在上一个窗口内时为10+窗口内的位；否则为11+前导0数量6位+
+// 有效位数减1的6位+有效位
+static void dbhist_enc_xor(dbhist_code *code, const dbhist_cur *cur, uint64_t val)
+{
+    uint64_t diff = val ^ cur->val;
+
+    code->lead  = cur->lead;
+    code->trail = cur->trail;
+    if (0 == diff) {
+        dbhist_emit(code, 0, 1);
+        return;
+    }
+    int lead  = __builtin_clzll(diff);
+    int trail = __builtin_ctzll(diff);
+    if (DBHIST_NOWIN != cur->lead && lead >= cur->lead && trail >= cur->trail) {
+        dbhist_emit(code, 0x2, 2);
+        dbhist_emit(code, diff >> cur->trail, 64 - cur->lead - cur->trail);
+        return;
+    }
+    int len = 64 - lead - trail;
+    dbhist_emit(code, 0x3, 2);
+    dbhist_emit(code, lead, 6);
+    dbhist_emit(code, len - 1, 6);
+    dbhist_emit(code, diff >> trail, len);
+    code->lead  = (uint8_t)lead;
+    code->trail = (uint8_t)trail;
+}
+
+// 按高位在前的顺序写入位，块在开始时已经清零
+static void dbhist_put(uint8_t *data, uint32_t pos, uint64_t val, int len)
+{
+    while (len > 0) {
+        int room = 8 - (pos & 7);
+        int take = len < room ? len : room;
+        uint8_t part = (uint8_t)((val >> (len - take)) & ((1u << take) - 1));
+        data[pos >> 3] |= (uint8_t)(part << (room - take));
+        pos += take;
+        len -= take;
+    }
+}
+
+// 读取位，超出已用位数时返回0并把位置移到末尾，保证损坏的副本不会越界
+static uint64_t dbhist_get(const uint8_t *data, uint32_t *pos, uint32_t end, int len)
+{
+    uint64_t val = 0;
+
+    if (*pos + len > end) {
+        *pos = end + 1;
+        return 0;
+    }
+    while (len > 0) {
+        int room = 8 - (*pos & 7);
+        int take = len < room ? len : room;
+        uint8_t part = (uint8_t)(data[*pos >> 3] >> (room - take)) & ((1u << take) - 1);
+        val = (val << take) | part;
+        *pos += take;
+        len  -= take;
+    }
+    return val;
+}
+
+static int64_t dbhist_dec_int(const uint8_t *data, uint32_t *pos, uint32_t end)
+{
+    static const uint8_t widths[] = {7, 9, 12, 64};
+    int level = 0;
+
+    if (0 == dbhist_get(data, pos, end, 1)) {
+        return 0;
+    }
+    while (level < 3 && 1 == dbhist_get(data, pos, end, 1)) {
+        ++level;
+    }
+    int len = widths[level];
+    uint64_t val = dbhist_get(data, pos, end, len);
+    if (len < 64 && (val >> (len - 1))) { // 符号扩展
+        val |= ~0ULL << len;
+    }
+    return (int64_t)val;
+}
+
+static inline dbhist_blk *dbhist_block(const dbhist *hist, int pos, uint32_t bno)
+{
+    return &hist->blk[(size_t)pos * hist->nblk + bno % hist->nblk];
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbhist_create
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :为一组测点建立历史记录，所有块一次申请并按缓存行对齐
+// Input          :npoint:测点数量
+//                :bytes:每个测点使用的字节数，按块尺寸向上取整，至少两个块，保证覆盖最早的
+//                 块时仍然保留一个块的历史
+// Output         :无
+// Return         :成功返回历史记录，失败返回NULL
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+dbhist *dbhist_create(int npoint, uint32_t bytes)
+{
+    void *mem = NULL;
+
+    if (npoint <= 0) {
+        return NULL;
+    }
+    dbhist *hist = (dbhist *)calloc(1, sizeof(dbhist));
+    if (NULL == hist) {
+        return NULL;
+    }
+    hist->npoint = npoint;
+    hist->nblk   = (bytes + DBHIST_BLOCK - 1) / DBHIST_BLOCK;
+    if (hist->nblk < 2) {
+        hist->nblk = 2;
+    }
+    size_t size = (size_t)npoint * hist->nblk * sizeof(dbhist_blk);
+    hist->cur = (dbhist_cur *)calloc(npoint, sizeof(dbhist_cur));
+    if (NULL == hist->cur || posix_memalign(&mem, 64, size) != 0) {
+        free(hist->cur);
+        free(hist);
+        return NULL;
+    }
+    memset(mem, 0, size);
+    hist->blk = (dbhist_blk *)mem;
+    return hist;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbhist_append
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :追加一个样本.先计算编码长度，当前块放不下或类型改变时覆盖环中最早的块，
+//                 新块保存完整的时间和值
+// Input          :hist:历史记录
+//                :pos:测点位置
+//                :ts:样本时间，毫秒
+//                :type:数据类型，只接受定长数值类型
+//                :raw:原始值，按dbvar联合体的方式保存
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+void dbhist_append(dbhist *hist, int pos, uint64_t ts, int type, uint64_t raw)
+{
+    dbhist_cur *cur = &hist->cur[pos];
+    uint64_t val = dbhist_is_float(type) ? raw : dbhist_widen(type, raw);
+
+    if (0 != cur->bno) {
+        dbhist_blk *blk = dbhist_block(hist, pos, cur->bno);
+        if (blk->type == type && blk->count < 0xFFFF) {
+            dbhist_code code;
+            int64_t delta = (int64_t)(ts - cur->ts);
+            code.num  = 0;
+            code.bits = 0;
+            dbhist_enc_int(&code, delta - cur->delta);
+            if (dbhist_is_float(type)) {
+                dbhist_enc_xor(&code, cur, val);
+            } else {
+                dbhist_enc_int(&code, (int64_t)(val - cur->val));
+                code.lead  = cur->lead;
+                code.trail = cur->trail;
+            }
+            if (blk->bits + code.bits <= DBHIST_BITS) {
+                uint32_t bit = blk->bits;
+                __atomic_store_n(&blk->seq, blk->seq + 1, __ATOMIC_RELAXED);
+                __atomic_thread_fence(__ATOMIC_RELEASE);
+                for (int idx = 0; idx < code.num; ++idx) {
+                    dbhist_put(blk->data, bit, code.val[idx], code.len[idx]);
+                    bit += code.len[idx];
+                }
+                blk->bits = (uint16_t)bit;
+                ++blk->count;
+                __atomic_store_n(&blk->seq, blk->seq + 1, __ATOMIC_RELEASE);
+                cur->ts    = ts;
+                cur->delta = delta;
+                cur->val   = val;
+                cur->lead  = code.lead;
+                cur->trail = code.trail;
+                return;
+            }
+        }
+    }
+    // 开始新块，覆盖环中最早的块
+    uint32_t bno = cur->bno + 1;
+    dbhist_blk *blk = dbhist_block(hist, pos, bno);
+    __atomic_store_n(&blk->seq, blk->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    blk->bno   = bno;
+    blk->count = 1;
+    blk->bits  = 0;
+    blk->type  = (uint8_t)type;
+    blk->t0    = ts;
+    blk->v0    = val;
+    memset(blk->data, 0, sizeof(blk->data));
+    __atomic_store_n(&blk->seq, blk->seq + 1, __ATOMIC_RELEASE);
+    cur->ts    = ts;
+    cur->delta = 0;
+    cur->val   = val;
+    cur->lead  = DBHIST_NOWIN;
+    cur->trail = 0;
+    __atomic_store_n(&cur->bno, bno, __ATOMIC_RELEASE);
+}
+
+// 复制一个块的一致副本
+static void dbhist_copy(const dbhist_blk *blk, dbhist_blk *out)
+{
+    uint32_t seq0, seq1;
+
+    for (;;) {
+        seq0 = __atomic_load_n(&blk->seq, __ATOMIC_ACQUIRE);
+        if (seq0 & 1) {
+            continue;
+        }
+        memcpy(out, blk, sizeof(dbhist_blk));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq1 = __atomic_load_n(&blk->seq, __ATOMIC_RELAXED);
+        if (seq0 == seq1) {
+            break;
+        }
+    }
+}
+
+// 把输出环旋转为按时间升序，first为最早样本的位置
+static void dbhist_rotate(dbsample *out, int num, int first)
+{
+    dbsample tmp;
+
+    for (int pass = 0; pass < 3; ++pass) {
+        int head = (0 == pass) ? 0 : (1 == pass) ? first : 0;
+        int tail = (0 == pass) ? first : num;
+        for (--tail; head < tail; ++head, --tail) {
+            tmp = out[head];
+            out[head] = out[tail];
+            out[tail] = tmp;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbhist_query
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :查询一个测点在时间范围内的样本.从最早的块开始逐块复制并解码，输出数组
+//                 作为环使用，超过max时覆盖最早的样本，最后旋转为升序
+// Input          :hist:历史记录
+//                :pos:测点位置
+//                :from:起始时间，毫秒
+//                :to:结束时间，包含在内
+//                :max:输出数组的容量
+// Output         :out:样本
+// Return         :输出的样本数量
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbhist_query(const dbhist *hist, int pos, uint64_t from, uint64_t to, dbsample *out, int max)
+{
+    dbhist_blk copy;
+    int total = 0;
+
+    if (NULL == hist || pos < 0 || pos >= hist->npoint || NULL == out || max <= 0) {
+        return 0;
+    }
+    uint32_t head  = __atomic_load_n(&hist->cur[pos].bno, __ATOMIC_ACQUIRE);
+    uint32_t first = head >= hist->nblk ? head - hist->nblk + 1 : 1;
+    for (uint32_t bno = first; bno <= head && 0 != head; ++bno) {
+        dbhist_copy(dbhist_block(hist, pos, bno), &copy);
+        if (copy.bno != bno) { // 复制前已经被覆盖，丢弃更早的样本，保证输出连续
+            total = 0;
+            continue;
+        }
+        uint64_t ts = copy.t0, val = copy.v0;
+        int64_t delta = 0;
+        uint8_t lead = DBHIST_NOWIN, trail = 0;
+        uint32_t bit = 0, end = copy.bits;
+        for (int idx = 0; idx < copy.count && bit <= end; ++idx) {
+            if (idx > 0) {
+                delta += dbhist_dec_int(copy.data, &bit, end);
+                ts    += delta;
+                if (!dbhist_is_float(copy.type)) {
+                    val += dbhist_dec_int(copy.data, &bit, end);
+                } else if (1 == dbhist_get(copy.data, &bit, end, 1)) {
+                    if (1 == dbhist_get(copy.data, &bit, end, 1)) {
+                        lead  = dbhist_get(copy.data, &bit, end, 6);
+                        trail = 64 - lead - (dbhist_get(copy.data, &bit, end, 6) + 1);
+                    } else if (DBHIST_NOWIN == lead) { // 没有窗口时不会出现10
+                        break;
+                    }
+                    val ^= dbhist_get(copy.data, &bit, end, 64 - lead - trail) << trail;
+                }
+                if (bit > end) {
+                    break;
+                }
+            }
+            if (ts < from || ts > to) {
+                continue;
+            }
+            dbsample *smp = &out[total % max];
+            smp->ts   = ts;
+            smp->type = copy.type;
+            memset(smp->rsv, 0, sizeof(smp->rsv));
+            smp->u64  = dbhist_narrow(copy.type, val);
+            ++total;
+        }
+    }
+    if (total > max) {
+        dbhist_rotate(out, max, total % max);
+        total = max;
+    }
+    return total;
+}
+
+size_t dbhist_size(const dbhist *hist)
+{
+    return sizeof(dbhist) + (size_t)hist->npoint * (sizeof(dbhist_cur) + hist->nblk * sizeof(dbhist_blk));
+}
+
+void dbhist_free(dbhist *hist)
+{
+    if (NULL != hist) {
+        free(hist->cur);
+        free(hist->blk);
+        free(hist);
+    }
+}
+
+uint64_t dbhist_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,33 @@
+#ifndef DBHIST_H_
+#define DBHIST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "db_in_mem.h"
+
+// 测点历史记录，供db_in_mem使用.每个测点有固定数量的历史块组成的环，写满后覆盖最早的块
+// 块内第一个样本保存完整的时间和原始值，之后的样本只保存差异:
+//   时间使用二阶差分(delta-of-delta)，按大小分为1/9/12/16/68位几档
+//   浮点数使用与前一个值异或(Gorilla)，相同时只占1位
+//   整数使用与前一个值的差，编码方式与时间相同
+// 写入由对象写锁串行，读者通过块的顺序锁复制一致副本，不阻塞写入
+
+#define DBHIST_BLOCK 128 // 历史块尺寸，包含32字节块头
+
+typedef struct dbhist dbhist;
+
+// 为npoint个测点建立历史记录，每个测点使用bytes字节，至少两个块
+dbhist *dbhist_create(int npoint, uint32_t bytes);
+// 追加一个样本，type为定长数值类型，raw为原始值，调用者保证同一测点的追加串行执行
+void dbhist_append(dbhist *hist, int pos, uint64_t ts, int type, uint64_t raw);
+// 查询时间在[from, to]之间的样本，按时间升序输出，超过max时保留最新的max个，返回输出的数量
+int dbhist_query(const dbhist *hist, int pos, uint64_t from, uint64_t to, dbsample *out, int max);
+// 占用的内存尺寸
+size_t dbhist_size(const dbhist *hist);
+// 释放历史记录
+void dbhist_free(dbhist *hist);
+// 当前时间，从1970年开始的毫秒数
+uint64_t dbhist_now(void);
+
+#endif
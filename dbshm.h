@@ -0,0 +1,215 @@
+#ifndef DBSHM_H_
+#define DBSHM_H_
+
+// 内存数据库的共享内存导出格式以及应用进程使用的读取接口
+// 通讯者在所有对象初始化完成后调用dbmem_export，把测点值镜像到shm_open建立的共享内存中，
+// 之后每次写入同步更新镜像.应用进程用dbshm_map映射一次，之后读取测点不需要任何系统调用
+// 本文件不依赖通讯者的其他头文件，可以单独交给应用使用，数据类型取值与db_in_mem.h中的DB_*相同
+//
+// 共享内存布局，所有偏移都相对于区域起始位置，版本号变化时布局不兼容:
+//   dbshm_head | dbshm_obj[nobj](按对象编号升序) | 每个对象的编号索引 | 每个对象的测点槽
+// 测点槽使用顺序锁，seq为奇数时表示正在写入，读者重试
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DBSHM_MAGIC    0x48534244 // "DBSH"
+#define DBSHM_VERSION  1
+#define DBSHM_DATA     48         // 测点槽中字符串和二进制数据的最大长度，超出部分截断
+#define DBSHM_STRING   11         // 与DB_STRING相同
+#define DBSHM_BLOB     12         // 与DB_BLOB相同
+
+// 函数返回结果定义
+#define DBSHM_OK         0
+#define DBSHM_ER_OPEN   -1 // 共享内存不存在或无法映射
+#define DBSHM_ER_FORMAT -2 // 格式或版本不匹配
+#define DBSHM_ER_OBJ    -3 // 未知对象
+#define DBSHM_ER_ID     -4 // 未知测点
+#define DBSHM_ER_TRUNC  -5 // 数据超过DBSHM_DATA，只复制了前面的部分
+#define DBSHM_ER_BUSY   -6 // 重试DBSHM_RETRY次仍没有读到一致的副本，写入者可能已经异常退出
+
+#define DBSHM_RETRY    100000     // dbshm_read读取一个测点的最多尝试次数
+
+// 区域头，64字节
+typedef struct {
+    uint32_t magic;     // DBSHM_MAGIC
+    uint16_t version;   // DBSHM_VERSION
+    uint16_t slot_size; // 测点槽尺寸，sizeof(dbshm_slot)
+    uint32_t size;      // 区域总尺寸
+    uint16_t nobj;      // 对象数量
+    uint16_t rsv;
+    uint32_t obj_off;   // 对象表偏移
+    uint8_t  pad[44];
+}dbshm_head;
+
+// 对象表项，16字节
+typedef struct {
+    uint16_t obj_id;    // 对象编号
+    uint16_t npoint;    // 测点数量
+    uint16_t max_id;    // 最大测点编号，索引长度为max_id+1
+    uint16_t rsv;
+    uint32_t index_off; // 编号索引偏移，uint16_t数组，值为测点槽序号加1，0表示没有该测点
+    uint32_t slot_off;  // 测点槽偏移
+}dbshm_obj;
+
+// 测点槽，64字节，一个缓存行
+typedef struct {
+    uint32_t seq;       // 顺序锁计数
+    uint16_t id;        // 测点编号
+    uint8_t  type;      // 数据类型，DB_*
+    uint8_t  rsv;
+    uint32_t len;       // 数据长度，字符串和二进制数据为完整长度
+    uint32_t rsv2;
+    union {
+        int8_t   i8;
+        uint8_t  u8;
+        int16_t  i16;
+        uint16_t u16;
+        int32_t  i32;
+        uint32_t u32;
+        int64_t  i64;
+        uint64_t u64;
+        float    f;
+        double   d;
+        int32_t  bl;
+        char     data[DBSHM_DATA]; // 字符串以0结尾，截断时不保证
+    };
+}dbshm_slot;
+
+// 应用进程的映射句柄
+typedef struct {
+    const uint8_t    *base; // 映射起始地址
+    size_t            size; // 映射尺寸
+    const dbshm_head *head;
+}dbshm_db;
+
+// 检查区域中[off, off+len)是否在size以内并且按align对齐
+static inline int dbshm_range(uint64_t off, uint64_t len, uint64_t size, uint64_t align)
+{
+    return 0 == off % align && off <= size && len <= size - off;
+}
+
+// 检查区域头和对象表中的所有偏移都在区域以内，索引中的槽序号不超过测点数量.映射时检查一次，
+// 之后的查找和读取不再检查
+static inline int dbshm_check(const uint8_t *base, uint64_t size)
+{
+    const dbshm_head *head = (const dbshm_head *)base;
+
+    if (!dbshm_range(head->obj_off, (uint64_t)sizeof(dbshm_obj) * head->nobj, size, sizeof(uint32_t))) {
+        return DBSHM_ER_FORMAT;
+    }
+    const dbshm_obj *tab = (const dbshm_obj *)(base + head->obj_off);
+    for (int idx = 0; idx < head->nobj; ++idx) {
+        if (!dbshm_range(tab[idx].index_off, sizeof(uint16_t) * ((uint64_t)tab[idx].max_id + 1), size, sizeof(uint16_t))
+            || !dbshm_range(tab[idx].slot_off, (uint64_t)sizeof(dbshm_slot) * tab[idx].npoint, size, sizeof(uint64_t))) {
+            return DBSHM_ER_FORMAT;
+        }
+        const uint16_t *index = (const uint16_t *)(base + tab[idx].index_off);
+        for (int id = 0; id <= tab[idx].max_id; ++id) {
+            if (index[id] > tab[idx].npoint) {
+                return DBSHM_ER_FORMAT;
+            }
+        }
+    }
+    return DBSHM_OK;
+}
+
+// 映射共享内存，只读
+static inline int dbshm_map(const char *name, dbshm_db *db)
+{
+    struct stat st;
+    int fd = shm_open(name, O_RDONLY, 0);
+
+    if (fd < 0) {
+        return DBSHM_ER_OPEN;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(dbshm_head)) {
+        close(fd);
+        return DBSHM_ER_OPEN;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base) {
+        return DBSHM_ER_OPEN;
+    }
+    db->base = (const uint8_t *)base;
+    db->size = st.st_size;
+    db->head = (const dbshm_head *)base;
+    // 魔数最后写入，读到魔数后其他内容都已经完整
+    if (DBSHM_MAGIC != __atomic_load_n(&db->head->magic, __ATOMIC_ACQUIRE) || DBSHM_VERSION != db->head->version
+        || sizeof(dbshm_slot) != db->head->slot_size || db->head->size > db->size
+        || DBSHM_OK != dbshm_check(db->base, db->head->size)) {
+        munmap(base, st.st_size);
+        db->base = NULL;
+        return DBSHM_ER_FORMAT;
+    }
+    return DBSHM_OK;
+}
+
+// 解除映射
+static inline void dbshm_unmap(dbshm_db *db)
+{
+    if (NULL != db->base) {
+        munmap((void *)db->base, db->size);
+        db->base = NULL;
+    }
+}
+
+// 按编号查找对象，返回的指针在映射期间一直有效，可以缓存
+static inline const dbshm_obj *dbshm_find(const dbshm_db *db, uint16_t obj_id)
+{
+    const dbshm_obj *tab = (const dbshm_obj *)(db->base + db->head->obj_off);
+    int head = 0, tail = db->head->nobj;
+
+    while (head < tail) {
+        int mid = (head + tail) / 2;
+        if (tab[mid].obj_id < obj_id) {
+            head = mid + 1;
+        } else {
+            tail = mid;
+        }
+    }
+    return (head < db->head->nobj && tab[head].obj_id == obj_id) ? &tab[head] : NULL;
+}
+
+// 读取一个测点的一致副本，成功返回DBSHM_OK，字符串超长时返回DBSHM_ER_TRUNC.写入者停在写入中间
+// (例如通讯者在写入时被杀死)时seq一直为奇数，重试DBSHM_RETRY次后返回DBSHM_ER_BUSY
+static inline int dbshm_read(const dbshm_db *db, const dbshm_obj *obj, uint16_t id, dbshm_slot *out)
+{
+    uint32_t seq0, seq1;
+
+    if (NULL == obj) {
+        return DBSHM_ER_OBJ;
+    }
+    if (id > obj->max_id) {
+        return DBSHM_ER_ID;
+    }
+    uint16_t pos = ((const uint16_t *)(db->base + obj->index_off))[id];
+    if (0 == pos) {
+        return DBSHM_ER_ID;
+    }
+    const dbshm_slot *slot = (const dbshm_slot *)(db->base + obj->slot_off) + (pos - 1);
+    for (int retry = 0;; ++retry) {
+        if (retry >= DBSHM_RETRY) {
+            return DBSHM_ER_BUSY;
+        }
+        seq0 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq0 & 1) {
+            continue;
+        }
+        memcpy(out, slot, sizeof(dbshm_slot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq1 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+        if (seq0 == seq1) {
+            break;
+        }
+    }
+    return out->len > DBSHM_DATA && (DBSHM_STRING == out->type || DBSHM_BLOB == out->type)
+        ? DBSHM_ER_TRUNC : DBSHM_OK;
+}
+
+#endif
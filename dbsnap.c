@@ -0,0 +1,759 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :dbsnap.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :内存数据库的快照和变化日志。后台线程按周期把变化的测点追加到日志，按更长
+//                 的周期生成快照；启动时映射快照文件并重放日志，重启后不需要等待重新采集。
+// Interface      :无
+// Others         :快照不阻塞写入者：生成快照前先切换到新一代日志，再用无锁读取逐个对象复制
+//                 测点值.复制期间的写入同时记录在新日志中，日志保存的是写入后的完整值，按顺序
+//                 重放到快照上得到的就是最后的状态，所以快照不需要是某一时刻的精确副本。
+//                 变化记录使用db_in_mem的DBMEM_WATCH_LOG通道，同一周期内的多次写入只记录一次
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define GLOG4C_MODULE GLOG4C_MOD_DBMEM
+#include "glog4c.h"
+#include "db_in_mem.h"
+#include "dbsnap.h"
+
+#define DBSNAP_MAGIC     0x4E534244 // "DBSN"
+#define DBSNAP_VERSION   1
+#define DBSNAP_HEAD_SIZE 16         // 快照头：魔数4B | 版本2B | 保留2B | 代数4B | 对象数量4B
+#define DBSNAP_REC_HEAD  8          // 日志记录头：长度4B | 校验4B
+#define DBSNAP_MAX_IDS   4096       // 一个对象最多的测点数量
+#define DBSNAP_MAX_SKIP  16
+#define DBSNAP_MAX_GENS  64         // 恢复时最多重放的日志文件数量，超出时只重放代数最大的
+
+// 编码缓冲区，按需要增长，线程退出时释放
+typedef struct {
+    uint8_t *data;
+    size_t   len;
+    size_t   cap;
+}dbsnap_buf;
+
+static char     m_dir[256];
+static uint32_t m_jnl_ms  = 1000;
+static uint32_t m_snap_s  = 300;
+static uint16_t m_skip[DBSNAP_MAX_SKIP];
+static int      m_nskip   = 0;
+static uint32_t m_gen     = 0;   // 当前日志的代数
+static uint32_t m_oldest  = 0;   // 目录中最早的日志代数，快照成功后删除更早的日志
+static int      m_jfd     = -1;  // 当前日志文件
+static int      m_run     = 0;   // 后台线程正在运行
+static int      m_stop    = 0;
+static uint32_t m_crc_tab[256];
+static dbsnap_buf m_buf;
+static uint16_t m_ids[DBSNAP_MAX_IDS];
+static uint64_t m_vals[DBSNAP_MAX_IDS];
+static pthread_t       m_thread;
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER; // 保护m_stop和条件变量
+static pthread_cond_t  m_cond; // 使用CLOCK_MONOTONIC，在dbsnap_start中初始化
+static pthread_mutex_t m_io   = PTHREAD_MUTEX_INITIALIZER; // 日志和快照文件操作互斥
+
+// CRC32，多项式0xEDB88320
+static uint32_t dbsnap_crc(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc = m_crc_tab[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// 保证缓冲区还有need字节的空间
+static int dbsnap_reserve(dbsnap_buf *buf, size_t need)
+{
+    if (buf->len + need <= buf->cap) {
+        return DBSNAP_OK;
+    }
+    size_t cap = (0 == buf->cap) ? 65536 : buf->cap;
+    while (cap < buf->len + need) {
+        cap *= 2;
+    }
+    uint8_t *mem = (uint8_t *)realloc(buf->data, cap);
+    if (NULL == mem) {
+        return DBSNAP_ER_MEM;
+    }
+    buf->data = mem;
+    buf->cap  = cap;
+    return DBSNAP_OK;
+}
+
+static void dbsnap_path(char *path, size_t size, const char *name, int gen)
+{
+    if (gen < 0) {
+        snprintf(path, size, "%s/%s", m_dir, name);
+    } else {
+        snprintf(path, size, "%s/%s.%u", m_dir, name, (uint32_t)gen);
+    }
+}
+
+static int dbsnap_skipped(uint16_t obj_id)
+{
+    for (int idx = 0; idx < m_nskip; ++idx) {
+        if (m_skip[idx] == obj_id) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsnap_encode
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :把一个对象的若干测点编码到缓冲区末尾.格式为对象编号2B | 数量2B | 条目，
+//                 条目为编号2B | 类型1B | 长度2B | 数据，没有值的测点不编码
+// Input          :obj_id:对象编号
+//                :ids:测点编号
+//                :num:测点数量
+// Output         :buf:编码缓冲区
+// Return         :成功返回编码的测点数量，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static int dbsnap_encode(dbsnap_buf *buf, uint16_t obj_id, const uint16_t *ids, int num)
+{
+    dbvar var;
+    uint16_t count = 0;
+
+    if (dbsnap_reserve(buf, 4) < 0) {
+        return DBSNAP_ER_MEM;
+    }
+    size_t head = buf->len;
+    memcpy(buf->data + head, &obj_id, 2);
+    buf->len += 4;
+    // 读临界区内字符串不会被释放
+    dbmem_read_lock();
+    for (int idx = 0; idx < num; ++idx) {
+        if (dbmem_read_value(obj_id, ids[idx], &var) != OBJSYS_RET_OK || DB_NULL == var.type) {
+            continue;
+        }
+        const void *data = &var.u64;
+        if (DB_STRING == var.type) {
+            data = dbvar_str(&var);
+        } else if (DB_BLOB == var.type) {
+            data = dbvar_blob(&var);
+        }
+        uint16_t len = var.len;
+        if (dbsnap_reserve(buf, 5 + len) < 0) {
+            dbmem_read_unlock();
+            return DBSNAP_ER_MEM;
+        }
+        uint8_t *ptr = buf->data + buf->len;
+        memcpy(ptr, &ids[idx], 2);
+        ptr[2] = var.type;
+        memcpy(ptr + 3, &len, 2);
+        memcpy(ptr + 5, data, len);
+        buf->len += 5 + len;
+        ++count;
+    }
+    dbmem_read_unlock();
+    memcpy(buf->data + head + 2, &count, 2);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsnap_apply
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :解码一个对象的测点并批量写入数据库，不存在的对象和测点跳过.定长数值先复制
+//                 到对齐的缓冲区，字符串和二进制数据直接引用映射的文件内容
+// Input          :ptr:对象数据起始位置
+//                :end:可用数据的结束位置
+// Output         :restored:累加写入的测点数量
+// Return         :成功返回消耗的字节数，格式错误返回DBSNAP_ER_FORMAT
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static int dbsnap_apply(const uint8_t *ptr, const uint8_t *end, int *restored)
+{
+    static uint8_t     types[DBSNAP_MAX_IDS];
+    static const void *values[DBSNAP_MAX_IDS];
+    static uint32_t    sizes[DBSNAP_MAX_IDS];
+    const uint8_t *cur = ptr + 4;
+    uint16_t obj_id, count;
+
+    if (end - ptr < 4) {
+        return DBSNAP_ER_FORMAT;
+    }
+    memcpy(&obj_id, ptr, 2);
+    memcpy(&count, ptr + 2, 2);
+    if (count > DBSNAP_MAX_IDS) {
+        return DBSNAP_ER_FORMAT;
+    }
+    for (int idx = 0; idx < count; ++idx) {
+        uint16_t len;
+        if (end - cur < 5) {
+            return DBSNAP_ER_FORMAT;
+        }
+        memcpy(&m_ids[idx], cur, 2);
+        types[idx] = cur[2];
+        memcpy(&len, cur + 3, 2);
+        if (end - cur - 5 < len) {
+            return DBSNAP_ER_FORMAT;
+        }
+        sizes[idx] = len;
+        if (DB_STRING == types[idx] || DB_BLOB == types[idx]) {
+            values[idx] = cur + 5;
+        } else if (len <= sizeof(uint64_t)) {
+            m_vals[idx] = 0;
+            memcpy(&m_vals[idx], cur + 5, len);
+            values[idx] = &m_vals[idx];
+        } else {
+            return DBSNAP_ER_FORMAT;
+        }
+        cur += 5 + len;
+    }
+    if (!dbsnap_skipped(obj_id)) {
+        int ret = dbmem_set_values(obj_id, m_ids, types, values, sizes, count);
+        if (ret > 0) {
+            *restored += ret;
+        }
+    }
+    return (int)(cur - ptr);
+}
+
+// 映射整个文件，文件为空或不存在时返回NULL
+static const uint8_t *dbsnap_map(const char *path, size_t *size)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || 0 == st.st_size) {
+        close(fd);
+        return NULL;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base) {
+        return NULL;
+    }
+    *size = st.st_size;
+    return (const uint8_t *)base;
+}
+
+// 加载快照，成功时返回快照的代数，没有可用快照时返回-1
+static int dbsnap_load_snap(int *restored)
+{
+    char path[300];
+    size_t size = 0;
+    uint32_t magic, gen, nobj, crc;
+    uint16_t version;
+
+    dbsnap_path(path, sizeof(path), "db.snap", -1);
+    const uint8_t *base = dbsnap_map(path, &size);
+    if (NULL == base) {
+        return -1;
+    }
+    int result = -1;
+    if (size < DBSNAP_HEAD_SIZE + 4) {
+        goto EXIT_LS;
+    }
+    memcpy(&magic, base, 4);
+    memcpy(&version, base + 4, 2);
+    memcpy(&gen, base + 8, 4);
+    memcpy(&nobj, base + 12, 4);
+    memcpy(&crc, base + size - 4, 4);
+    if (DBSNAP_MAGIC != magic || DBSNAP_VERSION != version || dbsnap_crc(0, base, size - 4) != crc) {
+        glog4c_err("snapshot file is broken, ignore it\n");
+        goto EXIT_LS;
+    }
+    const uint8_t *cur = base + DBSNAP_HEAD_SIZE, *end = base + size - 4;
+    for (uint32_t idx = 0; idx < nobj; ++idx) {
+        int used = dbsnap_apply(cur, end, restored);
+        if (used < 0) {
+            break;
+        }
+        cur += used;
+    }
+    result = (int)gen;
+EXIT_LS:
+    munmap((void *)base, size);
+    return result;
+}
+
+// 重放一个日志文件，末尾不完整或校验错误的记录及之后的内容被丢弃
+static void dbsnap_replay(uint32_t gen, int *restored)
+{
+    char path[300];
+    size_t size = 0;
+    uint32_t len, crc;
+
+    dbsnap_path(path, sizeof(path), "db.jnl", gen);
+    const uint8_t *base = dbsnap_map(path, &size);
+    if (NULL == base) {
+        return;
+    }
+    const uint8_t *cur = base, *end = base + size;
+    while (end - cur >= DBSNAP_REC_HEAD) {
+        memcpy(&len, cur, 4);
+        memcpy(&crc, cur + 4, 4);
+        if ((size_t)(end - cur - DBSNAP_REC_HEAD) < len
+            || dbsnap_crc(0, cur + DBSNAP_REC_HEAD, len) != crc) {
+            glog4c_warn("journal %u is truncated at %zu\n", gen, (size_t)(cur - base));
+            break;
+        }
+        const uint8_t *rec = cur + DBSNAP_REC_HEAD;
+        while (rec < cur + DBSNAP_REC_HEAD + len) {
+            int used = dbsnap_apply(rec, cur + DBSNAP_REC_HEAD + len, restored);
+            if (used < 0) {
+                break;
+            }
+            rec += used;
+        }
+        cur += DBSNAP_REC_HEAD + len;
+    }
+    munmap((void *)base, size);
+}
+
+static int dbsnap_cmp_gen(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsnap_load
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :映射最新的快照并写入数据库，再按代数顺序重放代数不小于快照的日志.快照损坏
+//                 或不存在时只重放日志，日志保存的是完整值，可以得到部分测点.扫描整个目录
+//                 得到最早和最新的代数，新日志从最新的代数之后开始；需要重放的日志超过
+//                 DBSNAP_MAX_GENS时只重放代数最大的部分，并报告跳过的数量
+// Input          :无
+// Output         :无
+// Return         :成功返回恢复的测点数量(重放中同一测点可能被计算多次)，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 扫描整个目录，保留代数最大的日志，不再受目录顺序影响
+//------------------------------------------------------------------------------
+int dbsnap_load(void)
+{
+    uint32_t gens[DBSNAP_MAX_GENS];
+    uint32_t oldest = UINT32_MAX, newest = 0;
+    int ngen = 0, skipped = 0, restored = 0;
+
+    if ('\0' == m_dir[0]) {
+        return DBSNAP_ER_PARAM;
+    }
+    int snap = dbsnap_load_snap(&restored);
+
+    DIR *dir = opendir(m_dir);
+    if (NULL == dir) {
+        return DBSNAP_ER_FILE;
+    }
+    struct dirent *ent;
+    while (NULL != (ent = readdir(dir))) {
+        char *tail;
+        if (strncmp(ent->d_name, "db.jnl.", 7) != 0) {
+            continue;
+        }
+        unsigned long num = strtoul(ent->d_name + 7, &tail, 10);
+        if ('\0' != *tail || tail == ent->d_name + 7 || num > UINT32_MAX) {
+            continue;
+        }
+        uint32_t gen = (uint32_t)num;
+        oldest = gen < oldest ? gen : oldest;
+        newest = gen > newest ? gen : newest;
+        if (snap >= 0 && gen < (uint32_t)snap) {
+            continue; // 已经包含在快照中
+        }
+        if (ngen < DBSNAP_MAX_GENS) {
+            gens[ngen++] = gen;
+            continue;
+        }
+        // 已满时替换代数最小的
+        int low = 0;
+        for (int idx = 1; idx < ngen; ++idx) {
+            if (gens[idx] < gens[low]) {
+                low = idx;
+            }
+        }
+        if (gen > gens[low]) {
+            gens[low] = gen;
+        }
+        ++skipped;
+    }
+    closedir(dir);
+    qsort(gens, ngen, sizeof(uint32_t), dbsnap_cmp_gen);
+    if (skipped > 0) {
+        glog4c_log(LOG_ERR, "%d journals before generation %u are not replayed, over %d\n",
+            skipped, gens[0], DBSNAP_MAX_GENS);
+    }
+
+    m_gen    = snap < 0 ? 0 : (uint32_t)snap;
+    m_oldest = m_gen;
+    if (oldest < m_oldest) {
+        m_oldest = oldest;
+    }
+    if (newest > m_gen) {
+        m_gen = newest;
+    }
+    for (int idx = 0; idx < ngen; ++idx) {
+        dbsnap_replay(gens[idx], &restored);
+    }
+    glog4c_info("restore %d values from snapshot %d and %d journals\n", restored, snap, ngen);
+    return restored;
+}
+
+// 日志记录没有写入时，把缓冲区中[start, end)已经编码的测点重新标记为变化，下个周期再写
+static void dbsnap_requeue(const dbsnap_buf *buf, size_t start, size_t end)
+{
+    const uint8_t *cur = buf->data + start;
+    uint16_t obj_id, count, len;
+
+    while (cur + 4 <= buf->data + end) {
+        memcpy(&obj_id, cur, 2);
+        memcpy(&count, cur + 2, 2);
+        cur += 4;
+        for (int idx = 0; idx < count && idx < DBSNAP_MAX_IDS; ++idx) {
+            memcpy(&m_ids[idx], cur, 2);
+            memcpy(&len, cur + 3, 2);
+            cur += 5 + len;
+        }
+        dbmem_put_dirty(obj_id, DBMEM_WATCH_LOG, m_ids, count);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsnap_journal
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :取走所有对象在日志通道上的变化，读取当前值编码成一条记录追加到当前日志，
+//                 并等待数据落盘.没有变化时不写文件.写入或落盘失败时把日志截断到追加前的
+//                 长度，已经取走的测点重新标记为变化，下个周期再写，日志中不会留下半条记录.
+//                 调用者持有m_io
+// Input          :无
+// Output         :无
+// Return         :成功返回记录的测点数量，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 失败时截断日志并放回变化
+//------------------------------------------------------------------------------
+static int dbsnap_journal(void)
+{
+    int total = 0;
+
+    m_buf.len = 0;
+    if (dbsnap_reserve(&m_buf, DBSNAP_REC_HEAD) < 0) {
+        return DBSNAP_ER_MEM;
+    }
+    m_buf.len = DBSNAP_REC_HEAD;
+    for (int id = dbmem_next_obj(-1); id >= 0; id = dbmem_next_obj(id)) {
+        if (dbsnap_skipped(id)) {
+            continue;
+        }
+        int num = dbmem_take_dirty(id, DBMEM_WATCH_LOG, m_ids, DBSNAP_MAX_IDS);
+        if (num <= 0) {
+            continue;
+        }
+        size_t head = m_buf.len;
+        int ret = dbsnap_encode(&m_buf, id, m_ids, num);
+        if (ret < 0) {
+            dbmem_put_dirty(id, DBMEM_WATCH_LOG, m_ids, num);
+            dbsnap_requeue(&m_buf, DBSNAP_REC_HEAD, head);
+            return ret;
+        }
+        total += ret;
+    }
+    if (m_buf.len == DBSNAP_REC_HEAD) {
+        return total;
+    }
+    uint32_t len = m_buf.len - DBSNAP_REC_HEAD;
+    uint32_t crc = dbsnap_crc(0, m_buf.data + DBSNAP_REC_HEAD, len);
+    memcpy(m_buf.data, &len, 4);
+    memcpy(m_buf.data + 4, &crc, 4);
+    off_t start = (m_jfd < 0) ? -1 : lseek(m_jfd, 0, SEEK_END);
+    int result = (start < 0) ? DBSNAP_ER_FILE : total;
+    for (size_t off = 0; start >= 0 && off < m_buf.len;) {
+        ssize_t ret = write(m_jfd, m_buf.data + off, m_buf.len - off);
+        if (ret < 0 && EINTR == errno) {
+            continue;
+        }
+        if (ret <= 0) {
+            glog4c_err(strerror(errno));
+            result = DBSNAP_ER_FILE;
+            break;
+        }
+        off += ret;
+    }
+    if (result >= 0 && fdatasync(m_jfd) < 0) {
+        glog4c_err(strerror(errno));
+        result = DBSNAP_ER_FILE;
+    }
+    if (result < 0) {
+        if (start >= 0 && ftruncate(m_jfd, start) < 0) {
+            glog4c_err(strerror(errno));
+        }
+        dbsnap_requeue(&m_buf, DBSNAP_REC_HEAD, m_buf.len);
+    }
+    return result;
+}
+
+// 打开一代新日志，之后的变化写入新日志
+static int dbsnap_open_journal(uint32_t gen)
+{
+    char path[300];
+
+    dbsnap_path(path, sizeof(path), "db.jnl", gen);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        glog4c_err(strerror(errno));
+        return DBSNAP_ER_FILE;
+    }
+    if (m_jfd >= 0) {
+        close(m_jfd);
+    }
+    m_jfd = fd;
+    m_gen = gen;
+    return DBSNAP_OK;
+}
+
+// 把快照写入临时文件，落盘后改名替换旧快照
+static int dbsnap_write(uint32_t gen)
+{
+    char path[300], tmp[300];
+    uint32_t nobj = 0, crc = 0;
+    int result = DBSNAP_OK;
+
+    dbsnap_path(path, sizeof(path), "db.snap", -1);
+    dbsnap_path(tmp, sizeof(tmp), "db.snap.tmp", -1);
+    FILE *fp = fopen(tmp, "wb");
+    if (NULL == fp) {
+        glog4c_err(strerror(errno));
+        return DBSNAP_ER_FILE;
+    }
+    for (int id = dbmem_next_obj(-1); id >= 0; id = dbmem_next_obj(id)) {
+        nobj += !dbsnap_skipped(id);
+    }
+    uint8_t head[DBSNAP_HEAD_SIZE] = {0};
+    uint32_t magic = DBSNAP_MAGIC;
+    uint16_t version = DBSNAP_VERSION;
+    memcpy(head, &magic, 4);
+    memcpy(head + 4, &version, 2);
+    memcpy(head + 8, &gen, 4);
+    memcpy(head + 12, &nobj, 4);
+    crc = dbsnap_crc(crc, head, sizeof(head));
+    fwrite(head, 1, sizeof(head), fp);
+    // 逐个对象复制并写出，写入者不受影响，复制期间的变化由新一代日志记录
+    uint32_t written = 0;
+    for (int id = dbmem_next_obj(-1); id >= 0 && written < nobj; id = dbmem_next_obj(id)) {
+        if (dbsnap_skipped(id)) {
+            continue;
+        }
+        int num = dbmem_get_range(id, 0, 0xFFFF, m_ids, NULL, m_vals, DBSNAP_MAX_IDS);
+        m_buf.len = 0;
+        if (dbsnap_encode(&m_buf, id, m_ids, num < 0 ? 0 : num) < 0) {
+            result = DBSNAP_ER_MEM;
+            break;
+        }
+        crc = dbsnap_crc(crc, m_buf.data, m_buf.len);
+        fwrite(m_buf.data, 1, m_buf.len, fp);
+        ++written;
+    }
+    fwrite(&crc, 1, sizeof(crc), fp);
+    if (DBSNAP_OK == result && (written != nobj || fflush(fp) != 0 || ferror(fp) || fsync(fileno(fp)) < 0)) {
+        glog4c_err("write snapshot error\n");
+        result = DBSNAP_ER_FILE;
+    }
+    fclose(fp);
+    if (DBSNAP_OK != result || rename(tmp, path) < 0) {
+        unlink(tmp);
+        return DBSNAP_OK == result ? DBSNAP_ER_FILE : result;
+    }
+    // 改名本身也要落盘
+    int dfd = open(m_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd >= 0) {
+        fsync(dfd);
+        close(dfd);
+    }
+    return DBSNAP_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsnap_save
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :生成一次快照.先把未记录的变化写入当前日志，再切换到新一代日志，然后写出
+//                 快照，成功后删除比新快照更早的日志.快照失败时旧快照和所有日志都保留
+// Input          :无
+// Output         :无
+// Return         :成功返回DBSNAP_OK，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbsnap_save(void)
+{
+    char path[300];
+
+    pthread_mutex_lock(&m_io);
+    dbsnap_journal();
+    uint32_t gen = m_gen + 1;
+    int ret = dbsnap_open_journal(gen);
+    if (DBSNAP_OK == ret) {
+        ret = dbsnap_write(gen);
+    }
+    if (DBSNAP_OK == ret) {
+        for (; m_oldest < gen; ++m_oldest) {
+            dbsnap_path(path, sizeof(path), "db.jnl", m_oldest);
+            unlink(path);
+        }
+    }
+    pthread_mutex_unlock(&m_io);
+    return ret;
+}
+
+// 后台线程，按日志周期写日志，按快照周期生成快照
+static void *dbsnap_thread(void *arg)
+{
+    struct timespec ts, last;
+
+    (void)arg;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+    last.tv_sec -= m_snap_s; // 启动后立即生成一次快照
+    pthread_mutex_lock(&m_lock);
+    while (!m_stop) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        pthread_mutex_unlock(&m_lock);
+        if (ts.tv_sec - last.tv_sec >= (time_t)m_snap_s) {
+            dbsnap_save();
+            last = ts;
+        } else {
+            pthread_mutex_lock(&m_io);
+            dbsnap_journal();
+            pthread_mutex_unlock(&m_io);
+        }
+        pthread_mutex_lock(&m_lock);
+        ts.tv_sec  += m_jnl_ms / 1000;
+        ts.tv_nsec += (m_jnl_ms % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_nsec -= 1000000000L;
+            ++ts.tv_sec;
+        }
+        while (!m_stop && pthread_cond_timedwait(&m_cond, &m_lock, &ts) != ETIMEDOUT) {
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+    return NULL;
+}
+
+// 设置数据目录和周期，目录必需已经存在
+int dbsnap_init(const char *dir, uint32_t jnl_ms, uint32_t snap_s)
+{
+    if (NULL == dir || strlen(dir) >= sizeof(m_dir) || 0 == jnl_ms || 0 == snap_s) {
+        return DBSNAP_ER_PARAM;
+    }
+    for (uint32_t idx = 0; idx < 256; ++idx) {
+        uint32_t crc = idx;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+        m_crc_tab[idx] = crc;
+    }
+    strcpy(m_dir, dir);
+    m_jnl_ms = jnl_ms;
+    m_snap_s = snap_s;
+    return DBSNAP_OK;
+}
+
+// 增加不保存的对象
+int dbsnap_skip(uint16_t obj_id)
+{
+    if (m_nskip >= DBSNAP_MAX_SKIP) {
+        return DBSNAP_ER_PARAM;
+    }
+    m_skip[m_nskip++] = obj_id;
+    return DBSNAP_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsnap_start
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :在所有对象上打开日志通道的变化记录，打开新一代日志并启动后台线程.恢复时
+//                 读到的日志不再追加，避免接在不完整的记录后面
+// Input          :无
+// Output         :无
+// Return         :成功返回DBSNAP_OK，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbsnap_start(void)
+{
+    if ('\0' == m_dir[0] || m_run) {
+        return DBSNAP_ER_PARAM;
+    }
+    for (int id = dbmem_next_obj(-1); id >= 0; id = dbmem_next_obj(id)) {
+        if (!dbsnap_skipped(id) && dbmem_watch(id, DBMEM_WATCH_LOG, 1) != OBJSYS_RET_OK) {
+            return DBSNAP_ER_MEM;
+        }
+    }
+    if (dbsnap_open_journal(m_gen + 1) < 0) {
+        return DBSNAP_ER_FILE;
+    }
+    // 后台线程用单调时钟计算等待期限，条件变量也要使用单调时钟
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    m_stop = 0;
+    if (pthread_create(&m_thread, NULL, dbsnap_thread, NULL) != 0) {
+        pthread_cond_destroy(&m_cond);
+        return DBSNAP_ER_MEM;
+    }
+    m_run = 1;
+    return DBSNAP_OK;
+}
+
+// 停止后台线程，退出前写完剩余变化并生成最后一次快照，下次启动只需要加载快照
+void dbsnap_exit(void)
+{
+    if (!m_run) {
+        return;
+    }
+    pthread_mutex_lock(&m_lock);
+    m_stop = 1;
+    pthread_cond_signal(&m_cond);
+    pthread_mutex_unlock(&m_lock);
+    pthread_join(m_thread, NULL);
+    pthread_cond_destroy(&m_cond);
+    m_run = 0;
+    dbsnap_save();
+    if (m_jfd >= 0) {
+        close(m_jfd);
+        m_jfd = -1;
+    }
+    for (int id = dbmem_next_obj(-1); id >= 0; id = dbmem_next_obj(id)) {
+        dbmem_watch(id, DBMEM_WATCH_LOG, 0);
+    }
+    free(m_buf.data);
+    memset(&m_buf, 0, sizeof(m_buf));
+}
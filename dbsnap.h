@@ -0,0 +1,33 @@
+#ifndef DBSNAP_H_
+#define DBSNAP_H_
+
+#include <stdint.h>
+
+// 内存数据库的快照和变化日志，用于重启后快速恢复测点值
+// 目录中的文件:
+//   db.snap      最新的快照，先写db.snap.tmp再改名，任何时候都是完整的
+//   db.jnl.<N>   第N代变化日志，记录N代快照开始之后的变化
+// 恢复时先加载快照，再按代数顺序重放代数不小于快照的所有日志，日志末尾不完整的记录被丢弃.
+// 快照长期失败使日志超过64个时只重放代数最大的64个
+// 快照和日志使用本机字节序，只用于同一台设备的重启
+
+#define DBSNAP_OK          0
+#define DBSNAP_ER_PARAM   -1 // 参数错误
+#define DBSNAP_ER_FILE    -2 // 文件操作失败
+#define DBSNAP_ER_FORMAT  -3 // 文件格式错误
+#define DBSNAP_ER_MEM     -4 // 内存不足
+
+// 设置数据目录、日志刷新周期(ms)和快照周期(s)
+int dbsnap_init(const char *dir, uint32_t jnl_ms, uint32_t snap_s);
+// 不保存的对象，例如由配置文件决定内容的系统对象
+int dbsnap_skip(uint16_t obj_id);
+// 从快照和日志恢复测点值，需要在对象初始化之后、写入之前调用，返回恢复的测点数量
+int dbsnap_load(void);
+// 打开变化记录并启动后台线程，启动后立即生成一次快照
+int dbsnap_start(void);
+// 立即生成一次快照
+int dbsnap_save(void);
+// 写入剩余的变化和最后一次快照，停止后台线程
+void dbsnap_exit(void);
+
+#endif
@@ -0,0 +1,230 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :dbsub.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :测点变化订阅。变化的测点由db_in_mem在写入时记录到对象的位图中，这里只
+//                 在每个周期取走一次，再按订阅范围切分后分批通知订阅者。
+// Interface      :无
+// Others         :订阅表按对象编号排序，同一对象的变化只取一次，所有订阅共用同一份有序编号，
+//                 每个订阅通过两次折半查找得到自己的范围。订阅表只在主线程中使用，回调中不能
+//                 增加或删除订阅
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#define GLOG4C_MODULE GLOG4C_MOD_DBMEM
+#include "glog4c.h"
+#include "db_in_mem.h"
+#include "dbsub.h"
+
+#define DBSUB_MAX_IDS  4096 // 一个对象最多的测点数量，测点编号只有12位
+
+typedef struct {
+    uint16_t obj_id; // 对象编号
+    uint16_t id_lo;  // 起始编号
+    uint16_t id_hi;  // 结束编号，包含在内
+    dbsub_cb cb;     // 通知回调
+    void    *arg;    // 回调参数
+}dbsub_item;
+
+static dbsub_item *m_subs = NULL;  // 订阅表，按对象编号排序
+static int  m_count    = 0;        // 订阅数量
+static int  m_cap      = 0;        // 订阅表容量
+static int  m_flushing = 0;        // 正在通知，禁止修改订阅表
+static uint16_t m_ids[DBSUB_MAX_IDS]; // 本周期取走的变化编号
+
+// 查找对象的第一条订阅位置，不存在时返回应该插入的位置
+static int dbsub_first(uint16_t obj_id)
+{
+    int head = 0, tail = m_count;
+
+    while (head < tail) {
+        int mid = (head + tail) / 2;
+        if (m_subs[mid].obj_id < obj_id) {
+            head = mid + 1;
+        } else {
+            tail = mid;
+        }
+    }
+    return head;
+}
+
+// 在有序编号中查找第一个不小于id的位置
+static int dbsub_lower(const uint16_t *ids, int num, uint32_t id)
+{
+    int head = 0, tail = num;
+
+    while (head < tail) {
+        int mid = (head + tail) / 2;
+        if (ids[mid] < id) {
+            head = mid + 1;
+        } else {
+            tail = mid;
+        }
+    }
+    return head;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsub_add
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :增加一条订阅，对象的第一条订阅会打开对象的变化记录.订阅之前的写入不会
+//                 被通知
+// Input          :obj_id:对象编号
+//                :id_lo:起始编号
+//                :id_hi:结束编号，包含在内
+//                :cb:通知回调
+//                :arg:回调参数
+// Output         :无
+// Return         :成功返回DBSUB_OK,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbsub_add(uint16_t obj_id, uint16_t id_lo, uint16_t id_hi, dbsub_cb cb, void *arg)
+{
+    if (NULL == cb || id_lo > id_hi || m_flushing) {
+        return DBSUB_ER_PARAM;
+    }
+    if (m_count == m_cap) {
+        int cap = (0 == m_cap) ? 16 : m_cap * 2;
+        dbsub_item *mem = (dbsub_item *)realloc(m_subs, sizeof(dbsub_item) * cap);
+        if (NULL == mem) {
+            return DBSUB_ER_MEM;
+        }
+        m_subs = mem;
+        m_cap  = cap;
+    }
+    int pos = dbsub_first(obj_id);
+    if (pos == m_count || m_subs[pos].obj_id != obj_id) {
+        int ret = dbmem_watch(obj_id, DBMEM_WATCH_SUB, 1);
+        if (OBJSYS_RET_OK != ret) {
+            glog4c_warn("watch obj_id=%d failed: %s\n", obj_id, dbmem_get_err_str(ret));
+            return OBJSYS_RET_FMEM == ret ? DBSUB_ER_MEM : DBSUB_ER_OBJ;
+        }
+    }
+    while (pos < m_count && m_subs[pos].obj_id == obj_id) { // 同一对象按订阅顺序通知
+        ++pos;
+    }
+    memmove(&m_subs[pos + 1], &m_subs[pos], sizeof(dbsub_item) * (m_count - pos));
+    m_subs[pos].obj_id = obj_id;
+    m_subs[pos].id_lo  = id_lo;
+    m_subs[pos].id_hi  = id_hi;
+    m_subs[pos].cb     = cb;
+    m_subs[pos].arg    = arg;
+    ++m_count;
+    return DBSUB_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsub_del
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :删除订阅，对象的最后一条订阅删除后关闭对象的变化记录
+// Input          :obj_id:对象编号
+//                :id_lo:起始编号，大于id_hi时不比较范围
+//                :id_hi:结束编号
+//                :cb:通知回调
+//                :arg:回调参数
+// Output         :无
+// Return         :成功返回删除的数量,失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbsub_del(uint16_t obj_id, uint16_t id_lo, uint16_t id_hi, dbsub_cb cb, void *arg)
+{
+    int removed = 0;
+
+    if (m_flushing) {
+        return DBSUB_ER_PARAM;
+    }
+    int pos = dbsub_first(obj_id);
+    int end = pos;
+    for (int idx = pos; idx < m_count && m_subs[idx].obj_id == obj_id; ++idx) {
+        const dbsub_item *sub = &m_subs[idx];
+        if (sub->cb == cb && sub->arg == arg
+            && (id_lo > id_hi || (sub->id_lo == id_lo && sub->id_hi == id_hi))) {
+            ++removed;
+            continue;
+        }
+        m_subs[end++] = *sub;
+    }
+    if (0 == removed) {
+        return DBSUB_ER_NONE;
+    }
+    memmove(&m_subs[end], &m_subs[end + removed], sizeof(dbsub_item) * (m_count - end - removed));
+    m_count -= removed;
+    if (end == pos) { // 对象已经没有订阅
+        dbmem_watch(obj_id, DBMEM_WATCH_SUB, 0);
+    }
+    return removed;
+}
+
+// 当前订阅数量
+int dbsub_count(void)
+{
+    return m_count;
+}
+
+//------------------------------------------------------------------------------
+// Function       :dbsub_flush
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :取走每个订阅对象在本周期内的变化，按订阅范围切分后调用回调.一个订阅在
+//                 一个周期内最多收到一次通知，范围内没有变化时不通知
+// Input          :无
+// Output         :无
+// Return         :有变化的测点数量
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int dbsub_flush(void)
+{
+    int total = 0;
+
+    m_flushing = 1;
+    for (int head = 0; head < m_count;) {
+        int tail = head + 1;
+        while (tail < m_count && m_subs[tail].obj_id == m_subs[head].obj_id) {
+            ++tail;
+        }
+        int num = dbmem_take_dirty(m_subs[head].obj_id, DBMEM_WATCH_SUB, m_ids, DBSUB_MAX_IDS);
+        for (int idx = head; idx < tail && num > 0; ++idx) {
+            const dbsub_item *sub = &m_subs[idx];
+            int lo = dbsub_lower(m_ids, num, sub->id_lo);
+            int hi = dbsub_lower(m_ids, num, (uint32_t)sub->id_hi + 1);
+            if (hi > lo) {
+                sub->cb(sub->arg, sub->obj_id, &m_ids[lo], hi - lo);
+            }
+        }
+        if (num > 0) {
+            total += num;
+        }
+        head = tail;
+    }
+    m_flushing = 0;
+    return total;
+}
+
+// 删除所有订阅并关闭对象的变化记录
+void dbsub_close(void)
+{
+    for (int idx = 0; idx < m_count; ++idx) {
+        if (0 == idx || m_subs[idx].obj_id != m_subs[idx - 1].obj_id) {
+            dbmem_watch(m_subs[idx].obj_id, DBMEM_WATCH_SUB, 0);
+        }
+    }
+    free(m_subs);
+    m_subs  = NULL;
+    m_count = 0;
+    m_cap   = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef DBSUB_H_
+#define DBSUB_H_
+
+#include <stdint.h>
+
+// 测点变化订阅.订阅后对象打开变化记录，写入路径只在位图中标记，每个周期调用一次
+// dbsub_flush取走所有变化并按订阅范围分批通知，同一周期内同一测点的多次变化只通知一次
+
+#define DBSUB_OK         0
+#define DBSUB_ER_PARAM  -1 // 参数错误
+#define DBSUB_ER_MEM    -2 // 内存不足
+#define DBSUB_ER_OBJ    -3 // 对象不存在
+#define DBSUB_ER_NONE   -4 // 没有匹配的订阅
+
+// 变化通知回调，ids为本周期内有变化的测点编号，升序，只在回调期间有效
+typedef void (*dbsub_cb)(void *arg, uint16_t obj_id, const uint16_t *ids, int num);
+
+// 订阅对象中编号在[id_lo, id_hi]之间的测点
+int dbsub_add(uint16_t obj_id, uint16_t id_lo, uint16_t id_hi, dbsub_cb cb, void *arg);
+// 删除范围、回调和参数都相同的订阅，id_lo大于id_hi时删除该回调在对象上的所有订阅
+int dbsub_del(uint16_t obj_id, uint16_t id_lo, uint16_t id_hi, dbsub_cb cb, void *arg);
+// 当前订阅数量
+int dbsub_count(void);
+// 取走所有订阅对象的变化并通知订阅者，返回有变化的测点数量
+int dbsub_flush(void);
+// 删除所有订阅
+void dbsub_close(void);
+
+#endif
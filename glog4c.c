@@ -0,0 +1,821 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :glog4c.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :异步日志。调用线程按格式字符串取出参数，连同格式字符串指针、文件名和行号
+//                 按二进制写入本线程独占的环形缓冲区；后台线程轮流取出所有缓冲区的记录，
+//                 格式化后批量写入文件或标准输出，错误同时写入syslog。
+// Interface      :无
+// Others         :每个缓冲区只有一个写者(所属线程)和一个读者(后台线程)，只用原子读写位置，
+//                 不加锁.线程退出后缓冲区在取空时归还，供新线程使用.不同线程之间的记录按
+//                 取出顺序输出，不保证严格的时间顺序
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "glog4c.h"
+
+#define GLOG4C_RING_SIZE  65536 // 每个线程的缓冲区尺寸，2的幂
+#define GLOG4C_RING_MASK  (GLOG4C_RING_SIZE - 1)
+#define GLOG4C_MAX_RINGS  64    // 缓冲区数量上限，超出的线程同步输出
+#define GLOG4C_MAX_ARGS   16    // 一条记录最多保存的参数数量，超出部分按原样输出格式字符串
+#define GLOG4C_REC_MAX    2048  // 一条记录的最大尺寸，字符串参数超出时截断
+#define GLOG4C_LINE_SIZE  1024  // 格式化后一行的最大长度
+#define GLOG4C_OUT_SIZE   65536 // 后台线程的输出缓冲区
+#define GLOG4C_PERIOD_MS  10    // 后台线程的取出周期
+#define GLOG4C_PAD        0xFFFF // 填充记录，表示缓冲区尾部剩余空间不用
+
+// 长度修饰符
+#define GLOG4C_LEN_NONE   0
+#define GLOG4C_LEN_HH     1
+#define GLOG4C_LEN_H      2
+#define GLOG4C_LEN_L      3
+#define GLOG4C_LEN_LL     4
+#define GLOG4C_LEN_Z      5
+#define GLOG4C_LEN_J      6
+#define GLOG4C_LEN_T      7
+#define GLOG4C_LEN_LD     8
+
+// 记录头，之后是按格式字符串顺序保存的参数，每个参数8字节，字符串参数的8字节保存长度，
+// 后面紧跟以0结尾的内容，按8字节对齐
+typedef struct {
+    uint32_t    size;   // 记录总长度，8字节对齐
+    uint16_t    level;  // 日志级别，GLOG4C_PAD表示填充记录
+    uint16_t    nslot;  // 参数区的8字节单元数量
+    uint32_t    line;   // 行号
+    uint32_t    nsec;   // 时间的纳秒部分
+    int64_t     sec;    // 时间的秒数部分
+    const char *file;   // 文件名
+    const char *format; // 格式字符串
+}glog4c_rec;
+
+// 线程的环形缓冲区，读写位置分别位于不同的缓存行
+typedef struct {
+    uint32_t head;      // 写入位置，只由所属线程修改
+    char     pad0[60];
+    uint32_t tail;      // 读出位置，只由后台线程修改
+    char     pad1[60];
+    uint32_t used;      // 已经被线程占用
+    uint32_t gone;      // 所属线程已经退出
+    uint64_t drops;     // 丢弃的记录数量，只由所属线程修改
+    uint64_t reported;  // 已经报告的丢弃数量
+    char     pad2[40];
+    uint8_t  buf[GLOG4C_RING_SIZE];
+}glog4c_ring;
+
+// 格式字符串中的一个转换说明
+typedef struct {
+    const char *flags;  // 标志
+    int         nflags;
+    const char *width;  // 宽度，'*'表示从参数中取
+    int         nwidth;
+    const char *prec;   // 精度，不含'.'，'*'表示从参数中取
+    int         nprec;
+    int         has_prec;
+    int         length; // 长度修饰符，GLOG4C_LEN_*
+    char        conv;   // 转换字符
+}glog4c_spec;
+
+volatile int8_t glog4c_levels[GLOG4C_MODS] = {LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO};
+static int8_t m_levels[GLOG4C_MODS] = {LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO}; // 设置的级别
+static int    m_debug = 0; // 已经切换到调试级别
+
+static glog4c_ring *m_rings[GLOG4C_MAX_RINGS];
+static uint32_t m_nring  = 0;
+static int      m_run    = 0;             // 后台线程正在运行
+static int      m_policy = GLOG4C_DROP;   // 缓冲区满时的处理方式
+static int      m_fd     = -1;            // 日志文件
+static pthread_t       m_thread;
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER; // 分配缓冲区以及同步输出
+static pthread_mutex_t m_wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  m_wait = PTHREAD_COND_INITIALIZER;  // 唤醒后台线程
+static pthread_key_t   m_key;
+static pthread_once_t  m_key_once  = PTHREAD_ONCE_INIT;
+static pthread_once_t  m_exit_once = PTHREAD_ONCE_INIT;
+static __thread glog4c_ring *m_ring = NULL; // 当前线程的缓冲区
+static __thread int          m_no_ring = 0; // 缓冲区已经用完，当前线程同步输出
+
+// 以下只由后台线程使用，后台线程没有运行时由m_lock保护
+static char    m_out[GLOG4C_OUT_SIZE];     // 输出缓冲区
+static size_t  m_out_len = 0;
+static int     m_out_fd  = -1;             // 输出缓冲区对应的文件
+static int64_t m_stamp_sec = -1;           // 时间前缀缓存
+static char    m_stamp[24];
+
+//------------------------------------------------------------------------------
+// Function       :glog4c_parse
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :解析'%'之后的一个转换说明，写入和格式化使用同一个解析，保证参数顺序一致
+// Input          :fmt:'%'之后的位置
+// Output         :spec:转换说明
+// Return         :成功返回转换字符之后的位置，无法识别时返回NULL
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static const char *glog4c_parse(const char *fmt, glog4c_spec *spec)
+{
+    spec->flags = fmt;
+    while ('-' == *fmt || '+' == *fmt || ' ' == *fmt || '#' == *fmt || '0' == *fmt || '\'' == *fmt) {
+        ++fmt;
+    }
+    spec->nflags = fmt - spec->flags;
+    spec->width  = fmt;
+    if ('*' == *fmt) {
+        ++fmt;
+    } else {
+        while (*fmt >= '0' && *fmt <= '9') {
+            ++fmt;
+        }
+    }
+    spec->nwidth   = fmt - spec->width;
+    spec->has_prec = ('.' == *fmt);
+    spec->prec     = fmt + spec->has_prec;
+    if (spec->has_prec) {
+        ++fmt;
+        if ('*' == *fmt) {
+            ++fmt;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') {
+                ++fmt;
+            }
+        }
+    }
+    spec->nprec  = fmt - spec->prec;
+    spec->length = GLOG4C_LEN_NONE;
+    switch (*fmt) {
+    case 'h':
+        spec->length = ('h' == fmt[1]) ? GLOG4C_LEN_HH : GLOG4C_LEN_H;
+        fmt += ('h' == fmt[1]) ? 2 : 1;
+    break;
+    case 'l':
+        spec->length = ('l' == fmt[1]) ? GLOG4C_LEN_LL : GLOG4C_LEN_L;
+        fmt += ('l' == fmt[1]) ? 2 : 1;
+    break;
+    case 'q': spec->length = GLOG4C_LEN_LL; ++fmt; break;
+    case 'z':
+    case 'Z': spec->length = GLOG4C_LEN_Z;  ++fmt; break;
+    case 'j': spec->length = GLOG4C_LEN_J;  ++fmt; break;
+    case 't': spec->length = GLOG4C_LEN_T;  ++fmt; break;
+    case 'L': spec->length = GLOG4C_LEN_LD; ++fmt; break;
+    }
+    spec->conv = *fmt;
+    switch (spec->conv) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+    case 's': case 'p': case 'n': case 'm':
+        return fmt + 1;
+    default:
+        return NULL;
+    }
+}
+
+// 按长度修饰符取出整数参数，统一扩展为64位
+static uint64_t glog4c_arg_int(const glog4c_spec *spec, va_list *ap)
+{
+    int sign = ('d' == spec->conv || 'i' == spec->conv);
+
+    switch (spec->length) {
+    case GLOG4C_LEN_L:  return sign ? (uint64_t)va_arg(*ap, long) : (uint64_t)va_arg(*ap, unsigned long);
+    case GLOG4C_LEN_LL: return sign ? (uint64_t)va_arg(*ap, long long) : (uint64_t)va_arg(*ap, unsigned long long);
+    case GLOG4C_LEN_Z:  return sign ? (uint64_t)va_arg(*ap, ssize_t) : (uint64_t)va_arg(*ap, size_t);
+    case GLOG4C_LEN_J:  return sign ? (uint64_t)va_arg(*ap, intmax_t) : (uint64_t)va_arg(*ap, uintmax_t);
+    case GLOG4C_LEN_T:  return (uint64_t)va_arg(*ap, ptrdiff_t);
+    default:            return sign ? (uint64_t)(int64_t)va_arg(*ap, int) : (uint64_t)va_arg(*ap, unsigned int);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :glog4c_encode
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :按格式字符串取出参数写入记录.数值保存原值，字符串复制内容，%m保存调用时的
+//                 errno.只遍历格式字符串，不做任何格式化
+// Input          :format:格式字符串
+//                :ap:参数
+//                :err:调用时的errno
+// Output         :rec:记录，记录头中的size和nslot在这里填写
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static void glog4c_encode(glog4c_rec *rec, const char *format, va_list *ap, int err)
+{
+    uint64_t *slot = (uint64_t *)(rec + 1);
+    uint64_t *end  = (uint64_t *)((char *)rec + GLOG4C_REC_MAX);
+    int nargs = 0;
+    glog4c_spec spec;
+
+    for (const char *fmt = format; NULL != fmt && '\0' != *fmt; ++fmt) {
+        if ('%' != *fmt) {
+            continue;
+        }
+        if ('%' == fmt[1]) {
+            ++fmt;
+            continue;
+        }
+        const char *next = glog4c_parse(fmt + 1, &spec);
+        if (NULL == next) {
+            break;
+        }
+        // 宽度和精度的'*'各占一个参数
+        int wstar = (1 == spec.nwidth && '*' == spec.width[0]);
+        int pstar = (1 == spec.nprec && '*' == spec.prec[0]);
+        if (nargs + wstar + pstar + 1 > GLOG4C_MAX_ARGS || slot + 4 > end) {
+            break;
+        }
+        if (wstar) {
+            *slot++ = (uint64_t)(int64_t)va_arg(*ap, int);
+            ++nargs;
+        }
+        if (pstar) {
+            *slot++ = (uint64_t)(int64_t)va_arg(*ap, int);
+            ++nargs;
+        }
+        switch (spec.conv) {
+        case 's': {
+            const char *str = va_arg(*ap, const char *);
+            size_t len = (NULL == str) ? 6 : strnlen(str, GLOG4C_MAX_STR);
+            size_t room = ((char *)end - (char *)(slot + 1)) - 1;
+            if (len > room) {
+                len = room;
+            }
+            *slot = len;
+            memcpy(slot + 1, NULL == str ? "(null)" : str, len);
+            ((char *)(slot + 1))[len] = '\0';
+            slot += 1 + (len + 8) / 8;
+        }
+        break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': {
+            double val = (GLOG4C_LEN_LD == spec.length) ? (double)va_arg(*ap, long double) : va_arg(*ap, double);
+            memcpy(slot++, &val, sizeof(val));
+        }
+        break;
+        case 'p':
+            *slot++ = (uint64_t)(uintptr_t)va_arg(*ap, void *);
+        break;
+        case 'n':
+            (void)va_arg(*ap, void *); // 不支持写回，只跳过参数
+        break;
+        case 'm':
+            *slot++ = (uint64_t)(int64_t)err;
+        break;
+        default:
+            *slot++ = glog4c_arg_int(&spec, ap);
+        }
+        ++nargs;
+        fmt = next - 1;
+    }
+    rec->nslot = (uint16_t)(slot - (uint64_t *)(rec + 1));
+    rec->size  = (uint32_t)((char *)slot - (char *)rec);
+}
+
+// 把宽度或精度追加到转换说明，'*'替换为参数值
+static char *glog4c_spec_num(char *out, const char *src, int len, const uint64_t **slot, const uint64_t *end)
+{
+    if (1 == len && '*' == src[0]) {
+        int val = (*slot < end) ? (int)(int64_t)*(*slot)++ : 0;
+        return out + sprintf(out, "%d", val);
+    }
+    memcpy(out, src, len);
+    return out + len;
+}
+
+//------------------------------------------------------------------------------
+// Function       :glog4c_format
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :按格式字符串和记录中的参数格式化消息.每个转换说明重新组装后单独调用
+//                 snprintf，64位整数统一使用ll修饰符，long double已经按double保存
+// Input          :rec:记录
+//                :size:输出缓冲区尺寸
+// Output         :out:消息，以0结尾
+// Return         :消息长度
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): '*'取到负数精度时去掉精度，与printf相同
+//------------------------------------------------------------------------------
+static int glog4c_format(const glog4c_rec *rec, char *out, int size)
+{
+    const uint64_t *slot = (const uint64_t *)(rec + 1);
+    const uint64_t *end  = slot + rec->nslot;
+    const char *fmt = rec->format;
+    glog4c_spec spec;
+    char conv[64];
+    int len = 0;
+
+    while (NULL != fmt && '\0' != *fmt && len < size - 1) {
+        if ('%' != *fmt) {
+            out[len++] = *fmt++;
+            continue;
+        }
+        if ('%' == fmt[1]) {
+            out[len++] = '%';
+            fmt += 2;
+            continue;
+        }
+        const char *next = glog4c_parse(fmt + 1, &spec);
+        if (NULL == next || spec.nflags > 8 || spec.nwidth > 8 || spec.nprec > 8
+            || (slot >= end && 'n' != spec.conv)) {
+            // 无法识别或参数已经用完，剩余部分原样输出
+            int n = strlen(fmt);
+            if (n > size - 1 - len) {
+                n = size - 1 - len;
+            }
+            memcpy(out + len, fmt, n);
+            len += n;
+            break;
+        }
+        char *pos = conv;
+        *pos++ = '%';
+        memcpy(pos, spec.flags, spec.nflags);
+        pos += spec.nflags;
+        pos = glog4c_spec_num(pos, spec.width, spec.nwidth, &slot, end);
+        if (spec.has_prec) {
+            char *dot = pos;
+            *pos++ = '.';
+            pos = glog4c_spec_num(pos, spec.prec, spec.nprec, &slot, end);
+            if ('-' == dot[1]) { // 参数给出的负数精度等于没有精度
+                pos = dot;
+            }
+        }
+        int wide = 0;
+        if (NULL != strchr("diouxX", spec.conv)) {
+            wide = (spec.length >= GLOG4C_LEN_L);
+            if (wide) {
+                *pos++ = 'l';
+                *pos++ = 'l';
+            } else if (GLOG4C_LEN_H == spec.length || GLOG4C_LEN_HH == spec.length) {
+                *pos++ = 'h';
+                if (GLOG4C_LEN_HH == spec.length) {
+                    *pos++ = 'h';
+                }
+            }
+        }
+        *pos++ = ('m' == spec.conv) ? 's' : spec.conv;
+        *pos   = '\0';
+
+        int n = 0, room = size - len;
+        if (slot >= end && 'n' != spec.conv) {
+            break;
+        }
+        switch (spec.conv) {
+        case 's':
+            n = snprintf(out + len, room, conv, (const char *)(slot + 1));
+            slot += 1 + (*slot + 8) / 8;
+        break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': {
+            double val;
+            memcpy(&val, slot++, sizeof(val));
+            n = snprintf(out + len, room, conv, val);
+        }
+        break;
+        case 'p':
+            n = snprintf(out + len, room, conv, (void *)(uintptr_t)*slot++);
+        break;
+        case 'n':
+        break;
+        case 'm':
+            n = snprintf(out + len, room, conv, strerror((int)(int64_t)*slot++));
+        break;
+        case 'd': case 'i':
+            n = wide ? snprintf(out + len, room, conv, (long long)*slot) : snprintf(out + len, room, conv, (int)*slot);
+            ++slot;
+        break;
+        default:
+            n = wide ? snprintf(out + len, room, conv, (unsigned long long)*slot)
+                     : snprintf(out + len, room, conv, (unsigned int)*slot);
+            ++slot;
+        }
+        len += (n < 0) ? 0 : (n >= room ? room - 1 : n);
+        fmt = next;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// 写出输出缓冲区
+static void glog4c_flush(void)
+{
+    size_t off = 0;
+
+    while (off < m_out_len && m_out_fd >= 0) {
+        ssize_t ret = write(m_out_fd, m_out + off, m_out_len - off);
+        if (ret < 0 && EINTR == errno) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        off += ret;
+    }
+    m_out_len = 0;
+}
+
+// 追加一行到输出缓冲区，目标文件改变或空间不足时先写出
+static void glog4c_append(int fd, const char *line, size_t len)
+{
+    if (fd != m_out_fd || m_out_len + len > sizeof(m_out)) {
+        glog4c_flush();
+        m_out_fd = fd;
+    }
+    memcpy(m_out + m_out_len, line, len);
+    m_out_len += len;
+}
+
+//------------------------------------------------------------------------------
+// Function       :glog4c_emit
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :输出一条记录.错误及以上级别写入syslog；配置了日志文件时所有记录带时间
+//                 前缀写入文件，否则普通记录写入标准输出.没有换行结尾的消息补一个换行
+// Input          :rec:记录
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static void glog4c_emit(const glog4c_rec *rec)
+{
+    char line[GLOG4C_LINE_SIZE + 64];
+    char msg[GLOG4C_LINE_SIZE];
+    int fd = __atomic_load_n(&m_fd, __ATOMIC_ACQUIRE);
+    int len = 0;
+
+    glog4c_format(rec, msg, sizeof(msg));
+    if (rec->level <= LOG_ERR) {
+        syslog(rec->level, "%s:%d::%s", rec->file, rec->line, msg);
+    }
+    if (fd >= 0) {
+        if (rec->sec != m_stamp_sec) {
+            struct tm tm;
+            time_t sec = (time_t)rec->sec;
+            localtime_r(&sec, &tm);
+            strftime(m_stamp, sizeof(m_stamp), "%Y-%m-%d %H:%M:%S", &tm);
+            m_stamp_sec = rec->sec;
+        }
+        len = snprintf(line, GLOG4C_LINE_SIZE, "%s.%03u %c ", m_stamp, rec->nsec / 1000000,
+            rec->level <= LOG_ERR ? 'E' : 'I');
+    } else if (rec->level <= LOG_ERR) {
+        return; // 由syslog输出到标准错误
+    } else {
+        fd = STDOUT_FILENO;
+    }
+    len += snprintf(line + len, sizeof(line) - len - 1, "%s:%u::%s", rec->file, rec->line, msg);
+    if (len > (int)sizeof(line) - 2) {
+        len = sizeof(line) - 2;
+    }
+    if ('\n' != line[len - 1]) {
+        line[len++] = '\n';
+    }
+    glog4c_append(fd, line, len);
+}
+
+// 线程退出时标记缓冲区，后台线程取空后归还
+static void glog4c_thread_exit(void *arg)
+{
+    glog4c_ring *ring = (glog4c_ring *)arg;
+
+    __atomic_store_n(&ring->gone, 1, __ATOMIC_RELEASE);
+}
+
+static void glog4c_key(void)
+{
+    pthread_key_create(&m_key, glog4c_thread_exit);
+}
+
+// 取得当前线程的缓冲区，第一次调用时占用一个空闲缓冲区或者申请新的缓冲区
+static glog4c_ring *glog4c_ring_get(void)
+{
+    glog4c_ring *ring = NULL;
+
+    if (NULL != m_ring || m_no_ring) {
+        return m_ring;
+    }
+    pthread_once(&m_key_once, glog4c_key);
+    pthread_mutex_lock(&m_lock);
+    for (uint32_t idx = 0; idx < m_nring && NULL == ring; ++idx) {
+        if (0 == __atomic_load_n(&m_rings[idx]->used, __ATOMIC_ACQUIRE)) {
+            ring = m_rings[idx];
+        }
+    }
+    if (NULL == ring && m_nring < GLOG4C_MAX_RINGS) {
+        void *mem = NULL;
+        if (0 == posix_memalign(&mem, 64, sizeof(glog4c_ring))) {
+            ring = (glog4c_ring *)mem;
+            memset(ring, 0, offsetof(glog4c_ring, buf));
+            m_rings[m_nring] = ring;
+            __atomic_store_n(&m_nring, m_nring + 1, __ATOMIC_RELEASE);
+        }
+    }
+    if (NULL != ring) {
+        ring->used = 1;
+        pthread_setspecific(m_key, ring);
+    }
+    pthread_mutex_unlock(&m_lock);
+    m_ring    = ring;
+    m_no_ring = (NULL == ring);
+    return ring;
+}
+
+// 把记录写入缓冲区，缓冲区满时按处理方式丢弃或等待，写入成功返回1
+static int glog4c_push(glog4c_ring *ring, const glog4c_rec *rec)
+{
+    uint32_t head = ring->head;
+    uint32_t off  = head & GLOG4C_RING_MASK;
+    uint32_t room = GLOG4C_RING_SIZE - off; // 到缓冲区尾部的连续空间
+    uint32_t need = (rec->size <= room) ? rec->size : room + rec->size;
+
+    for (;;) {
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (GLOG4C_RING_SIZE - (head - tail) >= need) {
+            break;
+        }
+        if (GLOG4C_DROP == m_policy || !__atomic_load_n(&m_run, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&ring->drops, ring->drops + 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        pthread_cond_signal(&m_wait);
+        sched_yield();
+    }
+    if (rec->size > room) { // 尾部放不下，填充后从头开始
+        glog4c_rec *pad = (glog4c_rec *)(ring->buf + off);
+        pad->size  = room;
+        pad->level = GLOG4C_PAD;
+        head += room;
+        off   = 0;
+    }
+    memcpy(ring->buf + off, rec, rec->size);
+    __atomic_store_n(&ring->head, head + rec->size, __ATOMIC_RELEASE);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// Function       :glog4c_write
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :写入一条日志记录.空间充足时参数直接编码到当前线程的缓冲区，否则先编码到栈上
+//                 再按溢出处理方式写入，调用者不做任何格式化和系统调用.后台线程没有运行或缓冲区
+//                 用完时同步输出.不改变errno
+// Input          :level:syslog级别
+//                :file:文件名，必需是常量
+//                :line:行号
+//                :format:格式字符串，必需是常量
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+void glog4c_write(int level, const char *file, int line, const char *format, ...)
+{
+    uint64_t buf[GLOG4C_REC_MAX / sizeof(uint64_t)];
+    glog4c_rec *rec = (glog4c_rec *)buf;
+    struct timespec ts;
+    int err = errno;
+    va_list ap;
+
+    glog4c_ring *ring = __atomic_load_n(&m_run, __ATOMIC_ACQUIRE) ? glog4c_ring_get() : NULL;
+    uint32_t head = (NULL != ring) ? ring->head : 0;
+    // 缓冲区中有一条最大记录的连续空间时直接在缓冲区中编码，省掉一次复制
+    int direct = NULL != ring && GLOG4C_RING_SIZE - (head & GLOG4C_RING_MASK) >= GLOG4C_REC_MAX
+        && GLOG4C_RING_SIZE - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) >= GLOG4C_REC_MAX;
+    if (direct) {
+        rec = (glog4c_rec *)(ring->buf + (head & GLOG4C_RING_MASK));
+    }
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    rec->level  = (uint16_t)level;
+    rec->line   = (uint32_t)line;
+    rec->sec    = ts.tv_sec;
+    rec->nsec   = (uint32_t)ts.tv_nsec;
+    rec->file   = file;
+    rec->format = format;
+    va_start(ap, format);
+    glog4c_encode(rec, format, &ap, err);
+    va_end(ap);
+
+    if (direct) {
+        __atomic_store_n(&ring->head, head + rec->size, __ATOMIC_RELEASE);
+    } else if (NULL != ring) {
+        glog4c_push(ring, rec);
+    } else {
+        pthread_mutex_lock(&m_lock);
+        glog4c_emit(rec);
+        glog4c_flush();
+        pthread_mutex_unlock(&m_lock);
+    }
+    errno = err;
+}
+
+//------------------------------------------------------------------------------
+// Function       :glog4c_drain
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :取出所有缓冲区中的记录并输出，报告各缓冲区新增的丢弃数量，归还所属线程
+//                 已经退出并且取空的缓冲区
+// Input          :无
+// Output         :无
+// Return         :输出的记录数量
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static int glog4c_drain(void)
+{
+    uint32_t nring = __atomic_load_n(&m_nring, __ATOMIC_ACQUIRE);
+    int total = 0;
+
+    for (uint32_t idx = 0; idx < nring; ++idx) {
+        glog4c_ring *ring = m_rings[idx];
+        int gone = __atomic_load_n(&ring->gone, __ATOMIC_ACQUIRE);
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t tail = ring->tail;
+        while (tail != head) {
+            const glog4c_rec *rec = (const glog4c_rec *)(ring->buf + (tail & GLOG4C_RING_MASK));
+            if (GLOG4C_PAD != rec->level) {
+                glog4c_emit(rec);
+                ++total;
+            }
+            tail += rec->size;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        uint64_t drops = __atomic_load_n(&ring->drops, __ATOMIC_RELAXED);
+        if (drops != ring->reported) {
+            char line[64];
+            int len = snprintf(line, sizeof(line), "glog4c: %llu records dropped\n",
+                (unsigned long long)(drops - ring->reported));
+            ring->reported = drops;
+            glog4c_append(m_fd >= 0 ? m_fd : STDERR_FILENO, line, len);
+        }
+        if (gone) { // 所属线程退出前写入的记录已经全部取出
+            ring->head = ring->tail = 0;
+            ring->drops = ring->reported = 0;
+            ring->gone = 0;
+            __atomic_store_n(&ring->used, 0, __ATOMIC_RELEASE);
+        }
+    }
+    glog4c_flush();
+    return total;
+}
+
+// 后台线程，没有记录时等待一个周期，阻塞方式下写入者可以提前唤醒
+static void *glog4c_thread(void *arg)
+{
+    struct timespec ts;
+
+    (void)arg;
+    while (__atomic_load_n(&m_run, __ATOMIC_ACQUIRE)) {
+        // 同步输出的线程也使用输出缓冲区，取出时持有m_lock
+        pthread_mutex_lock(&m_lock);
+        int num = glog4c_drain();
+        pthread_mutex_unlock(&m_lock);
+        if (num > 0) {
+            continue;
+        }
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += GLOG4C_PERIOD_MS * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_nsec -= 1000000000L;
+            ++ts.tv_sec;
+        }
+        pthread_mutex_lock(&m_wait_lock);
+        pthread_cond_timedwait(&m_wait, &m_wait_lock, &ts);
+        pthread_mutex_unlock(&m_wait_lock);
+    }
+    return NULL;
+}
+
+static void glog4c_atexit(void)
+{
+    atexit(glog4c_stop);
+}
+
+void glog4c_start(void)
+{
+    if (__atomic_load_n(&m_run, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    __atomic_store_n(&m_run, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&m_thread, NULL, glog4c_thread, NULL) != 0) {
+        __atomic_store_n(&m_run, 0, __ATOMIC_RELEASE);
+        return;
+    }
+    pthread_once(&m_exit_once, glog4c_atexit);
+}
+
+// 停止后台线程，之后的记录同步输出
+void glog4c_stop(void)
+{
+    if (!__atomic_load_n(&m_run, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    __atomic_store_n(&m_run, 0, __ATOMIC_RELEASE);
+    pthread_cond_signal(&m_wait);
+    pthread_join(m_thread, NULL);
+    pthread_mutex_lock(&m_lock);
+    glog4c_drain();
+    pthread_mutex_unlock(&m_lock);
+}
+
+// 设置日志文件和溢出处理方式，日志文件只能设置一次
+int glog4c_config(const char *file, int policy)
+{
+    m_policy = (GLOG4C_BLOCK == policy) ? GLOG4C_BLOCK : GLOG4C_DROP;
+    if (NULL == file || '\0' == file[0]) {
+        return 0;
+    }
+    if (m_fd >= 0) {
+        return -1;
+    }
+    int fd = open(file, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    __atomic_store_n(&m_fd, fd, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// 设置模块的运行时级别，同时作为切换调试级别后恢复的级别.超过编译时级别的部分已经被删除，
+// 告警提示需要用更高的LOG_LEVEL_MAX重新编译
+void glog4c_set_level(int module, int level)
+{
+    if (level < GLOG4C_OFF) {
+        return;
+    }
+    if (level > LOG_DEBUG) {
+        level = LOG_DEBUG;
+    }
+    if (level > GLOG4C_LEVEL_MAX) {
+        glog4c_write(LOG_WARNING, __FILE__, __LINE__,
+            "log level %d of module %d is above the compiled ceiling %d, rebuild with LOG_LEVEL_MAX\n",
+            level, module, GLOG4C_LEVEL_MAX);
+    }
+    for (int idx = 0; idx < GLOG4C_MODS; ++idx) {
+        if (GLOG4C_MOD_ALL == module || idx == module) {
+            __atomic_store_n(&m_levels[idx], (int8_t)level, __ATOMIC_RELAXED);
+            if (!__atomic_load_n(&m_debug, __ATOMIC_RELAXED)) {
+                glog4c_levels[idx] = (int8_t)level;
+            }
+        }
+    }
+}
+
+// 级别名称转换为级别，不区分大小写
+int glog4c_level_parse(const char *name)
+{
+    static const struct {
+        const char *name;
+        int         level;
+    } names[] = {
+        {"off",     GLOG4C_OFF},
+        {"err",     LOG_ERR},
+        {"error",   LOG_ERR},
+        {"warn",    LOG_WARNING},
+        {"warning", LOG_WARNING},
+        {"notice",  LOG_NOTICE},
+        {"info",    LOG_INFO},
+        {"debug",   LOG_DEBUG},
+    };
+
+    if (NULL == name) {
+        return GLOG4C_BAD;
+    }
+    for (size_t idx = 0; idx < sizeof(names) / sizeof(names[0]); ++idx) {
+        if (strcasecmp(name, names[idx].name) == 0) {
+            return names[idx].level;
+        }
+    }
+    return GLOG4C_BAD;
+}
+
+// 所有模块在调试级别和设置的级别之间切换，供SIGUSR1等信号使用
+void glog4c_toggle(void)
+{
+    int debug = !__atomic_load_n(&m_debug, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&m_debug, debug, __ATOMIC_RELAXED);
+    for (int idx = 0; idx < GLOG4C_MODS; ++idx) {
+        glog4c_levels[idx] = debug ? LOG_DEBUG : __atomic_load_n(&m_levels[idx], __ATOMIC_RELAXED);
+    }
+}
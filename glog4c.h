@@ -2,8 +2,62 @@
 #define GLOG4C_H_
 
 #include <stdio.h>
+#include <stdint.h>
 #include <syslog.h>
 
+// 异步日志.调用线程只把格式字符串指针和参数按二进制复制到本线程的无锁环形缓冲区，
+// 由后台线程统一格式化后批量输出:错误写入syslog，所有记录写入日志文件，未配置日志文件时
+// 普通记录写入标准输出.后台线程启动之前和停止之后的记录直接同步输出
+// 格式字符串必需是常量，字符串参数在调用时复制，最多复制GLOG4C_MAX_STR字节
+
+// 缓冲区满时的处理方式
+#define GLOG4C_DROP   0 // 丢弃记录并计数，调用者不等待
+#define GLOG4C_BLOCK  1 // 等待后台线程取走记录
+
+#define GLOG4C_MAX_STR 256 // 字符串参数最多复制的字节数
+
+// 日志级别使用syslog的LOG_ERR/LOG_WARNING/LOG_NOTICE/LOG_INFO/LOG_DEBUG，数值越大越详细
+#define GLOG4C_OFF    -1 // 关闭模块的所有日志
+#define GLOG4C_BAD    -2 // 无法识别的级别名称
+
+// 模块，包含glog4c.h之前定义GLOG4C_MODULE选择所属模块，未定义的属于GLOG4C_MOD_MAIN
+#define GLOG4C_MOD_MAIN     0
+#define GLOG4C_MOD_ASYNCOMM 1
+#define GLOG4C_MOD_DBMEM    2
+#define GLOG4C_MOD_CMDOPT   3
+#define GLOG4C_MODS         4
+#define GLOG4C_MOD_ALL      -1
+
+#ifndef GLOG4C_MODULE
+    #define GLOG4C_MODULE GLOG4C_MOD_MAIN
+#endif
+
+// 编译时保留的最详细级别，更详细的日志连同参数一起被编译器删除.由Makefile的LOG_LEVEL_MAX
+// 设置，运行时的级别和glog4c_toggle都不能超过这个级别
+#ifndef GLOG4C_LEVEL_MAX
+    #define GLOG4C_LEVEL_MAX LOG_INFO
+#endif
+
+// 各模块运行时的级别，只读，通过glog4c_set_level修改
+extern volatile int8_t glog4c_levels[GLOG4C_MODS];
+
+// 启动后台线程，进程退出时自动停止并输出剩余记录
+void glog4c_start(void);
+// 设置日志文件和溢出处理方式，file为NULL时不写文件
+int glog4c_config(const char *file, int policy);
+// 停止后台线程并输出剩余记录
+void glog4c_stop(void);
+// 设置模块的运行时级别，module为GLOG4C_MOD_ALL时设置所有模块，level为GLOG4C_OFF时关闭.
+// level超过GLOG4C_LEVEL_MAX时照常设置并输出告警，超出的部分没有编译，不会输出
+void glog4c_set_level(int module, int level);
+// 级别名称"off/err/warn/notice/info/debug"转换为级别，无法识别时返回GLOG4C_BAD
+int glog4c_level_parse(const char *name);
+// 在调试级别和设置的级别之间切换，只做原子读写，可以在信号处理函数中调用
+void glog4c_toggle(void);
+// 写入一条记录
+void glog4c_write(int level, const char *file, int line, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
 //安gun标准extern inline特性与宏定义类似不单独汇编，在代码中展开
 //采用inline特性的主要原因是允许编译器编译时会对代码调用进行检查而不是直接替换
 /*extern inline void glog4c_init(void) {
@@ -18,16 +72,19 @@ extern inline void glog4c_err(const char *arg) {
     syslog(LOG_ERR, "%s:%d::%s", __FILE__, __LINE__, arg);
 }*/
 
-#define glog4c_init() {openlog("communicator", LOG_PERROR, LOG_LOCAL7);}
-#define glog4c_close() {closelog();}
-#define glog4c_err(arg) {syslog(LOG_ERR, "%s:%d::%s", __FILE__, __LINE__, arg);}
+#define glog4c_init() {openlog("communicator", LOG_PERROR, LOG_LOCAL7); glog4c_start();}
+#define glog4c_close() {glog4c_stop(); closelog();}
 
-#if G_DEBUG
-    #define glog4c_info(format, arg...) { printf("%s:%d::",__FILE__,__LINE__);printf(format, ## arg); }
-    #define glog4c_hit(arg) { printf("%s:%d::%s", __FILE__, __LINE__, arg); }
-#else
-    #define glog4c_info(format, arg...)
-    #define glog4c_hit(arg)
-#endif
+// 级别打开时才计算参数并写入，编译时关闭的级别条件为常量0，整条语句被删除
+#define glog4c_on(level) ((level) <= GLOG4C_LEVEL_MAX && (level) <= glog4c_levels[GLOG4C_MODULE])
+#define glog4c_log(level, format, arg...) do { \
+    if (glog4c_on(level)) { glog4c_write(level, __FILE__, __LINE__, format, ## arg); } \
+} while (0)
+
+#define glog4c_err(arg) glog4c_log(LOG_ERR, "%s", arg)
+#define glog4c_warn(format, arg...) glog4c_log(LOG_WARNING, format, ## arg)
+#define glog4c_hit(arg) glog4c_log(LOG_NOTICE, "%s", arg)
+#define glog4c_info(format, arg...) glog4c_log(LOG_INFO, format, ## arg)
+#define glog4c_debug(format, arg...) glog4c_log(LOG_DEBUG, format, ## arg)
 
 #endif
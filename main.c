@@ -22,6 +22,9 @@
 #include <unistd.h>
 #include <inttypes.h>
 #include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 // 自定义的头文件
 #include "cmd_opt.h"
@@ -30,19 +33,553 @@
 #include "objects.h"
 #include "db_in_mem.h"
 #include "asyncomm.h"
+#include "codec.h"
+#include "dbsub.h"
+#include "dbsnap.h"
+#include "metric.h"
+#include "appq.h"
 
 // 测点类型初始化
 const uint16_t init_var[]={OBJSYS_CFG_FILE_PATH, DB_STRING};
 
+#define MAIN_MAX_EVENTS 4 // 主循环单次epoll_wait最多处理的事件数量
+#define MAIN_SUB_CYCLE  100 // 默认的变化通知周期，单位ms
+#define MAIN_SNAP_PERIOD 300 // 默认的快照周期，单位s
+#define MAIN_JNL_PERIOD 1000 // 默认的变化日志刷新周期，单位ms
+#define MAIN_METRIC_PERIOD 1000 // 默认的统计更新周期，单位ms
+#define MAIN_DRAIN_RECORDS 256 // 默认每次唤醒最多处理的应用消息数量
+#define MAIN_DRAIN_BYTES (256 * 1024) // 默认每次唤醒最多处理的应用消息字节数
+#define MAIN_BLOCK_MIN 8 // 编号连续的定长数值达到这个数量时按整块写入
+#define MAIN_HIST_MAX 1024 // 一个历史查询条目最多返回的样本数量
+
 // 定义模块变量
-mqd_t m_app2queue, m_queue2app;
 volatile sig_atomic_t m_exit_flag = 0;
+int m_exit_evfd = -1; // 退出事件句柄，用于唤醒阻塞在epoll_wait上的主循环
+int m_sub_tmfd  = -1; // 变化通知定时器，只在有订阅时运行
+static uint32_t m_sub_cycle = MAIN_SUB_CYCLE;
+
+static codec_item *m_items = NULL; // 解码条目数组，按应用队列消息能容纳的最多条目申请一次
+static int         m_nitem = 0;
+// 批量写入数据库的参数数组，与解码条目数组同时申请
+static uint16_t    *m_set_ids    = NULL;
+static uint8_t     *m_set_types  = NULL;
+static const void **m_set_values = NULL;
+static uint32_t    *m_set_sizes  = NULL;
+static uint64_t    *m_set_block  = NULL; // 整块写入时数值连续存放的缓冲区
+static dbsample    *m_hist = NULL; // 历史查询的样本缓冲区，MAIN_HIST_MAX个
+static char       *m_reply = NULL; // 应答组帧缓冲区，尺寸与应用队列消息尺寸一致
+static size_t      m_reply_size = 0;
+static uint32_t    m_drain_records = MAIN_DRAIN_RECORDS; // 每次唤醒处理应用消息的预算
+static uint32_t    m_drain_bytes   = MAIN_DRAIN_BYTES;
+static int         m_app_more = 0; // 预算用完时队列中还有消息，下一轮不阻塞
+
+// SIGUSR1在调试级别和配置的级别之间切换日志级别
+void log_toggle(int sig)
+{
+    glog4c_toggle();
+}
 
-// CTRL+C信号量捕获
+// CTRL+C信号量捕获，信号处理函数中只能调用异步信号安全的函数，所以这里不打印日志
 void ctrl_c(int sig)
 {
-    glog4c_hit("user break process!\n");
+    uint64_t one = 1;
+
     m_exit_flag = 1;
+    if (m_exit_evfd >= 0) {
+        ssize_t wret = write(m_exit_evfd, &one, sizeof(one));
+        (void)wret;
+    }
+}
+
+// 发送一帧应答到应用队列，队列满时丢弃
+static void main_reply(codec_writer *wr)
+{
+    size_t len = codec_end(wr);
+
+    int ret = appq_send(m_reply, len);
+
+    if (ret < 0) {
+        glog4c_warn("send reply failed: %d\n", ret);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :main_send_values
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :读取测点值并按cmd组帧发送到应用队列.一帧中条目类型必需相同，类型变化或
+//                 缓冲区写满时先发送当前帧再开始新帧，未知测点不发送
+// Input          :cmd:帧命令，CODEC_CMD_VALUE或CODEC_CMD_CHANGE
+//                :obj_id:对象编号
+//                :ids:测点编号
+//                :count:测点数量
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 改为按编号数组发送，供变化通知共用
+//------------------------------------------------------------------------------
+static void main_send_values(uint16_t cmd, uint16_t obj_id, const uint16_t *ids, int count)
+{
+    codec_writer wr;
+    int open = 0;
+
+    dbvar snap, *var = &snap;
+
+    // 读临界区内读到的字符串不会被通信线程的写入释放
+    dbmem_read_lock();
+    for (int idx = 0; idx < count; ++idx) {
+        if (dbmem_read_value(obj_id, ids[idx], var) != OBJSYS_RET_OK
+            || DB_NULL == var->type || codec_type_size(var->type) < 0) {
+            continue;
+        }
+        const void *value = &var->u64;
+        if (DB_STRING == var->type) {
+            value = dbvar_str(var);
+        } else if (DB_BLOB == var->type) {
+            value = dbvar_blob(var);
+        }
+        if (open && wr.type != var->type) {
+            main_reply(&wr);
+            open = 0;
+        }
+        for (;;) {
+            if (!open) {
+                codec_begin(&wr, m_reply, m_reply_size, cmd, var->type, obj_id);
+                open = 1;
+            }
+            int ret = codec_put(&wr, ids[idx], value, var->len);
+            if (CODEC_OK == ret) {
+                break;
+            }
+            if (0 == wr.count) { // 单个条目超过消息尺寸，无法应答
+                glog4c_debug("value obj=%u id=%u is too large\n", obj_id, ids[idx]);
+                break;
+            }
+            main_reply(&wr);
+            open = 0;
+        }
+    }
+    dbmem_read_unlock();
+    if (open && wr.count > 0) {
+        main_reply(&wr);
+    }
+}
+
+// 订阅回调，本周期的变化以CODEC_CMD_CHANGE帧批量推送到应用队列
+static void main_notify(void *arg, uint16_t obj_id, const uint16_t *ids, int num)
+{
+    (void)arg;
+    main_send_values(CODEC_CMD_CHANGE, obj_id, ids, num);
+}
+
+// 有订阅时按周期运行通知定时器，没有订阅时停止，空闲进程不被定时唤醒
+static void main_sub_timer(void)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    if (dbsub_count() > 0) {
+        its.it_value.tv_sec  = m_sub_cycle / 1000;
+        its.it_value.tv_nsec = (m_sub_cycle % 1000) * 1000000L;
+        its.it_interval = its.it_value;
+    }
+    if (timerfd_settime(m_sub_tmfd, 0, &its, NULL) < 0) {
+        glog4c_warn("set subscribe timer failed: %s\n", strerror(errno));
+    }
+}
+
+// 处理订阅和取消订阅，每个条目的编号是起始编号，值是结束编号
+static void main_subscribe(const codec_head *head, const codec_item *items, int count)
+{
+    int had = dbsub_count();
+
+    if (CODEC_CMD_UNSUB == head->cmd && 0 == count) {
+        dbsub_del(head->obj_id, 1, 0, main_notify, NULL);
+    } else if (DB_UINT16 != head->type) {
+        glog4c_debug("subscribe frame type=%u is error\n", head->type);
+        return;
+    }
+    for (int idx = 0; idx < count; ++idx) {
+        uint16_t id_hi = (uint16_t)items[idx].raw;
+        int ret = (CODEC_CMD_SUB == head->cmd)
+            ? dbsub_add(head->obj_id, items[idx].id, id_hi, main_notify, NULL)
+            : dbsub_del(head->obj_id, items[idx].id, id_hi, main_notify, NULL);
+        if (ret < 0) {
+            glog4c_debug("subscribe obj=%u %u~%u failed(%d)\n", head->obj_id, items[idx].id, id_hi, ret);
+        }
+    }
+    if ((0 == had) != (0 == dbsub_count())) {
+        main_sub_timer();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :main_request
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :把应用的请求交给端口的事务表，应答由通信线程返回.端口没有启用事务或者
+//                 等待队列已满的请求在这里直接以CODEC_CMD_RESP返回失败状态，一帧中的
+//                 失败状态合并为一帧应答
+// Input          :items:请求条目，编号为端口号，值为 标签4B | 请求
+//                :count:条目数量
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static void main_request(const codec_item *items, int count)
+{
+    codec_writer wr;
+    uint8_t val[5];
+    uint32_t tag;
+
+    codec_begin(&wr, m_reply, m_reply_size, CODEC_CMD_RESP, DB_BLOB, 0);
+    for (int idx = 0; idx < count; ++idx) {
+        if (items[idx].len < sizeof(tag)) {
+            continue;
+        }
+        const uint8_t *req = (const uint8_t *)items[idx].value;
+        memcpy(&tag, req, sizeof(tag));
+        int ret = asyncomm_request(items[idx].id, tag, req + sizeof(tag), items[idx].len - sizeof(tag));
+        if (ASY_OK == ret) {
+            continue;
+        }
+        memcpy(val, &tag, sizeof(tag));
+        val[4] = (ASY_ER_AGAIN == ret) ? ASY_TXN_BUSY : ASY_TXN_NOPORT;
+        if (codec_put(&wr, items[idx].id, val, sizeof(val)) != CODEC_OK) {
+            main_reply(&wr);
+            codec_begin(&wr, m_reply, m_reply_size, CODEC_CMD_RESP, DB_BLOB, 0);
+            codec_put(&wr, items[idx].id, val, sizeof(val));
+        }
+    }
+    if (wr.count > 0) {
+        main_reply(&wr);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :main_history
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :处理历史查询，每个条目查询一个测点，样本以CODEC_CMD_HISTORY帧返回，缓冲区
+//                 写满时先发送当前帧.没有样本时也应答一个空帧，应用据此知道查询已经完成
+// Input          :head:帧头
+//                :items:查询条目，编号为测点编号，值为 起始时间8B | 结束时间8B | 最多样本数2B
+//                :count:条目数量
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static void main_history(const codec_head *head, const codec_item *items, int count)
+{
+    codec_writer wr;
+    uint64_t from, to;
+    uint16_t max;
+
+    if (DB_BLOB != head->type) {
+        glog4c_debug("history frame type=%u is error\n", head->type);
+        return;
+    }
+    codec_begin(&wr, m_reply, m_reply_size, CODEC_CMD_HISTORY, DB_BLOB, head->obj_id);
+    for (int idx = 0; idx < count; ++idx) {
+        if (codec_get_hist_query(&items[idx], &from, &to, &max) != CODEC_OK) {
+            glog4c_debug("history query obj=%u id=%u is error\n", head->obj_id, items[idx].id);
+            continue;
+        }
+        if (0 == max || max > MAIN_HIST_MAX) {
+            max = MAIN_HIST_MAX;
+        }
+        int num = dbmem_get_history(head->obj_id, items[idx].id, from, to, m_hist, max);
+        for (int k = 0; k < num; ++k) {
+            if (codec_put_sample(&wr, items[idx].id, m_hist[k].ts, m_hist[k].type, m_hist[k].u64) != CODEC_OK) {
+                main_reply(&wr);
+                codec_begin(&wr, m_reply, m_reply_size, CODEC_CMD_HISTORY, DB_BLOB, head->obj_id);
+                codec_put_sample(&wr, items[idx].id, m_hist[k].ts, m_hist[k].type, m_hist[k].u64);
+            }
+        }
+    }
+    main_reply(&wr);
+}
+
+//------------------------------------------------------------------------------
+// Function       :main_set
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :把一帧SET中的测点写入数据库.定长数值类型中编号连续的条目达到MAIN_BLOCK_MIN
+//                 个时，数值拷贝到连续缓冲区后用dbmem_set_block整块写入；其余条目收集起来用
+//                 dbmem_set_values批量写入.两种方式语义相同:每个已知测点都写入并标记变化，
+//                 数值没有变化也产生历史样本、订阅变化和日志记录，结果与条目编号是否连续
+//                 无关.整块写入前先写入之前收集的条目，保持帧中条目的先后顺序
+// Input          :head:帧头
+//                :items:解码后的条目
+//                :count:条目数量
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 整块写入不再跳过没有变化的测点，与逐个写入一致
+//------------------------------------------------------------------------------
+static void main_set(const codec_head *head, const codec_item *items, int count)
+{
+    int vsize = codec_type_size(head->type);
+    int num = 0;
+    int idx = 0;
+
+    while (idx < count) {
+        int end = idx + 1;
+        if (vsize > 0) {
+            // 测点编号不超过0x0FFF，超出的编号不并入整块
+            while (end < count && items[end].id == items[end - 1].id + 1 && items[end].id <= 0x0FFF) {
+                ++end;
+            }
+        }
+        if (end - idx < MAIN_BLOCK_MIN) {
+            m_set_ids[num]    = items[idx].id;
+            m_set_types[num]  = head->type;
+            m_set_values[num] = items[idx].value;
+            m_set_sizes[num]  = items[idx].len;
+            ++num;
+            ++idx;
+            continue;
+        }
+        if (num > 0) {
+            dbmem_set_values(head->obj_id, m_set_ids, m_set_types, m_set_values, m_set_sizes, num);
+            num = 0;
+        }
+        uint8_t *dst = (uint8_t *)m_set_block;
+        for (int k = idx; k < end; ++k) {
+            memcpy(dst + (k - idx) * vsize, items[k].value, vsize);
+        }
+        dbmem_set_block(head->obj_id, items[idx].id, head->type, m_set_block, end - idx, DBMEM_BAND_ALL, NULL);
+        idx = end;
+    }
+    if (num > 0) {
+        dbmem_set_values(head->obj_id, m_set_ids, m_set_types, m_set_values, m_set_sizes, num);
+    }
+}
+
+// 按命令处理一帧应用消息
+static void main_dispatch(const char *buf, size_t size)
+{
+    codec_head head;
+    uint64_t start = metric_begin(METRIC_H_DECODE);
+    int count = codec_decode(buf, size, &head, m_items, m_nitem);
+    metric_end(METRIC_H_DECODE, start);
+
+    if (count < 0) {
+        glog4c_debug("bad frame size=%zu: %s\n", size, codec_err_str(count));
+        return;
+    }
+    switch (head.cmd) {
+    case CODEC_CMD_SET:
+        main_set(&head, m_items, count);
+    break;
+    case CODEC_CMD_GET:
+        for (int idx = 0; idx < count; ++idx) {
+            m_set_ids[idx] = m_items[idx].id;
+        }
+        main_send_values(CODEC_CMD_VALUE, head.obj_id, m_set_ids, count);
+    break;
+    case CODEC_CMD_SUB:
+    case CODEC_CMD_UNSUB:
+        main_subscribe(&head, m_items, count);
+    break;
+    case CODEC_CMD_HIST:
+        main_history(&head, m_items, count);
+    break;
+    case CODEC_CMD_WRITE:
+        if (DB_BLOB != head.type) {
+            glog4c_debug("write frame type=%u is error\n", head.type);
+            break;
+        }
+        for (int idx = 0; idx < count; ++idx) {
+            asyncomm_write(m_items[idx].id, m_items[idx].value, m_items[idx].len);
+        }
+    break;
+    case CODEC_CMD_REQ:
+        if (DB_BLOB != head.type) {
+            glog4c_debug("request frame type=%u is error\n", head.type);
+            break;
+        }
+        main_request(m_items, count);
+    break;
+    default:
+        glog4c_debug("unknow command 0x%04x\n", head.cmd);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :main_drain_app
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :一次唤醒后批量处理应用队列中待处理的消息，直到队列为空或者本次唤醒的消息
+//                 数量、字节数预算用完.预算用完时设置m_app_more，主循环不阻塞地处理完其他
+//                 事件后继续读取，应用突发大量消息时定时器和退出事件也能及时处理
+// Input          :buf:接收缓冲区
+//                :size:接收缓冲区尺寸，必需不小于appq_msgsize()
+// Output         :无
+// Return         :本次处理的消息数量
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 改为通过appq接收，支持共享内存环
+// 2026-10-17 (llemmx): 增加每次唤醒的处理预算
+//------------------------------------------------------------------------------
+static int main_drain_app(char *buf, size_t size)
+{
+    int qsize;
+    int count = 0;
+    uint64_t bytes = 0;
+
+    m_app_more = 0;
+    for (;m_exit_flag != 1;) {
+        if ((uint32_t)count >= m_drain_records || bytes >= m_drain_bytes) {
+            metric_add(METRIC_MQ_BUDGET, 1);
+            m_app_more = 1;
+            break;
+        }
+        qsize = appq_recv(buf, size);
+        if (qsize < 0) {
+            if (APPQ_ER_AGAIN == qsize) { // 队列已经读空，回到epoll等待下一次唤醒
+                metric_add(METRIC_MQ_EAGAIN, 1);
+            }
+            break;
+        }
+        ++count;
+        bytes += (uint64_t)qsize;
+
+        // 解析对应的协议. 命令2B ｜ 数量2B ｜ 类型1B ｜ 数据，格式定义见codec.h
+        main_dispatch(buf, (size_t)qsize);
+    }
+    metric_add(METRIC_MQ_MSGS, (uint64_t)count);
+    metric_add(METRIC_MQ_BYTES, bytes);
+    return count;
+}
+
+// 读取系统对象中的无符号整数配置，未配置时返回默认值
+static uint32_t main_cfg_u32(uint16_t id, uint32_t def)
+{
+    dbvar *var = dbmem_get_value(OBJSYS_ID, id);
+
+    if (NULL == var || DB_UINT32 != var->type || 0 == var->u32) {
+        return def;
+    }
+    return var->u32;
+}
+
+// 按系统对象中的级别名称设置模块的日志级别，未配置时保持原级别，超过编译时级别时由
+// glog4c_set_level告警
+static void main_log_level(uint16_t id, int module)
+{
+    dbvar *var = dbmem_get_value(OBJSYS_ID, id);
+
+    if (NULL == var || DB_STRING != var->type || 0 == var->len) {
+        return;
+    }
+    int level = glog4c_level_parse(dbvar_str(var));
+    if (GLOG4C_BAD == level) {
+        glog4c_warn("unknow log level %s\n", dbvar_str(var));
+        return;
+    }
+    glog4c_set_level(module, level);
+}
+
+// 读取可以为0或负数的整数配置，未配置时返回默认值
+static int main_cfg_int(uint16_t id, int def)
+{
+    dbvar *var = dbmem_get_value(OBJSYS_ID, id);
+
+    if (NULL == var || DB_UINT32 != var->type) {
+        return def;
+    }
+    return (int)(int32_t)var->u32;
+}
+
+// 读取端口的积压处理方式，未配置或无法识别时丢弃最早的数据
+static int main_cfg_flow(uint16_t id)
+{
+    dbvar *var = dbmem_get_value(OBJSYS_ID, id);
+
+    if (NULL == var || DB_STRING != var->type || NULL == dbvar_str(var)) {
+        return ASY_FLOW_OLDEST;
+    }
+    int flow = asyncomm_flow_parse(dbvar_str(var));
+    if (flow < 0) {
+        glog4c_warn("Unknown flow policy %s, use oldest\n", dbvar_str(var));
+        return ASY_FLOW_OLDEST;
+    }
+    return flow;
+}
+
+// 按配置文件打开串口，串口未使能时直接返回
+static int main_open_serial(void)
+{
+    dbvar *enable = dbmem_get_value(OBJSYS_ID, OBJSYS_SERIAL_EN);
+    dbvar *dev    = dbmem_get_value(OBJSYS_ID, OBJSYS_SERIAL1);
+    dbvar *parity = dbmem_get_value(OBJSYS_ID, OBJSYS_SERIAL1_PAR);
+    asyserial_cfg cfg;
+
+    if (NULL == enable || DB_BOOL != enable->type || 0 == enable->bl) {
+        return ASY_OK;
+    }
+    if (NULL == dev || DB_STRING != dev->type || NULL == dbvar_str(dev)) {
+        return ASY_ER_PARAM;
+    }
+    cfg.baud     = main_cfg_u32(OBJSYS_SERIAL1_BAUD, 9600);
+    cfg.databits = main_cfg_u32(OBJSYS_SERIAL1_DATA, 8);
+    cfg.stopbits = main_cfg_u32(OBJSYS_SERIAL1_STOP, 1);
+    cfg.vmin     = main_cfg_u32(OBJSYS_SERIAL1_VMIN, 0);
+    cfg.vtime    = main_cfg_u32(OBJSYS_SERIAL1_VTIME, 0);
+    cfg.flow     = (uint8_t)main_cfg_flow(OBJSYS_SERIAL1_FLOW);
+    memset(&cfg.txn, 0, sizeof(cfg.txn));
+    cfg.txn.timeout = main_cfg_u32(OBJSYS_SERIAL1_TXN_TIMEOUT, 0);
+    cfg.txn.window  = (0 == cfg.txn.timeout) ? 0 : 1;
+    cfg.txn.retry   = (uint16_t)main_cfg_u32(OBJSYS_SERIAL1_TXN_RETRY, 0);
+    cfg.txn.seq_off = -1;
+    cfg.txn.len_off = -1;
+    cfg.parity   = 'N';
+    if (NULL != parity && DB_STRING == parity->type && NULL != dbvar_str(parity)) {
+        cfg.parity = dbvar_str(parity)[0];
+    }
+    return asyncomm_open_serial(dbvar_str(dev), &cfg);
+}
+
+// 按配置文件打开TCP通道，地址格式为host:port，host为空表示所有地址
+static int main_open_tcp(uint16_t id, uint16_t flow_id, int server)
+{
+    dbvar *addr = dbmem_get_value(OBJSYS_ID, id);
+    char host[64];
+
+    if (NULL == addr || DB_STRING != addr->type || NULL == dbvar_str(addr)) {
+        return ASY_OK;
+    }
+    char *colon = strrchr(dbvar_str(addr), ':');
+    size_t hlen = (NULL == colon) ? 0 : (size_t)(colon - dbvar_str(addr));
+    if (NULL == colon || hlen >= sizeof(host)) {
+        glog4c_warn("Error tcp address %s\n", dbvar_str(addr));
+        return ASY_ER_PARAM;
+    }
+    memcpy(host, dbvar_str(addr), hlen);
+    host[hlen] = '\0';
+    uint16_t port = (uint16_t)strtoul(colon + 1, NULL, 10);
+    int flow = main_cfg_flow(flow_id);
+    if (server) {
+        return asyncomm_open_tcps(host, port, flow);
+    }
+    asytxn_cfg txn;
+    txn.window  = (uint16_t)main_cfg_u32(OBJSYS_TCPC_TXN_WINDOW, 0);
+    txn.timeout = main_cfg_u32(OBJSYS_TCPC_TXN_TIMEOUT, 1000);
+    txn.retry   = (uint16_t)main_cfg_u32(OBJSYS_TCPC_TXN_RETRY, 0);
+    txn.seq_off = (int16_t)main_cfg_int(OBJSYS_TCPC_TXN_SEQ, -1);
+    txn.len_off = (int16_t)main_cfg_int(OBJSYS_TCPC_TXN_LEN, -1);
+    txn.len_adj = (int16_t)main_cfg_int(OBJSYS_TCPC_TXN_LENADJ, 0);
+    return asyncomm_open_tcpc(host, port, flow, &txn);
 }
 
 // 参考文章《SQlite数据库的C编程接口》
@@ -86,7 +623,7 @@ int main(int argc, char **argv)
     }
 
     // 解析配置文件
-    ret_v = cmdopt_parser_cfg(conf->str);
+    ret_v = cmdopt_parser_cfg(dbvar_str(conf));
     if (ret_v < 0) {
         glog4c_err("Parse config file is error!\n");
         // 后续这里遇到错误应该进入默认参数的安全模式
@@ -94,6 +631,65 @@ int main(int argc, char **argv)
     }
     glog4c_info("%s", "Read config is completed!\n");
 
+    // 日志文件和缓冲区满时的处理方式
+    dbvar *log_file  = dbmem_get_value(OBJSYS_ID, OBJSYS_LOG_FILE);
+    dbvar *log_block = dbmem_get_value(OBJSYS_ID, OBJSYS_LOG_BLOCK);
+    ret_v = glog4c_config((NULL != log_file && DB_STRING == log_file->type) ? dbvar_str(log_file) : NULL,
+        (NULL != log_block && DB_BOOL == log_block->type && log_block->bl) ? GLOG4C_BLOCK : GLOG4C_DROP);
+    if (ret_v < 0) {
+        glog4c_err("open log file error!\n");
+    }
+    // 日志级别，先设置所有模块，再按模块覆盖
+    main_log_level(OBJSYS_LOG_LEVEL,    GLOG4C_MOD_ALL);
+    main_log_level(OBJSYS_LOG_ASYNCOMM, GLOG4C_MOD_ASYNCOMM);
+    main_log_level(OBJSYS_LOG_DBMEM,    GLOG4C_MOD_DBMEM);
+    main_log_level(OBJSYS_LOG_CMDOPT,   GLOG4C_MOD_CMDOPT);
+
+    // 从快照和变化日志恢复测点值，系统对象由配置文件决定，不保存
+    dbvar *data_dir = dbmem_get_value(OBJSYS_ID, OBJSYS_DATA_DIR);
+    if (NULL != data_dir && DB_STRING == data_dir->type && data_dir->len > 0) {
+        ret_v = dbsnap_init(dbvar_str(data_dir), main_cfg_u32(OBJSYS_JNL_PERIOD, MAIN_JNL_PERIOD),
+            main_cfg_u32(OBJSYS_SNAP_PERIOD, MAIN_SNAP_PERIOD));
+        if (DBSNAP_OK == ret_v) {
+            dbsnap_skip(OBJSYS_ID);
+            dbsnap_load();
+            ret_v = dbsnap_start();
+        }
+        if (ret_v < 0) {
+            glog4c_err("start snapshot error!\n");
+        }
+    }
+
+    // 为应用对象打开历史记录，放在快照恢复之后，恢复的值不作为新样本
+    uint32_t hist_bytes = main_cfg_u32(OBJSYS_HIST_BYTES, 0);
+    for (int id = dbmem_next_obj(-1); id >= 0 && hist_bytes > 0; id = dbmem_next_obj(id)) {
+        if (OBJSYS_ID != id) {
+            ret_v = dbmem_history(id, hist_bytes);
+            if (ret_v < 0) {
+                glog4c_err(dbmem_get_err_str(ret_v));
+            }
+        }
+    }
+
+    // 对象初始化完成后导出到共享内存，应用进程可以不经过队列直接读取测点
+    dbvar *shm_name = dbmem_get_value(OBJSYS_ID, OBJSYS_SHM_NAME);
+    if (NULL != shm_name && DB_STRING == shm_name->type && shm_name->len > 0) {
+        ret_v = dbmem_export(dbvar_str(shm_name));
+        if (ret_v < 0) {
+            glog4c_err("export shared memory error!\n");
+        }
+    }
+
+    // 运行统计，共享内存和套接字都没有配置时不统计
+    dbvar *metric_shm  = dbmem_get_value(OBJSYS_ID, OBJSYS_METRIC_SHM);
+    dbvar *metric_sock = dbmem_get_value(OBJSYS_ID, OBJSYS_METRIC_SOCK);
+    ret_v = metric_init((NULL != metric_shm && DB_STRING == metric_shm->type) ? dbvar_str(metric_shm) : NULL,
+        (NULL != metric_sock && DB_STRING == metric_sock->type) ? dbvar_str(metric_sock) : NULL,
+        main_cfg_u32(OBJSYS_METRIC_PERIOD, MAIN_METRIC_PERIOD));
+    if (ret_v < 0) {
+        glog4c_err("start metric error!\n");
+    }
+
     // 根据配置文件内容创建各种通讯服务
     // 创建应用到通讯者的服务
     dbvar *a2q_name = dbmem_get_value(OBJSYS_ID, OBJSYS_CFG_A2Q);
@@ -102,74 +698,180 @@ int main(int argc, char **argv)
         glog4c_err("Can't get queue name!\n");
         exit(EXIT_FAILURE);
     }
-    // 打开从应用到通讯者的队列
-    m_app2queue = mq_open(a2q_name->str, O_RDONLY | O_CREAT | O_NONBLOCK, 0666, NULL);
+    // 打开两个方向的应用队列，传输方式未配置时使用POSIX消息队列
+    int app_kind = APPQ_MQUEUE;
+    dbvar *app_trans = dbmem_get_value(OBJSYS_ID, OBJSYS_APP_TRANSPORT);
+    if (NULL != app_trans && DB_STRING == app_trans->type) {
+        app_kind = appq_kind_parse(dbvar_str(app_trans));
+        if (app_kind < 0) {
+            glog4c_err("unknown app transport!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (appq_open(app_kind, dbvar_str(a2q_name), dbvar_str(q2a_name),
+        main_cfg_u32(OBJSYS_APP_RING, APPQ_RING_SIZE)) < 0) {
+        exit(EXIT_FAILURE);
+    }
 
-    if (m_app2queue < 0){
-        glog4c_err("open app2queue queue error:");
+    // 创建退出事件，信号处理函数和其他线程都可以通过它唤醒主循环
+    m_exit_evfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_exit_evfd < 0) {
+        glog4c_err("create exit eventfd error:");
         glog4c_err(strerror(errno));
+        appq_close();
         exit(EXIT_FAILURE);
     }
-    // 打开从通讯者到应用的队列，该队列句柄需要传递到通讯线程内部
-    m_queue2app = mq_open(q2a_name->str, O_RDWR | O_CREAT | O_NONBLOCK, 0666, NULL);
-    if (m_queue2app < 0){
-        if (errno == EEXIST) {
-            m_queue2app = mq_open(q2a_name->str, O_RDWR | O_NONBLOCK, 0666, NULL);
-        }
-    }
-    if (m_queue2app < 0) {
-        glog4c_err("open queue2app queue error:");
+
+    // 创建变化通知定时器，第一条订阅到来时才启动
+    m_sub_tmfd  = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    m_sub_cycle = main_cfg_u32(OBJSYS_SUB_CYCLE, MAIN_SUB_CYCLE);
+    if (m_sub_tmfd < 0) {
+        glog4c_err("create subscribe timer error:");
         glog4c_err(strerror(errno));
         exit(EXIT_FAILURE);
     }
 
-    // Register signals
-    signal(SIGINT, ctrl_c); 
-
-    // 读取当前队列属性
-    struct mq_attr a2q_attr;
+    // Register signals, 不设置SA_RESTART，保证阻塞的系统调用能被信号打断
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ctrl_c;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = log_toggle;
+    sa.sa_flags   = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
 
-    if (mq_getattr(m_app2queue, &a2q_attr) == -1) {
-        glog4c_err("get mqueue attr error:");
-        glog4c_err(strerror(errno));
-        mq_close(m_app2queue);
-        mq_close(m_queue2app);
+    // 按队列消息尺寸申请内测，解码和应答缓冲区在启动时一次申请，处理消息时不再申请内存
+    size_t app_msgsize = appq_msgsize();
+    char *buf = (char*)malloc(app_msgsize);
+    m_nitem = (app_msgsize - CODEC_HEAD_SIZE) / 2; // 最短的条目只有编号
+    if (m_nitem > 0xFFFF) {
+        m_nitem = 0xFFFF;
+    }
+    m_items      = (codec_item *)malloc(sizeof(codec_item) * (m_nitem + 1));
+    m_set_ids    = (uint16_t *)malloc(sizeof(uint16_t) * (m_nitem + 1));
+    m_set_types  = (uint8_t *)malloc(sizeof(uint8_t) * (m_nitem + 1));
+    m_set_values = (const void **)malloc(sizeof(void *) * (m_nitem + 1));
+    m_set_sizes  = (uint32_t *)malloc(sizeof(uint32_t) * (m_nitem + 1));
+    m_set_block  = (uint64_t *)malloc(sizeof(uint64_t) * (m_nitem + 1));
+    m_hist       = (dbsample *)malloc(sizeof(dbsample) * MAIN_HIST_MAX);
+    if (NULL == buf || NULL == m_items || NULL == m_set_ids || NULL == m_set_types
+        || NULL == m_set_values || NULL == m_set_sizes || NULL == m_set_block || NULL == m_hist) {
+        glog4c_err("malloc receive buffer error!\n");
         exit(EXIT_FAILURE);
     }
-    // 按队列缓冲尺寸申请内测
-    char *buf = (char*)malloc(a2q_attr.mq_msgsize);
 
-    // 创建异步通信线程
-    ret_v = asyncomm_init(&m_queue2app);
+    // 创建异步通信线程，线程数量由配置文件决定，未配置或配置为0时使用1个线程
+    asyncomm_set_watermark(main_cfg_u32(OBJSYS_FLOW_HIGH, 0), main_cfg_u32(OBJSYS_FLOW_LOW, 0));
+    ret_v = asyncomm_init((int)main_cfg_u32(OBJSYS_IO_THREADS, 1), main_cfg_u32(OBJSYS_FWD_DELAY, 0));
     if (ret_v < 0) {
         // 通信线程初始化失败，终止程序
         exit(EXIT_FAILURE);
     }
+    m_reply_size = asyncomm_msgsize();
+    m_reply = (char*)malloc(m_reply_size);
+    if (NULL == m_reply) {
+        glog4c_err("malloc reply buffer error!\n");
+        exit(EXIT_FAILURE);
+    }
+    // 串口打开失败时不影响其他通道，记录错误后继续运行
+    if (main_open_serial() < 0) {
+        glog4c_err("open serial error!\n");
+    }
+    if (main_open_tcp(OBJSYS_TCPS_ADDR, OBJSYS_TCPS_FLOW, 1) < 0) {
+        glog4c_err("open tcp server error!\n");
+    }
+    if (main_open_tcp(OBJSYS_TCPC_ADDR, OBJSYS_TCPC_FLOW, 0) < 0) {
+        glog4c_err("open tcp client error!\n");
+    }
 
-    // 循环读取应用进程发来的数据
-    ssize_t qsize;
+    // Linux下mqd_t就是文件描述符，共享内存环的门铃是FIFO，都可以直接交给epoll管理，
+    // 进程空闲时阻塞在epoll_wait上
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        glog4c_err("create main epoll error:");
+        glog4c_err(strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event ev;
+    ev.events  = EPOLLIN;
+    ev.data.fd = appq_fd();
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, appq_fd(), &ev) < 0) {
+        glog4c_err("register app2queue error:");
+        glog4c_err(strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    ev.events  = EPOLLIN;
+    ev.data.fd = m_exit_evfd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, m_exit_evfd, &ev) < 0) {
+        glog4c_err("register exit eventfd error:");
+        glog4c_err(strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    ev.events  = EPOLLIN;
+    ev.data.fd = m_sub_tmfd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, m_sub_tmfd, &ev) < 0) {
+        glog4c_err("register subscribe timer error:");
+        glog4c_err(strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // 循环读取应用进程发来的数据，每次唤醒按预算批量处理队列中的消息，预算用完时不阻塞
+    m_drain_records = main_cfg_u32(OBJSYS_DRAIN_RECORDS, MAIN_DRAIN_RECORDS);
+    m_drain_bytes   = main_cfg_u32(OBJSYS_DRAIN_BYTES, MAIN_DRAIN_BYTES);
+    struct epoll_event evs[MAIN_MAX_EVENTS];
     for (;m_exit_flag != 1;) {
-        qsize = mq_receive(m_app2queue, buf, a2q_attr.mq_msgsize, NULL);
-        if (qsize < 0){
-            if (errno == EAGAIN){ // 资源未准备好，异步通信时容易发生此类事件
-                usleep(10);
+        int app_ready = m_app_more;
+        int nev = epoll_wait(epfd, evs, MAIN_MAX_EVENTS, m_app_more ? 0 : -1);
+        if (nev < 0) {
+            if (errno == EINTR) { // 被信号打断，回到循环判断退出标志
                 continue;
             }
-            glog4c_err("receive message failed:");
+            glog4c_err("main epoll wait failed:");
             glog4c_err(strerror(errno));
-            continue;
+            break;
+        }
+        metric_add(METRIC_MAIN_WAKE, 1);
+        for (int idx = 0; idx < nev; ++idx) {
+            if (evs[idx].data.fd == m_exit_evfd) {
+                m_exit_flag = 1;
+            } else if (evs[idx].data.fd == appq_fd()) {
+                app_ready = 1;
+            } else if (evs[idx].data.fd == m_sub_tmfd) {
+                uint64_t ticks;
+                if (read(m_sub_tmfd, &ticks, sizeof(ticks)) == sizeof(ticks)) {
+                    dbsub_flush(); // 错过的周期合并为一次
+                }
+            }
+        }
+        if (app_ready && m_exit_flag != 1) {
+            main_drain_app(buf, app_msgsize);
         }
-
-        // 解析对应的协议，格式简单处理. 命令2B ｜ 数量2B ｜ 类型1B ｜ 数据
-        glog4c_info("get buf size = %ld\n", qsize);
     }
+    glog4c_hit("user break process!\n");
 
-    mq_close(m_app2queue);
-    mq_close(m_queue2app);
-    closelog();
+    // 先停止通信线程，再关闭它使用的队列
+    asyncomm_exit();
+    dbsnap_exit();
+    metric_exit();
+    close(epfd);
+    close(m_exit_evfd);
+    close(m_sub_tmfd);
+    dbsub_close();
+    free(buf);
+    free(m_items);
+    free(m_set_ids);
+    free(m_set_types);
+    free(m_set_values);
+    free(m_set_sizes);
+    free(m_set_block);
+    free(m_hist);
+    free(m_reply);
+    appq_close();
+    glog4c_close();
     dbmem_close();
-    mq_unlink(a2q_name->str);
-    mq_unlink(q2a_name->str);
     exit(EXIT_SUCCESS);
 }
 
@@ -0,0 +1,485 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :metric.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :运行统计。各线程在第一次统计时从统计表中取得独占的统计数据，之后只写自己的
+//                 数据；后台线程按周期把所有线程的数据相加，写入共享内存统计块，并把
+//                 Prometheus文本格式的结果推送给连接到Unix套接字的客户端。
+// Interface      :无
+// Others         :计数器只由所属线程写入，使用原子读写保证读者不会读到半个值，不需要加锁.
+//                 线程的统计数据在进程退出前不回收，退出线程的计数仍然计入总数.每次推送以
+//                 "# EOF"结束，客户端跟不上时断开连接，不阻塞后台线程
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // accept4需要GNU扩展
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+
+#include "metric.h"
+
+#define METRIC_CLIENTS   8      // 最多同时连接的客户端数量
+#define METRIC_TEXT_SIZE 32768  // 文本格式输出缓冲区
+#define METRIC_LE_LOW    6      // 直方图输出的最小边界2^6ns
+#define METRIC_LE_HIGH   34     // 直方图输出的最大边界2^34ns，约17秒
+
+int metric_on = 0;
+__thread metric_slot *metric_cur = NULL;
+
+// 计数器名称和说明，与METRIC_*计数器编号一一对应
+static const char *m_counter_name[METRIC_COUNTERS][2] = {
+    {"communicator_mq_messages_total",   "Messages received from the application queue."},
+    {"communicator_mq_bytes_total",      "Bytes received from the application queue."},
+    {"communicator_mq_eagain_total",     "Application queue reads that returned EAGAIN."},
+    {"communicator_main_wakeups_total",  "Main loop epoll wakeups."},
+    {"communicator_db_set_points_total", "Points written to the memory database."},
+    {"communicator_db_get_points_total", "Points read from the memory database."},
+    {"communicator_allocations_total",   "Memory allocations on the write and send paths."},
+    {"communicator_io_wakeups_total",    "Communication thread epoll wakeups."},
+    {"communicator_io_rx_bytes_total",   "Bytes received on communication ports."},
+    {"communicator_io_tx_bytes_total",   "Bytes accepted for sending on communication ports."},
+    {"communicator_io_drops_total",      "Forwarded records dropped because a port backlog exceeded its limit."},
+    {"communicator_fwd_records_total",   "Data records forwarded to the application."},
+    {"communicator_fwd_frames_total",    "Coalesced data frames forwarded to the application."},
+    {"communicator_mq_budget_total",     "Application queue drains stopped by the per-wakeup budget."},
+    {"communicator_flow_queued_total",   "Forwarded records queued in port backlogs while the application queue was congested."},
+    {"communicator_flow_conflate_total", "Backlogged records replaced by newer data on keep-latest ports."},
+    {"communicator_flow_pause_total",    "Port reads paused at the backlog high watermark."},
+    {"communicator_flow_resume_total",   "Port reads resumed at the backlog low watermark."},
+    {"communicator_flow_congest_total",  "Times forwarding entered the congested state because the application queue was full."},
+    {"communicator_txn_requests_total",  "Requests sent to device channels, excluding retries."},
+    {"communicator_txn_replies_total",   "Requests completed by a matching device reply."},
+    {"communicator_txn_retries_total",   "Requests resent after a reply timeout."},
+    {"communicator_txn_timeouts_total",  "Requests that timed out after all retries."},
+    {"communicator_timer_fired_total",   "Reactor timer callbacks run on expiry."},
+    {"communicator_timer_wakeups_total", "Reactor timerfd wakeups; fired/wakeups is the expiry coalescing ratio."},
+};
+
+// 直方图名称和说明，与METRIC_H_*编号一一对应
+static const char *m_hist_name[METRIC_HISTS][2] = {
+    {"communicator_decode_seconds", "Sampled time to decode one application frame."},
+    {"communicator_db_set_seconds", "Sampled time of one memory database write call."},
+    {"communicator_db_get_seconds", "Sampled time of one memory database read call."},
+    {"communicator_fwd_delay_seconds", "Sampled time a forwarded record waits for its frame to be sent."},
+    {"communicator_txn_rtt_seconds", "Sampled time from the first send of a request to its reply."},
+};
+
+static metric_slot  *m_slots  = NULL;  // 统计表
+static uint32_t      m_nslot  = 0;     // 已经分配的数量
+static metric_block *m_shm    = NULL;  // 共享内存统计块
+static metric_block  m_sum;            // 汇总结果，只由后台线程使用
+static char          m_shm_name[64];
+static char          m_sock_path[108];
+static int           m_lfd    = -1;    // 监听套接字
+static int           m_evfd   = -1;    // 唤醒后台线程退出
+static int           m_clients[METRIC_CLIENTS];
+static int           m_run    = 0;
+static uint32_t      m_period = 1000;
+static char          m_text[METRIC_TEXT_SIZE];
+static size_t        m_text_len = 0;
+static pthread_t     m_thread;
+
+// 为当前线程分配统计数据，统计表用完后当前线程不再统计
+metric_slot *metric_attach(void)
+{
+    static __thread int none = 0;
+
+    if (none || NULL == m_slots) {
+        return NULL;
+    }
+    uint32_t idx = __atomic_fetch_add(&m_nslot, 1, __ATOMIC_ACQ_REL);
+    if (idx >= METRIC_THREADS) {
+        none = 1;
+        return NULL;
+    }
+    metric_cur = &m_slots[idx];
+    return metric_cur;
+}
+
+// 记录一个延迟采样，只在采样时调用
+void metric_record(int hist, uint64_t ns)
+{
+    metric_slot *slot = metric_cur;
+
+    if (NULL == slot || hist < 0 || hist >= METRIC_HISTS) {
+        return;
+    }
+    metric_hist *h = &slot->hist[hist];
+    int idx = metric_bucket(ns);
+    __atomic_store_n(&h->bucket[idx], h->bucket[idx] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum, h->sum + ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELAXED);
+}
+
+// 相加所有线程的统计数据
+static void metric_collect(metric_block *sum)
+{
+    uint32_t nslot = __atomic_load_n(&m_nslot, __ATOMIC_ACQUIRE);
+
+    nslot = nslot > METRIC_THREADS ? METRIC_THREADS : nslot;
+    memset(sum, 0, sizeof(metric_block));
+    sum->nthread = (uint16_t)nslot;
+    for (uint32_t idx = 0; idx < nslot; ++idx) {
+        const metric_slot *slot = &m_slots[idx];
+        for (int cnt = 0; cnt < METRIC_COUNTERS; ++cnt) {
+            sum->counter[cnt] += __atomic_load_n(&slot->counter[cnt], __ATOMIC_RELAXED);
+        }
+        for (int port = 0; port < METRIC_PORTS; ++port) {
+            sum->port_rx[port] += __atomic_load_n(&slot->port_rx[port], __ATOMIC_RELAXED);
+            sum->port_tx[port] += __atomic_load_n(&slot->port_tx[port], __ATOMIC_RELAXED);
+        }
+        for (int hist = 0; hist < METRIC_HISTS; ++hist) {
+            const metric_hist *src = &slot->hist[hist];
+            metric_hist *dst = &sum->hist[hist];
+            dst->count += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+            dst->sum   += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+            for (int bkt = 0; bkt < METRIC_BUCKETS; ++bkt) {
+                dst->bucket[bkt] += __atomic_load_n(&src->bucket[bkt], __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+// 按缓冲区剩余空间追加格式化文本，空间不足时截断
+static void metric_text(const char *format, ...) __attribute__((format(printf, 1, 2)));
+static void metric_text(const char *format, ...)
+{
+    va_list ap;
+
+    if (m_text_len >= sizeof(m_text)) {
+        return;
+    }
+    va_start(ap, format);
+    int len = vsnprintf(m_text + m_text_len, sizeof(m_text) - m_text_len, format, ap);
+    va_end(ap);
+    if (len > 0) {
+        m_text_len += (size_t)len;
+        if (m_text_len > sizeof(m_text)) {
+            m_text_len = sizeof(m_text);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Function       :metric_render
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :把汇总结果转换为Prometheus文本格式.直方图按2的幂输出累计数量，HDR子区间
+//                 正好落在这些边界内，不需要插值；端口只输出有数据的端口
+// Input          :sum:汇总结果
+// Output         :无
+// Return         :无
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+static void metric_render(const metric_block *sum)
+{
+    m_text_len = 0;
+    for (int cnt = 0; cnt < METRIC_COUNTERS; ++cnt) {
+        metric_text("# HELP %s %s\n# TYPE %s counter\n%s %llu\n", m_counter_name[cnt][0],
+            m_counter_name[cnt][1], m_counter_name[cnt][0], m_counter_name[cnt][0],
+            (unsigned long long)sum->counter[cnt]);
+    }
+    metric_text("# HELP communicator_port_rx_bytes_total Bytes received per port.\n"
+        "# TYPE communicator_port_rx_bytes_total counter\n");
+    for (int port = 0; port < METRIC_PORTS; ++port) {
+        if (sum->port_rx[port] > 0) {
+            metric_text("communicator_port_rx_bytes_total{port=\"%d\"} %llu\n", port,
+                (unsigned long long)sum->port_rx[port]);
+        }
+    }
+    metric_text("# HELP communicator_port_tx_bytes_total Bytes accepted for sending per port.\n"
+        "# TYPE communicator_port_tx_bytes_total counter\n");
+    for (int port = 0; port < METRIC_PORTS; ++port) {
+        if (sum->port_tx[port] > 0) {
+            metric_text("communicator_port_tx_bytes_total{port=\"%d\"} %llu\n", port,
+                (unsigned long long)sum->port_tx[port]);
+        }
+    }
+    for (int hist = 0; hist < METRIC_HISTS; ++hist) {
+        const metric_hist *h = &sum->hist[hist];
+        const char *name = m_hist_name[hist][0];
+        uint64_t total = 0;
+        int bkt = 0;
+        metric_text("# HELP %s %s\n# TYPE %s histogram\n", name, m_hist_name[hist][1], name);
+        for (int bit = METRIC_LE_LOW; bit <= METRIC_LE_HIGH; ++bit) {
+            uint64_t edge = 1ULL << bit;
+            for (; bkt < METRIC_BUCKETS && metric_bucket_low(bkt) < edge; ++bkt) {
+                total += h->bucket[bkt];
+            }
+            metric_text("%s_bucket{le=\"%g\"} %llu\n", name, (double)edge * 1e-9, (unsigned long long)total);
+        }
+        // 总数也按区间相加，与各线程分别写入的count不一定同时读到
+        for (; bkt < METRIC_BUCKETS; ++bkt) {
+            total += h->bucket[bkt];
+        }
+        metric_text("%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.9f\n%s_count %llu\n", name,
+            (unsigned long long)total, name, (double)h->sum * 1e-9, name, (unsigned long long)total);
+    }
+    metric_text("# EOF\n");
+}
+
+// 发送当前的文本结果，不能一次写完时断开，避免慢客户端阻塞后台线程
+static void metric_send(int idx)
+{
+    ssize_t ret = send(m_clients[idx], m_text, m_text_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if (ret != (ssize_t)m_text_len) {
+        close(m_clients[idx]);
+        m_clients[idx] = -1;
+    }
+}
+
+// 接收新的客户端，连接后立即发送一次最近的结果
+static void metric_accept(void)
+{
+    for (;;) {
+        int fd = accept4(m_lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            break;
+        }
+        int idx = 0;
+        for (; idx < METRIC_CLIENTS && m_clients[idx] >= 0; ++idx) {
+        }
+        if (idx == METRIC_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        m_clients[idx] = fd;
+        if (m_text_len > 0) {
+            metric_send(idx);
+        }
+    }
+}
+
+// 汇总并发布一次结果
+static void metric_publish(void)
+{
+    struct timespec ts;
+
+    metric_collect(&m_sum);
+    clock_gettime(CLOCK_REALTIME, &ts);
+    m_sum.ts = (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    if (NULL != m_shm) {
+        uint32_t seq = m_shm->seq;
+        __atomic_store_n(&m_shm->seq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        m_shm->nthread = m_sum.nthread;
+        memcpy(&m_shm->ts, &m_sum.ts, sizeof(metric_block) - offsetof(metric_block, ts));
+        __atomic_store_n(&m_shm->seq, seq + 2, __ATOMIC_RELEASE);
+    }
+    if (m_lfd >= 0) {
+        metric_render(&m_sum);
+        for (int idx = 0; idx < METRIC_CLIENTS; ++idx) {
+            if (m_clients[idx] >= 0) {
+                metric_send(idx);
+            }
+        }
+    }
+}
+
+// 后台线程，按周期发布结果，等待期间接收新的客户端
+static void *metric_thread(void *arg)
+{
+    struct pollfd fds[2];
+    uint64_t next = metric_now() / 1000000 + m_period;
+
+    (void)arg;
+    fds[0].fd     = m_evfd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = m_lfd;
+    fds[1].events = POLLIN;
+    for (;;) {
+        uint64_t now = metric_now() / 1000000;
+        if (now >= next) {
+            metric_publish();
+            next = now + m_period;
+        }
+        int ret = poll(fds, m_lfd >= 0 ? 2 : 1, (int)(next - now));
+        if (ret < 0 && EINTR != errno) {
+            break;
+        }
+        if (ret > 0 && (fds[0].revents & POLLIN)) {
+            break;
+        }
+        if (ret > 0 && m_lfd >= 0 && (fds[1].revents & POLLIN)) {
+            metric_accept();
+        }
+    }
+    return NULL;
+}
+
+// 建立共享内存统计块
+static int metric_open_shm(const char *name)
+{
+    if (strlen(name) >= sizeof(m_shm_name)) {
+        return METRIC_ER_PARAM;
+    }
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return METRIC_ER_SHM;
+    }
+    if (ftruncate(fd, sizeof(metric_block)) < 0) {
+        close(fd);
+        shm_unlink(name);
+        return METRIC_ER_SHM;
+    }
+    void *base = mmap(NULL, sizeof(metric_block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base) {
+        shm_unlink(name);
+        return METRIC_ER_SHM;
+    }
+    m_shm = (metric_block *)base;
+    m_shm->version = METRIC_VERSION;
+    m_shm->period  = m_period;
+    __atomic_store_n(&m_shm->magic, METRIC_MAGIC, __ATOMIC_RELEASE);
+    strcpy(m_shm_name, name);
+    return METRIC_OK;
+}
+
+// 建立Unix监听套接字，删除上次运行遗留的套接字文件
+static int metric_open_sock(const char *path)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return METRIC_ER_PARAM;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    m_lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_lfd < 0) {
+        return METRIC_ER_SOCK;
+    }
+    unlink(path);
+    if (bind(m_lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(m_lfd, METRIC_CLIENTS) < 0) {
+        close(m_lfd);
+        m_lfd = -1;
+        return METRIC_ER_SOCK;
+    }
+    strcpy(m_sock_path, path);
+    return METRIC_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :metric_init
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :申请统计表，建立共享内存统计块和Unix套接字，启动后台线程并打开统计.
+//                 共享内存和套接字都没有配置时不启动，统计操作保持为空操作
+// Input          :shm:共享内存名称，格式与shm_open相同，为NULL或空字符串时不建立
+//                :sock:Unix套接字路径，为NULL或空字符串时不建立
+//                :period:更新周期，单位ms
+// Output         :无
+// Return         :成功返回METRIC_OK，失败按头文件中的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+//------------------------------------------------------------------------------
+int metric_init(const char *shm, const char *sock, uint32_t period)
+{
+    int ret = METRIC_OK;
+    int has_shm  = NULL != shm && '\0' != shm[0];
+    int has_sock = NULL != sock && '\0' != sock[0];
+
+    if (m_run || 0 == period) {
+        return METRIC_ER_PARAM;
+    }
+    if (!has_shm && !has_sock) {
+        return METRIC_OK;
+    }
+    m_period = period;
+    for (int idx = 0; idx < METRIC_CLIENTS; ++idx) {
+        m_clients[idx] = -1;
+    }
+    if (NULL == m_slots) {
+        if (posix_memalign((void **)&m_slots, 64, sizeof(metric_slot) * METRIC_THREADS) != 0) {
+            m_slots = NULL;
+            return METRIC_ER_MEM;
+        }
+        memset(m_slots, 0, sizeof(metric_slot) * METRIC_THREADS);
+    }
+    if (has_shm) {
+        ret = metric_open_shm(shm);
+    }
+    if (METRIC_OK == ret && has_sock) {
+        ret = metric_open_sock(sock);
+    }
+    if (METRIC_OK == ret) {
+        m_evfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        ret = m_evfd < 0 ? METRIC_ER_THREAD : METRIC_OK;
+    }
+    if (METRIC_OK == ret && pthread_create(&m_thread, NULL, metric_thread, NULL) != 0) {
+        ret = METRIC_ER_THREAD;
+    }
+    if (METRIC_OK != ret) {
+        m_run = 1; // 借用退出流程释放已经建立的资源
+        metric_exit();
+        return ret;
+    }
+    m_run = 2;
+    __atomic_store_n(&metric_on, 1, __ATOMIC_RELEASE);
+    return METRIC_OK;
+}
+
+// 停止后台线程，关闭套接字和共享内存，之后的统计操作不再记录新线程
+void metric_exit(void)
+{
+    uint64_t one = 1;
+
+    if (!m_run) {
+        return;
+    }
+    __atomic_store_n(&metric_on, 0, __ATOMIC_RELEASE);
+    if (m_run > 1) {
+        ssize_t wret = write(m_evfd, &one, sizeof(one));
+        (void)wret;
+        pthread_join(m_thread, NULL);
+    }
+    m_run = 0;
+    for (int idx = 0; idx < METRIC_CLIENTS; ++idx) {
+        if (m_clients[idx] >= 0) {
+            close(m_clients[idx]);
+            m_clients[idx] = -1;
+        }
+    }
+    if (m_evfd >= 0) {
+        close(m_evfd);
+        m_evfd = -1;
+    }
+    if (m_lfd >= 0) {
+        close(m_lfd);
+        m_lfd = -1;
+        unlink(m_sock_path);
+    }
+    if (NULL != m_shm) {
+        munmap(m_shm, sizeof(metric_block));
+        m_shm = NULL;
+        shm_unlink(m_shm_name);
+    }
+}
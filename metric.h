@@ -0,0 +1,217 @@
+#ifndef METRIC_H_
+#define METRIC_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// 运行统计.计数器和延迟直方图按线程分开保存，每个线程独占若干缓存行，热路径只对本线程的
+// 数据做普通加法，没有原子读改写和跨线程的缓存行争用.后台线程按周期汇总所有线程的数据，
+// 写入共享内存统计块，并以Prometheus文本格式推送给连接到本地Unix套接字的客户端
+// 未调用metric_init时所有统计操作只检查一个标志.延迟每METRIC_SAMPLE次操作采样一次，
+// 直方图中的数量是采样数量，操作总数见对应的计数器
+
+#define METRIC_OK         0
+#define METRIC_ER_PARAM  -1 // 参数错误
+#define METRIC_ER_MEM    -2 // 内存不足
+#define METRIC_ER_SHM    -3 // 共享内存建立失败
+#define METRIC_ER_SOCK   -4 // 套接字建立失败
+#define METRIC_ER_THREAD -5 // 后台线程建立失败
+
+// 计数器
+#define METRIC_MQ_MSGS    0  // 从应用队列收到的消息数量
+#define METRIC_MQ_BYTES   1  // 从应用队列收到的字节数
+#define METRIC_MQ_EAGAIN  2  // 读应用队列遇到EAGAIN的次数
+#define METRIC_MAIN_WAKE  3  // 主循环epoll唤醒次数
+#define METRIC_DB_SET     4  // 写入数据库的测点数量
+#define METRIC_DB_GET     5  // 读取数据库的测点数量
+#define METRIC_ALLOC      6  // 运行中写入和发送路径的内存申请次数
+#define METRIC_ASY_WAKE   7  // 通信线程epoll唤醒次数
+#define METRIC_ASY_RX     8  // 通信端口收到的字节数
+#define METRIC_ASY_TX     9  // 通信端口接收发送的字节数
+#define METRIC_ASY_DROP   10 // 积压超过上限时丢弃的转发数据条目数量
+#define METRIC_FWD_RECORDS 11 // 转发到应用的数据条目数量，与帧数量的比值是合并比例
+#define METRIC_FWD_FRAMES 12 // 转发到应用的数据帧数量
+#define METRIC_MQ_BUDGET  13 // 读应用队列因为单次唤醒的预算用完而暂停的次数
+#define METRIC_FLOW_QUEUED 14 // 应用队列拥塞时进入端口积压的数据条目数量
+#define METRIC_FLOW_CONFLATE 15 // 只保留最新数据的端口被新数据替换的积压条目数量
+#define METRIC_FLOW_PAUSE 16 // 积压达到高水位停止读取端口的次数
+#define METRIC_FLOW_RESUME 17 // 积压降到低水位恢复读取端口的次数
+#define METRIC_FLOW_CONGEST 18 // 应用队列满导致转发进入拥塞状态的次数
+#define METRIC_TXN_REQ    19 // 发送到通道的请求数量，不含重发
+#define METRIC_TXN_RESP   20 // 匹配到应答的请求数量
+#define METRIC_TXN_RETRY  21 // 请求超时重发的次数
+#define METRIC_TXN_TIMEOUT 22 // 重发次数用完仍然超时的请求数量
+#define METRIC_TIMER_FIRE 23 // 通信线程定时器到期执行回调的次数
+#define METRIC_TIMER_WAKE 24 // 通信线程定时器句柄唤醒次数，与回调次数的比值是到期合并比例
+#define METRIC_COUNTERS   25
+
+// 延迟直方图，单位ns
+#define METRIC_H_DECODE   0  // 解码一帧应用消息
+#define METRIC_H_DB_SET   1  // 一次数据库写入调用
+#define METRIC_H_DB_GET   2  // 一次数据库读取调用
+#define METRIC_H_FWD_DELAY 3 // 转发数据帧中第一条数据从合并到发送的等待时间
+#define METRIC_H_TXN_RTT  4  // 请求第一次发送到收到应答的时间
+#define METRIC_HISTS      5
+
+// HDR方式的直方图，每个2的幂区间再分为2^METRIC_SUB_BITS个子区间，相对误差不超过12.5%，
+// 小于2^METRIC_SUB_BITS的值每个值一个区间，最大覆盖到2^METRIC_MAX_BITS ns
+#define METRIC_SUB_BITS   3
+#define METRIC_MAX_BITS   40
+#define METRIC_BUCKETS    ((METRIC_MAX_BITS - METRIC_SUB_BITS + 1) << METRIC_SUB_BITS)
+
+#define METRIC_PORTS      64 // 单独统计字节数的通信端口数量，编号更大的端口只计入总数
+#define METRIC_THREADS    64 // 最多统计的线程数量，超出的线程不统计
+#define METRIC_SAMPLE     64 // 延迟采样间隔，2的幂
+
+// 共享内存统计块格式，由后台线程按周期整体更新，seq为奇数时表示正在更新，读者重试
+#define METRIC_MAGIC      0x5254454D // "METR"
+#define METRIC_VERSION    5
+
+typedef struct {
+    uint64_t count;                   // 采样数量
+    uint64_t sum;                     // 采样值的和
+    uint64_t bucket[METRIC_BUCKETS];  // 各区间的数量，区间下限见metric_bucket_low
+}metric_hist;
+
+typedef struct {
+    uint32_t    magic;    // METRIC_MAGIC
+    uint16_t    version;  // METRIC_VERSION
+    uint16_t    nthread;  // 已经统计的线程数量
+    uint32_t    seq;      // 顺序锁计数
+    uint32_t    period;   // 更新周期，单位ms
+    uint64_t    ts;       // 更新时间，从1970年开始的毫秒数
+    uint64_t    counter[METRIC_COUNTERS];
+    uint64_t    port_rx[METRIC_PORTS];
+    uint64_t    port_tx[METRIC_PORTS];
+    metric_hist hist[METRIC_HISTS];
+}metric_block;
+
+// 每个线程的统计数据，按缓存行对齐，只有所属线程写入
+typedef struct {
+    uint64_t    counter[METRIC_COUNTERS];
+    uint64_t    port_rx[METRIC_PORTS];
+    uint64_t    port_tx[METRIC_PORTS];
+    uint32_t    tick[METRIC_HISTS]; // 各直方图的采样计数，同一线程交替计时的操作互不影响
+    metric_hist hist[METRIC_HISTS];
+}__attribute__((aligned(64))) metric_slot;
+
+extern int metric_on;                     // 统计已经启动
+extern __thread metric_slot *metric_cur;  // 当前线程的统计数据
+
+// 启动统计，shm为共享内存名称，sock为Unix套接字路径，都可以为NULL，period为更新周期(ms)
+int metric_init(const char *shm, const char *sock, uint32_t period);
+// 停止后台线程，删除共享内存和套接字.线程的统计数据保留到进程退出
+void metric_exit(void);
+// 为当前线程分配统计数据，统计未启动或线程数量超出时返回NULL
+metric_slot *metric_attach(void);
+// 记录一个延迟采样
+void metric_record(int hist, uint64_t ns);
+
+// 区间的下限
+static inline uint64_t metric_bucket_low(int idx)
+{
+    if (idx < (1 << METRIC_SUB_BITS)) {
+        return (uint64_t)idx;
+    }
+    int shift = (idx >> METRIC_SUB_BITS) - 1;
+    return ((uint64_t)((1 << METRIC_SUB_BITS) | (idx & ((1 << METRIC_SUB_BITS) - 1)))) << shift;
+}
+
+// 值所在的区间
+static inline int metric_bucket(uint64_t val)
+{
+    if (val < (1 << METRIC_SUB_BITS)) {
+        return (int)val;
+    }
+    int msb = 63 - __builtin_clzll(val);
+    int idx = ((msb - METRIC_SUB_BITS + 1) << METRIC_SUB_BITS)
+        + (int)((val >> (msb - METRIC_SUB_BITS)) & ((1 << METRIC_SUB_BITS) - 1));
+    return idx < METRIC_BUCKETS ? idx : METRIC_BUCKETS - 1;
+}
+
+// 当前线程的统计数据，统计未启动时返回NULL
+static inline metric_slot *metric_slot_get(void)
+{
+    metric_slot *slot = metric_cur;
+
+    if (__builtin_expect(NULL == slot, 0) && __atomic_load_n(&metric_on, __ATOMIC_RELAXED)) {
+        slot = metric_attach();
+    }
+    return slot;
+}
+
+// 计数器增加val，只有所属线程写入，不需要原子读改写
+static inline void metric_add(int id, uint64_t val)
+{
+    metric_slot *slot = metric_slot_get();
+
+    if (NULL != slot) {
+        __atomic_store_n(&slot->counter[id], slot->counter[id] + val, __ATOMIC_RELAXED);
+    }
+}
+
+// 端口字节数，rx为1时是收到的字节，否则是发送的字节
+static inline void metric_port(int port, int rx, uint64_t bytes)
+{
+    metric_slot *slot = metric_slot_get();
+
+    if (NULL == slot) {
+        return;
+    }
+    uint64_t *total = &slot->counter[rx ? METRIC_ASY_RX : METRIC_ASY_TX];
+    __atomic_store_n(total, *total + bytes, __ATOMIC_RELAXED);
+    if (port >= 0 && port < METRIC_PORTS) {
+        uint64_t *cnt = rx ? &slot->port_rx[port] : &slot->port_tx[port];
+        __atomic_store_n(cnt, *cnt + bytes, __ATOMIC_RELAXED);
+    }
+}
+
+// 单调时钟，单位ns
+static inline uint64_t metric_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 开始计时，本次不采样或统计未启动时返回0
+static inline uint64_t metric_begin(int hist)
+{
+    metric_slot *slot = metric_slot_get();
+
+    if (NULL == slot || (++slot->tick[hist] & (METRIC_SAMPLE - 1)) != 0) {
+        return 0;
+    }
+    return metric_now();
+}
+
+// 结束计时，start为metric_begin的返回值
+static inline void metric_end(int hist, uint64_t start)
+{
+    if (0 != start) {
+        metric_record(hist, metric_now() - start);
+    }
+}
+
+// 读取共享内存统计块的一致副本
+static inline void metric_read(const metric_block *blk, metric_block *out)
+{
+    uint32_t seq0, seq1;
+
+    for (;;) {
+        seq0 = __atomic_load_n(&blk->seq, __ATOMIC_ACQUIRE);
+        if (seq0 & 1) {
+            continue;
+        }
+        memcpy(out, blk, sizeof(metric_block));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq1 = __atomic_load_n(&blk->seq, __ATOMIC_RELAXED);
+        if (seq0 == seq1) {
+            break;
+        }
+    }
+}
+
+#endif
@@ -13,8 +13,62 @@
 #define OBJSYS_CFG_Q2A       0x0003 // posix message with Communicator to App
 #define OBJSYS_SERIAL_EN     0x0004 // 串口是否生效
 #define OBJSYS_SERIAL1       0x0005 // 串口1路径
-#define OBJSYS_MAXID         0x0005 // 最大测点数量
+#define OBJSYS_IO_THREADS    0x0006 // 异步通信线程数量
+#define OBJSYS_SERIAL1_BAUD  0x0007 // 串口1波特率
+#define OBJSYS_SERIAL1_PAR   0x0008 // 串口1校验方式，N/E/O
+#define OBJSYS_SERIAL1_DATA  0x0009 // 串口1数据位
+#define OBJSYS_SERIAL1_STOP  0x000A // 串口1停止位
+#define OBJSYS_SERIAL1_VMIN  0x000B // 串口1成帧字节数
+#define OBJSYS_SERIAL1_VTIME 0x000C // 串口1帧间隔，单位0.1秒
+#define OBJSYS_TCPS_ADDR     0x000D // TCP服务端监听地址，格式为host:port
+#define OBJSYS_TCPC_ADDR     0x000E // TCP客户端连接地址，格式为host:port
+#define OBJSYS_SUB_CYCLE     0x000F // 变化通知周期，单位ms
+#define OBJSYS_SHM_NAME      0x0010 // 共享内存导出名称，未配置时不导出
+#define OBJSYS_DATA_DIR      0x0011 // 快照和变化日志目录，未配置时不保存
+#define OBJSYS_SNAP_PERIOD   0x0012 // 快照周期，单位s
+#define OBJSYS_JNL_PERIOD    0x0013 // 变化日志刷新周期，单位ms
+#define OBJSYS_HIST_BYTES    0x0014 // 每个测点的历史记录空间，单位B，未配置时不记录
+#define OBJSYS_LOG_FILE      0x0015 // 日志文件路径，未配置时普通日志写入标准输出
+#define OBJSYS_LOG_BLOCK     0x0016 // 日志缓冲区满时等待，未使能时丢弃
+#define OBJSYS_LOG_LEVEL     0x0017 // 所有模块的日志级别，off/err/warn/notice/info/debug，默认info
+#define OBJSYS_LOG_ASYNCOMM  0x0018 // 异步通信模块的日志级别，未配置时使用OBJSYS_LOG_LEVEL
+#define OBJSYS_LOG_DBMEM     0x0019 // 内存数据库模块的日志级别，未配置时使用OBJSYS_LOG_LEVEL
+#define OBJSYS_LOG_CMDOPT    0x001A // 配置解析模块的日志级别，未配置时使用OBJSYS_LOG_LEVEL
+#define OBJSYS_METRIC_SHM    0x001B // 统计共享内存名称，与统计套接字都未配置时不统计
+#define OBJSYS_METRIC_SOCK   0x001C // 统计推送的Unix套接字路径
+#define OBJSYS_METRIC_PERIOD 0x001D // 统计更新周期，单位ms
+#define OBJSYS_APP_TRANSPORT 0x001E // 应用队列的传输方式，mqueue或shm，默认mqueue
+#define OBJSYS_APP_RING      0x001F // 共享内存传输每个方向的环尺寸，单位B
+#define OBJSYS_FWD_DELAY     0x0020 // 转发数据合并的最长等待时间，单位us，0表示只合并同一次唤醒中的数据
+#define OBJSYS_DRAIN_RECORDS 0x0021 // 主循环每次唤醒最多处理的应用消息数量
+#define OBJSYS_DRAIN_BYTES   0x0022 // 主循环每次唤醒最多处理的应用消息字节数
+#define OBJSYS_SERIAL1_FLOW  0x0023 // 串口1在应用队列拥塞时的积压处理方式，oldest/latest/block，默认oldest
+#define OBJSYS_TCPS_FLOW     0x0024 // TCP服务端接入连接的积压处理方式，oldest/block，不支持latest
+#define OBJSYS_TCPC_FLOW     0x0025 // TCP客户端的积压处理方式，latest需要按长度字段成帧的事务
+#define OBJSYS_FLOW_HIGH     0x0026 // 每个端口积压的高水位，单位B
+#define OBJSYS_FLOW_LOW      0x0027 // 每个端口积压的低水位，单位B，停止读取的端口降到这里后恢复
+#define OBJSYS_SERIAL1_TXN_TIMEOUT 0x0028 // 串口1请求的应答超时，单位ms，未配置时不启用事务
+#define OBJSYS_SERIAL1_TXN_RETRY   0x0029 // 串口1请求超时后的重发次数
+#define OBJSYS_TCPC_TXN_WINDOW  0x002A // TCP客户端同时在途的请求数量，未配置时不启用事务
+#define OBJSYS_TCPC_TXN_TIMEOUT 0x002B // TCP客户端请求的应答超时，单位ms
+#define OBJSYS_TCPC_TXN_RETRY   0x002C // TCP客户端请求超时后的重发次数
+#define OBJSYS_TCPC_TXN_SEQ     0x002D // 请求和应答中2字节大端序号的位置，未配置时按发送顺序匹配
+#define OBJSYS_TCPC_TXN_LEN     0x002E // 应答中2字节大端长度字段的位置，未配置时每次读到的数据是一个应答
+#define OBJSYS_TCPC_TXN_LENADJ  0x002F // 应答总长度 = 长度字段位置 + 2 + 长度字段的值 + 调整值
+#define OBJSYS_MAXID         0x002F // 最大测点数量
 // 属性列表
-#define OBJSYS_ID_LIST       OBJSYS_CFG_FILE_PATH, OBJSYS_CFG_A2Q, OBJSYS_CFG_Q2A, OBJSYS_SERIAL_EN, OBJSYS_SERIAL1
+#define OBJSYS_ID_LIST       OBJSYS_CFG_FILE_PATH, OBJSYS_CFG_A2Q, OBJSYS_CFG_Q2A, OBJSYS_SERIAL_EN, OBJSYS_SERIAL1, \
+                             OBJSYS_IO_THREADS, OBJSYS_SERIAL1_BAUD, OBJSYS_SERIAL1_PAR, OBJSYS_SERIAL1_DATA, \
+                             OBJSYS_SERIAL1_STOP, OBJSYS_SERIAL1_VMIN, OBJSYS_SERIAL1_VTIME, OBJSYS_TCPS_ADDR, \
+                             OBJSYS_TCPC_ADDR, OBJSYS_SUB_CYCLE, OBJSYS_SHM_NAME, OBJSYS_DATA_DIR, \
+                             OBJSYS_SNAP_PERIOD, OBJSYS_JNL_PERIOD, OBJSYS_HIST_BYTES, \
+                             OBJSYS_LOG_FILE, OBJSYS_LOG_BLOCK, OBJSYS_LOG_LEVEL, OBJSYS_LOG_ASYNCOMM, \
+                             OBJSYS_LOG_DBMEM, OBJSYS_LOG_CMDOPT, OBJSYS_METRIC_SHM, OBJSYS_METRIC_SOCK, \
+                             OBJSYS_METRIC_PERIOD, OBJSYS_APP_TRANSPORT, OBJSYS_APP_RING, \
+                             OBJSYS_FWD_DELAY, OBJSYS_DRAIN_RECORDS, OBJSYS_DRAIN_BYTES, \
+                             OBJSYS_SERIAL1_FLOW, OBJSYS_TCPS_FLOW, OBJSYS_TCPC_FLOW, OBJSYS_FLOW_HIGH, \
+                             OBJSYS_FLOW_LOW, OBJSYS_SERIAL1_TXN_TIMEOUT, OBJSYS_SERIAL1_TXN_RETRY, \
+                             OBJSYS_TCPC_TXN_WINDOW, OBJSYS_TCPC_TXN_TIMEOUT, OBJSYS_TCPC_TXN_RETRY, \
+                             OBJSYS_TCPC_TXN_SEQ, OBJSYS_TCPC_TXN_LEN, OBJSYS_TCPC_TXN_LENADJ
 
 #endif
@@ -0,0 +1,146 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :ringbuf.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :字节环形缓冲区。空闲区和数据区都以iovec的形式给出，这样一次readv/writev
+//                 系统调用就可以处理跨越缓冲区尾部的数据，不需要额外拷贝。
+// Interface      :无
+// Others         :无
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#include "ringbuf.h"
+
+int ringbuf_init(ringbuf *rb, uint32_t size)
+{
+    uint32_t cap = 1;
+
+    if (NULL == rb || 0 == size || size > 0x80000000u) {
+        return RINGBUF_PARAM;
+    }
+    while (cap < size) {
+        cap <<= 1;
+    }
+    rb->buf = (uint8_t *)malloc(cap);
+    if (NULL == rb->buf) {
+        return RINGBUF_FMEM;
+    }
+    rb->size = cap;
+    rb->head = 0;
+    rb->tail = 0;
+    return RINGBUF_OK;
+}
+
+void ringbuf_free(ringbuf *rb)
+{
+    free(rb->buf);
+    rb->buf  = NULL;
+    rb->size = 0;
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+uint32_t ringbuf_used(const ringbuf *rb)
+{
+    return rb->head - rb->tail;
+}
+
+uint32_t ringbuf_space(const ringbuf *rb)
+{
+    return rb->size - (rb->head - rb->tail);
+}
+
+int ringbuf_space_vec(ringbuf *rb, struct iovec iov[2])
+{
+    uint32_t space = ringbuf_space(rb);
+    uint32_t pos   = rb->head & (rb->size - 1);
+    uint32_t first = rb->size - pos;
+
+    if (0 == space) {
+        return 0;
+    }
+    iov[0].iov_base = rb->buf + pos;
+    if (space <= first) {
+        iov[0].iov_len = space;
+        return 1;
+    }
+    iov[0].iov_len  = first;
+    iov[1].iov_base = rb->buf;
+    iov[1].iov_len  = space - first;
+    return 2;
+}
+
+void ringbuf_produce(ringbuf *rb, uint32_t n)
+{
+    rb->head += n;
+}
+
+int ringbuf_data_vec(const ringbuf *rb, struct iovec iov[2])
+{
+    uint32_t used  = ringbuf_used(rb);
+    uint32_t pos   = rb->tail & (rb->size - 1);
+    uint32_t first = rb->size - pos;
+
+    if (0 == used) {
+        return 0;
+    }
+    iov[0].iov_base = rb->buf + pos;
+    if (used <= first) {
+        iov[0].iov_len = used;
+        return 1;
+    }
+    iov[0].iov_len  = first;
+    iov[1].iov_base = rb->buf;
+    iov[1].iov_len  = used - first;
+    return 2;
+}
+
+void ringbuf_consume(ringbuf *rb, uint32_t n)
+{
+    rb->tail += n;
+}
+
+uint32_t ringbuf_write(ringbuf *rb, const void *data, uint32_t n)
+{
+    struct iovec iov[2];
+    const uint8_t *src = (const uint8_t *)data;
+    uint32_t done = 0;
+    int cnt = ringbuf_space_vec(rb, iov);
+
+    for (int idx = 0; idx < cnt && done < n; ++idx) {
+        uint32_t len = n - done;
+        if (len > iov[idx].iov_len) {
+            len = iov[idx].iov_len;
+        }
+        memcpy(iov[idx].iov_base, src + done, len);
+        done += len;
+    }
+    ringbuf_produce(rb, done);
+    return done;
+}
+
+uint32_t ringbuf_read(ringbuf *rb, void *data, uint32_t n)
+{
+    struct iovec iov[2];
+    uint8_t *dst = (uint8_t *)data;
+    uint32_t done = 0;
+    int cnt = ringbuf_data_vec(rb, iov);
+
+    for (int idx = 0; idx < cnt && done < n; ++idx) {
+        uint32_t len = n - done;
+        if (len > iov[idx].iov_len) {
+            len = iov[idx].iov_len;
+        }
+        memcpy(dst + done, iov[idx].iov_base, len);
+        done += len;
+    }
+    ringbuf_consume(rb, done);
+    return done;
+}
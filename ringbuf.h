@@ -0,0 +1,41 @@
+#ifndef RINGBUF_H_
+#define RINGBUF_H_
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+// 字节环形缓冲区，容量为2的幂，读写位置为累计计数，依靠无符号溢出自然回绕
+// 本身不带锁，由使用者保证同一时刻只有一个线程操作
+typedef struct {
+    uint8_t *buf;  // 数据区
+    uint32_t size; // 容量，2的幂
+    uint32_t head; // 写入位置
+    uint32_t tail; // 读出位置
+}ringbuf;
+
+#define RINGBUF_OK     0
+#define RINGBUF_PARAM -1 // 参数错误
+#define RINGBUF_FMEM  -2 // 内存不足
+
+// 初始化缓冲区，size会向上取整为2的幂
+int ringbuf_init(ringbuf *rb, uint32_t size);
+// 释放缓冲区
+void ringbuf_free(ringbuf *rb);
+// 已使用的字节数
+uint32_t ringbuf_used(const ringbuf *rb);
+// 剩余空间字节数
+uint32_t ringbuf_space(const ringbuf *rb);
+// 获取空闲区域，最多两段，返回段数，可以直接交给readv一次读满
+int ringbuf_space_vec(ringbuf *rb, struct iovec iov[2]);
+// 确认写入了n字节
+void ringbuf_produce(ringbuf *rb, uint32_t n);
+// 获取数据区域，最多两段，返回段数，可以直接交给writev
+int ringbuf_data_vec(const ringbuf *rb, struct iovec iov[2]);
+// 确认读出了n字节
+void ringbuf_consume(ringbuf *rb, uint32_t n);
+// 拷贝写入数据，返回实际写入的字节数
+uint32_t ringbuf_write(ringbuf *rb, const void *data, uint32_t n);
+// 拷贝读出数据，返回实际读出的字节数
+uint32_t ringbuf_read(ringbuf *rb, void *data, uint32_t n);
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef SHMRING_H_
+#define SHMRING_H_
+
+// 共享内存单生产者单消费者环形队列，用于通讯者和应用进程之间的消息传递，可以代替POSIX消息队列
+// 每个方向一个环，通讯者启动时建立(见appq.c)，应用进程用shmring_open映射.发送和接收只读写
+// 共享内存，不进入内核；只有消费者读空后登记了停车标志时，生产者才通过门铃FIFO唤醒一次
+// 门铃是普通的命名管道，可以交给epoll/poll等待.本文件不依赖通讯者的其他头文件，可以单独交给
+// 应用使用.同一个环只能有一个生产者线程和一个消费者线程，多个线程发送时由使用者加锁
+//
+// 共享内存布局:
+//   shmring_head(写入位置、读出位置和停车标志分别位于独立的缓存行) | 数据区(2的幂)
+// 数据区中的记录: 长度4B | 数据 | 填充到8字节对齐.尾部空间不够一条记录时写入长度为
+// SHMRING_PAD的填充记录，从数据区开头继续.门铃FIFO的路径为/dev/shm下共享内存名称加".bell"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHMRING_MAGIC    0x474E5253 // "SRNG"
+#define SHMRING_VERSION  1
+#define SHMRING_PAD      0xFFFFFFFF // 填充记录的长度
+#define SHMRING_LINE     64
+
+// 函数返回结果定义
+#define SHMRING_OK         0
+#define SHMRING_ER_OPEN   -1 // 共享内存或门铃不存在、无法建立或映射
+#define SHMRING_ER_FORMAT -2 // 格式或版本不匹配
+#define SHMRING_ER_AGAIN  -3 // 发送时环已满，接收时环为空
+#define SHMRING_ER_SIZE   -4 // 记录超过最大长度或接收缓冲区太小
+#define SHMRING_ER_CORRUPT -5 // 记录长度超出最大长度、数据区或已经写入的范围
+
+// 环头，3个缓存行之后是数据区
+typedef struct {
+    uint32_t magic;    // SHMRING_MAGIC
+    uint16_t version;  // SHMRING_VERSION
+    uint16_t rsv;
+    uint32_t size;     // 数据区尺寸，2的幂
+    uint32_t maxmsg;   // 单条记录的最大长度
+    uint8_t  pad0[SHMRING_LINE - 16];
+    uint32_t head;     // 写入位置，累计计数，只由生产者修改
+    uint8_t  pad1[SHMRING_LINE - 4];
+    uint32_t tail;     // 读出位置，累计计数，只由消费者修改
+    uint8_t  pad2[SHMRING_LINE - 4];
+    uint32_t parked;   // 消费者已经读空并准备等待门铃，生产者发送后清除并按门铃
+    uint8_t  pad3[SHMRING_LINE - 4];
+}shmring_head;
+
+// 进程内的环句柄
+typedef struct {
+    shmring_head *ring;
+    uint8_t      *data;   // 数据区
+    size_t        mapped; // 映射尺寸
+    uint32_t      mask;   // 数据区尺寸减1
+    uint32_t      cache;  // 生产者缓存的读出位置，消费者缓存的写入位置，减少对另一方缓存行的访问
+    int           bell;   // 门铃FIFO
+}shmring;
+
+// 记录在数据区中占用的尺寸
+static inline uint32_t shmring_rec_size(uint32_t len)
+{
+    return (uint32_t)((sizeof(uint32_t) + len + 7) & ~(size_t)7);
+}
+
+// 门铃FIFO路径
+static inline int shmring_bell_path(const char *name, char *path, size_t size)
+{
+    int len = snprintf(path, size, "/dev/shm/%s.bell", '/' == name[0] ? name + 1 : name);
+    return (len < 0 || (size_t)len >= size) ? SHMRING_ER_OPEN : SHMRING_OK;
+}
+
+// 映射已经建立的环，应用进程使用
+static inline int shmring_open(const char *name, shmring *rb)
+{
+    struct stat st;
+    char path[128];
+
+    memset(rb, 0, sizeof(shmring));
+    rb->bell = -1;
+    if (shmring_bell_path(name, path, sizeof(path)) != SHMRING_OK) {
+        return SHMRING_ER_OPEN;
+    }
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return SHMRING_ER_OPEN;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(shmring_head)) {
+        close(fd);
+        return SHMRING_ER_OPEN;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base) {
+        return SHMRING_ER_OPEN;
+    }
+    rb->ring   = (shmring_head *)base;
+    rb->mapped = st.st_size;
+    if (SHMRING_MAGIC != __atomic_load_n(&rb->ring->magic, __ATOMIC_ACQUIRE)
+        || SHMRING_VERSION != rb->ring->version
+        || sizeof(shmring_head) + rb->ring->size > rb->mapped) {
+        munmap(base, rb->mapped);
+        rb->ring = NULL;
+        return SHMRING_ER_FORMAT;
+    }
+    rb->data = (uint8_t *)base + sizeof(shmring_head);
+    rb->mask = rb->ring->size - 1;
+    // 读写方式打开FIFO，打开时不需要等待另一端，也不会因为另一端关闭而读到文件结束
+    rb->bell = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (rb->bell < 0) {
+        munmap(base, rb->mapped);
+        rb->ring = NULL;
+        return SHMRING_ER_OPEN;
+    }
+    return SHMRING_OK;
+}
+
+// 解除映射并关闭门铃
+static inline void shmring_close(shmring *rb)
+{
+    if (NULL != rb->ring) {
+        munmap(rb->ring, rb->mapped);
+        rb->ring = NULL;
+    }
+    if (rb->bell >= 0) {
+        close(rb->bell);
+        rb->bell = -1;
+    }
+}
+
+// 门铃句柄，消费者读到SHMRING_ER_AGAIN后等待它可读
+static inline int shmring_fd(const shmring *rb)
+{
+    return rb->bell;
+}
+
+// 发送一条记录，环满时返回SHMRING_ER_AGAIN，记录不会部分写入
+static inline int shmring_send(shmring *rb, const void *buf, uint32_t len)
+{
+    shmring_head *ring = rb->ring;
+
+    if (len > ring->maxmsg) {
+        return SHMRING_ER_SIZE;
+    }
+    uint32_t head = ring->head;
+    uint32_t need = shmring_rec_size(len);
+    uint32_t room = ring->size - (head & rb->mask); // 到数据区末尾的连续空间
+    uint32_t total = (room < need) ? room + need : need;
+    if (ring->size - (head - rb->cache) < total) {
+        rb->cache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (ring->size - (head - rb->cache) < total) {
+            return SHMRING_ER_AGAIN;
+        }
+    }
+    if (room < need) {
+        *(uint32_t *)(rb->data + (head & rb->mask)) = SHMRING_PAD;
+        head += room;
+    }
+    uint8_t *rec = rb->data + (head & rb->mask);
+    *(uint32_t *)rec = len;
+    memcpy(rec + sizeof(uint32_t), buf, len);
+    __atomic_store_n(&ring->head, head + need, __ATOMIC_RELEASE);
+    // 与消费者登记停车标志后的重新检查配对，两边都使用全屏障，不会同时错过对方
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->parked, __ATOMIC_RELAXED)
+        && __atomic_exchange_n(&ring->parked, 0, __ATOMIC_ACQ_REL)) {
+        uint8_t one = 1;
+        ssize_t wret = write(rb->bell, &one, sizeof(one)); // FIFO已满说明门铃已经按过
+        (void)wret;
+    }
+    return SHMRING_OK;
+}
+
+//------------------------------------------------------------------------------
+// Function       :shmring_recv
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :接收一条记录.环为空时清空门铃，登记停车标志后再检查一次，仍然为空才返回
+//                 SHMRING_ER_AGAIN，此后生产者发送的第一条记录会按响门铃，调用者可以放心
+//                 等待门铃句柄.缓冲区太小时记录保留在环中.长度超过maxmsg、越过数据区末尾
+//                 或超出写入位置的记录是损坏的，不读取并返回SHMRING_ER_CORRUPT
+// Input          :rb:环句柄
+//                :size:缓冲区尺寸
+// Output         :buf:记录内容
+// Return         :成功返回记录长度，失败按上面的定义返回
+//------------------------------------------------------------------------------
+// Modification History:
+// 2026-10-17 (llemmx): 创建
+// 2026-10-17 (llemmx): 检查记录长度，数据区尺寸使用映射时的mask，不使用共享内存中的值
+//------------------------------------------------------------------------------
+static inline int shmring_recv(shmring *rb, void *buf, uint32_t size)
+{
+    shmring_head *ring = rb->ring;
+    uint32_t tail = ring->tail;
+
+    for (;;) {
+        if (tail == rb->cache) {
+            rb->cache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        }
+        if (tail != rb->cache) {
+            uint32_t len = *(const uint32_t *)(rb->data + (tail & rb->mask));
+            if (SHMRING_PAD != len) {
+                break;
+            }
+            tail += rb->mask + 1 - (tail & rb->mask);
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+            continue;
+        }
+        // 读空，清空门铃后登记停车
+        uint8_t drain[64];
+        while (read(rb->bell, drain, sizeof(drain)) > 0) {
+        }
+        __atomic_store_n(&ring->parked, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        rb->cache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (tail == rb->cache) {
+            return SHMRING_ER_AGAIN;
+        }
+        // 登记之后有新的记录，撤销停车.生产者已经按过门铃时只会多一次空唤醒
+        __atomic_store_n(&ring->parked, 0, __ATOMIC_RELAXED);
+    }
+    uint32_t len = *(const uint32_t *)(rb->data + (tail & rb->mask));
+    if (len > ring->maxmsg || (uint64_t)(tail & rb->mask) + sizeof(uint32_t) + len > (uint64_t)rb->mask + 1
+        || rb->cache - tail < shmring_rec_size(len)) {
+        return SHMRING_ER_CORRUPT;
+    }
+    if (len > size) {
+        return SHMRING_ER_SIZE;
+    }
+    memcpy(buf, rb->data + (tail & rb->mask) + sizeof(uint32_t), len);
+    __atomic_store_n(&ring->tail, tail + shmring_rec_size(len), __ATOMIC_RELEASE);
+    return (int)len;
+}
+
+// 阻塞接收一条记录，timeout为等待门铃的毫秒数，-1表示一直等待，超时返回SHMRING_ER_AGAIN
+static inline int shmring_recv_wait(shmring *rb, void *buf, uint32_t size, int timeout)
+{
+    struct pollfd pfd;
+
+    for (;;) {
+        int ret = shmring_recv(rb, buf, size);
+        if (SHMRING_ER_AGAIN != ret) {
+            return ret;
+        }
+        pfd.fd     = rb->bell;
+        pfd.events = POLLIN;
+        ret = poll(&pfd, 1, timeout);
+        if (0 == ret) {
+            return SHMRING_ER_AGAIN;
+        }
+        if (ret < 0 && EINTR != errno) {
+            return SHMRING_ER_OPEN;
+        }
+    }
+}
+
+#endif
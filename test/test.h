@@ -0,0 +1,100 @@
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <fcntl.h>
+#include <mqueue.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "appq.h"
+#include "codec.h"
+
+// 测试的公共函数，每个测试是一个独立的程序，检查失败时打印位置并以非0退出
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        exit(EXIT_FAILURE); \
+    } \
+} while (0)
+
+#define TEST_RX_ITEMS 1024 // 一帧中最多解码的条目数量
+
+// 从通讯者到应用的队列接收帧并逐条取出条目
+typedef struct {
+    mqd_t      mq;
+    char      *buf;
+    size_t     size;
+    codec_head head;
+    codec_item item[TEST_RX_ITEMS];
+    int        num;  // 当前帧的条目数量
+    int        next; // 下一个取出的条目
+}test_rx;
+
+// 单调时钟，单位ns
+static inline uint64_t test_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 用带进程号的队列名打开应用队列，并打开通讯者到应用方向的读取句柄
+static inline void test_appq_open(test_rx *rx, const char *tag)
+{
+    char a2q[64], q2a[64];
+    struct mq_attr attr;
+
+    snprintf(a2q, sizeof(a2q), "/test_%s_a2q_%d", tag, (int)getpid());
+    snprintf(q2a, sizeof(q2a), "/test_%s_q2a_%d", tag, (int)getpid());
+    CHECK(appq_open(APPQ_MQUEUE, a2q, q2a, 0) == APPQ_OK);
+    rx->mq = mq_open(q2a, O_RDONLY);
+    CHECK(rx->mq != (mqd_t)-1);
+    CHECK(mq_getattr(rx->mq, &attr) == 0);
+    rx->size = (size_t)attr.mq_msgsize;
+    rx->buf  = (char*)malloc(rx->size);
+    CHECK(NULL != rx->buf);
+    rx->num  = 0;
+    rx->next = 0;
+}
+
+static inline void test_appq_close(test_rx *rx)
+{
+    mq_close(rx->mq);
+    free(rx->buf);
+    appq_close();
+}
+
+// 取出下一个命令为cmd的帧中的条目，其他命令的帧丢弃，timeout_ms内没有收到时返回NULL
+static inline const codec_item *test_rx_next(test_rx *rx, uint16_t cmd, int timeout_ms)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec  += 1;
+        ts.tv_nsec -= 1000000000L;
+    }
+    while (rx->next >= rx->num) {
+        ssize_t len = mq_timedreceive(rx->mq, rx->buf, rx->size, NULL, &ts);
+        if (len < 0) {
+            return NULL;
+        }
+        rx->next = 0;
+        rx->num  = codec_decode(rx->buf, (size_t)len, &rx->head, rx->item, TEST_RX_ITEMS);
+        CHECK(rx->num >= 0);
+        if (rx->head.cmd != cmd) {
+            rx->num = 0;
+        }
+    }
+    return &rx->item[rx->next++];
+}
+
+#endif
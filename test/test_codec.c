@@ -0,0 +1,254 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_codec.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :应用消息编解码测试.各数据类型编码后解码得到相同的帧头和条目，帧头字段
+//                 按小端序排列；截断、多余字节、未知类型、条目过多等错误帧被拒绝；
+//                 编码缓冲区不足时不写入半个条目；历史查询和历史样本条目编码后解码一致，
+//                 历史记录的压缩和查询见test_dbhist
+// Interface      :test_codec
+// Others         :无
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include "db_in_mem.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define ITEMS 16
+
+static uint8_t    m_buf[4096];
+static codec_item m_item[ITEMS];
+
+// 每种定长类型编码ITEMS个条目后解码，值和编号一致
+static void test_fixed(void)
+{
+    for (uint8_t type = DB_NULL; type <= DB_BOOL; ++type) {
+        int vsize = codec_type_size(type);
+        codec_writer wr;
+        codec_head head;
+
+        if (DB_STRING == type || DB_BLOB == type) {
+            continue;
+        }
+        CHECK(vsize >= 0);
+        CHECK(codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_SET, type, 0x1234) == CODEC_OK);
+        for (int idx = 0; idx < ITEMS; ++idx) {
+            uint64_t val = 0x0102030405060708ULL * (uint64_t)(idx + 1);
+            CHECK(codec_put(&wr, (uint16_t)(100 + idx), &val, 0) == CODEC_OK);
+        }
+        size_t len = codec_end(&wr);
+        CHECK(len == CODEC_HEAD_SIZE + (size_t)ITEMS * (2 + vsize));
+        // 帧头字段为小端序
+        CHECK(m_buf[0] == (CODEC_CMD_SET & 0xFF) && m_buf[1] == (CODEC_CMD_SET >> 8));
+        CHECK(m_buf[2] == ITEMS && m_buf[3] == 0);
+        CHECK(m_buf[4] == type);
+        CHECK(m_buf[5] == 0x34 && m_buf[6] == 0x12);
+
+        CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == ITEMS);
+        CHECK(head.cmd == CODEC_CMD_SET && head.count == ITEMS);
+        CHECK(head.type == type && head.obj_id == 0x1234);
+        for (int idx = 0; idx < ITEMS; ++idx) {
+            uint64_t val = 0x0102030405060708ULL * (uint64_t)(idx + 1);
+            CHECK(m_item[idx].id == 100 + idx);
+            CHECK(m_item[idx].len == vsize);
+            CHECK(m_item[idx].value == &m_item[idx].raw);
+            CHECK(memcmp(&m_item[idx].raw, &val, vsize) == 0);
+        }
+    }
+}
+
+// 变长类型编码后解码，值指向接收缓冲区，包含空值
+static void test_var(void)
+{
+    static const char *str[] = {"", "a", "hello", "0123456789abcdef0123456789abcdef"};
+    codec_writer wr;
+    codec_head head;
+
+    CHECK(codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_VALUE, DB_STRING, 7) == CODEC_OK);
+    for (int idx = 0; idx < 4; ++idx) {
+        CHECK(codec_put(&wr, (uint16_t)idx, str[idx], (uint16_t)strlen(str[idx])) == CODEC_OK);
+    }
+    size_t len = codec_end(&wr);
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == 4);
+    CHECK(head.type == DB_STRING && head.obj_id == 7);
+    for (int idx = 0; idx < 4; ++idx) {
+        CHECK(m_item[idx].id == idx);
+        CHECK(m_item[idx].len == strlen(str[idx]));
+        CHECK(memcmp(m_item[idx].value, str[idx], m_item[idx].len) == 0);
+        CHECK((const uint8_t *)m_item[idx].value >= m_buf && (const uint8_t *)m_item[idx].value < m_buf + len);
+    }
+
+    // 数据已经位于条目位置时原地组帧
+    CHECK(codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_DATA, DB_BLOB, 0) == CODEC_OK);
+    memcpy(m_buf + CODEC_HEAD_SIZE + 4, "inplace", 7);
+    CHECK(codec_put(&wr, 3, m_buf + CODEC_HEAD_SIZE + 4, 7) == CODEC_OK);
+    len = codec_end(&wr);
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == 1);
+    CHECK(m_item[0].len == 7 && memcmp(m_item[0].value, "inplace", 7) == 0);
+
+    // 条目数量为0的帧
+    CHECK(codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_UNSUB, DB_UINT16, 9) == CODEC_OK);
+    len = codec_end(&wr);
+    CHECK(len == CODEC_HEAD_SIZE);
+    CHECK(codec_decode(m_buf, len, &head, NULL, 0) == 0);
+}
+
+// 错误帧
+static void test_malformed(void)
+{
+    codec_writer wr;
+    codec_head head;
+    uint32_t val = 42;
+
+    CHECK(codec_decode(m_buf, CODEC_HEAD_SIZE - 1, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+    CHECK(codec_decode(NULL, 16, &head, m_item, ITEMS) == CODEC_ER_PARAM);
+    CHECK(codec_decode(m_buf, 16, NULL, m_item, ITEMS) == CODEC_ER_PARAM);
+
+    // 定长帧:缺字节、多字节
+    codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_SET, DB_UINT32, 1);
+    codec_put(&wr, 1, &val, 0);
+    codec_put(&wr, 2, &val, 0);
+    size_t len = codec_end(&wr);
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == 2);
+    CHECK(codec_decode(m_buf, len - 1, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+    CHECK(codec_decode(m_buf, len + 1, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+    // 条目数量超出调用者的数组
+    CHECK(codec_decode(m_buf, len, &head, m_item, 1) == CODEC_ER_COUNT);
+    // 数量字段大于实际条目
+    m_buf[2] = 3;
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+    m_buf[2] = 2;
+    // 未知类型
+    m_buf[4] = DB_BOOL + 1;
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == CODEC_ER_TYPE);
+    m_buf[4] = 0xFF;
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == CODEC_ER_TYPE);
+
+    // 变长帧:条目长度越界、缺条目头、尾部多余字节
+    codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_WRITE, DB_BLOB, 0);
+    codec_put(&wr, 1, "abcd", 4);
+    codec_put(&wr, 2, "ef", 2);
+    len = codec_end(&wr);
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == 2);
+    CHECK(codec_decode(m_buf, len - 1, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+    CHECK(codec_decode(m_buf, len + 1, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+    CHECK(codec_decode(m_buf, CODEC_HEAD_SIZE + 3, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+    m_buf[CODEC_HEAD_SIZE + 2] = 0xFF; // 第一个条目的长度超过帧
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == CODEC_ER_SHORT);
+
+    CHECK(strcmp(codec_err_str(CODEC_ER_SHORT), "Frame length is error.") == 0);
+    CHECK(strcmp(codec_err_str(-100), "Nothing") == 0);
+}
+
+// 编码缓冲区不足
+static void test_space(void)
+{
+    codec_writer wr;
+    codec_head head;
+    uint16_t val = 7;
+
+    CHECK(codec_begin(&wr, m_buf, CODEC_HEAD_SIZE - 1, CODEC_CMD_SET, DB_UINT16, 0) == CODEC_ER_SPACE);
+    CHECK(codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_SET, DB_BOOL + 1, 0) == CODEC_ER_PARAM);
+
+    // 只能容纳两个条目
+    CHECK(codec_begin(&wr, m_buf, CODEC_HEAD_SIZE + 9, CODEC_CMD_SET, DB_UINT16, 0) == CODEC_OK);
+    CHECK(codec_put(&wr, 1, &val, 0) == CODEC_OK);
+    CHECK(codec_put(&wr, 2, &val, 0) == CODEC_OK);
+    CHECK(codec_put(&wr, 3, &val, 0) == CODEC_ER_SPACE);
+    size_t len = codec_end(&wr);
+    CHECK(len == CODEC_HEAD_SIZE + 8);
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == 2);
+
+    CHECK(codec_begin(&wr, m_buf, CODEC_HEAD_SIZE + 8, CODEC_CMD_DATA, DB_BLOB, 0) == CODEC_OK);
+    CHECK(codec_put(&wr, 1, "12345", 5) == CODEC_ER_SPACE);
+    CHECK(codec_put(&wr, 1, "1234", 4) == CODEC_OK);
+    CHECK(codec_item_size(DB_BLOB, 4) == 8);
+    CHECK(codec_item_size(DB_DOUBLE, 0) == 10);
+}
+
+// 历史查询和历史样本条目的编解码，样本帧写满时分成多帧，解码得到相同的样本.历史记录
+// 本身的检查见test_dbhist
+static void test_history(void)
+{
+    static const uint64_t from[] = {0, 1700000000000ULL, 5};
+    static const uint64_t to[]   = {UINT64_MAX, 1700000001000ULL, 5};
+    static const uint16_t max[]  = {0, 100, 0xFFFF};
+    codec_writer wr;
+    codec_head head;
+    uint64_t ts, raw, f, t;
+    uint16_t m;
+    uint8_t type;
+
+    CHECK(codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_HIST, DB_BLOB, 7) == CODEC_OK);
+    for (int idx = 0; idx < 3; ++idx) {
+        CHECK(codec_put_hist_query(&wr, (uint16_t)(10 + idx), from[idx], to[idx], max[idx]) == CODEC_OK);
+    }
+    size_t len = codec_end(&wr);
+    CHECK(len == CODEC_HEAD_SIZE + 3 * (4 + CODEC_HIST_QUERY));
+    CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == 3);
+    CHECK(CODEC_CMD_HIST == head.cmd && DB_BLOB == head.type && 7 == head.obj_id);
+    for (int idx = 0; idx < 3; ++idx) {
+        CHECK(m_item[idx].id == 10 + idx);
+        CHECK(codec_get_hist_query(&m_item[idx], &f, &t, &m) == CODEC_OK);
+        CHECK(f == from[idx] && t == to[idx] && m == max[idx]);
+        CHECK(codec_get_sample(&m_item[idx], &ts, &type, &raw) == CODEC_ER_SHORT);
+    }
+
+    // 类型不是DB_BLOB的编码器
+    CHECK(codec_begin(&wr, m_buf, sizeof(m_buf), CODEC_CMD_HIST, DB_UINT32, 7) == CODEC_OK);
+    CHECK(codec_put_hist_query(&wr, 1, 0, 1, 1) == CODEC_ER_TYPE);
+    CHECK(codec_put_sample(&wr, 1, 0, DB_UINT32, 1) == CODEC_ER_TYPE);
+
+    // 样本按HISTORY帧返回，缓冲区只能放下5个样本，前20个属于测点1，之后属于测点2
+    dbsample hist[40];
+    int num = 40;
+    for (int idx = 0; idx < num; ++idx) {
+        hist[idx].ts  = 1700000000000ULL + (uint64_t)idx * 250;
+        hist[idx].u64 = 0;
+        if (idx < 20) {
+            hist[idx].type = DB_DOUBLE;
+            hist[idx].d    = idx * 0.25 - 3;
+        } else {
+            hist[idx].type = DB_INT32;
+            hist[idx].i32  = idx * idx - 100;
+        }
+    }
+
+    size_t cap = CODEC_HEAD_SIZE + 5 * (4 + CODEC_HIST_SAMPLE);
+    int got = 0;
+    for (int idx = 0; idx < num;) {
+        CHECK(codec_begin(&wr, m_buf, cap, CODEC_CMD_HISTORY, DB_BLOB, 7) == CODEC_OK);
+        int start = idx;
+        while (idx < num && CODEC_OK == codec_put_sample(&wr, idx < 20 ? 1 : 2, hist[idx].ts, hist[idx].type, hist[idx].u64)) {
+            ++idx;
+        }
+        CHECK(idx - start == 5 || idx == num);
+        len = codec_end(&wr);
+        CHECK(codec_decode(m_buf, len, &head, m_item, ITEMS) == idx - start);
+        CHECK(CODEC_CMD_HISTORY == head.cmd && 7 == head.obj_id);
+        for (int k = 0; k < idx - start; ++k, ++got) {
+            CHECK(m_item[k].id == (got < 20 ? 1 : 2));
+            CHECK(codec_get_sample(&m_item[k], &ts, &type, &raw) == CODEC_OK);
+            CHECK(ts == hist[got].ts && type == hist[got].type && raw == hist[got].u64);
+            CHECK(codec_get_hist_query(&m_item[k], &f, &t, &m) == CODEC_ER_SHORT);
+        }
+    }
+    CHECK(got == num);
+}
+
+int main(void)
+{
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_ERR);
+    test_fixed();
+    test_var();
+    test_malformed();
+    test_space();
+    test_history();
+    printf("test_codec: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,294 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_dbconv.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :整块写入的向量化实现与普通循环的比较.dbconv的扩展、转换、原始值比较和
+//                 死区比较在0~100个元素、各种对齐位置上与逐个计算的结果一致；dbmem_set_block
+//                 在行存储和列存储对象上写入的测点、返回数量和变化位图与逐个判断的参考模型一致，
+//                 包括死区、NaN、类型改变和未知测点；DBMEM_BAND_ALL不比较，全部写入并标记变化
+// Interface      :test_dbconv
+// Others         :参考实现按小端平台上dbvar联合体的保存方式计算原始值
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <math.h>
+
+#include "db_in_mem.h"
+#include "dbconv.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define MAX_NUM   100
+#define MAX_ID    250
+#define ROUNDS    3000
+#define OBJ_AOS   40
+#define OBJ_SOA   41
+
+static const int m_types[] = {DB_INT8, DB_UINT8, DB_INT16, DB_UINT16, DB_INT32, DB_UINT32,
+    DB_INT64, DB_UINT64, DB_FLOAT, DB_DOUBLE, DB_BOOL};
+static const int m_width[] = {0, 1, 1, 2, 2, 4, 4, 8, 8, 4, 8, 0, 0, 4};
+
+static uint32_t m_rand = 2463534242U;
+static uint32_t test_rand(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+// 生成一个数值，整数在-8~8之间，浮点数偶尔为NaN，便于产生死区内外的差值
+static void make_value(int type, void *dst)
+{
+    int v = (int)(test_rand() % 17) - 8;
+
+    switch (type) {
+    case DB_INT8:   *(int8_t *)dst   = (int8_t)v; break;
+    case DB_UINT8:  *(uint8_t *)dst  = (uint8_t)(v + 8); break;
+    case DB_INT16:  *(int16_t *)dst  = (int16_t)(v * 1000); break;
+    case DB_UINT16: *(uint16_t *)dst = (uint16_t)(v + 60000); break;
+    case DB_INT32:
+    case DB_BOOL:   *(int32_t *)dst  = v; break;
+    case DB_UINT32: *(uint32_t *)dst = (uint32_t)(v + 8) << 28; break;
+    case DB_INT64:  *(int64_t *)dst  = (int64_t)v << 40; break;
+    case DB_UINT64: *(uint64_t *)dst = (uint64_t)(v + 8); break;
+    case DB_FLOAT:  *(float *)dst    = (0 == test_rand() % 23) ? NAN : v * 0.75f; break;
+    case DB_DOUBLE: *(double *)dst   = (0 == test_rand() % 23) ? NAN : v * 0.75; break;
+    }
+}
+
+// 参考实现:原始值为清零后的64位内容写入数值
+static uint64_t ref_raw(int type, const void *src)
+{
+    uint64_t raw = 0;
+
+    memcpy(&raw, src, m_width[type]);
+    return raw;
+}
+
+static double ref_double(int type, uint64_t raw)
+{
+    float  f;
+    double d;
+
+    switch (type) {
+    case DB_INT8:   return (int8_t)raw;
+    case DB_UINT8:  return (uint8_t)raw;
+    case DB_INT16:  return (int16_t)raw;
+    case DB_UINT16: return (uint16_t)raw;
+    case DB_INT32:
+    case DB_BOOL:   return (int32_t)raw;
+    case DB_UINT32: return (uint32_t)raw;
+    case DB_INT64:  return (int64_t)raw;
+    case DB_UINT64: return raw;
+    case DB_FLOAT:  memcpy(&f, &raw, sizeof(f)); return f;
+    case DB_DOUBLE: memcpy(&d, &raw, sizeof(d)); return d;
+    }
+    return 0;
+}
+
+static int ref_outside(double a, double b, double band)
+{
+    return !(fabs(a - b) <= band);
+}
+
+static int get_bit(const uint32_t *bitmap, int k)
+{
+    return (bitmap[k / 32] >> (k % 32)) & 1;
+}
+
+// dbconv各函数在不同长度和起始位置上与逐个计算一致
+static void test_kernels(void)
+{
+    uint8_t  src[(MAX_NUM + 8) * 8];
+    uint64_t raw[MAX_NUM + 8], other[MAX_NUM + 8];
+    double   da[MAX_NUM + 8], db[MAX_NUM + 8];
+    uint32_t bitmap[(MAX_NUM + 31) / 32 + 1];
+
+    for (size_t t = 0; t < sizeof(m_types) / sizeof(m_types[0]); ++t) {
+        int type = m_types[t];
+        int width = m_width[type];
+        for (int num = 0; num <= MAX_NUM; ++num) {
+            int off = (int)(test_rand() % 4); // 源数组和结果数组的起始位置不对齐
+            for (int k = 0; k < num; ++k) {
+                make_value(type, src + (off + k) * width);
+            }
+            CHECK(dbconv_widen(type, src + off * width, num, raw + off) == 0);
+            for (int k = 0; k < num; ++k) {
+                CHECK(raw[off + k] == ref_raw(type, src + (off + k) * width));
+            }
+
+            dbconv_to_double(type, raw + off, num, da);
+            for (int k = 0; k < num; ++k) {
+                double ref = ref_double(type, raw[off + k]);
+                CHECK(memcmp(&da[k], &ref, sizeof(double)) == 0 || (isnan(da[k]) && isnan(ref)));
+            }
+
+            // 一半元素相同，另一半重新生成
+            for (int k = 0; k < num; ++k) {
+                uint8_t tmp[8];
+                other[k] = raw[off + k];
+                if (test_rand() & 1) {
+                    make_value(type, tmp);
+                    other[k] = ref_raw(type, tmp);
+                }
+            }
+            int count = dbconv_diff(raw + off, other, num, bitmap);
+            int expect = 0;
+            for (int k = 0; k < num; ++k) {
+                int bit = raw[off + k] != other[k];
+                CHECK(get_bit(bitmap, k) == bit);
+                expect += bit;
+            }
+            CHECK(count == expect);
+
+            static const double bands[] = {0.0, 0.5, 1.0, 1000.0};
+            double band = bands[test_rand() % 4];
+            dbconv_to_double(type, other, num, db);
+            count  = dbconv_band(da, db, num, band, bitmap);
+            expect = 0;
+            for (int k = 0; k < num; ++k) {
+                int bit = ref_outside(da[k], db[k], band);
+                CHECK(get_bit(bitmap, k) == bit);
+                expect += bit;
+            }
+            CHECK(count == expect);
+        }
+    }
+}
+
+// 参考模型，下标为测点编号
+static uint8_t  m_exist[MAX_ID + 1];
+static uint8_t  m_mtype[MAX_ID + 1];
+static uint64_t m_mraw[MAX_ID + 1];
+
+static void check_object(uint16_t obj_id)
+{
+    dbvar var;
+
+    for (int id = 0; id <= MAX_ID; ++id) {
+        int ret = dbmem_read_value(obj_id, (uint16_t)id, &var);
+        if (!m_exist[id]) {
+            CHECK(OBJSYS_RET_UNKNOWID == ret);
+            continue;
+        }
+        CHECK(OBJSYS_RET_OK == ret);
+        CHECK(var.type == m_mtype[id]);
+        if (DB_NULL != var.type) {
+            CHECK(var.u64 == m_mraw[id]);
+            CHECK(var.len == (uint32_t)m_width[var.type]);
+        }
+    }
+}
+
+// dbmem_set_block与逐个判断的结果一致
+static void test_block(uint16_t obj_id, int soa)
+{
+    uint16_t ids[MAX_ID + 1];
+    uint8_t  src[MAX_NUM * 8];
+    uint32_t changed[(MAX_NUM + 31) / 32];
+    int num_ids = 0;
+
+    // 每7个编号缺一个，整块中包含未知测点
+    memset(m_exist, 0, sizeof(m_exist));
+    for (int id = 1; id <= MAX_ID; ++id) {
+        if (0 != id % 7) {
+            ids[num_ids++] = (uint16_t)id;
+            m_exist[id] = 1;
+        }
+    }
+    if (soa) {
+        CHECK(dbmem_create_soa(obj_id, "soa", num_ids) == OBJSYS_RET_OK);
+    } else {
+        CHECK(dbmem_create_obj(obj_id, "aos", num_ids) == OBJSYS_RET_OK);
+    }
+    CHECK(dbmem_init_values(obj_id, ids, (uint16_t)num_ids) == OBJSYS_RET_OK);
+    memset(m_mtype, DB_NULL, sizeof(m_mtype));
+    memset(m_mraw, 0, sizeof(m_mraw));
+    check_object(obj_id);
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        // 大部分写入保持同一类型，偶尔换类型
+        int type = (0 == test_rand() % 8) ? m_types[test_rand() % (sizeof(m_types) / sizeof(m_types[0]))]
+            : m_types[(round / 300) % (sizeof(m_types) / sizeof(m_types[0]))];
+        int width = m_width[type];
+        int num = 1 + (int)(test_rand() % MAX_NUM);
+        int start = (int)(test_rand() % (MAX_ID - num + 2));
+        static const double bands[] = {0.0, 0.0, 0.5, 2.0, DBMEM_BAND_ALL};
+        double band = bands[test_rand() % 5];
+
+        for (int k = 0; k < num; ++k) {
+            make_value(type, src + k * width);
+        }
+        memset(changed, 0xA5, sizeof(changed));
+        int ret = dbmem_set_block(obj_id, (uint16_t)start, type, src, num, band, changed);
+
+        int expect = 0;
+        for (int k = 0; k < num; ++k) {
+            int id = start + k;
+            uint64_t raw = ref_raw(type, src + k * width);
+            int bit = 0;
+            if (m_exist[id]) {
+                if (m_mtype[id] != type || band < 0) {
+                    bit = 1;
+                } else if (raw != m_mraw[id]) {
+                    bit = band <= 0 || ref_outside(ref_double(type, raw), ref_double(type, m_mraw[id]), band);
+                }
+            }
+            CHECK(get_bit(changed, k) == bit);
+            if (bit) {
+                m_mtype[id] = (uint8_t)type;
+                m_mraw[id]  = raw;
+                ++expect;
+            }
+        }
+        CHECK(ret == expect);
+        if (0 == round % 100) {
+            check_object(obj_id);
+        }
+    }
+    check_object(obj_id);
+
+    // 同样的数值再写一次:比较时不标记变化，DBMEM_BAND_ALL与dbmem_set_values一样全部标记
+    uint16_t dirty[MAX_ID + 1];
+    int known = 0;
+    for (int k = 0; k < 32; ++k) {
+        ((uint32_t *)src)[k] = (uint32_t)k;
+        known += m_exist[1 + k];
+    }
+    CHECK(dbmem_set_block(obj_id, 1, DB_UINT32, src, 32, 0, NULL) >= 0);
+    CHECK(dbmem_watch(obj_id, DBMEM_WATCH_SUB, 1) == OBJSYS_RET_OK);
+    CHECK(dbmem_set_block(obj_id, 1, DB_UINT32, src, 32, 0, NULL) == 0);
+    CHECK(dbmem_take_dirty(obj_id, DBMEM_WATCH_SUB, dirty, MAX_ID + 1) == 0);
+    CHECK(dbmem_set_block(obj_id, 1, DB_UINT32, src, 32, DBMEM_BAND_ALL, NULL) == known);
+    CHECK(dbmem_take_dirty(obj_id, DBMEM_WATCH_SUB, dirty, MAX_ID + 1) == known);
+    CHECK(dbmem_watch(obj_id, DBMEM_WATCH_SUB, 0) == OBJSYS_RET_OK);
+    for (int k = 0; k < 32; ++k) {
+        if (m_exist[1 + k]) {
+            m_mtype[1 + k] = DB_UINT32;
+            m_mraw[1 + k]  = (uint32_t)k;
+        }
+    }
+    check_object(obj_id);
+
+    // 参数错误
+    CHECK(dbmem_set_block(obj_id, 1, DB_STRING, src, 4, 0, NULL) == OBJSYS_RET_PARAM);
+    CHECK(dbmem_set_block(obj_id, 1, DB_UINT16, src, 0, 0, NULL) == OBJSYS_RET_PARAM);
+    CHECK(dbmem_set_block(obj_id, 0x0FFE, DB_UINT16, src, 4, 0, NULL) == OBJSYS_RET_PARAM);
+    CHECK(dbmem_set_block(obj_id + 100, 1, DB_UINT16, src, 4, 0, NULL) == OBJSYS_RET_UNKNOWOBJ);
+}
+
+int main(void)
+{
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_ERR);
+    test_kernels();
+    test_block(OBJ_AOS, 0);
+    test_block(OBJ_SOA, 1);
+    dbmem_close();
+    printf("test_dbconv: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,375 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_dbhist.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :测点历史记录的压缩编码测试.每种定长类型的随机序列(时间差包含抖动、大跳变
+//                 和倒退，数值包含重复、小变化和任意值)与参考数组比较，查询结果必需是参考序列
+//                 的后缀，环写满覆盖最早的块后仍然如此；按块容量检查异或窗口重用(10)和整数
+//                 差值的编码长度；64位转义、类型改变开始新块；from/to/max过滤与参考数组一致，
+//                 经过dbmem_get_history的查询和错误返回
+// Interface      :test_dbhist
+// Others         :块内可用位数按dbhist.h中的块尺寸减去32字节块头计算
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stdint.h>
+
+#include "db_in_mem.h"
+#include "dbhist.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define HIST_BITS  ((DBHIST_BLOCK - 32) * 8) // 块内可用的位数
+#define SERIES     6000                      // 随机序列的长度
+#define OUT_MAX    2048                      // 查询输出的容量，大于一个测点能保存的样本数量
+#define T0         1700000000000ULL
+
+// 一个测点的参考序列
+typedef struct {
+    int      type;
+    int      num;
+    int      first; // 上一次查询时保留的最早样本，覆盖只能丢弃更早的样本
+    uint64_t ts[SERIES];
+    uint64_t raw[SERIES];
+    int64_t  delta;
+}hist_ref;
+
+static const int m_types[] = {DB_INT8, DB_UINT8, DB_INT16, DB_UINT16, DB_INT32, DB_UINT32,
+    DB_INT64, DB_UINT64, DB_FLOAT, DB_DOUBLE, DB_BOOL};
+#define NTYPE ((int)(sizeof(m_types) / sizeof(m_types[0])))
+
+static hist_ref m_ref[NTYPE];
+static dbsample m_out[OUT_MAX];
+
+static uint32_t m_rand = 2463534242U;
+static uint32_t test_rand(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+static uint64_t test_rand64(void)
+{
+    return ((uint64_t)test_rand() << 32) | test_rand();
+}
+
+// 原始值只保留类型的宽度
+static uint64_t type_mask(int type, uint64_t raw)
+{
+    switch (type) {
+    case DB_INT8:
+    case DB_UINT8:  return raw & 0xFF;
+    case DB_INT16:
+    case DB_UINT16: return raw & 0xFFFF;
+    case DB_INT32:
+    case DB_UINT32:
+    case DB_FLOAT:
+    case DB_BOOL:   return raw & 0xFFFFFFFF;
+    default:        return raw;
+    }
+}
+
+// 下一个时间:大部分等间隔，其余为抖动、间隔改变、大跳变、倒退和相同时间
+static uint64_t next_ts(hist_ref *ref)
+{
+    uint64_t last = ref->num > 0 ? ref->ts[ref->num - 1] : T0;
+    uint32_t sel = test_rand() % 16;
+
+    if (sel >= 8 && sel <= 10) {
+        ref->delta += (int64_t)(test_rand() % 127) - 63;
+    } else if (11 == sel) {
+        ref->delta += (int64_t)(test_rand() % 4095) - 2047;
+    } else if (12 == sel) {
+        ref->delta = (int64_t)(test_rand64() >> 24); // 最多约10^12毫秒
+    } else if (13 == sel) {
+        ref->delta = -(int64_t)(1 + test_rand() % 100000);
+    } else if (14 == sel) {
+        ref->delta = 0;
+    } else if (15 == sel) {
+        ref->delta = (int64_t)test_rand();
+    }
+    if (ref->delta < 0 && (uint64_t)-ref->delta > last - T0 / 2) { // 不倒退到0之前
+        ref->delta = -ref->delta;
+    }
+    return last + (uint64_t)ref->delta;
+}
+
+// 下一个值:重复、小变化、中等变化、低位翻转或任意值
+static uint64_t next_raw(const hist_ref *ref)
+{
+    uint64_t last = ref->num > 0 ? ref->raw[ref->num - 1] : 0;
+
+    switch (test_rand() % 8) {
+    case 0:
+    case 1:  return last;
+    case 2:
+    case 3:  return last + (uint64_t)((int64_t)(test_rand() % 127) - 63);
+    case 4:  return last + (uint64_t)((int64_t)(test_rand() % 4095) - 2047);
+    case 5:  return last ^ ((uint64_t)(test_rand() & 0xFF) << (test_rand() % 24));
+    default: return test_rand64();
+    }
+}
+
+// 查询测点的全部样本，必需是参考序列的后缀并且不少于keep个，返回后缀开始的位置
+static int check_all(const dbhist *hist, int pos, hist_ref *ref, int keep)
+{
+    int num = dbhist_query(hist, pos, 0, UINT64_MAX, m_out, OUT_MAX);
+    int start = ref->num - num;
+
+    CHECK(num < OUT_MAX);
+    CHECK(num >= (keep < ref->num ? keep : ref->num));
+    CHECK(start >= ref->first);
+    for (int idx = 0; idx < num; ++idx) {
+        const dbsample *smp = &m_out[idx];
+        if (smp->ts != ref->ts[start + idx] || smp->type != ref->type || smp->u64 != ref->raw[start + idx]) {
+            fprintf(stderr, "pos %d sample %d of %d: ts %llu/%llu raw %llx/%llx type %d/%d\n", pos,
+                start + idx, ref->num, (unsigned long long)smp->ts, (unsigned long long)ref->ts[start + idx],
+                (unsigned long long)smp->u64, (unsigned long long)ref->raw[start + idx], smp->type, ref->type);
+            exit(EXIT_FAILURE);
+        }
+    }
+    ref->first = start;
+    return start;
+}
+
+// 按from/to/max查询，结果为保留部分中时间在范围内的最新max个样本
+static void check_range(const dbhist *hist, int pos, const hist_ref *ref, int start,
+    uint64_t from, uint64_t to, int max)
+{
+    int expect[OUT_MAX];
+    int nexp = 0;
+
+    for (int idx = start; idx < ref->num; ++idx) {
+        if (ref->ts[idx] >= from && ref->ts[idx] <= to) {
+            expect[nexp++] = idx;
+        }
+    }
+    int skip = nexp > max ? nexp - max : 0;
+    int num = dbhist_query(hist, pos, from, to, m_out, max);
+    CHECK(num == nexp - skip);
+    for (int idx = 0; idx < num; ++idx) {
+        CHECK(m_out[idx].ts == ref->ts[expect[skip + idx]]);
+        CHECK(m_out[idx].u64 == ref->raw[expect[skip + idx]]);
+    }
+}
+
+// 每种类型一个测点，随机序列交替写入，定期与参考数组比较
+static void test_random(void)
+{
+    // 一个样本最多68位时间和78位数值，每块至少保存1+HIST_BITS/146个样本
+    const int per_blk = 1 + HIST_BITS / 146;
+    const int nblk = 4;
+    dbhist *hist = dbhist_create(NTYPE, nblk * DBHIST_BLOCK);
+
+    CHECK(NULL != hist);
+    for (int pos = 0; pos < NTYPE; ++pos) {
+        m_ref[pos].type = m_types[pos];
+    }
+    for (int step = 0; step < SERIES; ++step) {
+        for (int pos = 0; pos < NTYPE; ++pos) {
+            hist_ref *ref = &m_ref[pos];
+            uint64_t ts  = next_ts(ref);
+            uint64_t raw = type_mask(ref->type, next_raw(ref));
+            dbhist_append(hist, pos, ts, ref->type, raw);
+            ref->ts[ref->num]  = ts;
+            ref->raw[ref->num] = raw;
+            ++ref->num;
+            if (0 != step % 37 && step != SERIES - 1) {
+                continue;
+            }
+            int start = check_all(hist, pos, ref, (nblk - 1) * per_blk + 1);
+            int lo = start + (int)(test_rand() % (uint32_t)(ref->num - start));
+            int hi = start + (int)(test_rand() % (uint32_t)(ref->num - start));
+            uint64_t from = ref->ts[lo] < ref->ts[hi] ? ref->ts[lo] : ref->ts[hi];
+            uint64_t to   = ref->ts[lo] < ref->ts[hi] ? ref->ts[hi] : ref->ts[lo];
+            check_range(hist, pos, ref, start, from, to, 1 + (int)(test_rand() % 64));
+            check_range(hist, pos, ref, start, from, from, OUT_MAX);
+            check_range(hist, pos, ref, start, 0, to, 1);
+            check_range(hist, pos, ref, start, to + 1, UINT64_MAX, OUT_MAX);
+        }
+    }
+    for (int pos = 0; pos < NTYPE; ++pos) {
+        CHECK(m_ref[pos].first > 0); // 所有测点都经过了覆盖
+    }
+    dbhist_free(hist);
+}
+
+// 两个块的测点按固定模式写入，第2C+1个样本开始第三个块并覆盖第一个块，只保留C+1个.
+// first为第一个差异样本的位数，rest为之后每个样本的位数
+static void check_capacity(int type, uint64_t (*gen)(int), int first, int rest)
+{
+    const int cap = 2 + (HIST_BITS - first) / rest;
+    dbhist *hist = dbhist_create(1, 2 * DBHIST_BLOCK);
+    hist_ref *ref = &m_ref[0];
+
+    CHECK(NULL != hist);
+    memset(ref, 0, sizeof(*ref));
+    ref->type = type;
+    for (int idx = 0; idx <= 2 * cap; ++idx) {
+        ref->ts[idx]  = T0 + 10 * (uint64_t)idx;
+        ref->raw[idx] = gen(idx);
+        ref->num = idx + 1;
+        dbhist_append(hist, 0, ref->ts[idx], type, ref->raw[idx]);
+        check_all(hist, 0, ref, 0);
+        CHECK(ref->first == (idx < 2 * cap ? 0 : cap));
+    }
+    dbhist_free(hist);
+    memset(ref, 0, sizeof(*ref));
+}
+
+// 每次异或结果都是第20~27位，与第一个样本建立的窗口相同
+static uint64_t gen_window(int idx)
+{
+    uint64_t val = 0x3FF0000000000000ULL; // 1.0
+
+    for (int k = 1; k <= idx; ++k) {
+        val ^= (uint64_t)(0x81 | ((k * 37) & 0x7E)) << 20;
+    }
+    return val;
+}
+
+static uint64_t gen_const(int idx)
+{
+    (void)idx;
+    return 5;
+}
+
+static void test_capacity(void)
+{
+    // 时间间隔10:第一个差异样本的二阶差分为10，2+7位，之后为0，1位.
+    // 浮点第一个差异样本建立窗口11+6+6+8位，之后重用窗口10+8位
+    check_capacity(DB_DOUBLE, gen_window, 9 + 2 + 6 + 6 + 8, 1 + 2 + 8);
+    // 整数值不变，差值为0，1位
+    check_capacity(DB_UINT32, gen_const, 9 + 1, 1 + 1);
+}
+
+// 64位转义:时间和数值的差超出12位时使用1111+64位，包括负数
+static void test_escape(void)
+{
+    static const uint64_t ts[] = {T0, T0 + (1ULL << 50), T0 + 1, T0 + (1ULL << 50) + 7, T0 - 86400000,
+        T0 - 86400000 + 2048, T0 - 86400000 + 4096 + 2049, T0};
+    static const uint64_t raw[] = {0, 0x7FFFFFFFFFFFFFFFULL, 0x8000000000000000ULL, 1, UINT64_MAX,
+        2048, 0xFFFFFFFFFFFFF7FFULL, 0x123456789ABCDEF0ULL};
+    const int num = (int)(sizeof(ts) / sizeof(ts[0]));
+    const int types[] = {DB_INT64, DB_UINT64, DB_DOUBLE};
+    dbhist *hist = dbhist_create(3, 8 * DBHIST_BLOCK);
+
+    CHECK(NULL != hist);
+    for (int pos = 0; pos < 3; ++pos) {
+        for (int idx = 0; idx < num; ++idx) {
+            dbhist_append(hist, pos, ts[idx], types[pos], raw[idx]);
+        }
+        CHECK(dbhist_query(hist, pos, 0, UINT64_MAX, m_out, OUT_MAX) == num);
+        for (int idx = 0; idx < num; ++idx) {
+            CHECK(m_out[idx].ts == ts[idx] && m_out[idx].u64 == raw[idx] && m_out[idx].type == types[pos]);
+        }
+    }
+    // 时间倒退后按范围过滤，不要求时间有序
+    CHECK(dbhist_query(hist, 0, T0 - 86400000, T0 - 1, m_out, OUT_MAX) == 3);
+    CHECK(m_out[0].u64 == UINT64_MAX && m_out[2].u64 == 0xFFFFFFFFFFFFF7FFULL);
+    dbhist_free(hist);
+}
+
+// 类型改变时开始新块，两个块的测点只保留最近两次类型改变之后的样本
+static void test_type_change(void)
+{
+    double d = 2.5;
+    uint64_t draw;
+    dbhist *hist = dbhist_create(1, 0);
+
+    CHECK(NULL != hist);
+    memcpy(&draw, &d, sizeof(draw));
+    CHECK(dbhist_query(hist, 0, 0, UINT64_MAX, m_out, OUT_MAX) == 0);
+    dbhist_append(hist, 0, T0, DB_INT32, 0xFFFFFFFF);
+    dbhist_append(hist, 0, T0 + 1, DB_INT32, 1);
+    dbhist_append(hist, 0, T0 + 2, DB_DOUBLE, draw);
+    CHECK(dbhist_query(hist, 0, 0, UINT64_MAX, m_out, OUT_MAX) == 3);
+    CHECK(DB_INT32 == m_out[0].type && 0xFFFFFFFF == m_out[0].u64);
+    CHECK(DB_DOUBLE == m_out[2].type && 2.5 == m_out[2].d);
+    dbhist_append(hist, 0, T0 + 3, DB_UINT8, 0x80);
+    CHECK(dbhist_query(hist, 0, 0, UINT64_MAX, m_out, OUT_MAX) == 2);
+    CHECK(DB_DOUBLE == m_out[0].type && T0 + 2 == m_out[0].ts);
+    CHECK(DB_UINT8 == m_out[1].type && 0x80 == m_out[1].u64);
+    // 越界的测点和参数
+    CHECK(dbhist_query(hist, 1, 0, UINT64_MAX, m_out, OUT_MAX) == 0);
+    CHECK(dbhist_query(hist, -1, 0, UINT64_MAX, m_out, OUT_MAX) == 0);
+    CHECK(dbhist_query(hist, 0, 0, UINT64_MAX, m_out, 0) == 0);
+    CHECK(dbhist_query(hist, 0, T0 + 3, T0 + 2, m_out, OUT_MAX) == 0);
+    dbhist_free(hist);
+}
+
+// 经过数据库写入的样本按时间范围和数量查询，两个测点互不影响
+static void test_dbmem(void)
+{
+    uint16_t ids[] = {1, 2};
+    static dbsample all[300];
+    int expect[300];
+
+    CHECK(dbmem_create_obj(7, "hist", 2) == OBJSYS_RET_OK);
+    CHECK(dbmem_init_values(7, ids, 2) == OBJSYS_RET_OK);
+    CHECK(dbmem_get_history(7, 1, 0, UINT64_MAX, all, 10) == OBJSYS_RET_PARAM);
+    CHECK(dbmem_history(7, 4096) == OBJSYS_RET_OK);
+    CHECK(dbmem_history(7, 4096) == OBJSYS_RET_PARAM);
+    for (int idx = 0; idx < 200; ++idx) {
+        double d = idx * 0.25 - 3;
+        int32_t i = idx * idx - 100;
+        CHECK(dbmem_set_value(7, 1, DB_DOUBLE, &d, 0) == OBJSYS_RET_OK);
+        if (idx < 30) {
+            CHECK(dbmem_set_value(7, 2, DB_INT32, &i, 0) == OBJSYS_RET_OK);
+        }
+        if (0 == idx % 10) {
+            usleep(1500); // 样本分布在不同的毫秒
+        }
+    }
+    int num = dbmem_get_history(7, 1, 0, UINT64_MAX, all, 300);
+    CHECK(200 == num);
+    for (int idx = 0; idx < num; ++idx) {
+        CHECK(DB_DOUBLE == all[idx].type && all[idx].d == idx * 0.25 - 3);
+    }
+    CHECK(dbmem_get_history(7, 2, 0, UINT64_MAX, m_out, 20) == 20);
+    CHECK(DB_INT32 == m_out[19].type && m_out[19].i32 == 29 * 29 - 100);
+    CHECK(m_out[0].i32 == 10 * 10 - 100);
+
+    uint64_t from = all[50].ts, to = all[120].ts;
+    int nexp = 0;
+    for (int idx = 0; idx < num; ++idx) {
+        if (all[idx].ts >= from && all[idx].ts <= to) {
+            expect[nexp++] = idx;
+        }
+    }
+    CHECK(nexp >= 71);
+    CHECK(dbmem_get_history(7, 1, from, to, m_out, OUT_MAX) == nexp);
+    for (int idx = 0; idx < nexp; ++idx) {
+        CHECK(m_out[idx].ts == all[expect[idx]].ts && m_out[idx].u64 == all[expect[idx]].u64);
+    }
+    CHECK(dbmem_get_history(7, 1, from, to, m_out, 7) == 7);
+    for (int idx = 0; idx < 7; ++idx) {
+        CHECK(m_out[idx].u64 == all[expect[nexp - 7 + idx]].u64);
+    }
+    CHECK(dbmem_get_history(7, 1, to + 1, from, m_out, OUT_MAX) == 0);
+    CHECK(dbmem_get_history(7, 1, all[num - 1].ts + 1, UINT64_MAX, m_out, OUT_MAX) == 0);
+
+    CHECK(dbmem_get_history(7, 1, 0, UINT64_MAX, m_out, 0) == OBJSYS_RET_PARAM);
+    CHECK(dbmem_get_history(7, 1, 0, UINT64_MAX, NULL, 10) == OBJSYS_RET_PARAM);
+    CHECK(dbmem_get_history(8, 1, 0, UINT64_MAX, m_out, 10) == OBJSYS_RET_UNKNOWOBJ);
+    CHECK(dbmem_get_history(7, 3, 0, UINT64_MAX, m_out, 10) == OBJSYS_RET_UNKNOWID);
+    dbmem_close();
+}
+
+int main(void)
+{
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_ERR);
+    test_random();
+    test_capacity();
+    test_escape();
+    test_type_change();
+    test_dbmem();
+    printf("test_dbhist: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_dbmem_mt.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :内存数据库并发读写测试.一个写线程不断改变数值测点的类型和值，以及字符串
+//                 测点的长度和内容(跨越短字符串的界限)，读线程在读临界区内读取副本并检查
+//                 类型、长度和值一致，退出临界区前再次检查字符串内容没有被回收重用.
+//                 分别用1/2/4个读线程测量读取速度，最后让超过读者槽位数量的线程同时停在
+//                 读临界区内，检查不会活锁，退回读锁的读者读到的数据同样不会被回收
+// Interface      :test_dbmem_mt
+// Others         :30秒内没有完成时按失败退出
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <pthread.h>
+#include <signal.h>
+
+#include "db_in_mem.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define OBJ_ID      10
+#define NUM_POINTS  32          // 数值测点1~32，字符串测点33~64
+#define STR_BASE    33
+#define PHASE_MS    300         // 每组读线程的测量时间
+#define OVF_THREADS 72          // 超过读者槽位数量(64)的线程数量
+#define BATCH       64          // 读者每次临界区内读取的测点数量
+
+static volatile int m_stop;
+static uint64_t m_writes;
+static uint64_t m_reads;
+static pthread_barrier_t m_barrier;
+
+// 字符串的长度和内容由同一个计数决定，长度1~26，内容全部为'a'+长度-1
+static void make_str(uint64_t k, char *buf, uint32_t *len)
+{
+    *len = 1 + (uint32_t)(k % 26);
+    memset(buf, 'a' + (int)*len - 1, *len);
+}
+
+static void check_str(const dbvar *var)
+{
+    const char *str = dbvar_str(var);
+
+    CHECK(DB_STRING == var->type);
+    CHECK(var->len >= 1 && var->len <= 26);
+    CHECK(strlen(str) == var->len);
+    for (uint32_t idx = 0; idx < var->len; ++idx) {
+        CHECK(str[idx] == 'a' + (int)var->len - 1);
+    }
+}
+
+// 偶数次写入64位值，高低32位相同；奇数次写入16位值
+static void check_num(const dbvar *var)
+{
+    if (DB_UINT64 == var->type) {
+        CHECK(var->len == 8);
+        CHECK((var->u64 >> 32) == (var->u64 & 0xFFFFFFFFULL));
+    } else {
+        CHECK(DB_UINT16 == var->type || DB_NULL == var->type);
+        CHECK(DB_NULL == var->type || var->len == 2);
+        CHECK((var->u64 >> 16) == 0);
+    }
+}
+
+static void *writer(void *arg)
+{
+    char buf[32];
+    uint32_t len;
+
+    (void)arg;
+    for (uint64_t k = 0; !m_stop; ++k) {
+        uint16_t id = (uint16_t)(1 + k % NUM_POINTS);
+        if (k & 1) {
+            uint16_t v16 = (uint16_t)k;
+            CHECK(dbmem_set_value(OBJ_ID, id, DB_UINT16, &v16, 0) == OBJSYS_RET_OK);
+        } else {
+            uint64_t v64 = ((k & 0xFFFFFFFFULL) << 32) | (k & 0xFFFFFFFFULL);
+            CHECK(dbmem_set_value(OBJ_ID, id, DB_UINT64, &v64, 0) == OBJSYS_RET_OK);
+        }
+        make_str(k, buf, &len);
+        CHECK(dbmem_set_value(OBJ_ID, (uint16_t)(STR_BASE + k % NUM_POINTS), DB_STRING, buf, len) == OBJSYS_RET_OK);
+        __atomic_add_fetch(&m_writes, 2, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    dbvar var, str[BATCH / 2];
+    uint64_t count = 0;
+
+    (void)arg;
+    while (!m_stop) {
+        dbmem_read_lock();
+        for (int idx = 0; idx < BATCH / 2; ++idx) {
+            CHECK(dbmem_read_value(OBJ_ID, (uint16_t)(1 + idx), &var) == OBJSYS_RET_OK);
+            check_num(&var);
+            CHECK(dbmem_read_value(OBJ_ID, (uint16_t)(STR_BASE + idx), &str[idx]) == OBJSYS_RET_OK);
+            if (DB_STRING == str[idx].type) {
+                check_str(&str[idx]);
+            }
+        }
+        // 临界区结束前，本次读到的字符串不能被回收重用
+        for (int idx = 0; idx < BATCH / 2; ++idx) {
+            if (DB_STRING == str[idx].type) {
+                check_str(&str[idx]);
+            }
+        }
+        dbmem_read_unlock();
+        count += BATCH;
+    }
+    __atomic_add_fetch(&m_reads, count, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// 所有线程同时停在读临界区内，写线程继续替换字符串
+static void *holder(void *arg)
+{
+    dbvar str;
+
+    (void)arg;
+    dbmem_read_lock();
+    CHECK(dbmem_read_value(OBJ_ID, STR_BASE, &str) == OBJSYS_RET_OK);
+    pthread_barrier_wait(&m_barrier);
+    usleep(50000);
+    if (DB_STRING == str.type) {
+        check_str(&str);
+    }
+    dbmem_read_unlock();
+    return NULL;
+}
+
+static void run_readers(int nreader)
+{
+    pthread_t wr, rd[4];
+
+    m_stop   = 0;
+    m_writes = 0;
+    m_reads  = 0;
+    CHECK(pthread_create(&wr, NULL, writer, NULL) == 0);
+    for (int idx = 0; idx < nreader; ++idx) {
+        CHECK(pthread_create(&rd[idx], NULL, reader, NULL) == 0);
+    }
+    uint64_t start = test_now();
+    usleep(PHASE_MS * 1000);
+    m_stop = 1;
+    for (int idx = 0; idx < nreader; ++idx) {
+        pthread_join(rd[idx], NULL);
+    }
+    pthread_join(wr, NULL);
+    double secs = (test_now() - start) / 1e9;
+    printf("dbmem: %d reader(s) %.2f M reads/s, writer %.2f M writes/s\n",
+        nreader, m_reads / secs / 1e6, m_writes / secs / 1e6);
+}
+
+static void run_overflow(void)
+{
+    pthread_t wr, th[OVF_THREADS];
+
+    m_stop = 0;
+    CHECK(pthread_barrier_init(&m_barrier, NULL, OVF_THREADS) == 0);
+    CHECK(pthread_create(&wr, NULL, writer, NULL) == 0);
+    for (int idx = 0; idx < OVF_THREADS; ++idx) {
+        CHECK(pthread_create(&th[idx], NULL, holder, NULL) == 0);
+    }
+    for (int idx = 0; idx < OVF_THREADS; ++idx) {
+        pthread_join(th[idx], NULL);
+    }
+    m_stop = 1;
+    pthread_join(wr, NULL);
+    pthread_barrier_destroy(&m_barrier);
+    printf("dbmem: %d readers inside the read section at once\n", OVF_THREADS);
+}
+
+int main(void)
+{
+    uint16_t ids[NUM_POINTS * 2];
+
+    alarm(30);
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_ERR);
+    for (int idx = 0; idx < NUM_POINTS * 2; ++idx) {
+        ids[idx] = (uint16_t)(1 + idx);
+    }
+    CHECK(dbmem_create_obj(OBJ_ID, "mt", NUM_POINTS * 2) == OBJSYS_RET_OK);
+    CHECK(dbmem_init_values(OBJ_ID, ids, NUM_POINTS * 2) == OBJSYS_RET_OK);
+
+    run_readers(1);
+    run_readers(2);
+    run_readers(4);
+    run_overflow();
+    // 退回读锁的读者退出后回收恢复正常，再跑一轮确认没有残留状态
+    run_readers(2);
+
+    dbmem_close();
+    printf("test_dbmem_mt: ok\n");
+    return EXIT_SUCCESS;
+}
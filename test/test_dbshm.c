@@ -0,0 +1,111 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_dbshm.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :共享内存镜像测试.导出后应用侧读到写入的数值和字符串；区域头或对象表中的
+//                 偏移超出区域、没有对齐、索引指向不存在的测点槽时映射失败；测点槽的顺序锁
+//                 一直为奇数时读取有限次重试后返回DBSHM_ER_BUSY
+// Interface      :test_dbshm
+// Others         :通过另外一个可写映射修改区域内容，模拟损坏的区域和停在写入中间的写入者
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stddef.h>
+
+#include "db_in_mem.h"
+#include "dbshm.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define OBJ_ID 70
+
+static char m_name[64];
+
+// 把区域中off处width字节的字段改为val后映射，返回映射结果，之后恢复原值
+static int map_with(uint8_t *rw, size_t off, uint32_t val, size_t width)
+{
+    uint8_t save[4];
+    dbshm_db db;
+
+    memcpy(save, rw + off, width);
+    memcpy(rw + off, &val, width);
+    int ret = dbshm_map(m_name, &db);
+    if (DBSHM_OK == ret) {
+        dbshm_unmap(&db);
+    }
+    memcpy(rw + off, save, width);
+    return ret;
+}
+
+int main(void)
+{
+    uint16_t ids[] = {1, 2, 9};
+    uint32_t u32 = 12345;
+    dbshm_db db;
+    dbshm_slot slot;
+
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_ERR);
+    snprintf(m_name, sizeof(m_name), "/test_dbshm_%d", (int)getpid());
+    CHECK(dbmem_create_obj(OBJ_ID, "shm", 3) == OBJSYS_RET_OK);
+    CHECK(dbmem_init_values(OBJ_ID, ids, 3) == OBJSYS_RET_OK);
+    CHECK(dbmem_export(m_name) == OBJSYS_RET_OK);
+
+    // 正常读取
+    CHECK(dbshm_map(m_name, &db) == DBSHM_OK);
+    const dbshm_obj *obj = dbshm_find(&db, OBJ_ID);
+    CHECK(NULL != obj);
+    CHECK(NULL == dbshm_find(&db, OBJ_ID + 1));
+    CHECK(dbmem_set_value(OBJ_ID, 2, DB_UINT32, &u32, 0) == OBJSYS_RET_OK);
+    CHECK(dbmem_set_value(OBJ_ID, 9, DB_STRING, "hello", 5) == OBJSYS_RET_OK);
+    CHECK(dbshm_read(&db, obj, 2, &slot) == DBSHM_OK);
+    CHECK(DB_UINT32 == slot.type && 12345 == slot.u32);
+    CHECK(dbshm_read(&db, obj, 9, &slot) == DBSHM_OK);
+    CHECK(DB_STRING == slot.type && 5 == slot.len && 0 == strcmp(slot.data, "hello"));
+    CHECK(dbshm_read(&db, obj, 3, &slot) == DBSHM_ER_ID);
+    CHECK(dbshm_read(&db, obj, 10, &slot) == DBSHM_ER_ID);
+    CHECK(dbshm_read(&db, NULL, 1, &slot) == DBSHM_ER_OBJ);
+
+    int fd = shm_open(m_name, O_RDWR, 0);
+    CHECK(fd >= 0);
+    uint8_t *rw = (uint8_t *)mmap(NULL, db.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK(MAP_FAILED != rw);
+    size_t obj_pos = (const uint8_t *)obj - db.base;
+    uint32_t size = db.head->size;
+
+    // 偏移检查
+    CHECK(map_with(rw, offsetof(dbshm_head, obj_off), size, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, offsetof(dbshm_head, obj_off), 2, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, offsetof(dbshm_head, nobj), 0xFFFF, 2) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, obj_pos + offsetof(dbshm_obj, index_off), size - 2, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, obj_pos + offsetof(dbshm_obj, index_off), 0xFFFFFFFFU, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, obj_pos + offsetof(dbshm_obj, max_id), 0xFFFF, 2) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, obj_pos + offsetof(dbshm_obj, slot_off), size - 64, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, obj_pos + offsetof(dbshm_obj, slot_off), obj->slot_off + 4, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, obj_pos + offsetof(dbshm_obj, npoint), 0xFFFF, 2) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, obj_pos + offsetof(dbshm_obj, npoint), 2, 2) == DBSHM_ER_FORMAT); // 索引中有槽序号3
+    CHECK(map_with(rw, offsetof(dbshm_head, magic), 0, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, offsetof(dbshm_head, size), size + 4096, 4) == DBSHM_ER_FORMAT);
+    CHECK(map_with(rw, offsetof(dbshm_head, size), size, 4) == DBSHM_OK);
+
+    // 写入者停在写入中间
+    uint16_t pos = ((const uint16_t *)(db.base + obj->index_off))[2];
+    uint32_t *seq = &((dbshm_slot *)(rw + obj->slot_off))[pos - 1].seq;
+    uint32_t save = *seq;
+    *seq = save | 1;
+    CHECK(dbshm_read(&db, obj, 2, &slot) == DBSHM_ER_BUSY);
+    *seq = save;
+    CHECK(dbshm_read(&db, obj, 2, &slot) == DBSHM_OK);
+    CHECK(12345 == slot.u32);
+
+    munmap(rw, db.size);
+    dbshm_unmap(&db);
+    dbmem_close();
+    shm_unlink(m_name);
+    printf("test_dbshm: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,369 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_dbsnap.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :快照和变化日志的恢复测试.子进程启动快照线程、分两个周期写入测点后不做任何
+//                 清理直接退出(模拟掉电)，父进程在新的数据库上恢复并检查:完整日志恢复第二次
+//                 写入的值；日志最后一条记录被截断或校验错误时恢复到第一次写入的值；正常退出
+//                 后只从快照恢复.日志写入失败(文件尺寸限制)时日志被截断回原来的长度，变化在
+//                 恢复写入后补写.后台线程空闲时不占用CPU.快照一直失败使日志超过恢复时处理的
+//                 上限时，恢复代数最大的日志，新日志不覆盖已有的日志，下一次快照删除所有旧日志
+// Interface      :test_dbsnap
+// Others         :数据目录建立在/tmp下，结束时删除
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <dirent.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "db_in_mem.h"
+#include "dbsnap.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define OBJ_ID  80
+#define JNL_MS  20
+#define WAIT_US 150000 // 等待日志线程写完一个周期
+#define MANY_GENS 100  // 超过恢复时处理的日志数量(64)
+
+static char m_dir[64];
+
+static void create_db(void)
+{
+    uint16_t ids[] = {1, 2, 3, 4};
+
+    CHECK(dbmem_create_obj(OBJ_ID, "snap", 4) == OBJSYS_RET_OK);
+    CHECK(dbmem_init_values(OBJ_ID, ids, 4) == OBJSYS_RET_OK);
+}
+
+static void put_u32(uint16_t id, uint32_t val)
+{
+    CHECK(dbmem_set_value(OBJ_ID, id, DB_UINT32, &val, 0) == OBJSYS_RET_OK);
+}
+
+static void put_str(uint16_t id, const char *str)
+{
+    CHECK(dbmem_set_value(OBJ_ID, id, DB_STRING, (void *)str, strlen(str)) == OBJSYS_RET_OK);
+}
+
+static void check_u32(uint16_t id, uint32_t val)
+{
+    dbvar var;
+
+    CHECK(dbmem_read_value(OBJ_ID, id, &var) == OBJSYS_RET_OK);
+    CHECK(DB_UINT32 == var.type && val == var.u32);
+}
+
+static void check_str(uint16_t id, const char *str)
+{
+    dbvar var;
+
+    CHECK(dbmem_read_value(OBJ_ID, id, &var) == OBJSYS_RET_OK);
+    CHECK(DB_STRING == var.type && strlen(str) == var.len && 0 == strcmp(dbvar_str(&var), str));
+}
+
+static void check_null(uint16_t id)
+{
+    dbvar var;
+
+    CHECK(dbmem_read_value(OBJ_ID, id, &var) == OBJSYS_RET_OK);
+    CHECK(DB_NULL == var.type);
+}
+
+// 在新的数据库上从数据目录恢复
+static int reload(void)
+{
+    dbmem_close();
+    create_db();
+    CHECK(dbsnap_init(m_dir, JNL_MS, 3600) == DBSNAP_OK);
+    return dbsnap_load();
+}
+
+// 代数最大的日志文件
+static void last_journal(char *path, size_t size)
+{
+    unsigned long best = 0;
+    struct dirent *ent;
+    DIR *dir = opendir(m_dir);
+
+    CHECK(NULL != dir);
+    path[0] = '\0';
+    while (NULL != (ent = readdir(dir))) {
+        if (0 == strncmp(ent->d_name, "db.jnl.", 7) && strtoul(ent->d_name + 7, NULL, 10) >= best) {
+            best = strtoul(ent->d_name + 7, NULL, 10);
+            snprintf(path, size, "%s/%s", m_dir, ent->d_name);
+        }
+    }
+    closedir(dir);
+    CHECK('\0' != path[0]);
+}
+
+static off_t file_size(const char *path)
+{
+    struct stat st;
+
+    CHECK(stat(path, &st) == 0);
+    return st.st_size;
+}
+
+// 一次批量写入，保证同一批测点记录在同一条日志记录中
+static void put_batch(uint32_t v1, const char *s2, const uint32_t *v3)
+{
+    uint16_t ids[] = {1, 2, 3};
+    uint8_t types[] = {DB_UINT32, DB_STRING, DB_UINT32};
+    const void *values[] = {&v1, s2, v3};
+    uint32_t sizes[] = {0, (uint32_t)strlen(s2), 0};
+
+    CHECK(dbmem_set_values(OBJ_ID, ids, types, values, sizes, NULL == v3 ? 2 : 3) == (NULL == v3 ? 2 : 3));
+}
+
+// 子进程:写入两个周期后直接退出，不写最后的快照
+static void child_crash(void)
+{
+    uint32_t v3 = 300;
+
+    create_db();
+    CHECK(dbsnap_init(m_dir, JNL_MS, 3600) == DBSNAP_OK);
+    CHECK(dbsnap_load() >= 0);
+    CHECK(dbsnap_start() == DBSNAP_OK);
+    usleep(WAIT_US);
+    put_batch(100, "first value", NULL);
+    usleep(WAIT_US);
+    put_batch(200, "second, longer than the inline storage", &v3);
+    usleep(WAIT_US);
+    _exit(EXIT_SUCCESS);
+}
+
+// 子进程:日志文件写满时写入失败，解除限制后补写
+static void child_full(void)
+{
+    struct rlimit lim;
+    char path[512];
+    char big[200];
+
+    signal(SIGXFSZ, SIG_IGN);
+    create_db();
+    CHECK(dbsnap_init(m_dir, JNL_MS, 3600) == DBSNAP_OK);
+    CHECK(dbsnap_load() >= 0);
+    CHECK(dbsnap_start() == DBSNAP_OK);
+    usleep(WAIT_US);
+    put_u32(1, 7);
+    usleep(WAIT_US);
+    last_journal(path, sizeof(path));
+    off_t size = file_size(path);
+    CHECK(size > 0);
+
+    // 只能再写10字节，下一条记录只写入一部分
+    CHECK(getrlimit(RLIMIT_FSIZE, &lim) == 0);
+    rlim_t old = lim.rlim_cur;
+    lim.rlim_cur = size + 10;
+    CHECK(setrlimit(RLIMIT_FSIZE, &lim) == 0);
+    memset(big, 'z', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    put_u32(1, 8);
+    put_str(2, big);
+    usleep(WAIT_US);
+    CHECK(file_size(path) == size);
+
+    lim.rlim_cur = old;
+    CHECK(setrlimit(RLIMIT_FSIZE, &lim) == 0);
+    usleep(WAIT_US);
+    CHECK(file_size(path) > size);
+    _exit(EXIT_SUCCESS);
+}
+
+// 子进程:快照一直失败(db.snap.tmp是目录)，每次写入后切换日志，留下MANY_GENS个日志
+static void child_many(void)
+{
+    char path[512];
+
+    snprintf(path, sizeof(path), "%s/db.snap.tmp", m_dir);
+    CHECK(mkdir(path, 0755) == 0);
+    create_db();
+    CHECK(dbsnap_init(m_dir, JNL_MS, 3600) == DBSNAP_OK);
+    CHECK(dbsnap_load() >= 0);
+    CHECK(dbsnap_start() == DBSNAP_OK);
+    for (uint32_t val = 1; val <= MANY_GENS; ++val) {
+        put_u32(1, val);
+        CHECK(dbsnap_save() != DBSNAP_OK);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+static void run_child(void (*fn)(void))
+{
+    int status;
+    pid_t pid = fork();
+
+    CHECK(pid >= 0);
+    if (0 == pid) {
+        dbmem_close(); // 子进程从空的数据库开始
+        fn();
+    }
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status));
+}
+
+static void clear_dir(void)
+{
+    struct dirent *ent;
+    char path[512];
+    DIR *dir = opendir(m_dir);
+
+    CHECK(NULL != dir);
+    while (NULL != (ent = readdir(dir))) {
+        if ('.' != ent->d_name[0]) {
+            snprintf(path, sizeof(path), "%s/%s", m_dir, ent->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dir);
+}
+
+static void test_crash(void)
+{
+    char path[512];
+
+    clear_dir();
+    run_child(child_crash);
+
+    // 完整的日志
+    CHECK(reload() > 0);
+    check_u32(1, 200);
+    check_str(2, "second, longer than the inline storage");
+    check_u32(3, 300);
+    check_null(4);
+
+    // 最后一条记录校验错误
+    last_journal(path, sizeof(path));
+    off_t size = file_size(path);
+    int fd = open(path, O_RDWR);
+    CHECK(fd >= 0);
+    char byte;
+    CHECK(pread(fd, &byte, 1, size - 1) == 1);
+    byte ^= 0x5A;
+    CHECK(pwrite(fd, &byte, 1, size - 1) == 1);
+    CHECK(reload() > 0);
+    check_u32(1, 100);
+    check_str(2, "first value");
+    check_null(3);
+
+    // 最后一条记录被截断
+    byte ^= 0x5A;
+    CHECK(pwrite(fd, &byte, 1, size - 1) == 1);
+    CHECK(ftruncate(fd, size - 3) == 0);
+    close(fd);
+    CHECK(reload() > 0);
+    check_u32(1, 100);
+    check_str(2, "first value");
+    check_null(3);
+}
+
+static void test_clean_exit(void)
+{
+    struct timespec t0, t1;
+
+    clear_dir();
+    CHECK(reload() == 0);
+    CHECK(dbsnap_start() == DBSNAP_OK);
+    put_u32(4, 44);
+    put_str(2, "saved");
+
+    // 后台线程按日志周期等待，不应该忙等
+    usleep(WAIT_US);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t0);
+    usleep(300000);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t1);
+    double cpu = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    CHECK(cpu < 0.05);
+
+    dbsnap_exit();
+    CHECK(reload() == 2);
+    check_u32(4, 44);
+    check_str(2, "saved");
+}
+
+static void test_full(void)
+{
+    clear_dir();
+    run_child(child_full);
+    CHECK(reload() > 0);
+    check_u32(1, 8);
+    dbvar var;
+    CHECK(dbmem_read_value(OBJ_ID, 2, &var) == OBJSYS_RET_OK);
+    CHECK(DB_STRING == var.type && 199 == var.len);
+}
+
+// 统计日志文件的数量和最小的代数
+static int count_journals(unsigned long *oldest)
+{
+    struct dirent *ent;
+    int num = 0;
+    DIR *dir = opendir(m_dir);
+
+    CHECK(NULL != dir);
+    *oldest = ULONG_MAX;
+    while (NULL != (ent = readdir(dir))) {
+        if (0 == strncmp(ent->d_name, "db.jnl.", 7)) {
+            unsigned long gen = strtoul(ent->d_name + 7, NULL, 10);
+            *oldest = gen < *oldest ? gen : *oldest;
+            ++num;
+        }
+    }
+    closedir(dir);
+    return num;
+}
+
+static void test_many(void)
+{
+    char path[512];
+    unsigned long oldest;
+
+    clear_dir();
+    run_child(child_many);
+    snprintf(path, sizeof(path), "%s/db.snap.tmp", m_dir);
+    CHECK(rmdir(path) == 0);
+    CHECK(count_journals(&oldest) > MANY_GENS);
+
+    // 最新的值在代数最大的日志中，与目录顺序无关
+    CHECK(reload() > 0);
+    check_u32(1, MANY_GENS);
+
+    // 新日志在最新的代数之后，快照成功后删除所有旧日志
+    last_journal(path, sizeof(path));
+    CHECK(dbsnap_start() == DBSNAP_OK);
+    usleep(WAIT_US);
+    CHECK(access(path, F_OK) != 0);
+    CHECK(1 == count_journals(&oldest));
+    put_u32(1, 1000);
+    usleep(WAIT_US);
+    dbsnap_exit();
+    CHECK(reload() > 0);
+    check_u32(1, 1000);
+}
+
+int main(void)
+{
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_CRIT);
+    snprintf(m_dir, sizeof(m_dir), "/tmp/test_dbsnap_XXXXXX");
+    CHECK(NULL != mkdtemp(m_dir));
+
+    test_crash();
+    test_clean_exit();
+    test_full();
+    test_many();
+
+    dbmem_close();
+    clear_dir();
+    rmdir(m_dir);
+    printf("test_dbsnap: ok\n");
+    return EXIT_SUCCESS;
+}
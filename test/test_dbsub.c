@@ -0,0 +1,218 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_dbsub.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :变化订阅测试.检查按订阅范围切分变化(重叠范围、边界、单个测点、超出对象
+//                 的范围)，同一周期多次写入只通知一次，没有变化的订阅不通知，多个对象互不
+//                 影响；增加和删除订阅的参数检查、按范围删除和删除回调的所有订阅，最后一条
+//                 订阅删除后不再记录变化，回调中不能修改订阅表
+// Interface      :test_dbsub
+// Others         :无
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include "db_in_mem.h"
+#include "dbsub.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define OBJ_A 60
+#define OBJ_B 61
+
+// 记录一个订阅者本周期收到的通知
+typedef struct {
+    int      calls;
+    uint16_t obj_id;
+    uint16_t ids[128];
+    int      num;
+}recorder;
+
+static recorder m_rec[6];
+
+static void on_change(void *arg, uint16_t obj_id, const uint16_t *ids, int num)
+{
+    recorder *rec = (recorder *)arg;
+
+    ++rec->calls;
+    rec->obj_id = obj_id;
+    CHECK(num > 0 && num <= 128);
+    memcpy(rec->ids, ids, sizeof(uint16_t) * num);
+    rec->num = num;
+}
+
+// 回调中修改订阅表必需失败
+static void on_change_modify(void *arg, uint16_t obj_id, const uint16_t *ids, int num)
+{
+    CHECK(dbsub_add(obj_id, 1, 2, on_change, arg) == DBSUB_ER_PARAM);
+    CHECK(dbsub_del(obj_id, 1, 0, on_change, arg) == DBSUB_ER_PARAM);
+    on_change(arg, obj_id, ids, num);
+}
+
+static void reset(void)
+{
+    memset(m_rec, 0, sizeof(m_rec));
+}
+
+static void put(uint16_t obj_id, uint16_t id, uint32_t val)
+{
+    CHECK(dbmem_set_value(obj_id, id, DB_UINT32, &val, 0) == OBJSYS_RET_OK);
+}
+
+// 检查收到的编号与期望的一致，expect以0结束，为空时检查没有通知
+static void expect(const recorder *rec, uint16_t obj_id, const uint16_t *ids)
+{
+    int num = 0;
+
+    while (0 != ids[num]) {
+        ++num;
+    }
+    if (0 == num) {
+        CHECK(0 == rec->calls);
+        return;
+    }
+    CHECK(1 == rec->calls);
+    CHECK(rec->obj_id == obj_id);
+    CHECK(rec->num == num);
+    CHECK(memcmp(rec->ids, ids, sizeof(uint16_t) * num) == 0);
+}
+
+static void test_split(void)
+{
+    reset();
+    CHECK(dbsub_add(OBJ_A, 1, 10, on_change, &m_rec[0]) == DBSUB_OK);
+    CHECK(dbsub_add(OBJ_A, 5, 20, on_change, &m_rec[1]) == DBSUB_OK);   // 与上一个重叠
+    CHECK(dbsub_add(OBJ_A, 50, 50, on_change, &m_rec[2]) == DBSUB_OK);  // 单个测点
+    CHECK(dbsub_add(OBJ_A, 90, 4000, on_change, &m_rec[3]) == DBSUB_OK); // 超出对象的范围
+    CHECK(dbsub_add(OBJ_A, 30, 40, on_change, &m_rec[4]) == DBSUB_OK);  // 本周期没有变化
+    CHECK(dbsub_add(OBJ_B, 0, 0x0FFF, on_change, &m_rec[5]) == DBSUB_OK);
+    CHECK(dbsub_count() == 6);
+
+    // 乱序写入，同一测点写入多次
+    put(OBJ_A, 100, 1);
+    put(OBJ_A, 10, 1);
+    put(OBJ_A, 5, 1);
+    put(OBJ_A, 4, 1);
+    put(OBJ_A, 10, 2);
+    put(OBJ_A, 11, 1);
+    put(OBJ_A, 20, 1);
+    put(OBJ_A, 21, 1);
+    put(OBJ_A, 50, 1);
+    put(OBJ_A, 49, 1);
+    put(OBJ_A, 90, 1);
+    put(OBJ_B, 3, 1);
+    CHECK(dbsub_flush() == 11);
+    expect(&m_rec[0], OBJ_A, (const uint16_t[]){4, 5, 10, 0});
+    expect(&m_rec[1], OBJ_A, (const uint16_t[]){5, 10, 11, 20, 0});
+    expect(&m_rec[2], OBJ_A, (const uint16_t[]){50, 0});
+    expect(&m_rec[3], OBJ_A, (const uint16_t[]){90, 100, 0});
+    expect(&m_rec[4], OBJ_A, (const uint16_t[]){0});
+    expect(&m_rec[5], OBJ_B, (const uint16_t[]){3, 0});
+
+    // 取走之后没有新的变化
+    reset();
+    CHECK(dbsub_flush() == 0);
+    for (int idx = 0; idx < 6; ++idx) {
+        CHECK(0 == m_rec[idx].calls);
+    }
+
+    // 边界上的测点
+    reset();
+    put(OBJ_A, 1, 3);
+    put(OBJ_A, 40, 3);
+    put(OBJ_A, 30, 3);
+    CHECK(dbsub_flush() == 3);
+    expect(&m_rec[0], OBJ_A, (const uint16_t[]){1, 0});
+    expect(&m_rec[1], OBJ_A, (const uint16_t[]){0});
+    expect(&m_rec[4], OBJ_A, (const uint16_t[]){30, 40, 0});
+    expect(&m_rec[5], OBJ_B, (const uint16_t[]){0});
+}
+
+static void test_add_del(void)
+{
+    recorder other;
+
+    // 参数检查
+    CHECK(dbsub_add(OBJ_A, 1, 2, NULL, NULL) == DBSUB_ER_PARAM);
+    CHECK(dbsub_add(OBJ_A, 3, 2, on_change, NULL) == DBSUB_ER_PARAM);
+    CHECK(dbsub_add(999, 1, 2, on_change, NULL) == DBSUB_ER_OBJ);
+    CHECK(dbsub_count() == 6);
+
+    // 范围或参数不同的订阅不会被删除
+    CHECK(dbsub_del(OBJ_A, 1, 11, on_change, &m_rec[0]) == DBSUB_ER_NONE);
+    CHECK(dbsub_del(OBJ_A, 1, 10, on_change, &other) == DBSUB_ER_NONE);
+    CHECK(dbsub_del(OBJ_A, 1, 10, on_change_modify, &m_rec[0]) == DBSUB_ER_NONE);
+    CHECK(dbsub_del(OBJ_B, 1, 10, on_change, &m_rec[0]) == DBSUB_ER_NONE);
+
+    // 按范围删除一条
+    CHECK(dbsub_del(OBJ_A, 5, 20, on_change, &m_rec[1]) == 1);
+    CHECK(dbsub_count() == 5);
+    reset();
+    put(OBJ_A, 6, 4);
+    CHECK(dbsub_flush() == 1);
+    expect(&m_rec[0], OBJ_A, (const uint16_t[]){6, 0});
+    expect(&m_rec[1], OBJ_A, (const uint16_t[]){0});
+
+    // 同一回调和参数的多条订阅一次删除
+    CHECK(dbsub_add(OBJ_A, 60, 70, on_change, &m_rec[0]) == DBSUB_OK);
+    CHECK(dbsub_del(OBJ_A, 1, 0, on_change, &m_rec[0]) == 2);
+    CHECK(dbsub_count() == 4);
+    reset();
+    put(OBJ_A, 6, 5);
+    put(OBJ_A, 65, 5);
+    put(OBJ_A, 50, 5);
+    CHECK(dbsub_flush() == 3);
+    expect(&m_rec[0], OBJ_A, (const uint16_t[]){0});
+    expect(&m_rec[2], OBJ_A, (const uint16_t[]){50, 0});
+
+    // 删除对象的最后一条订阅后不再记录变化，重新订阅时不通知之前的写入
+    CHECK(dbsub_del(OBJ_A, 50, 50, on_change, &m_rec[2]) == 1);
+    CHECK(dbsub_del(OBJ_A, 90, 4000, on_change, &m_rec[3]) == 1);
+    CHECK(dbsub_del(OBJ_A, 30, 40, on_change, &m_rec[4]) == 1);
+    CHECK(dbsub_count() == 1);
+    put(OBJ_A, 7, 6);
+    CHECK(dbsub_add(OBJ_A, 1, 100, on_change, &m_rec[0]) == DBSUB_OK);
+    reset();
+    CHECK(dbsub_flush() == 0);
+    expect(&m_rec[0], OBJ_A, (const uint16_t[]){0});
+    put(OBJ_A, 8, 6);
+    CHECK(dbsub_flush() == 1);
+    expect(&m_rec[0], OBJ_A, (const uint16_t[]){8, 0});
+
+    // 回调中不能增加或删除订阅
+    CHECK(dbsub_add(OBJ_B, 1, 10, on_change_modify, &m_rec[1]) == DBSUB_OK);
+    reset();
+    put(OBJ_B, 2, 7);
+    CHECK(dbsub_flush() == 1);
+    expect(&m_rec[1], OBJ_B, (const uint16_t[]){2, 0});
+    expect(&m_rec[5], OBJ_B, (const uint16_t[]){2, 0});
+
+    dbsub_close();
+    CHECK(dbsub_count() == 0);
+    put(OBJ_A, 9, 8);
+    CHECK(dbsub_flush() == 0);
+}
+
+int main(void)
+{
+    uint16_t ids[100];
+
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_ERR);
+    for (int idx = 0; idx < 100; ++idx) {
+        ids[idx] = (uint16_t)(1 + idx);
+    }
+    CHECK(dbmem_create_obj(OBJ_A, "a", 100) == OBJSYS_RET_OK);
+    CHECK(dbmem_init_values(OBJ_A, ids, 100) == OBJSYS_RET_OK);
+    CHECK(dbmem_create_obj(OBJ_B, "b", 10) == OBJSYS_RET_OK);
+    CHECK(dbmem_init_values(OBJ_B, ids, 10) == OBJSYS_RET_OK);
+
+    test_split();
+    test_add_del();
+
+    dbmem_close();
+    printf("test_dbsub: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_flow.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :应用队列拥塞时端口积压的处理测试.端口的数据来自SOCK_SEQPACKET套接字，每条
+//                 记录超过半帧，单独成为一帧.先写满应用队列，再继续写入，检查读空队列后应用
+//                 收到的记录:oldest保留积压上限内最新的记录，latest只保留最后一条，block在
+//                 积压达到高水位时停止读取套接字，剩下的记录留在套接字中，降到低水位后恢复
+//                 读取，所有记录按顺序到达，没有丢失.TCP没有成帧方式时拒绝latest
+// Interface      :test_flow
+// Others         :高水位为3条多记录，低水位略大于1条记录
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <sys/socket.h>
+
+#include "asyncomm.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define REC_SIZE  5000  // 每条记录的长度，超过默认消息尺寸(8192)的一半
+#define REC_EXTRA 12    // 写满应用队列之后再写入的记录数量
+#define FLOW_HIGH 16000 // 积压高水位，oldest最多保留3条记录，block第4条记录后停止读取
+#define FLOW_LOW  6000  // 积压低水位，block剩1条记录时恢复读取
+#define SETTLE_US 200000
+
+typedef struct {
+    int fd[2];
+    int port;
+    int reads; // 回调读到的记录数量
+    int busy;  // asyncomm_forward返回ASY_ER_BUSY的次数
+}test_src;
+
+static test_rx m_rx;
+static int     m_qmax; // 应用队列能容纳的消息数量
+static test_src m_src[3];
+
+static int src_write(void *ctx, const void *buf, size_t size)
+{
+    return (int)write(((test_src *)ctx)->fd[0], buf, size);
+}
+
+static void src_close(void *ctx)
+{
+    (void)ctx;
+}
+
+static const asyport_ops m_ops = {src_write, src_close};
+
+// 读到EAGAIN为止，端口停止读取时直接返回，与通道的读取回调相同
+static int src_read(int fd, uint32_t events, void *arg)
+{
+    test_src *src = (test_src *)arg;
+    char buf[REC_SIZE];
+
+    (void)events;
+    for (;;) {
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) {
+            return ASY_OK;
+        }
+        __atomic_add_fetch(&src->reads, 1, __ATOMIC_RELAXED);
+        if (ASY_ER_BUSY == asyncomm_forward(src->port, buf, (size_t)len)) {
+            __atomic_add_fetch(&src->busy, 1, __ATOMIC_RELAXED);
+            return ASY_OK;
+        }
+    }
+}
+
+static void src_open(test_src *src, int policy)
+{
+    memset(src, 0, sizeof(test_src));
+    CHECK(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0, src->fd) == 0);
+    src->port = asyncomm_port_add(src, &m_ops);
+    CHECK(src->port >= 0);
+    CHECK(asyncomm_port_flow(src->port, policy) == ASY_OK);
+    CHECK(asyncomm_register(src->fd[0], src_read, src) == ASY_OK);
+    CHECK(asyncomm_set_port(src->fd[0], src->port) == ASY_OK);
+}
+
+static void src_close_all(test_src *src)
+{
+    asyncomm_port_del(src->port);
+    CHECK(asyncomm_remove(src->fd[0]) == ASY_OK);
+    close(src->fd[0]);
+    close(src->fd[1]);
+}
+
+// 写入一条记录，开头4字节是序号
+static void put(test_src *src, uint32_t seq)
+{
+    char buf[REC_SIZE];
+
+    memset(buf, (int)('a' + seq % 26), sizeof(buf));
+    memcpy(buf, &seq, sizeof(seq));
+    CHECK(write(src->fd[1], buf, sizeof(buf)) == (ssize_t)sizeof(buf));
+}
+
+// 从应用队列取出下一条记录，返回序号
+static uint32_t take(const test_src *src)
+{
+    const codec_item *item = test_rx_next(&m_rx, CODEC_CMD_DATA, 1000);
+    uint32_t seq;
+
+    CHECK(NULL != item);
+    CHECK(item->id == src->port);
+    CHECK(REC_SIZE == item->len);
+    memcpy(&seq, item->value, sizeof(seq));
+    CHECK(((const uint8_t *)item->value)[REC_SIZE - 1] == 'a' + seq % 26);
+    return seq;
+}
+
+// 拥塞期间重试定时器可能已经把一条积压记录组成合并帧，这一帧保留到队列有空间时发送，
+// 不再参与丢弃或合并.跳过最多一条这样的记录，返回之后的第一条记录，它必需是first
+static uint32_t take_retained(const test_src *src, uint32_t first)
+{
+    uint32_t seq = take(src);
+
+    if (seq < first) {
+        CHECK(seq >= (uint32_t)m_qmax);
+        seq = take(src);
+    }
+    CHECK(seq == first);
+    return seq;
+}
+
+static void expect_empty(void)
+{
+    CHECK(NULL == test_rx_next(&m_rx, CODEC_CMD_DATA, 100));
+}
+
+// 写满应用队列后再写入REC_EXTRA条记录，等待通信线程处理完
+static void fill(test_src *src, int extra)
+{
+    for (int seq = 0; seq < m_qmax + extra; ++seq) {
+        put(src, (uint32_t)seq);
+    }
+    usleep(SETTLE_US);
+}
+
+static void test_oldest(test_src *src)
+{
+    src_open(src, ASY_FLOW_OLDEST);
+    fill(src, REC_EXTRA);
+    CHECK(m_qmax + REC_EXTRA == src->reads);
+    CHECK(0 == src->busy);
+    // 队列中的记录，之后是积压上限内最新的3条
+    for (int seq = 0; seq < m_qmax; ++seq) {
+        CHECK(take(src) == (uint32_t)seq);
+    }
+    uint32_t seq = take_retained(src, m_qmax + REC_EXTRA - 3);
+    for (int idx = 1; idx < 3; ++idx) {
+        CHECK(take(src) == ++seq);
+    }
+    expect_empty();
+
+    // 拥塞解除后直接转发
+    put(src, 1000);
+    CHECK(take(src) == 1000);
+}
+
+static void test_latest(test_src *src)
+{
+    src_open(src, ASY_FLOW_LATEST);
+    fill(src, REC_EXTRA);
+    CHECK(m_qmax + REC_EXTRA == src->reads);
+    for (int seq = 0; seq < m_qmax; ++seq) {
+        CHECK(take(src) == (uint32_t)seq);
+    }
+    take_retained(src, m_qmax + REC_EXTRA - 1);
+    expect_empty();
+
+    // 字节流的一次读取不是完整的消息，没有长度字段时不能使用latest
+    asytxn_cfg txn;
+    memset(&txn, 0, sizeof(txn));
+    CHECK(asyncomm_open_tcps("127.0.0.1", 0, ASY_FLOW_LATEST) == ASY_ER_PARAM);
+    CHECK(asyncomm_open_tcpc("127.0.0.1", 9, ASY_FLOW_LATEST, NULL) == ASY_ER_PARAM);
+    txn.window  = 2;
+    txn.len_off = -1;
+    CHECK(asyncomm_open_tcpc("127.0.0.1", 9, ASY_FLOW_LATEST, &txn) == ASY_ER_PARAM);
+}
+
+static void test_block(test_src *src)
+{
+    src_open(src, ASY_FLOW_BLOCK);
+    fill(src, REC_EXTRA);
+    // 积压4条记录达到高水位后停止读取，其余记录留在套接字中
+    CHECK(m_qmax + 4 == src->reads);
+    CHECK(1 == src->busy);
+    usleep(SETTLE_US);
+    CHECK(m_qmax + 4 == src->reads);
+
+    // 取走队列中的记录后积压依次发送，降到低水位时恢复读取
+    for (int seq = 0; seq < m_qmax + REC_EXTRA; ++seq) {
+        CHECK(take(src) == (uint32_t)seq);
+    }
+    expect_empty();
+    CHECK(m_qmax + REC_EXTRA == src->reads);
+
+    // 再次写满，第二次停止和恢复
+    fill(src, REC_EXTRA);
+    CHECK(2 * m_qmax + REC_EXTRA + 4 == src->reads);
+    CHECK(2 == src->busy);
+    for (int seq = 0; seq < m_qmax + REC_EXTRA; ++seq) {
+        CHECK(take(src) == (uint32_t)seq);
+    }
+    expect_empty();
+    CHECK(2 * (m_qmax + REC_EXTRA) == src->reads);
+}
+
+int main(void)
+{
+    struct mq_attr attr;
+
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    test_appq_open(&m_rx, "flow");
+    CHECK(mq_getattr(m_rx.mq, &attr) == 0);
+    m_qmax = (int)attr.mq_maxmsg;
+    CHECK(appq_sendsize() / 2 < REC_SIZE + ASY_FWD_HEAD && appq_sendsize() > REC_SIZE + ASY_FWD_HEAD);
+    asyncomm_set_watermark(FLOW_HIGH, FLOW_LOW);
+    CHECK(asyncomm_init(1, 0) == ASY_OK);
+
+    // 端口删除后通道在通信线程下一次唤醒时才释放，各项测试使用不同的端口，最后一起关闭
+    test_oldest(&m_src[0]);
+    test_latest(&m_src[1]);
+    test_block(&m_src[2]);
+    for (int idx = 0; idx < 3; ++idx) {
+        src_close_all(&m_src[idx]);
+    }
+
+    asyncomm_exit();
+    test_appq_close(&m_rx);
+    printf("test_flow: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,302 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_glog4c.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :异步日志的编码和格式化测试.每种支持的转换(整数、浮点、字符、字符串、指针、
+//                 %m、%n)与标志、宽度、精度、'*'和长度修饰符的组合，写入日志文件后的消息
+//                 与snprintf的结果一致；NULL字符串、字符串参数截断、超长消息截断、参数超过
+//                 上限和无法识别的转换按约定输出.同步输出(后台线程未启动)和经过环形缓冲区
+//                 两条路径都检查.最后检查缓冲区满时drop丢弃并报告数量，block不丢失记录.
+//                 级别检查:关闭的级别(编译时和运行时)不计算参数，各模块的级别互不影响，
+//                 超过编译时级别的设置输出告警
+// Interface      :test_glog4c
+// Others         :只使用LOG_INFO级别，不写syslog.q/Z修饰符不是标准写法，编译器会告警，不测
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+#include "glog4c.h"
+#include "test.h"
+
+#define MSG_SIZE   1024   // 与日志格式化后一条消息的缓冲区相同
+#define CASE_MAX   256
+#define BURST      200000 // 溢出测试写入的记录数量
+
+static char   m_path[64];
+static off_t  m_off;                    // 已经检查过的文件位置
+static char   m_expect[CASE_MAX][MSG_SIZE];
+static int    m_ncase;
+static char  *m_text;                   // 读到的文件内容
+static size_t m_len;
+static volatile int m_wide = 1500;      // 超过消息缓冲区的宽度，编译器看不到数值，不告警
+
+// 按相同的格式和参数生成期望的消息并写入日志
+#define CASE(format, arg...) do { \
+    CHECK(m_ncase < CASE_MAX); \
+    snprintf(m_expect[m_ncase++], MSG_SIZE, format, ## arg); \
+    glog4c_write(LOG_INFO, __FILE__, __LINE__, format, ## arg); \
+} while (0)
+
+// 读取日志文件中m_off之后的内容
+static void read_new(void)
+{
+    struct stat st;
+
+    int fd = open(m_path, O_RDONLY);
+    CHECK(fd >= 0);
+    CHECK(fstat(fd, &st) == 0);
+    m_len  = (size_t)(st.st_size - m_off);
+    m_text = (char *)realloc(m_text, m_len + 1);
+    CHECK(NULL != m_text);
+    CHECK(pread(fd, m_text, m_len, m_off) == (ssize_t)m_len);
+    m_text[m_len] = '\0';
+    m_off = st.st_size;
+    close(fd);
+}
+
+// 取出下一行的消息部分(文件名和行号之后)，没有更多行时返回NULL
+static char *next_msg(char **pos)
+{
+    char *line = *pos;
+
+    if ('\0' == *line) {
+        return NULL;
+    }
+    char *end = strchr(line, '\n');
+    CHECK(NULL != end);
+    *end = '\0';
+    *pos = end + 1;
+    char *msg = strstr(line, "::");
+    CHECK(NULL != msg);
+    return msg + 2;
+}
+
+// 比较文件中新增的消息与期望的消息
+static void check_cases(void)
+{
+    char *pos, *msg;
+    int idx = 0;
+
+    read_new();
+    pos = m_text;
+    while (NULL != (msg = next_msg(&pos))) {
+        CHECK(idx < m_ncase);
+        if (strcmp(msg, m_expect[idx]) != 0) {
+            fprintf(stderr, "case %d\n  got    [%s]\n  expect [%s]\n", idx, msg, m_expect[idx]);
+            exit(EXIT_FAILURE);
+        }
+        ++idx;
+    }
+    CHECK(idx == m_ncase);
+    m_ncase = 0;
+}
+
+static void write_cases(void)
+{
+    char longstr[1000];
+    const char *volatile null = NULL; // 编译器看不到NULL，不告警
+    long double ld = 1.5L;
+    int pos = 0;
+
+    // 整数和长度修饰符
+    CASE("int %d %i %u %o %x %X", -42, 42, 42U, 42U, 0xBEEFU, 0xBEEFU);
+    CASE("hh %hhd %hhu %hhx / h %hd %hu", 300, 300, 300, 70000, 70000);
+    CASE("l %ld %lu %lx", LONG_MIN, ULONG_MAX, 0x123456789ABCUL);
+    CASE("ll %lld %llu %llX", LLONG_MIN, ULLONG_MAX, 0xFEDCBA9876543210ULL);
+    CASE("z %zd %zu / j %jd %ju / t %td", (ssize_t)-7, (size_t)SIZE_MAX, (intmax_t)INT64_MIN,
+        (uintmax_t)UINT64_MAX, (ptrdiff_t)-123456789);
+    // 标志、宽度和精度
+    CASE("[%5d][%-5d][%05d][%+d][% d][%+5d]", 42, 42, 42, 42, 42, -42);
+    CASE("[%#o][%#x][%#X][%#8x][%-#8x]", 8U, 255U, 255U, 255U, 255U);
+    CASE("[%.3d][%8.3d][%-8.3d][%.0d][%.0d]", 7, -7, 7, 0, 1);
+    CASE("[%'d][%'u]", 1234567, 7654321U);
+    // '*'宽度和精度，负数宽度表示左对齐，负数精度等于没有精度
+    CASE("[%*d][%*d][%.*d][%*.*d]", 6, 42, -6, 42, 4, 42, 8, 5, 42);
+    CASE("[%.*d][%.*f][%.*s]", -3, 42, -1, 3.25, -2, "abc");
+    CASE("[%*s][%-*s][%.*s]", 8, "ab", 8, "ab", 2, "abcdef");
+    // 浮点
+    CASE("f %f %.2f %10.3f %-10.1f| %+f %08.2f", 3.14159, 2.675, -1.5, 2.25, 1.0, -3.5);
+    CASE("e %e %.3E %12.4e / g %g %G %.3g %#g", 123456.789, 0.000123, -9.5e-10, 0.0001, 1e20, 3.14159, 1.0);
+    CASE("a %a %A %.2a / F %F", 1.0, -0.5, 3.0, 2.5);
+    CASE("inf %f %e nan %f %F", 1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0, 0.0 / 0.0);
+    CASE("L %Lf %.2Le %Lg", ld, ld, ld);
+    // 字符、字符串和指针
+    CASE("c [%c][%3c][%-3c]", 'A', 'b', 'c');
+    CASE("s [%s][%10s][%-10s][%.2s][%10.3s]", "hello", "hi", "hi", "hello", "hello");
+    CASE("s [%s][%s]", "", null);
+    CASE("null [%10s][%-8s|]", null, null);
+    CASE("p %p %p %20p", (void *)0x1234, (void *)NULL, (void *)&pos);
+    // %m取调用时的errno，%n不输出
+    errno = EACCES;
+    CASE("m [%m] [%30m]");
+    errno = ENOENT;
+    CASE("n a%nb", &pos);
+    CASE("%% [%%] %d%%", 50);
+    CASE("mix %s=%d (%5.1f%%) at %p [%c] %llu", "temp", -3, 99.44, (void *)0xABC, 'z', 1ULL << 63);
+
+    // 字符串参数最多复制GLOG4C_MAX_STR字节
+    memset(longstr, 's', sizeof(longstr) - 1);
+    longstr[sizeof(longstr) - 1] = '\0';
+    glog4c_write(LOG_INFO, __FILE__, __LINE__, "[%s]", longstr);
+    snprintf(m_expect[m_ncase++], MSG_SIZE, "[%.*s]", GLOG4C_MAX_STR, longstr);
+    // 超长的消息截断到消息缓冲区
+    CASE("%*d|", m_wide, 1);
+    // 参数超过上限，之后的部分原样输出
+    glog4c_write(LOG_INFO, __FILE__, __LINE__, "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d",
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18);
+    snprintf(m_expect[m_ncase++], MSG_SIZE, "1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 %%d %%d");
+    glog4c_write(LOG_INFO, __FILE__, __LINE__, "%*d %*d %*d %*d %*d %*d %*d %*d %*d",
+        1, 1, 1, 2, 1, 3, 1, 4, 1, 5, 1, 6, 1, 7, 1, 8, 1, 9);
+    snprintf(m_expect[m_ncase++], MSG_SIZE, "1 2 3 4 5 6 7 8 %%*d");
+    // 无法识别的转换，之后的部分原样输出
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+    glog4c_write(LOG_INFO, __FILE__, __LINE__, "a %d %y %d", 1, 2);
+#pragma GCC diagnostic pop
+    snprintf(m_expect[m_ncase++], MSG_SIZE, "a 1 %%y %%d");
+}
+
+// 统计m_off之后的新增行中包含text的行数
+static int count_new(const char *text)
+{
+    int num = 0;
+
+    read_new();
+    for (char *pos = m_text; NULL != (pos = strstr(pos, text)); pos += strlen(text)) {
+        ++num;
+    }
+    return num;
+}
+
+// 在DBMEM模块中写入，参数带有副作用
+#undef GLOG4C_MODULE
+#define GLOG4C_MODULE GLOG4C_MOD_DBMEM
+static void dbmem_log(int *calls)
+{
+    glog4c_info("dbmem info %d\n", ++*calls);
+    glog4c_warn("dbmem warn %d\n", ++*calls);
+}
+#undef GLOG4C_MODULE
+#define GLOG4C_MODULE GLOG4C_MOD_MAIN
+
+static void check_levels(void)
+{
+    int calls = 0;
+
+    // 编译时关闭的级别，运行时打开也不计算参数
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_DEBUG);
+    if (LOG_DEBUG > GLOG4C_LEVEL_MAX) {
+        CHECK(1 == count_new("above the compiled ceiling"));
+        glog4c_debug("main debug %d\n", ++calls);
+        CHECK(0 == calls);
+        CHECK(0 == count_new("main debug"));
+    }
+
+    // 运行时关闭的级别不计算参数，其它模块不受影响
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_INFO);
+    glog4c_set_level(GLOG4C_MOD_DBMEM, LOG_WARNING);
+    glog4c_info("main info %d\n", ++calls);
+    CHECK(1 == calls);
+    dbmem_log(&calls);
+    CHECK(2 == calls);
+    read_new();
+    CHECK(NULL != strstr(m_text, "main info 1"));
+    CHECK(NULL != strstr(m_text, "dbmem warn 2"));
+    CHECK(NULL == strstr(m_text, "dbmem info"));
+
+    glog4c_set_level(GLOG4C_MOD_DBMEM, GLOG4C_OFF);
+    dbmem_log(&calls);
+    glog4c_info("main info %d\n", ++calls);
+    CHECK(3 == calls);
+    CHECK(0 == count_new("dbmem"));
+
+    glog4c_set_level(GLOG4C_MOD_MAIN, LOG_ERR);
+    glog4c_set_level(GLOG4C_MOD_DBMEM, LOG_INFO);
+    glog4c_info("main info %d\n", ++calls);
+    dbmem_log(&calls);
+    CHECK(5 == calls);
+    read_new();
+    CHECK(NULL == strstr(m_text, "main info"));
+    CHECK(NULL != strstr(m_text, "dbmem info 4"));
+    CHECK(NULL != strstr(m_text, "dbmem warn 5"));
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_INFO);
+}
+
+// 连续写入BURST条记录，返回文件中的记录数量和报告的丢弃数量，记录必需按顺序
+static void burst(int policy, long *lines, long *drops)
+{
+    char *pos, *msg;
+    long last = -1;
+
+    CHECK(glog4c_config(NULL, policy) == 0);
+    glog4c_start();
+    for (int seq = 0; seq < BURST; ++seq) {
+        glog4c_write(LOG_INFO, __FILE__, __LINE__, "burst %d %s %f", seq, "0123456789abcdef", seq * 0.5);
+    }
+    glog4c_stop();
+    read_new();
+    *lines = 0;
+    *drops = 0;
+    pos = m_text;
+    while ('\0' != *pos) {
+        char *end = strchr(pos, '\n');
+        CHECK(NULL != end);
+        *end = '\0';
+        unsigned long long num;
+        if (NULL != strstr(pos, "glog4c: ") && sscanf(strstr(pos, "glog4c: "), "glog4c: %llu records dropped", &num) == 1) {
+            *drops += (long)num;
+        } else {
+            msg = strstr(pos, "::");
+            CHECK(NULL != msg);
+            long seq;
+            CHECK(sscanf(msg + 2, "burst %ld", &seq) == 1);
+            CHECK(seq > last);
+            last = seq;
+            ++*lines;
+        }
+        pos = end + 1;
+    }
+}
+
+int main(void)
+{
+    long lines, drops;
+
+    snprintf(m_path, sizeof(m_path), "/tmp/test_glog4c_%d.log", (int)getpid());
+    unlink(m_path);
+    CHECK(glog4c_config(m_path, GLOG4C_DROP) == 0);
+    check_levels();
+
+    // 后台线程未启动时同步输出
+    write_cases();
+    check_cases();
+
+    // 经过环形缓冲区，由后台线程格式化
+    glog4c_start();
+    write_cases();
+    glog4c_stop();
+    check_cases();
+
+    // 缓冲区满时丢弃并报告数量，输出的记录和丢弃的记录合计等于写入数量
+    burst(GLOG4C_DROP, &lines, &drops);
+    CHECK(drops > 0);
+    CHECK(lines + drops == BURST);
+    // 等待后台线程取走，不丢失记录
+    burst(GLOG4C_BLOCK, &lines, &drops);
+    CHECK(0 == drops);
+    CHECK(BURST == lines);
+
+    free(m_text);
+    unlink(m_path);
+    printf("test_glog4c: ok\n");
+    return EXIT_SUCCESS;
+}
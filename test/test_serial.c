@@ -0,0 +1,175 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_serial.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :串口成帧测试.用openpty建立伪终端，从主设备写入数据，从通讯者到应用的
+//                 队列检查帧边界:按字节数成帧、按帧间隔成帧，以及按字节数成帧之后帧间隔
+//                 定时器仍然在计时的情况.最后按一问一答测量吞吐量和每帧延迟
+// Interface      :test_serial
+// Others         :无
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <pty.h>
+
+#include "asyncomm.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define PERF_FRAMES 1000 // 测量吞吐量的帧数
+#define PERF_SIZE   64   // 每帧字节数
+
+static test_rx m_rx;
+
+// 打开一对伪终端，从设备交给通讯者，返回主设备句柄和端口号
+static int open_pty(uint8_t vmin, uint8_t vtime, int *port)
+{
+    int master, slave;
+    char name[64];
+    asyserial_cfg cfg;
+
+    CHECK(openpty(&master, &slave, name, NULL, NULL) == 0);
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.baud     = 115200;
+    cfg.databits = 8;
+    cfg.stopbits = 1;
+    cfg.parity   = 'N';
+    cfg.vmin     = vmin;
+    cfg.vtime    = vtime;
+    *port = asyncomm_open_serial(name, &cfg);
+    CHECK(*port >= 0);
+    close(slave); // 通讯者打开了自己的句柄
+    return master;
+}
+
+static void put(int master, const char *data)
+{
+    size_t len = strlen(data);
+    CHECK(write(master, data, len) == (ssize_t)len);
+}
+
+// 等待端口的下一帧并与期望的内容比较
+static void expect(int port, const char *data, int timeout_ms)
+{
+    const codec_item *item = test_rx_next(&m_rx, CODEC_CMD_DATA, timeout_ms);
+
+    CHECK(NULL != item);
+    CHECK(item->id == port);
+    CHECK(item->len == strlen(data));
+    CHECK(memcmp(item->value, data, item->len) == 0);
+}
+
+static void expect_none(int timeout_ms)
+{
+    CHECK(NULL == test_rx_next(&m_rx, CODEC_CMD_DATA, timeout_ms));
+}
+
+// 缓存达到vmin字节时立即成帧，不足时不成帧
+static void test_vmin(void)
+{
+    int port;
+    int master = open_pty(8, 0, &port);
+
+    put(master, "ABCDE");
+    expect_none(100);
+    put(master, "FGH");
+    expect(port, "ABCDEFGH", 100);
+    put(master, "0123456789");
+    expect(port, "0123456789", 100);
+    expect_none(50);
+    close(master);
+}
+
+// 帧间隔内连续到达的数据合并为一帧，间隔到期后成帧
+static void test_gap(void)
+{
+    int port;
+    int master = open_pty(0, 1, &port);
+
+    uint64_t start = test_now();
+    put(master, "abc");
+    usleep(30000);
+    put(master, "def");
+    expect(port, "abcdef", 500);
+    uint64_t elapsed = test_now() - start;
+    CHECK(elapsed >= 120000000ULL); // 从最后一次收到数据开始计时
+    put(master, "xyz");
+    expect(port, "xyz", 500);
+    close(master);
+}
+
+// 按字节数成帧时不停止帧间隔定时器，到期时缓存为空不能产生空帧；
+// 之后收到的数据重新计时，不能被先前的到期时间提前切断
+static void test_vmin_gap(void)
+{
+    int port;
+    int master = open_pty(8, 2, &port);
+
+    put(master, "1234");          // 启动200ms的帧间隔定时器
+    usleep(50000);
+    uint64_t start = test_now();
+    put(master, "5678");          // 达到vmin，立即成帧
+    expect(port, "12345678", 100);
+    CHECK(test_now() - start < 100000000ULL);
+    expect_none(300);             // 先前的定时器到期，缓存为空
+
+    put(master, "wxyz");
+    usleep(50000);
+    put(master, "1234abcd");      // 达到vmin，定时器仍然在计时
+    expect(port, "wxyz1234abcd", 100);
+    usleep(50000);
+    start = test_now();
+    put(master, "ab");            // 在先前的到期时间之前收到，重新计时
+    expect(port, "ab", 500);
+    CHECK(test_now() - start >= 180000000ULL);
+    close(master);
+}
+
+// 一问一答测量吞吐量和每帧从写入到应用收到的延迟
+static void test_perf(void)
+{
+    int port;
+    int master = open_pty(PERF_SIZE, 0, &port);
+    char data[PERF_SIZE + 1];
+    static uint64_t lat[PERF_FRAMES];
+
+    uint64_t start = test_now();
+    for (int idx = 0; idx < PERF_FRAMES; ++idx) {
+        memset(data, 'a' + idx % 26, PERF_SIZE);
+        data[PERF_SIZE] = '\0';
+        uint64_t sent = test_now();
+        put(master, data);
+        expect(port, data, 1000);
+        lat[idx] = test_now() - sent;
+    }
+    double elapsed = (test_now() - start) / 1e9;
+    uint64_t sum = 0, max = 0;
+    for (int idx = 0; idx < PERF_FRAMES; ++idx) {
+        sum += lat[idx];
+        max = lat[idx] > max ? lat[idx] : max;
+    }
+    printf("serial: %d frames of %d B, %.0f B/s, latency avg %.1f us max %.1f us\n",
+        PERF_FRAMES, PERF_SIZE, PERF_FRAMES * PERF_SIZE / elapsed, sum / 1e3 / PERF_FRAMES, max / 1e3);
+    close(master);
+}
+
+int main(void)
+{
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    test_appq_open(&m_rx, "serial");
+    CHECK(asyncomm_init(1, 0) == ASY_OK);
+
+    test_vmin();
+    test_gap();
+    test_vmin_gap();
+    test_perf();
+
+    asyncomm_exit();
+    test_appq_close(&m_rx);
+    printf("test_serial: ok\n");
+    return EXIT_SUCCESS;
+}
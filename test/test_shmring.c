@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_shmring.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :共享内存环的记录检查.正常记录和跨过数据区末尾的填充记录能读出；记录长度
+//                 超过maxmsg、越过数据区末尾或超出写入位置时返回SHMRING_ER_CORRUPT，不读取
+//                 也不移动读出位置，appq_recv返回APPQ_ER_IO
+// Interface      :test_shmring
+// Others         :通讯者侧用appq建立环，应用侧用shmring_open映射同一个环后直接修改记录长度
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include "appq.h"
+#include "shmring.h"
+#include "glog4c.h"
+#include "test.h"
+
+static shmring m_tx;
+
+// 发送一条记录后把它的长度改为len
+static uint32_t *send_with(uint32_t len)
+{
+    char msg[32] = "record";
+
+    uint32_t head = m_tx.ring->head;
+    CHECK(shmring_send(&m_tx, msg, sizeof(msg)) == SHMRING_OK);
+    // 跨过末尾时记录在数据区开头
+    if ((head & m_tx.mask) + shmring_rec_size(sizeof(msg)) > m_tx.mask + 1) {
+        head = 0;
+    }
+    uint32_t *rec = (uint32_t *)(m_tx.data + (head & m_tx.mask));
+    *rec = len;
+    return rec;
+}
+
+int main(void)
+{
+    char a2q[64], q2a[64], buf[8192];
+
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_CRIT);
+    snprintf(a2q, sizeof(a2q), "/test_shmring_a2q_%d", (int)getpid());
+    snprintf(q2a, sizeof(q2a), "/test_shmring_q2a_%d", (int)getpid());
+    CHECK(appq_open(APPQ_SHM, a2q, q2a, APPQ_RING_MIN) == APPQ_OK);
+    CHECK(shmring_open(a2q, &m_tx) == SHMRING_OK);
+    uint32_t size   = m_tx.mask + 1;
+    uint32_t maxmsg = m_tx.ring->maxmsg;
+
+    // 正常记录，写满一圈以上，经过填充记录
+    for (int idx = 0; idx < 300; ++idx) {
+        CHECK(shmring_send(&m_tx, "0123456789abcdefghijklmnopqrstuvwxyz", 20 + idx % 17) == SHMRING_OK);
+        CHECK(appq_recv(buf, sizeof(buf)) == 20 + idx % 17);
+        CHECK(memcmp(buf, "0123456789", 10) == 0);
+    }
+    CHECK(appq_recv(buf, sizeof(buf)) == APPQ_ER_AGAIN);
+
+    // 超过最大长度
+    uint32_t *rec = send_with(maxmsg + 1);
+    uint32_t tail = m_tx.ring->tail;
+    CHECK(appq_recv(buf, sizeof(buf)) == APPQ_ER_IO);
+    CHECK(m_tx.ring->tail == tail);
+
+    // 不超过最大长度但超出写入位置
+    *rec = 64;
+    CHECK(appq_recv(buf, sizeof(buf)) == APPQ_ER_IO);
+    CHECK(m_tx.ring->tail == tail);
+
+    // 恢复后可以读出
+    *rec = 32;
+    CHECK(appq_recv(buf, sizeof(buf)) == 32);
+    CHECK(0 == strcmp(buf, "record"));
+
+    // 越过数据区末尾:把写入位置移到末尾前一条记录的位置
+    while ((m_tx.ring->head & m_tx.mask) < size - 2 * shmring_rec_size(32)) {
+        CHECK(shmring_send(&m_tx, buf, 32) == SHMRING_OK);
+        CHECK(appq_recv(buf, sizeof(buf)) == 32);
+    }
+    CHECK(size - (m_tx.ring->head & m_tx.mask) >= shmring_rec_size(32));
+    rec = send_with(size - (m_tx.ring->head & m_tx.mask));
+    CHECK((uint8_t *)rec != m_tx.data);
+    CHECK(*rec <= maxmsg);
+    CHECK(appq_recv(buf, sizeof(buf)) == APPQ_ER_IO);
+    *rec = 32;
+    CHECK(appq_recv(buf, sizeof(buf)) == 32);
+    CHECK(appq_recv(buf, sizeof(buf)) == APPQ_ER_AGAIN);
+
+    shmring_close(&m_tx);
+    appq_close();
+    printf("test_shmring: ok\n");
+    return EXIT_SUCCESS;
+}
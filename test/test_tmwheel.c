@@ -0,0 +1,220 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_tmwheel.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :分层时间轮测试.检查定时器按距离放入的层和槽，超出范围的定时器放在最高层；
+//                 下一次处理时间(第0层为到期时间，上层为下放时间)；跨层下放后在到期的tick
+//                 准确到期.最后与逐个比较的参考模型对照随机的插入、删除、重新启动和推进
+// Interface      :test_tmwheel
+// Others         :无
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include "tmwheel.h"
+#include "test.h"
+
+#define MODEL_NUM 2000
+
+static tmwheel m_wheel;
+
+static int slot_of(int lvl, uint64_t expire)
+{
+    return (lvl << TMW_BITS) | (int)((expire >> (lvl * TMW_BITS)) & (TMW_SLOTS - 1));
+}
+
+// 推进到now，返回到期的定时器数量，检查到期顺序
+static int advance(uint64_t now, tmnode **fired, int max)
+{
+    tmnode out, *node;
+    int num = 0;
+
+    tmnode_init(&out);
+    tmwheel_advance(&m_wheel, now, &out);
+    CHECK(m_wheel.cur == now);
+    while (NULL != (node = tmwheel_pop(&out))) {
+        CHECK(num < max);
+        CHECK(node->expire <= now);
+        CHECK(0 == num || fired[num - 1]->expire <= node->expire);
+        CHECK(!tmnode_pending(node));
+        fired[num++] = node;
+    }
+    return num;
+}
+
+static void test_place(void)
+{
+    static const uint64_t starts[] = {0, 1000, 0xFFFFFF00ULL, 0x123456789ULL};
+    tmnode node[6];
+    tmnode *fired[8];
+
+    for (size_t run = 0; run < sizeof(starts) / sizeof(starts[0]); ++run) {
+        uint64_t cur = starts[run];
+        tmwheel_init(&m_wheel, cur);
+        for (int idx = 0; idx < 6; ++idx) {
+            tmnode_init(&node[idx]);
+        }
+        CHECK(TMW_NEVER == tmwheel_next(&m_wheel));
+
+        // 已经过去的时间在下一个tick到期
+        tmwheel_add(&m_wheel, &node[0], cur > 0 ? cur - 1 : 0);
+        CHECK(cur + 1 == node[0].expire);
+        CHECK(slot_of(0, cur + 1) == node[0].slot);
+        tmwheel_add(&m_wheel, &node[1], cur + TMW_SLOTS - 1);
+        CHECK(slot_of(0, cur + TMW_SLOTS - 1) == node[1].slot);
+        tmwheel_add(&m_wheel, &node[2], cur + TMW_SLOTS);
+        CHECK(slot_of(1, cur + TMW_SLOTS) == node[2].slot);
+        tmwheel_add(&m_wheel, &node[3], cur + ((uint64_t)TMW_SLOTS << TMW_BITS) + 7);
+        CHECK(slot_of(2, cur + ((uint64_t)TMW_SLOTS << TMW_BITS) + 7) == node[3].slot);
+        tmwheel_add(&m_wheel, &node[4], cur + (TMW_SPAN >> TMW_BITS));
+        CHECK(slot_of(3, cur + (TMW_SPAN >> TMW_BITS)) == node[4].slot);
+        // 超出范围的放在最高层最远的槽
+        tmwheel_add(&m_wheel, &node[5], cur + TMW_SPAN * 3 + 5);
+        CHECK(slot_of(3, cur + TMW_SPAN - 1) == node[5].slot);
+        CHECK(cur + TMW_SPAN * 3 + 5 == node[5].expire);
+        CHECK(6 == m_wheel.count);
+        for (int idx = 0; idx < 6; ++idx) {
+            CHECK(tmnode_pending(&node[idx]));
+        }
+
+        // 下一次处理时间
+        CHECK(cur + 1 == tmwheel_next(&m_wheel));
+        CHECK(1 == advance(cur + 1, fired, 8) && &node[0] == fired[0]);
+        // 上层返回区间起点，下放后返回到期时间
+        uint64_t start = (cur + TMW_SLOTS) & ~(uint64_t)(TMW_SLOTS - 1);
+        CHECK((start < cur + TMW_SLOTS - 1 ? start : cur + TMW_SLOTS - 1) == tmwheel_next(&m_wheel));
+        tmwheel_del(&m_wheel, &node[1]);
+        CHECK(!tmnode_pending(&node[1]));
+        CHECK(start == tmwheel_next(&m_wheel));
+        if (start < cur + TMW_SLOTS) {
+            CHECK(0 == advance(start, fired, 8));
+            CHECK(slot_of(0, cur + TMW_SLOTS) == node[2].slot);
+            CHECK(cur + TMW_SLOTS == tmwheel_next(&m_wheel));
+        }
+        CHECK(1 == advance(cur + TMW_SLOTS, fired, 8) && &node[2] == fired[0]);
+
+        // 跨两层下放后准确到期
+        uint64_t at = node[3].expire;
+        CHECK(0 == advance(at - 1, fired, 8));
+        CHECK(at == tmwheel_next(&m_wheel));
+        CHECK(1 == advance(at, fired, 8) && &node[3] == fired[0]);
+
+        // 第3层和超出范围的定时器
+        at = node[4].expire;
+        CHECK(0 == advance(at - 1, fired, 8));
+        CHECK(1 == advance(at, fired, 8) && &node[4] == fired[0]);
+        at = node[5].expire;
+        CHECK(0 == advance(at - 1, fired, 8));
+        CHECK(1 == m_wheel.count);
+        CHECK(1 == advance(at, fired, 8) && &node[5] == fired[0]);
+        CHECK(0 == m_wheel.count);
+        CHECK(TMW_NEVER == tmwheel_next(&m_wheel));
+    }
+}
+
+// 到期链表中的定时器可以删除或重新启动
+static void test_out_list(void)
+{
+    tmnode node[3], out;
+
+    tmwheel_init(&m_wheel, 0);
+    tmnode_init(&out);
+    for (int idx = 0; idx < 3; ++idx) {
+        tmnode_init(&node[idx]);
+        tmwheel_add(&m_wheel, &node[idx], 10);
+    }
+    tmwheel_advance(&m_wheel, 10, &out);
+    CHECK(0 == m_wheel.count);
+    CHECK(TMW_OUT == node[1].slot && tmnode_pending(&node[1]));
+    tmwheel_del(&m_wheel, &node[1]);
+    CHECK(!tmnode_pending(&node[1]));
+    tmwheel_add(&m_wheel, &node[2], 20);
+    CHECK(1 == m_wheel.count);
+    CHECK(&node[0] == tmwheel_pop(&out));
+    CHECK(NULL == tmwheel_pop(&out));
+    CHECK(20 == tmwheel_next(&m_wheel));
+}
+
+static uint32_t m_rand = 2463534242U;
+static uint32_t rnd(void)
+{
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+}
+
+// 随机的到期距离，覆盖各层和超出范围的情况
+static uint64_t rnd_delta(void)
+{
+    switch (rnd() % 5) {
+    case 0: return rnd() % TMW_SLOTS;
+    case 1: return rnd() % ((uint64_t)TMW_SLOTS << TMW_BITS);
+    case 2: return rnd() % (TMW_SPAN >> TMW_BITS);
+    case 3: return rnd() % 4000;
+    default: return TMW_SPAN + rnd() % 100000;
+    }
+}
+
+static void test_model(void)
+{
+    static tmnode node[MODEL_NUM];
+    static uint64_t due[MODEL_NUM]; // 参考模型中的到期时间，0表示未启动
+    static tmnode *fired[MODEL_NUM];
+    uint64_t now = 0xFFFFF000ULL;
+
+    tmwheel_init(&m_wheel, now);
+    for (int idx = 0; idx < MODEL_NUM; ++idx) {
+        tmnode_init(&node[idx]);
+        due[idx] = 0;
+    }
+    for (int round = 0; round < 20000; ++round) {
+        for (int op = 0; op < 4; ++op) {
+            int idx = (int)(rnd() % MODEL_NUM);
+            if (rnd() % 4 == 0) {
+                tmwheel_del(&m_wheel, &node[idx]);
+                due[idx] = 0;
+            } else {
+                uint64_t at = now + rnd_delta();
+                tmwheel_add(&m_wheel, &node[idx], at);
+                due[idx] = (at > now) ? at : now + 1;
+            }
+        }
+        // 推进到下一次处理时间，或者随机的一段时间
+        uint64_t next = tmwheel_next(&m_wheel);
+        uint64_t target = (rnd() % 2 && TMW_NEVER != next) ? next : now + 1 + rnd_delta() % 3000;
+        uint64_t first = TMW_NEVER;
+        int expect = 0, count = 0;
+        for (int idx = 0; idx < MODEL_NUM; ++idx) {
+            if (0 != due[idx]) {
+                ++count;
+                first = due[idx] < first ? due[idx] : first;
+                expect += due[idx] <= target;
+            }
+        }
+        CHECK((uint32_t)count == m_wheel.count);
+        // 下一次处理时间不晚于最早的到期时间
+        CHECK(next <= first && next > now);
+        int num = advance(target, fired, MODEL_NUM);
+        CHECK(num == expect);
+        for (int pos = 0; pos < num; ++pos) {
+            int idx = (int)(fired[pos] - node);
+            CHECK(due[idx] <= target && due[idx] > now);
+            CHECK(fired[pos]->expire == due[idx]);
+            due[idx] = 0;
+        }
+        now = target;
+    }
+}
+
+int main(void)
+{
+    test_place();
+    test_out_list();
+    test_model();
+    printf("test_tmwheel: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,284 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :test_txn.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :请求/应答事务测试.用openpty建立伪终端，主设备模拟串口设备，读取请求后按
+//                 需要应答.检查:按发送顺序匹配应答，排队的请求依次发出；按序号匹配时序号不对
+//                 的应答作为普通数据转发；按长度字段拼接分两次到达的应答；超时后重发，重发次数
+//                 用完以ASY_TXN_TIMEOUT结束；端口关闭时在途和排队的请求以ASY_TXN_CLOSED结束；
+//                 TCP字节流没有长度字段时事务窗口按1处理
+// Interface      :test_txn
+// Others         :串口是半双工的，一次只有一个请求在途
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <poll.h>
+#include <pty.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "asyncomm.h"
+#include "glog4c.h"
+#include "test.h"
+
+#define TXN_HEAD 5 // 应答条目值的头部，标签4B | 状态1B
+
+static test_rx m_rx;
+
+// 打开一对伪终端，从设备交给通讯者并启用事务，返回主设备句柄和端口号
+static int open_pty(int16_t seq_off, int16_t len_off, uint16_t retry, uint32_t timeout, int *port)
+{
+    int master, slave;
+    char name[64];
+    asyserial_cfg cfg;
+
+    CHECK(openpty(&master, &slave, name, NULL, NULL) == 0);
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.baud        = 115200;
+    cfg.databits    = 8;
+    cfg.stopbits    = 1;
+    cfg.parity      = 'N';
+    cfg.txn.window  = 1;
+    cfg.txn.retry   = retry;
+    cfg.txn.timeout = timeout;
+    cfg.txn.seq_off = seq_off;
+    cfg.txn.len_off = len_off;
+    *port = asyncomm_open_serial(name, &cfg);
+    CHECK(*port >= 0);
+    close(slave); // 通讯者打开了自己的句柄
+    return master;
+}
+
+// 设备侧读取一个请求，timeout_ms内没有收到时返回0
+static int dev_read(int master, uint8_t *buf, size_t size, int timeout_ms)
+{
+    struct pollfd pfd;
+
+    pfd.fd     = master;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return 0;
+    }
+    ssize_t len = read(master, buf, size);
+    CHECK(len > 0);
+    return (int)len;
+}
+
+static void dev_write(int master, const void *buf, size_t len)
+{
+    CHECK(write(master, buf, len) == (ssize_t)len);
+}
+
+// 设备侧读到的请求必需是req
+static void dev_expect(int master, const char *req, int timeout_ms)
+{
+    uint8_t buf[256];
+    int len = dev_read(master, buf, sizeof(buf), timeout_ms);
+
+    CHECK(len == (int)strlen(req));
+    CHECK(memcmp(buf, req, len) == 0);
+}
+
+// 等待下一条应答并检查标签、状态和内容，data为NULL时不检查内容
+static void expect_resp(int port, uint32_t tag, uint8_t status, const void *data, size_t len)
+{
+    const codec_item *item = test_rx_next(&m_rx, CODEC_CMD_RESP, 1000);
+    uint32_t rtag;
+
+    CHECK(NULL != item);
+    CHECK(item->id == port);
+    CHECK(item->len >= TXN_HEAD);
+    memcpy(&rtag, item->value, sizeof(rtag));
+    CHECK(rtag == tag);
+    CHECK(((const uint8_t *)item->value)[4] == status);
+    if (NULL != data) {
+        CHECK(item->len == TXN_HEAD + len);
+        CHECK(memcmp((const uint8_t *)item->value + TXN_HEAD, data, len) == 0);
+    }
+}
+
+// 没有序号时应答属于最早的请求，后面的请求排队，前一个完成后发出
+static void test_fifo(void)
+{
+    int port;
+    int master = open_pty(-1, -1, 0, 1000, &port);
+
+    CHECK(asyncomm_request(port, 1, "REQ1", 4) == ASY_OK);
+    CHECK(asyncomm_request(port, 2, "REQ2", 4) == ASY_OK);
+    CHECK(asyncomm_request(port, 3, "REQ3", 4) == ASY_OK);
+    for (int idx = 1; idx <= 3; ++idx) {
+        char req[8], ans[8];
+        snprintf(req, sizeof(req), "REQ%d", idx);
+        snprintf(ans, sizeof(ans), "ANS%d", idx);
+        dev_expect(master, req, 1000);
+        // 半双工，上一个请求完成前不会发出下一个
+        CHECK(0 == dev_read(master, (uint8_t *)req, sizeof(req), 50));
+        dev_write(master, ans, 4);
+        expect_resp(port, idx, ASY_TXN_OK, ans, 4);
+    }
+    CHECK(asyncomm_request(9999, 1, "REQ1", 4) == ASY_ER_PARAM);
+    CHECK(asyncomm_close(port) == ASY_OK);
+    close(master);
+}
+
+// 请求的第1、2字节写入序号，应答中序号相同才匹配
+static void test_seq(void)
+{
+    int port;
+    int master = open_pty(1, -1, 0, 1000, &port);
+    uint8_t req[8], ans[4];
+
+    for (uint32_t tag = 10; tag < 13; ++tag) {
+        uint8_t out[4] = {0xA5, 0, 0, (uint8_t)tag};
+        CHECK(asyncomm_request(port, tag, out, sizeof(out)) == ASY_OK);
+        CHECK(dev_read(master, req, sizeof(req), 1000) == 4);
+        CHECK(0xA5 == req[0] && tag == req[3]);
+
+        // 序号不对的应答作为普通数据转发，请求仍然在途
+        ans[0] = 0x5A;
+        ans[1] = req[1];
+        ans[2] = (uint8_t)(req[2] + 1);
+        ans[3] = 0xEE;
+        dev_write(master, ans, sizeof(ans));
+        const codec_item *item = test_rx_next(&m_rx, CODEC_CMD_DATA, 1000);
+        CHECK(NULL != item && item->id == port && 4 == item->len);
+        CHECK(memcmp(item->value, ans, sizeof(ans)) == 0);
+
+        ans[2] = req[2];
+        ans[3] = (uint8_t)tag;
+        dev_write(master, ans, sizeof(ans));
+        expect_resp(port, tag, ASY_TXN_OK, ans, sizeof(ans));
+    }
+    CHECK(asyncomm_close(port) == ASY_OK);
+    close(master);
+}
+
+// 应答第1、2字节是后面数据的长度，分两次到达时拼接成一个应答
+static void test_length(void)
+{
+    int port;
+    int master = open_pty(-1, 0, 0, 1000, &port);
+    static const uint8_t ans[] = {0x00, 0x06, 'a', 'b', 'c', 'd', 'e', 'f'};
+
+    CHECK(asyncomm_request(port, 20, "LEN", 3) == ASY_OK);
+    dev_expect(master, "LEN", 1000);
+    dev_write(master, ans, 3);
+    CHECK(NULL == test_rx_next(&m_rx, CODEC_CMD_RESP, 100));
+    dev_write(master, ans + 3, sizeof(ans) - 3);
+    expect_resp(port, 20, ASY_TXN_OK, ans, sizeof(ans));
+    CHECK(asyncomm_close(port) == ASY_OK);
+    close(master);
+}
+
+// 超时后重发，重发次数用完后结束；重发之后收到应答时正常完成
+static void test_retry(void)
+{
+    int port;
+    int master = open_pty(-1, -1, 2, 50, &port);
+    uint8_t buf[16];
+
+    uint64_t start = test_now();
+    CHECK(asyncomm_request(port, 30, "PING", 4) == ASY_OK);
+    for (int idx = 0; idx < 3; ++idx) {
+        dev_expect(master, "PING", 1000);
+    }
+    expect_resp(port, 30, ASY_TXN_TIMEOUT, "", 0);
+    CHECK(test_now() - start >= 3 * 50 * 1000000ULL);
+    CHECK(0 == dev_read(master, buf, sizeof(buf), 100));
+
+    CHECK(asyncomm_request(port, 31, "PING", 4) == ASY_OK);
+    dev_expect(master, "PING", 1000);
+    dev_expect(master, "PING", 1000);
+    dev_write(master, "PONG", 4);
+    expect_resp(port, 31, ASY_TXN_OK, "PONG", 4);
+    CHECK(0 == dev_read(master, buf, sizeof(buf), 150));
+    CHECK(asyncomm_close(port) == ASY_OK);
+    close(master);
+}
+
+// 端口关闭时在途和排队的请求都以ASY_TXN_CLOSED结束，之后不能再发送请求
+static void test_closed(void)
+{
+    int port;
+    int master = open_pty(-1, -1, 0, 5000, &port);
+
+    CHECK(asyncomm_request(port, 40, "REQ", 3) == ASY_OK);
+    CHECK(asyncomm_request(port, 41, "REQ", 3) == ASY_OK);
+    CHECK(asyncomm_request(port, 42, "REQ", 3) == ASY_OK);
+    dev_expect(master, "REQ", 1000);
+    CHECK(asyncomm_close(port) == ASY_OK);
+    expect_resp(port, 40, ASY_TXN_CLOSED, "", 0);
+    expect_resp(port, 41, ASY_TXN_CLOSED, "", 0);
+    expect_resp(port, 42, ASY_TXN_CLOSED, "", 0);
+    CHECK(asyncomm_request(port, 43, "REQ", 3) == ASY_ER_PARAM);
+    close(master);
+}
+
+// TCP字节流没有长度字段时事务窗口按1处理，第一个请求完成前不发出第二个
+static void test_tcp_window(void)
+{
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    asytxn_cfg txn;
+    uint8_t buf[16];
+    int one = 1;
+
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(lfd >= 0);
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    CHECK(listen(lfd, 1) == 0);
+    CHECK(getsockname(lfd, (struct sockaddr *)&addr, &alen) == 0);
+
+    memset(&txn, 0, sizeof(txn));
+    txn.window  = 4;
+    txn.timeout = 5000;
+    txn.seq_off = -1;
+    txn.len_off = -1;
+    int port = asyncomm_open_tcpc("127.0.0.1", ntohs(addr.sin_port), ASY_FLOW_OLDEST, &txn);
+    CHECK(port >= 0);
+    int cfd = accept(lfd, NULL, NULL);
+    CHECK(cfd >= 0);
+    usleep(50000); // 等待客户端处理连接完成
+
+    CHECK(asyncomm_request(port, 50, "REQ1", 4) == ASY_OK);
+    CHECK(asyncomm_request(port, 51, "REQ2", 4) == ASY_OK);
+    dev_expect(cfd, "REQ1", 1000);
+    CHECK(0 == dev_read(cfd, buf, sizeof(buf), 100));
+    dev_write(cfd, "ANS1", 4);
+    expect_resp(port, 50, ASY_TXN_OK, "ANS1", 4);
+    dev_expect(cfd, "REQ2", 1000);
+    dev_write(cfd, "ANS2", 4);
+    expect_resp(port, 51, ASY_TXN_OK, "ANS2", 4);
+
+    CHECK(asyncomm_close(port) == ASY_OK);
+    close(cfd);
+    close(lfd);
+}
+
+int main(void)
+{
+    glog4c_set_level(GLOG4C_MOD_ALL, LOG_WARNING);
+    test_appq_open(&m_rx, "txn");
+    CHECK(asyncomm_init(1, 0) == ASY_OK);
+
+    test_fifo();
+    test_seq();
+    test_length();
+    test_retry();
+    test_closed();
+    test_tcp_window();
+
+    asyncomm_exit();
+    test_appq_close(&m_rx);
+    printf("test_txn: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+//-----------------------------------------------------------------------------
+// Copyright (C)
+// File name      :tmwheel.c
+// Author         :llemmx
+// Date           :2026-10-17
+// Description    :分层时间轮.插入、删除是O(1)的链表操作，推进时只处理非空的槽，下一次到期
+//                 时间由各层的非空槽位图直接算出，事件循环据此只设置一次timerfd
+// Interface      :无
+// Others         :第L层的槽按到期tick右移L*TMW_BITS位取模编号，放入第L层的定时器与当前
+//                 时间相差1到TMW_SLOTS个这样的区间，区间起点到达时下放，不会提前或错过
+//-----------------------------------------------------------------------------
+// History:        初稿
+//-----------------------------------------------------------------------------
+// 2026-10-17 : 1.0.0 : llemmx
+// Modification   :
+//-----------------------------------------------------------------------------
+#include <stddef.h>
+
+#include "tmwheel.h"
+
+#define TMW_MASK (TMW_SLOTS - 1)
+
+void tmnode_init(tmnode *node)
+{
+    node->next   = node;
+    node->prev   = node;
+    node->expire = 0;
+    node->slot   = TMW_IDLE;
+}
+
+void tmwheel_init(tmwheel *w, uint64_t now)
+{
+    for (int lvl = 0; lvl < TMW_LEVELS; ++lvl) {
+        for (int idx = 0; idx < TMW_SLOTS; ++idx) {
+            tmnode_init(&w->slot[lvl][idx]);
+        }
+        for (int idx = 0; idx < TMW_SLOTS / 64; ++idx) {
+            w->map[lvl][idx] = 0;
+        }
+    }
+    w->cur   = now;
+    w->count = 0;
+}
+
+static inline void tmw_link(tmnode *head, tmnode *node)
+{
+    node->prev       = head->prev;
+    node->next       = head;
+    head->prev->next = node;
+    head->prev       = node;
+}
+
+static inline void tmw_unlink(tmnode *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node;
+    node->prev = node;
+}
+
+// 按到期时间放入对应的层，调用者保证expire不早于cur
+static void tmw_place(tmwheel *w, tmnode *node)
+{
+    uint64_t expire = node->expire;
+    uint64_t delta  = expire - w->cur;
+
+    if (delta >= TMW_SPAN) { // 超出范围的定时器先放在最高层最远的槽，下放时重新计算
+        expire = w->cur + TMW_SPAN - 1;
+        delta  = TMW_SPAN - 1;
+    }
+    int lvl = (delta < TMW_SLOTS) ? 0 : (63 - __builtin_clzll(delta)) / TMW_BITS;
+    int idx = (int)((expire >> (lvl * TMW_BITS)) & TMW_MASK);
+    tmw_link(&w->slot[lvl][idx], node);
+    w->map[lvl][idx >> 6] |= 1ULL << (idx & 63);
+    node->slot = (lvl << TMW_BITS) | idx;
+}
+
+void tmwheel_add(tmwheel *w, tmnode *node, uint64_t expire)
+{
+    tmwheel_del(w, node);
+    node->expire = (expire > w->cur) ? expire : w->cur + 1;
+    tmw_place(w, node);
+    ++w->count;
+}
+
+void tmwheel_del(tmwheel *w, tmnode *node)
+{
+    if (TMW_IDLE == node->slot) {
+        return;
+    }
+    tmw_unlink(node);
+    if (TMW_OUT != node->slot) {
+        int lvl = node->slot >> TMW_BITS;
+        int idx = node->slot & TMW_MASK;
+        tmnode *head = &w->slot[lvl][idx];
+        if (head->next == head) {
+            w->map[lvl][idx >> 6] &= ~(1ULL << (idx & 63));
+        }
+        --w->count;
+    }
+    node->slot = TMW_IDLE;
+}
+
+// 从start开始循环查找第一个非空槽，返回相对start的距离，全空时返回-1
+static int tmw_scan(const uint64_t *map, int start)
+{
+    int word = start >> 6;
+    uint64_t bits = map[word] & (~0ULL << (start & 63));
+
+    for (int step = 0; step <= TMW_SLOTS / 64; ++step) {
+        if (0 != bits) {
+            int pos = (word << 6) + __builtin_ctzll(bits);
+            return (pos - start) & TMW_MASK;
+        }
+        word = (word + 1) & (TMW_SLOTS / 64 - 1);
+        bits = map[word];
+    }
+    return -1;
+}
+
+uint64_t tmwheel_next(const tmwheel *w)
+{
+    uint64_t next = TMW_NEVER;
+
+    if (0 == w->count) {
+        return next;
+    }
+    // 第0层是到期时间，上层是槽所代表区间的起点，也就是下放的时间
+    for (int lvl = 0; lvl < TMW_LEVELS; ++lvl) {
+        int shift = lvl * TMW_BITS;
+        uint64_t base = (w->cur >> shift) + 1;
+        int dist = tmw_scan(w->map[lvl], (int)(base & TMW_MASK));
+        if (dist >= 0) {
+            uint64_t at = (base + (uint64_t)dist) << shift;
+            if (at < next) {
+                next = at;
+            }
+        }
+    }
+    return next;
+}
+
+// 把槽中的定时器重新放入下层
+static void tmw_cascade(tmwheel *w, int lvl, int idx)
+{
+    tmnode *head = &w->slot[lvl][idx];
+
+    while (head->next != head) {
+        tmnode *node = head->next;
+        tmw_unlink(node);
+        tmw_place(w, node);
+    }
+    w->map[lvl][idx >> 6] &= ~(1ULL << (idx & 63));
+}
+
+/******************************************************************************
+* Description    : 推进时间轮.跳过没有事件的区间，每到一个需要处理的tick先把上层对应的
+*                  槽下放，再把第0层当前槽中的定时器移到到期链表
+* Input          : w - 时间轮
+*                : now - 当前tick
+* Output         : out - 到期链表，节点标记为TMW_OUT
+* Return         : None
+*------------------------------------------------------------------------------
+* 2026-10-17     : 1.0.0 : llemmx
+* Modification   :
+******************************************************************************/
+void tmwheel_advance(tmwheel *w, uint64_t now, tmnode *out)
+{
+    while (w->cur < now) {
+        uint64_t next = tmwheel_next(w);
+        if (next > now) {
+            w->cur = now;
+            break;
+        }
+        w->cur = next;
+        for (int lvl = 1; lvl < TMW_LEVELS; ++lvl) {
+            if (0 != (w->cur & ((1ULL << (lvl * TMW_BITS)) - 1))) {
+                break;
+            }
+            tmw_cascade(w, lvl, (int)((w->cur >> (lvl * TMW_BITS)) & TMW_MASK));
+        }
+        int idx = (int)(w->cur & TMW_MASK);
+        tmnode *head = &w->slot[0][idx];
+        while (head->next != head) {
+            tmnode *node = head->next;
+            tmw_unlink(node);
+            tmw_link(out, node);
+            node->slot = TMW_OUT;
+            --w->count;
+        }
+        w->map[0][idx >> 6] &= ~(1ULL << (idx & 63));
+    }
+}
+
+tmnode *tmwheel_pop(tmnode *out)
+{
+    tmnode *node = out->next;
+
+    if (node == out) {
+        return NULL;
+    }
+    tmw_unlink(node);
+    node->slot = TMW_IDLE;
+    return node;
+}
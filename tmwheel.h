@@ -0,0 +1,57 @@
+#ifndef TMWHEEL_H_
+#define TMWHEEL_H_
+
+#include <stdint.h>
+
+// 分层时间轮.时间以tick为单位，共TMW_LEVELS层，每层TMW_SLOTS个槽，第L层一个槽覆盖
+// TMW_SLOTS^L个tick.定时器按距离到期的远近放入对应层的槽中，插入和删除都是链表操作；
+// 时间推进到上层槽的起点时，槽中的定时器重新放入下层，到第0层的槽时到期.每层用位图记录
+// 非空的槽，可以直接算出下一次需要处理的时间，空闲期间不需要逐个tick推进
+// 本身不带锁，由使用者保证同一时刻只有一个线程操作
+
+#define TMW_BITS   8
+#define TMW_SLOTS  (1 << TMW_BITS)
+#define TMW_LEVELS 4
+#define TMW_SPAN   (1ULL << (TMW_BITS * TMW_LEVELS)) // 最远能直接放入的距离，更远的定时器在最高层轮转
+#define TMW_NEVER  UINT64_MAX
+
+#define TMW_IDLE   -1 // 未启动
+#define TMW_OUT    -2 // 已经到期，在到期链表中
+
+// 定时器节点，嵌入到使用者的结构中
+typedef struct tmnode {
+    struct tmnode *next;
+    struct tmnode *prev;
+    uint64_t       expire; // 到期tick
+    int32_t        slot;   // 所在的槽(层 << TMW_BITS | 槽号)，或TMW_IDLE/TMW_OUT
+}tmnode;
+
+typedef struct {
+    tmnode   slot[TMW_LEVELS][TMW_SLOTS];           // 各槽的链表头
+    uint64_t map[TMW_LEVELS][TMW_SLOTS / 64];       // 非空槽位图
+    uint64_t cur;                                   // 已经处理到的tick
+    uint32_t count;                                 // 在轮中的定时器数量
+}tmwheel;
+
+// 初始化时间轮，now为当前tick
+void tmwheel_init(tmwheel *w, uint64_t now);
+// 初始化节点或链表头
+void tmnode_init(tmnode *node);
+// 启动定时器，已经启动的先删除.不晚于当前tick的定时器在下一个tick到期
+void tmwheel_add(tmwheel *w, tmnode *node, uint64_t expire);
+// 删除定时器，在轮中或到期链表中都可以删除
+void tmwheel_del(tmwheel *w, tmnode *node);
+// 下一次需要处理的tick(到期或者上层槽下放)，没有定时器时返回TMW_NEVER
+uint64_t tmwheel_next(const tmwheel *w);
+// 推进到now，到期的定时器按到期顺序追加到out链表
+void tmwheel_advance(tmwheel *w, uint64_t now, tmnode *out);
+// 取出到期链表中的第一个定时器，链表为空时返回NULL
+tmnode *tmwheel_pop(tmnode *out);
+
+// 定时器是否已经启动并且还没有被取出
+static inline int tmnode_pending(const tmnode *node)
+{
+    return TMW_IDLE != node->slot;
+}
+
+#endif